@@ -0,0 +1,116 @@
+// the micro benchmark of the locks,compile on linux system can use below command :
+// g++ -std=c++11 -O2 -I .. lock_bench.cpp -o lock_bench -lpthread
+//
+// usage : lock_bench [milliseconds of every case,default 1000] [max threads,default 128]
+//
+// every thread acquires the lock,increases a shared counter,releases the lock and does a little
+// work out of the lock,the acquire latency is the time of lock(),and it's measured by every
+// thread into it's own histogram.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include <zdb2/util/histogram.hpp>
+#include <zdb2/util/spin_lock.hpp>
+#include <zdb2/util/adaptive_mutex.hpp>
+
+struct result
+{
+	uint64_t ops = 0;
+	double seconds = 0;
+	zdb2::histogram latency_ns;
+};
+
+template<typename Lock>
+void run(Lock & lock, std::size_t threads, std::size_t milliseconds, result & r)
+{
+	std::atomic<bool> start{ false };
+	std::atomic<bool> stop{ false };
+	volatile uint64_t counter = 0;
+
+	std::vector<std::shared_ptr<zdb2::histogram>> histograms;
+	std::vector<uint64_t> ops(threads, 0);
+	std::vector<std::thread> workers;
+	for (std::size_t i = 0; i < threads; i++)
+	{
+		histograms.emplace_back(std::make_shared<zdb2::histogram>());
+		workers.emplace_back([&, i]()
+		{
+			zdb2::histogram & h = *histograms[i];
+			uint64_t n = 0;
+			uint64_t local = 0;
+
+			while (!start.load(std::memory_order_acquire))
+				std::this_thread::yield();
+
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				auto t0 = std::chrono::steady_clock::now();
+				lock.lock();
+				auto t1 = std::chrono::steady_clock::now();
+				counter = counter + 1;
+				lock.unlock();
+
+				h.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+				n++;
+
+				// the work out of the lock
+				for (int k = 0; k < 64; k++)
+					local = local * 6364136223846793005ULL + 1442695040888963407ULL;
+			}
+			ops[i] = n + (local == 1 ? 1 : 0);
+		});
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	start.store(true, std::memory_order_release);
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+	stop.store(true);
+	for (auto & t : workers)
+		t.join();
+	r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	for (std::size_t i = 0; i < threads; i++)
+	{
+		r.ops += ops[i];
+		r.latency_ns.merge(*histograms[i]);
+	}
+}
+
+template<typename Lock>
+void bench(const char * name, std::size_t threads, std::size_t milliseconds)
+{
+	Lock lock;
+	std::unique_ptr<result> r(new result());
+	run(lock, threads, milliseconds, *r);
+
+	std::printf("%-16s %7zu %14.0f %10llu %10llu %10llu %12llu\n", name, threads, (double)r->ops / r->seconds,
+		(unsigned long long)r->latency_ns.get_percentile(50),
+		(unsigned long long)r->latency_ns.get_percentile(99),
+		(unsigned long long)r->latency_ns.get_percentile(99.9),
+		(unsigned long long)r->latency_ns.get_max());
+	std::fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+	std::size_t milliseconds = (argc > 1 ? (std::size_t)std::atoi(argv[1]) : 1000);
+	std::size_t max_threads = (argc > 2 ? (std::size_t)std::atoi(argv[2]) : 128);
+
+	std::printf("%-16s %7s %14s %10s %10s %10s %12s\n", "lock", "threads", "ops/s", "p50_ns", "p99_ns", "p999_ns", "max_ns");
+	for (std::size_t threads = 2; threads <= max_threads; threads *= 2)
+	{
+		bench<zdb2::spin_lock>("spin_lock", threads, milliseconds);
+		bench<zdb2::adaptive_mutex>("adaptive_mutex", threads, milliseconds);
+		bench<std::mutex>("std::mutex", threads, milliseconds);
+	}
+	return 0;
+}
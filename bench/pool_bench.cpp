@@ -0,0 +1,260 @@
+// the benchmark of the pool checkout,compile on linux system can use below command :
+// g++ -std=c++11 -O2 -I .. pool_bench.cpp -o pool_bench -lpthread -ldl
+//
+// usage : pool_bench [milliseconds of every case,default 1000] [max threads,default 128]
+//                    [simulated latency of the statements in us,default 0] [json file]
+//
+// the connections are of the null backend (see zdb2/db/null/null_connection.hpp),so only the
+// cost of the pool is measured.the cases are :
+//
+// get              : pool::get() and the return of the connection,the pool has a connection
+//                    for every thread
+// get/pool4        : the same but the pool has 4 connections,the threads retry when the pool
+//                    is exhausted,the latency is of the successful checkouts only
+// get+execute      : get(),one execute() with the simulated latency and the return
+// get+execute/stats: the same with the statement stats of the pool enabled
+// shared_from_this : the shared_from_this() of the pool which get() does for every checkout
+// deleter          : make and destroy a shared_ptr<connection> with a custom deleter which
+//                    captures a shared_ptr of the pool,as get() does for every checkout
+//
+// the results are printed as a table,and written as json into the file if it's given,"-" means
+// the json is printed instead of the table.they can be compared between the commits.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+// only the null backend is needed
+#define ZDB2_USE_NULL
+
+#include <zdb2/zdb.hpp>
+
+struct result
+{
+	std::string name;
+	std::size_t threads = 0;
+	uint64_t ops = 0;
+	uint64_t exhausted = 0;
+	double seconds = 0;
+	zdb2::histogram latency_ns;
+};
+
+struct worker_state
+{
+	zdb2::histogram latency_ns;
+	uint64_t ops = 0;
+	uint64_t exhausted = 0;
+};
+
+// the operation of the case returns false if it's not done,eg : the pool is exhausted
+typedef std::function<bool(worker_state &)> operation;
+
+void run(std::size_t threads, std::size_t milliseconds, operation op, result & r)
+{
+	std::atomic<bool> start{ false };
+	std::atomic<bool> stop{ false };
+
+	std::vector<std::shared_ptr<worker_state>> states;
+	std::vector<std::thread> workers;
+	for (std::size_t i = 0; i < threads; i++)
+	{
+		states.emplace_back(std::make_shared<worker_state>());
+		workers.emplace_back([&, i]()
+		{
+			worker_state & s = *states[i];
+
+			while (!start.load(std::memory_order_acquire))
+				std::this_thread::yield();
+
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				auto t0 = std::chrono::steady_clock::now();
+				bool done = op(s);
+				auto t1 = std::chrono::steady_clock::now();
+				if (!done)
+				{
+					s.exhausted++;
+					std::this_thread::yield();
+					continue;
+				}
+				s.latency_ns.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+				s.ops++;
+			}
+		});
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	start.store(true, std::memory_order_release);
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+	stop.store(true);
+	for (auto & t : workers)
+		t.join();
+	r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	r.threads = threads;
+
+	for (auto & s : states)
+	{
+		r.ops += s->ops;
+		r.exhausted += s->exhausted;
+		r.latency_ns.merge(s->latency_ns);
+	}
+}
+
+std::shared_ptr<zdb2::pool> make_pool(std::size_t connections, std::size_t latency_us)
+{
+	std::string url = "null:///bench?latency_us=" + std::to_string(latency_us);
+	return std::make_shared<zdb2::pool>(std::make_shared<zdb2::url>(url.c_str()),
+		connections, zdb2::DEFAULT_CONNECTION_TIMEOUT, zdb2::DEFAULT_TIMEOUT, connections);
+}
+
+std::vector<std::shared_ptr<result>> results;
+bool json_only = false;
+
+void report(std::shared_ptr<result> r)
+{
+	results.emplace_back(r);
+	if (json_only)
+		return;
+
+	std::printf("%-18s %7zu %14.0f %10llu %10llu %10llu %12llu %12llu\n", r->name.c_str(), r->threads,
+		(double)r->ops / r->seconds,
+		(unsigned long long)r->latency_ns.get_percentile(50),
+		(unsigned long long)r->latency_ns.get_percentile(99),
+		(unsigned long long)r->latency_ns.get_percentile(99.9),
+		(unsigned long long)r->latency_ns.get_max(),
+		(unsigned long long)r->exhausted);
+	std::fflush(stdout);
+}
+
+void bench(const char * name, std::size_t threads, std::size_t milliseconds, operation op)
+{
+	std::shared_ptr<result> r = std::make_shared<result>();
+	r->name = name;
+	run(threads, milliseconds, op, *r);
+	report(r);
+}
+
+std::string to_json(std::size_t milliseconds, std::size_t latency_us)
+{
+	char buf[512];
+	std::string s;
+	std::snprintf(buf, sizeof(buf), "{\"benchmark\":\"pool_bench\",\"milliseconds\":%zu,\"latency_us\":%zu,"
+		"\"hardware_concurrency\":%u,\"results\":[", milliseconds, latency_us, std::thread::hardware_concurrency());
+	s += buf;
+	for (std::size_t i = 0; i < results.size(); i++)
+	{
+		result & r = *results[i];
+		std::snprintf(buf, sizeof(buf), "%s\n{\"case\":\"%s\",\"threads\":%zu,\"ops\":%llu,\"seconds\":%.6f,"
+			"\"ops_per_sec\":%.1f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu,\"exhausted\":%llu}",
+			(i > 0 ? "," : ""), r.name.c_str(), r.threads, (unsigned long long)r.ops, r.seconds,
+			(double)r.ops / r.seconds,
+			(unsigned long long)r.latency_ns.get_percentile(50),
+			(unsigned long long)r.latency_ns.get_percentile(99),
+			(unsigned long long)r.latency_ns.get_percentile(99.9),
+			(unsigned long long)r.latency_ns.get_max(),
+			(unsigned long long)r.exhausted);
+		s += buf;
+	}
+	s += "\n]}\n";
+	return s;
+}
+
+int main(int argc, char *argv[])
+{
+	std::size_t milliseconds = (argc > 1 ? (std::size_t)std::atoi(argv[1]) : 1000);
+	std::size_t max_threads = (argc > 2 ? (std::size_t)std::atoi(argv[2]) : 128);
+	std::size_t latency_us = (argc > 3 ? (std::size_t)std::atoi(argv[3]) : 0);
+	std::string json_file = (argc > 4 ? argv[4] : "");
+	json_only = (json_file == "-");
+
+	if (!json_only)
+		std::printf("%-18s %7s %14s %10s %10s %10s %12s %12s\n", "case", "threads", "ops/s", "p50_ns", "p99_ns", "p999_ns", "max_ns", "exhausted");
+
+	for (std::size_t threads = 1; threads <= max_threads; threads *= 2)
+	{
+		{
+			std::shared_ptr<zdb2::pool> p = make_pool(threads, latency_us);
+			bench("get", threads, milliseconds, [p](worker_state &)
+			{
+				std::shared_ptr<zdb2::connection> conn = p->get();
+				return (conn != nullptr);
+			});
+		}
+
+		{
+			std::shared_ptr<zdb2::pool> p = make_pool(4, latency_us);
+			bench("get/pool4", threads, milliseconds, [p](worker_state &)
+			{
+				std::shared_ptr<zdb2::connection> conn = p->get();
+				return (conn != nullptr);
+			});
+		}
+
+		for (int stats = 0; stats < 2; stats++)
+		{
+			std::shared_ptr<zdb2::pool> p = make_pool(threads, latency_us);
+			p->enable_stats(stats != 0);
+			bench((stats ? "get+execute/stats" : "get+execute"), threads, milliseconds, [p](worker_state &)
+			{
+				std::shared_ptr<zdb2::connection> conn = p->get();
+				if (!conn)
+					return false;
+				conn->execute("update t set a = 1 where id = %d", 10);
+				return true;
+			});
+		}
+
+		{
+			std::shared_ptr<zdb2::pool> p = make_pool(1, latency_us);
+			bench("shared_from_this", threads, milliseconds, [p](worker_state &)
+			{
+				std::shared_ptr<zdb2::pool> this_ptr = p->shared_from_this();
+				return (this_ptr != nullptr);
+			});
+		}
+
+		{
+			std::shared_ptr<zdb2::pool> p = make_pool(1, latency_us);
+			std::shared_ptr<zdb2::connection> conn = p->get();
+			zdb2::connection * raw = conn.get();
+			bench("deleter", threads, milliseconds, [p, raw](worker_state & s)
+			{
+				auto checkout = std::chrono::steady_clock::now();
+				uint64_t * ops = &s.ops;
+				std::shared_ptr<zdb2::connection> c(raw, [p, checkout, ops](zdb2::connection *)
+				{
+					// the same captures as the deleter of pool::get(),and not optimized out
+					if (checkout.time_since_epoch().count() == 0)
+						(*ops)++;
+				});
+				return (c != nullptr);
+			});
+		}
+	}
+
+	std::string json = to_json(milliseconds, latency_us);
+	if (json_only)
+	{
+		std::fputs(json.c_str(), stdout);
+	}
+	else if (!json_file.empty())
+	{
+		FILE * fp = std::fopen(json_file.c_str(), "w");
+		if (!fp)
+		{
+			std::fprintf(stderr, "can't open %s\n", json_file.c_str());
+			return 1;
+		}
+		std::fputs(json.c_str(), fp);
+		std::fclose(fp);
+	}
+	return 0;
+}
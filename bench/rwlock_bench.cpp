@@ -0,0 +1,155 @@
+// the micro benchmark of the read write locks,compile on linux system can use below command :
+// g++ -std=c++11 -O2 -I .. rwlock_bench.cpp -o rwlock_bench -lpthread
+//
+// usage : rwlock_bench [milliseconds of every case,default 1000] [max threads,default 128] [writes per million ops,default 100]
+//
+// every thread reads a small shared table under the read lock,and sometimes updates it under the
+// write lock,the read mostly data like the shard map.the acquire latency of the read lock is
+// measured by every thread into it's own histogram.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include <zdb2/util/histogram.hpp>
+#include <zdb2/util/rwlock.hpp>
+#include <zdb2/util/br_rwlock.hpp>
+
+struct result
+{
+	uint64_t reads = 0;
+	uint64_t writes = 0;
+	double seconds = 0;
+	zdb2::histogram latency_ns;
+};
+
+// make the locks have the same interface
+struct rwlock_adapter
+{
+	zdb2::rwlock lock;
+	void lock_read() { lock.lock_read(); }
+	void unlock_read() { lock.unlock_read(); }
+	void lock_write() { lock.lock_write(); }
+	void unlock_write() { lock.unlock_write(); }
+};
+
+struct br_rwlock_adapter
+{
+	zdb2::br_rwlock lock;
+	void lock_read() { lock.lock_read(); }
+	void unlock_read() { lock.unlock_read(); }
+	void lock_write() { lock.lock_write(); }
+	void unlock_write() { lock.unlock_write(); }
+};
+
+struct mutex_adapter
+{
+	std::mutex lock;
+	void lock_read() { lock.lock(); }
+	void unlock_read() { lock.unlock(); }
+	void lock_write() { lock.lock(); }
+	void unlock_write() { lock.unlock(); }
+};
+
+template<typename Lock>
+void run(Lock & lock, std::size_t threads, std::size_t milliseconds, uint64_t writes_per_million, result & r)
+{
+	std::atomic<bool> start{ false };
+	std::atomic<bool> stop{ false };
+	volatile uint64_t table[16] = { 0 };
+
+	std::vector<std::shared_ptr<zdb2::histogram>> histograms;
+	std::vector<uint64_t> reads(threads, 0), writes(threads, 0);
+	std::vector<std::thread> workers;
+	for (std::size_t i = 0; i < threads; i++)
+	{
+		histograms.emplace_back(std::make_shared<zdb2::histogram>());
+		workers.emplace_back([&, i]()
+		{
+			zdb2::histogram & h = *histograms[i];
+			uint64_t nr = 0, nw = 0, sum = 0;
+			uint64_t rnd = 0x9E3779B97F4A7C15ULL * (i + 1);
+
+			while (!start.load(std::memory_order_acquire))
+				std::this_thread::yield();
+
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				rnd = rnd * 6364136223846793005ULL + 1442695040888963407ULL;
+				if ((rnd >> 33) % 1000000 < writes_per_million)
+				{
+					lock.lock_write();
+					table[(rnd >> 13) & 15] = table[(rnd >> 13) & 15] + 1;
+					lock.unlock_write();
+					nw++;
+					continue;
+				}
+
+				auto t0 = std::chrono::steady_clock::now();
+				lock.lock_read();
+				auto t1 = std::chrono::steady_clock::now();
+				sum += table[(rnd >> 13) & 15];
+				lock.unlock_read();
+
+				h.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+				nr++;
+			}
+			reads[i] = nr + (sum == 1 ? 1 : 0);
+			writes[i] = nw;
+		});
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	start.store(true, std::memory_order_release);
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+	stop.store(true);
+	for (auto & t : workers)
+		t.join();
+	r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	for (std::size_t i = 0; i < threads; i++)
+	{
+		r.reads += reads[i];
+		r.writes += writes[i];
+		r.latency_ns.merge(*histograms[i]);
+	}
+}
+
+template<typename Lock>
+void bench(const char * name, std::size_t threads, std::size_t milliseconds, uint64_t writes_per_million)
+{
+	std::unique_ptr<Lock> lock(new Lock());
+	std::unique_ptr<result> r(new result());
+	run(*lock, threads, milliseconds, writes_per_million, *r);
+
+	std::printf("%-12s %7zu %14.0f %12.0f %10llu %10llu %10llu %12llu\n", name, threads,
+		(double)r->reads / r->seconds, (double)r->writes / r->seconds,
+		(unsigned long long)r->latency_ns.get_percentile(50),
+		(unsigned long long)r->latency_ns.get_percentile(99),
+		(unsigned long long)r->latency_ns.get_percentile(99.9),
+		(unsigned long long)r->latency_ns.get_max());
+	std::fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+	std::size_t milliseconds = (argc > 1 ? (std::size_t)std::atoi(argv[1]) : 1000);
+	std::size_t max_threads = (argc > 2 ? (std::size_t)std::atoi(argv[2]) : 128);
+	uint64_t writes_per_million = (argc > 3 ? (uint64_t)std::atoll(argv[3]) : 100);
+
+	std::printf("%-12s %7s %14s %12s %10s %10s %10s %12s\n", "lock", "threads", "reads/s", "writes/s", "p50_ns", "p99_ns", "p999_ns", "max_ns");
+	for (std::size_t threads = 1; threads <= max_threads; threads *= 2)
+	{
+		bench<rwlock_adapter>("rwlock", threads, milliseconds, writes_per_million);
+		bench<br_rwlock_adapter>("br_rwlock", threads, milliseconds, writes_per_million);
+		bench<mutex_adapter>("std::mutex", threads, milliseconds, writes_per_million);
+	}
+	return 0;
+}
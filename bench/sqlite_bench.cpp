@@ -0,0 +1,377 @@
+// the workload benchmark of the sqlite backend,compile on linux system can use below command :
+// g++ -std=c++11 -O2 -I .. sqlite_bench.cpp -o sqlite_bench -lsqlite3 -lpthread -ldl
+// g++ -std=c++11 -O2 -DSQLITEUNLOCK -I .. sqlite_bench.cpp -o sqlite_bench_unlock -lsqlite3 -lpthread -ldl
+//
+// the busy retry (sqlite_util::execute) and the unlock notify (SQLITEUNLOCK) are chosen when
+// compiling,so build it twice as above to compare them,the mode is printed in the results.
+//
+// usage : sqlite_bench [milliseconds of every case,default 1000] [max threads,default 8]
+//                      [database file,default ./zdb2_bench.db] [json file]
+//
+// every case is run on 4 configurations : shared cache on/off,WAL/rollback (DELETE) journal,
+// all with "synchronous=normal".the database file is created again for every configuration
+// with ROWS rows.the workloads are :
+//
+// point_select : select a row by the primary key
+// range_scan   : select and read 100 rows by a range of the primary key
+// insert       : insert a row in the autocommit mode
+// insert/txn   : insert a row,a transaction is committed every 100 rows
+// insert/batch : insert 100 rows by a prepared statement in a transaction,an op is a batch
+// mixed        : 90% point_select,10% update a row by the primary key
+//
+// every thread uses it's own connection of the pool for the whole case,so the pool is not
+// measured,see pool_bench.cpp for it.the latency is in microseconds,"errors" are the failed
+// operations,eg : the database is locked longer than the busy timeout.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <exception>
+
+#define ZDB2_USE_SQLITE
+
+#include <zdb2/zdb.hpp>
+
+enum
+{
+	ROWS = 100000,
+	RANGE = 100,
+	BATCH = 100,
+};
+
+struct result
+{
+	std::string config;
+	std::string name;
+	std::size_t threads = 0;
+	uint64_t ops = 0;
+	uint64_t errors = 0;
+	double seconds = 0;
+	zdb2::histogram latency_ns;
+};
+
+struct worker_state
+{
+	std::shared_ptr<zdb2::connection> conn;
+	std::shared_ptr<zdb2::stmt> stmt;
+	zdb2::histogram latency_ns;
+	uint64_t ops = 0;
+	uint64_t errors = 0;
+	uint64_t rnd = 0;
+
+	int next_id()
+	{
+		rnd = rnd * 6364136223846793005ULL + 1442695040888963407ULL;
+		return (int)((rnd >> 33) % ROWS) + 1;
+	}
+};
+
+// the operation of the case returns false if it's failed
+typedef std::function<bool(worker_state &)> operation;
+
+void run(std::shared_ptr<zdb2::pool> p, std::size_t threads, std::size_t milliseconds, operation op, result & r)
+{
+	std::atomic<bool> start{ false };
+	std::atomic<bool> stop{ false };
+
+	std::vector<std::shared_ptr<worker_state>> states;
+	for (std::size_t i = 0; i < threads; i++)
+	{
+		states.emplace_back(std::make_shared<worker_state>());
+		states[i]->rnd = 0x9E3779B97F4A7C15ULL * (i + 1);
+		states[i]->conn = p->get();
+		if (!states[i]->conn)
+			throw std::runtime_error("no available connection in the pool.");
+	}
+
+	std::vector<std::thread> workers;
+	for (std::size_t i = 0; i < threads; i++)
+	{
+		workers.emplace_back([&, i]()
+		{
+			worker_state & s = *states[i];
+
+			while (!start.load(std::memory_order_acquire))
+				std::this_thread::yield();
+
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				bool ok = false;
+				auto t0 = std::chrono::steady_clock::now();
+				try
+				{
+					ok = op(s);
+				}
+				catch (std::exception &)
+				{
+				}
+				auto t1 = std::chrono::steady_clock::now();
+				if (!ok)
+				{
+					s.errors++;
+					if (s.conn->is_intransaction())
+						s.conn->rollback();
+					continue;
+				}
+				s.latency_ns.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+				s.ops++;
+			}
+
+			if (s.conn->is_intransaction())
+				s.conn->commit();
+			s.stmt.reset();
+		});
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	start.store(true, std::memory_order_release);
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+	stop.store(true);
+	for (auto & t : workers)
+		t.join();
+	r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	r.threads = threads;
+
+	for (auto & s : states)
+	{
+		r.ops += s->ops;
+		r.errors += s->errors;
+		r.latency_ns.merge(s->latency_ns);
+	}
+}
+
+std::vector<std::shared_ptr<result>> results;
+bool json_only = false;
+
+void report(std::shared_ptr<result> r)
+{
+	results.emplace_back(r);
+	if (json_only)
+		return;
+
+	std::printf("%-22s %-14s %7zu %12.0f %10.1f %10.1f %10.1f %10llu\n", r->config.c_str(), r->name.c_str(), r->threads,
+		(double)r->ops / r->seconds,
+		(double)r->latency_ns.get_percentile(50) / 1000.0,
+		(double)r->latency_ns.get_percentile(99) / 1000.0,
+		(double)r->latency_ns.get_percentile(99.9) / 1000.0,
+		(unsigned long long)r->errors);
+	std::fflush(stdout);
+}
+
+std::string to_json(std::size_t milliseconds)
+{
+	char buf[512];
+	std::string s;
+#if defined SQLITEUNLOCK && SQLITE_VERSION_NUMBER >= 3006012
+	const char * mode = "unlock_notify";
+#else
+	const char * mode = "busy_retry";
+#endif
+	std::snprintf(buf, sizeof(buf), "{\"benchmark\":\"sqlite_bench\",\"milliseconds\":%zu,\"sqlite_version\":\"%s\","
+		"\"lock_wait\":\"%s\",\"hardware_concurrency\":%u,\"results\":[", milliseconds, sqlite3_libversion(), mode,
+		std::thread::hardware_concurrency());
+	s += buf;
+	for (std::size_t i = 0; i < results.size(); i++)
+	{
+		result & r = *results[i];
+		std::snprintf(buf, sizeof(buf), "%s\n{\"config\":\"%s\",\"case\":\"%s\",\"threads\":%zu,\"ops\":%llu,\"seconds\":%.6f,"
+			"\"ops_per_sec\":%.1f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,\"errors\":%llu}",
+			(i > 0 ? "," : ""), r.config.c_str(), r.name.c_str(), r.threads, (unsigned long long)r.ops, r.seconds,
+			(double)r.ops / r.seconds,
+			(double)r.latency_ns.get_percentile(50) / 1000.0,
+			(double)r.latency_ns.get_percentile(99) / 1000.0,
+			(double)r.latency_ns.get_percentile(99.9) / 1000.0,
+			(unsigned long long)r.errors);
+		s += buf;
+	}
+	s += "\n]}\n";
+	return s;
+}
+
+void remove_database(const std::string & path)
+{
+	std::remove(path.c_str());
+	std::remove((path + "-journal").c_str());
+	std::remove((path + "-wal").c_str());
+	std::remove((path + "-shm").c_str());
+}
+
+void fill_database(std::shared_ptr<zdb2::pool> p)
+{
+	std::shared_ptr<zdb2::connection> conn = p->get();
+	if (!conn)
+		throw std::runtime_error("no available connection in the pool.");
+
+	conn->execute("create table bench (id integer primary key, name varchar(32), value integer)");
+	conn->execute("create table bench_insert (id integer primary key autoincrement, name varchar(32), value integer)");
+
+	conn->begin_transaction();
+	std::shared_ptr<zdb2::stmt> stmt = conn->prepare_stmt("insert into bench (id, name, value) values (?, ?, ?)");
+	for (int i = 1; i <= ROWS; i++)
+	{
+		std::string name = "name" + std::to_string(i);
+		stmt->set_int(1, i);
+		stmt->set_string(2, name.c_str());
+		stmt->set_int(3, i % 1000);
+		stmt->execute();
+	}
+	stmt.reset();
+	conn->commit();
+}
+
+void bench_config(const std::string & path, bool shared_cache, bool wal, std::size_t max_threads, std::size_t milliseconds)
+{
+	std::string config = std::string(shared_cache ? "shared" : "private") + "/" + (wal ? "wal" : "rollback");
+	std::string url = "sqlite://" + path + "?synchronous=normal&journal_mode=" + (wal ? "WAL" : "DELETE") +
+		"&shared_cache=" + (shared_cache ? "true" : "false");
+
+	remove_database(path);
+	std::shared_ptr<zdb2::pool> p = std::make_shared<zdb2::pool>(std::make_shared<zdb2::url>(url.c_str()),
+		1, zdb2::DEFAULT_CONNECTION_TIMEOUT, zdb2::DEFAULT_TIMEOUT, max_threads);
+	fill_database(p);
+
+	struct workload
+	{
+		const char * name;
+		operation op;
+	};
+
+	std::vector<workload> workloads =
+	{
+		{ "point_select", [](worker_state & s)
+		{
+			std::shared_ptr<zdb2::resultset> rs = s.conn->query("select id, name, value from bench where id = %d", s.next_id());
+			if (!rs)
+				return false;
+			while (rs->next_row())
+				rs->get_string(1);
+			return true;
+		} },
+		{ "range_scan", [](worker_state & s)
+		{
+			int id = s.next_id();
+			std::shared_ptr<zdb2::resultset> rs = s.conn->query("select id, name, value from bench where id between %d and %d",
+				id, id + RANGE - 1);
+			if (!rs)
+				return false;
+			int64_t sum = 0;
+			while (rs->next_row())
+				sum += rs->get_int64(2);
+			return (sum >= 0);
+		} },
+		{ "insert", [](worker_state & s)
+		{
+			return s.conn->execute("insert into bench_insert (name, value) values ('name%d', %d)", s.next_id(), (int)s.ops);
+		} },
+		{ "insert/txn", [](worker_state & s)
+		{
+			if (!s.conn->is_intransaction() && !s.conn->begin_transaction())
+				return false;
+			if (!s.conn->execute("insert into bench_insert (name, value) values ('name%d', %d)", s.next_id(), (int)s.ops))
+				return false;
+			if (s.ops % BATCH == BATCH - 1)
+				return s.conn->commit();
+			return true;
+		} },
+		{ "insert/batch", [](worker_state & s)
+		{
+			if (!s.stmt)
+				s.stmt = s.conn->prepare_stmt("insert into bench_insert (name, value) values (?, ?)");
+			if (!s.conn->begin_transaction())
+				return false;
+			for (int i = 0; i < BATCH; i++)
+			{
+				s.stmt->set_string(1, "batch");
+				s.stmt->set_int(2, i);
+				s.stmt->execute();
+			}
+			return s.conn->commit();
+		} },
+		{ "mixed", [](worker_state & s)
+		{
+			int id = s.next_id();
+			if (s.rnd % 10 == 0)
+				return s.conn->execute("update bench set value = value + 1 where id = %d", id);
+
+			std::shared_ptr<zdb2::resultset> rs = s.conn->query("select id, name, value from bench where id = %d", id);
+			if (!rs)
+				return false;
+			while (rs->next_row())
+				rs->get_string(1);
+			return true;
+		} },
+	};
+
+	for (auto & w : workloads)
+	{
+		for (std::size_t threads = 1; threads <= max_threads; threads *= 2)
+		{
+			std::shared_ptr<result> r = std::make_shared<result>();
+			r->config = config;
+			r->name = w.name;
+			run(p, threads, milliseconds, w.op, *r);
+			report(r);
+		}
+	}
+
+	p.reset();
+	remove_database(path);
+}
+
+int main(int argc, char *argv[])
+{
+	std::size_t milliseconds = (argc > 1 ? (std::size_t)std::atoi(argv[1]) : 1000);
+	std::size_t max_threads = (argc > 2 ? (std::size_t)std::atoi(argv[2]) : 8);
+	std::string path = (argc > 3 ? argv[3] : "./zdb2_bench.db");
+	std::string json_file = (argc > 4 ? argv[4] : "");
+	json_only = (json_file == "-");
+
+	if (!json_only)
+	{
+#if defined SQLITEUNLOCK && SQLITE_VERSION_NUMBER >= 3006012
+		std::printf("sqlite %s,unlock notify\n", sqlite3_libversion());
+#else
+		std::printf("sqlite %s,busy retry\n", sqlite3_libversion());
+#endif
+		std::printf("%-22s %-14s %7s %12s %10s %10s %10s %10s\n", "config", "case", "threads", "ops/s", "p50_us", "p99_us", "p999_us", "errors");
+	}
+
+	try
+	{
+		for (int shared_cache = 1; shared_cache >= 0; shared_cache--)
+		{
+			for (int wal = 1; wal >= 0; wal--)
+				bench_config(path, shared_cache != 0, wal != 0, max_threads, milliseconds);
+		}
+	}
+	catch (std::exception & e)
+	{
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	std::string json = to_json(milliseconds);
+	if (json_only)
+	{
+		std::fputs(json.c_str(), stdout);
+	}
+	else if (!json_file.empty())
+	{
+		FILE * fp = std::fopen(json_file.c_str(), "w");
+		if (!fp)
+		{
+			std::fprintf(stderr, "can't open %s\n", json_file.c_str());
+			return 1;
+		}
+		std::fputs(json.c_str(), fp);
+		std::fclose(fp);
+	}
+	return 0;
+}
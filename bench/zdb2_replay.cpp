@@ -0,0 +1,347 @@
+// replay a capture file of zdb2::capture against a database,compile on linux system can use below
+// command,select the backends by the macros,see zdb2/db/backends.hpp :
+// g++ -std=c++11 -O2 -DZDB2_USE_SQLITE -I .. zdb2_replay.cpp -o zdb2_replay -lsqlite3 -lpthread -ldl
+//
+// usage : zdb2_replay <capture file> <url> [speed,default 1] [threads,default 8]
+//                     [max connections,default 2 * threads] [json file]
+//
+// eg    : zdb2_replay /tmp/app.zcap "sqlite:///tmp/app_copy.db?synchronous=normal" 5 16
+//
+// speed is the multiple of the captured speed,eg : 5 means the statements are started 5 times
+// faster than they were captured,0 means as fast as possible.
+//
+// every captured connection is replayed on a connection of the pool,the captured connections are
+// spread to the threads,and the statements of a thread are started in the captured order at the
+// captured time (divided by the speed).a thread can run only one statement at a time,so if the
+// captured connections of a thread were running at the same time,the later ones are delayed,use
+// more threads than the concurrent connections of the capture.the delay of every statement from
+// it's scheduled time is reported as the lag.
+//
+// the PreparedStatements are replayed with their captured parameters,the other statements are
+// replayed with query() if they begin with SELECT,WITH,SHOW,PRAGMA,EXPLAIN,VALUES,DESC or
+// DESCRIBE (all the rows are read),otherwise with execute().
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <exception>
+
+#include <zdb2/zdb.hpp>
+
+typedef zdb2::capture::record record;
+
+struct worker_state
+{
+	std::vector<const record *> records;
+
+	zdb2::histogram latency_ns;
+	zdb2::histogram lag_us;
+	uint64_t statements = 0;
+	uint64_t errors = 0;
+
+	/// the replaying connection of every captured connection
+	std::unordered_map<uint32_t, std::shared_ptr<zdb2::connection>> connections;
+};
+
+bool is_query(const std::string & sql)
+{
+	std::vector<std::string> words = zdb2::sql_util::get_words(sql.c_str(), 1);
+	if (words.empty())
+		return false;
+	const std::string & w = words[0];
+	return (w == "SELECT" || w == "WITH" || w == "SHOW" || w == "PRAGMA" || w == "EXPLAIN" || w == "VALUES" ||
+		w == "DESC" || w == "DESCRIBE");
+}
+
+std::shared_ptr<zdb2::connection> get_connection(std::shared_ptr<zdb2::pool> p, worker_state & s, uint32_t conn_id)
+{
+	auto it = s.connections.find(conn_id);
+	if (it != s.connections.end())
+		return it->second;
+
+	// the statements of a connection which is checked out before the capture is started,or the
+	// pool was exhausted at the checkout
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	std::shared_ptr<zdb2::connection> conn;
+	while (!(conn = p->get()) && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	if (conn)
+		s.connections[conn_id] = conn;
+	return conn;
+}
+
+bool execute_statement(zdb2::connection & conn, const record & rec)
+{
+	if (!rec.params.empty())
+	{
+		std::shared_ptr<zdb2::stmt> stmt = conn.prepare_stmt("%s", rec.sql->c_str());
+		if (!stmt)
+			return false;
+		for (std::size_t i = 0; i < rec.params.size(); i++)
+		{
+			const zdb2::hook_param & p = rec.params[i];
+			int index = (int)i + 1;
+			switch (p.type)
+			{
+			case zdb2::hook_param::STRING:    stmt->set_string(index, p.s.c_str()); break;
+			case zdb2::hook_param::INT:       stmt->set_int(index, (int)p.i); break;
+			case zdb2::hook_param::INT64:     stmt->set_int64(index, p.i); break;
+			case zdb2::hook_param::DOUBLE:    stmt->set_double(index, p.d); break;
+			case zdb2::hook_param::BLOB:      stmt->set_blob(index, p.s.data(), p.s.size()); break;
+			case zdb2::hook_param::TIMESTAMP: stmt->set_timestamp(index, (time_t)p.i); break;
+			default:                          stmt->set_string(index, nullptr); break;
+			}
+		}
+		stmt->execute();
+		return true;
+	}
+
+	if (is_query(*rec.sql))
+	{
+		std::shared_ptr<zdb2::resultset> rs = conn.query("%s", rec.sql->c_str());
+		if (!rs)
+			return false;
+		int cols = rs->get_column_count();
+		while (rs->next_row())
+		{
+			for (int i = 0; i < cols; i++)
+				rs->get_string(i);
+		}
+		return true;
+	}
+
+	return conn.execute("%s", rec.sql->c_str());
+}
+
+void replay(std::shared_ptr<zdb2::pool> p, worker_state & s, std::chrono::steady_clock::time_point begin, double speed)
+{
+	for (const record * rec : s.records)
+	{
+		if (speed > 0)
+		{
+			auto scheduled = begin + std::chrono::microseconds((int64_t)((double)rec->offset_us / speed));
+			auto now = std::chrono::steady_clock::now();
+			if (now < scheduled)
+				std::this_thread::sleep_until(scheduled);
+			else if (rec->type == zdb2::capture::STATEMENT)
+				s.lag_us.record((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - scheduled).count());
+		}
+
+		try
+		{
+			switch (rec->type)
+			{
+			case zdb2::capture::CHECKOUT:
+				get_connection(p, s, rec->conn_id);
+				break;
+
+			case zdb2::capture::RETURN:
+			{
+				auto it = s.connections.find(rec->conn_id);
+				if (it != s.connections.end())
+				{
+					if (it->second->is_intransaction())
+						it->second->rollback();
+					s.connections.erase(it);
+				}
+				break;
+			}
+
+			case zdb2::capture::BEGIN:
+			case zdb2::capture::COMMIT:
+			case zdb2::capture::ROLLBACK:
+			{
+				std::shared_ptr<zdb2::connection> conn = get_connection(p, s, rec->conn_id);
+				if (!conn)
+					break;
+				if (rec->type == zdb2::capture::BEGIN)
+					conn->begin_transaction();
+				else if (rec->type == zdb2::capture::COMMIT)
+					conn->commit();
+				else
+					conn->rollback();
+				break;
+			}
+
+			case zdb2::capture::STATEMENT:
+			{
+				s.statements++;
+				std::shared_ptr<zdb2::connection> conn = get_connection(p, s, rec->conn_id);
+				if (!conn)
+				{
+					s.errors++;
+					break;
+				}
+				bool ok = false;
+				auto t0 = std::chrono::steady_clock::now();
+				try
+				{
+					ok = execute_statement(*conn, *rec);
+				}
+				catch (std::exception &)
+				{
+				}
+				auto t1 = std::chrono::steady_clock::now();
+				s.latency_ns.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+				if (!ok)
+					s.errors++;
+				break;
+			}
+			}
+		}
+		catch (std::exception &)
+		{
+			s.errors++;
+		}
+	}
+
+	for (auto & pair : s.connections)
+	{
+		if (pair.second->is_intransaction())
+			pair.second->rollback();
+	}
+	s.connections.clear();
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+	{
+		std::fprintf(stderr, "usage : zdb2_replay <capture file> <url> [speed,default 1] [threads,default 8] "
+			"[max connections,default 2 * threads] [json file]\n");
+		return 1;
+	}
+
+	std::string path = argv[1];
+	std::string url = argv[2];
+	double speed = (argc > 3 ? std::atof(argv[3]) : 1.0);
+	std::size_t threads = (argc > 4 ? (std::size_t)std::atoi(argv[4]) : 8);
+	std::size_t max_conn = (argc > 5 ? (std::size_t)std::atoi(argv[5]) : 2 * threads);
+	std::string json_file = (argc > 6 ? argv[6] : "");
+	if (threads == 0)
+		threads = 1;
+
+	try
+	{
+		std::vector<record> records = zdb2::capture::load(path);
+
+		// the records are written when the events end,order them by the start time
+		std::stable_sort(records.begin(), records.end(), [](const record & a, const record & b)
+		{
+			return a.offset_us < b.offset_us;
+		});
+
+		std::vector<std::shared_ptr<worker_state>> states;
+		for (std::size_t i = 0; i < threads; i++)
+			states.emplace_back(std::make_shared<worker_state>());
+
+		zdb2::histogram captured_us;
+		uint64_t captured_span_us = 0;
+		for (auto & rec : records)
+		{
+			states[rec.conn_id % threads]->records.emplace_back(&rec);
+			if (rec.type == zdb2::capture::STATEMENT)
+			{
+				captured_us.record(rec.duration_us);
+				captured_span_us = (std::max)(captured_span_us, rec.offset_us + rec.duration_us);
+			}
+		}
+
+		std::shared_ptr<zdb2::pool> p = std::make_shared<zdb2::pool>(std::make_shared<zdb2::url>(url.c_str()),
+			(std::min)(threads, max_conn), zdb2::DEFAULT_CONNECTION_TIMEOUT, zdb2::DEFAULT_TIMEOUT, max_conn);
+		p->enable_stats(true);
+
+		if (speed > 0)
+			std::printf("replaying %zu records of %s at %gx speed from %zu threads\n", records.size(), path.c_str(), speed, threads);
+		else
+			std::printf("replaying %zu records of %s at unlimited speed from %zu threads\n", records.size(), path.c_str(), threads);
+		std::fflush(stdout);
+
+		auto begin = std::chrono::steady_clock::now();
+		std::vector<std::thread> workers;
+		for (std::size_t i = 0; i < threads; i++)
+		{
+			workers.emplace_back([&, i]()
+			{
+				replay(p, *states[i], begin, speed);
+			});
+		}
+		for (auto & t : workers)
+			t.join();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		zdb2::histogram latency_ns, lag_us;
+		uint64_t statements = 0, errors = 0;
+		for (auto & s : states)
+		{
+			latency_ns.merge(s->latency_ns);
+			lag_us.merge(s->lag_us);
+			statements += s->statements;
+			errors += s->errors;
+		}
+
+		std::printf("statements %llu,errors %llu,%.3f seconds (captured %.3f seconds),%.0f statements/s\n",
+			(unsigned long long)statements, (unsigned long long)errors, seconds, (double)captured_span_us / 1000000.0,
+			(double)statements / seconds);
+		std::printf("%-10s %10s %10s %10s %10s\n", "latency", "p50_us", "p99_us", "p999_us", "max_us");
+		std::printf("%-10s %10.1f %10.1f %10.1f %10.1f\n", "replay",
+			(double)latency_ns.get_percentile(50) / 1000.0, (double)latency_ns.get_percentile(99) / 1000.0,
+			(double)latency_ns.get_percentile(99.9) / 1000.0, (double)latency_ns.get_max() / 1000.0);
+		std::printf("%-10s %10llu %10llu %10llu %10llu\n", "captured",
+			(unsigned long long)captured_us.get_percentile(50), (unsigned long long)captured_us.get_percentile(99),
+			(unsigned long long)captured_us.get_percentile(99.9), (unsigned long long)captured_us.get_max());
+		std::printf("%-10s %10llu %10llu %10llu %10llu\n", "lag",
+			(unsigned long long)lag_us.get_percentile(50), (unsigned long long)lag_us.get_percentile(99),
+			(unsigned long long)lag_us.get_percentile(99.9), (unsigned long long)lag_us.get_max());
+
+		// the fingerprints which take the most time
+		std::vector<zdb2::statement_stats::entry_snapshot> entries = p->get_stats_snapshot();
+		std::sort(entries.begin(), entries.end(), [](const zdb2::statement_stats::entry_snapshot & a,
+			const zdb2::statement_stats::entry_snapshot & b)
+		{
+			return a.total_us > b.total_us;
+		});
+		if (entries.size() > 10)
+			entries.resize(10);
+
+		std::printf("\n%10s %8s %12s %10s %10s  %s\n", "count", "errors", "total_ms", "p50_us", "p99_us", "fingerprint");
+		for (auto & e : entries)
+		{
+			std::printf("%10llu %8llu %12.1f %10llu %10llu  %s\n", (unsigned long long)e.count, (unsigned long long)e.errors,
+				(double)e.total_us / 1000.0, (unsigned long long)e.execute_us->get_percentile(50),
+				(unsigned long long)e.execute_us->get_percentile(99), e.fingerprint.c_str());
+		}
+
+		if (!json_file.empty())
+		{
+			FILE * fp = std::fopen(json_file.c_str(), "w");
+			if (!fp)
+				throw std::runtime_error("can't open " + json_file);
+			std::fprintf(fp, "{\"benchmark\":\"zdb2_replay\",\"speed\":%.3f,\"threads\":%zu,\"max_connections\":%zu,"
+				"\"statements\":%llu,\"errors\":%llu,\"seconds\":%.6f,\"captured_seconds\":%.6f,"
+				"\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f,"
+				"\"lag_p50_us\":%llu,\"lag_p99_us\":%llu,\"lag_max_us\":%llu}\n",
+				speed, threads, max_conn, (unsigned long long)statements, (unsigned long long)errors, seconds,
+				(double)captured_span_us / 1000000.0,
+				(double)latency_ns.get_percentile(50) / 1000.0, (double)latency_ns.get_percentile(99) / 1000.0,
+				(double)latency_ns.get_percentile(99.9) / 1000.0, (double)latency_ns.get_max() / 1000.0,
+				(unsigned long long)lag_us.get_percentile(50), (unsigned long long)lag_us.get_percentile(99),
+				(unsigned long long)lag_us.get_max());
+			std::fclose(fp);
+		}
+	}
+	catch (std::exception & e)
+	{
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+	return 0;
+}
@@ -11,6 +11,10 @@
 
 //#define SQLITEUNLOCK
 
+// only the sqlite backend is compiled in,the others can still be loaded from the plugins,
+// see zdb2/db/backends.hpp
+#define ZDB2_USE_SQLITE
+
 #include <zdb2/zdb.hpp>
 
 
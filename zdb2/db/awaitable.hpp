@@ -0,0 +1,609 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+// the awaitables need c++ 20 coroutine support,with c++ 11/14/17 this file is empty.
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define ZDB2_HAS_COROUTINE
+#endif
+#endif
+
+#if defined(ZDB2_HAS_COROUTINE)
+
+#include <cstdio>
+#include <cstdarg>
+#include <string>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <deque>
+#include <mutex>
+#include <coroutine>
+
+#include <zdb2/util/executor.hpp>
+#include <zdb2/db/connection.hpp>
+#include <zdb2/db/resultset.hpp>
+#include <zdb2/db/materialized_result.hpp>
+#include <zdb2/db/pool.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * call the function when the task which holds this guard is destroyed without being run,eg :
+	 * the task is discarded by a stopped executor.
+	 */
+	class task_guard
+	{
+	public:
+		explicit task_guard(std::function<void()> on_drop) : m_on_drop(std::move(on_drop))
+		{
+		}
+
+		~task_guard()
+		{
+			if (m_on_drop)
+			{
+				try { m_on_drop(); } catch (...) {}
+			}
+		}
+
+		/// the task is run,the function will not be called
+		void release()
+		{
+			m_on_drop = nullptr;
+		}
+
+	protected:
+		std::function<void()> m_on_drop;
+	};
+
+	/**
+	 * post the task to the executor.if the task queue of the executor is full,the task is run on
+	 * the calling thread,so a busy executor slows the caller down instead of failing it.if the
+	 * executor is stopped,or the task is discarded when the executor is stopped,on_stopped is
+	 * called instead of the task.
+	 */
+	inline void post_or_run(std::shared_ptr<executor> executor_ptr, std::function<void()> task, std::function<void()> on_stopped)
+	{
+		if (!executor_ptr || executor_ptr->is_stopped())
+		{
+			on_stopped();
+			return;
+		}
+
+		std::shared_ptr<task_guard> guard = std::make_shared<task_guard>(on_stopped);
+		if (executor_ptr->post([guard, task]() { guard->release(); task(); }))
+			return;
+
+		guard->release();
+		if (executor_ptr->is_stopped())
+			on_stopped();
+		else
+			task();
+	}
+
+	/**
+	 * decide which thread a suspended coroutine is resumed on.if no scheduler is used,the
+	 * coroutine is resumed on the thread that completed the operation (an executor worker
+	 * or the event loop thread of a non-blocking backend).
+	 */
+	class scheduler
+	{
+	public:
+		virtual ~scheduler()
+		{
+		}
+
+		/**
+		 * resume the coroutine.if the scheduler can't resume it (eg : the executor is stopped),
+		 * cancel must be called instead,it completes the operation with an error and resumes the
+		 * coroutine on the calling thread.
+		 */
+		virtual void schedule(std::coroutine_handle<> handle, std::function<void()> cancel) = 0;
+	};
+
+	/**
+	 * the scheduler which resume the coroutines on an executor.
+	 */
+	class executor_scheduler : public scheduler
+	{
+	public:
+		explicit executor_scheduler(std::shared_ptr<executor> executor_ptr) : m_executor_ptr(executor_ptr)
+		{
+		}
+
+		virtual void schedule(std::coroutine_handle<> handle, std::function<void()> cancel) override
+		{
+			// if the executor queue is full,resume inline is better than lose the coroutine
+			post_or_run(m_executor_ptr, [handle]() { handle.resume(); }, std::move(cancel));
+		}
+
+	protected:
+		std::shared_ptr<executor> m_executor_ptr;
+	};
+
+	/**
+	 * awaitable of an asynchronous operation.the operation is started when the awaitable is
+	 * co_awaited,and it must call the completion handler exactly once.
+	 */
+	template<typename T>
+	class awaitable
+	{
+	public:
+		using handler_type = std::function<void(T, std::exception_ptr)>;
+		using operation_type = std::function<void(handler_type)>;
+
+		awaitable(operation_type op, std::shared_ptr<scheduler> sched)
+			: m_state_ptr(std::make_shared<state>())
+		{
+			m_state_ptr->op = std::move(op);
+			m_state_ptr->sched = std::move(sched);
+		}
+
+		/// create an awaitable which is already completed,co_await it will not suspend
+		static awaitable ready(T value)
+		{
+			awaitable a(nullptr, nullptr);
+			a.m_state_ptr->value = std::move(value);
+			a.m_state_ptr->done = true;
+			return a;
+		}
+
+		bool await_ready() const noexcept
+		{
+			return m_state_ptr->done;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			// [important] : the handler may be called before op returns,and the coroutine may be
+			// resumed and this awaitable may be destroyed at that time,so the handler holds the
+			// state by shared_ptr,and we must not access any member after op is called.
+			std::shared_ptr<state> state_ptr = m_state_ptr;
+			operation_type op = std::move(state_ptr->op);
+			op([state_ptr, handle](T value, std::exception_ptr ep) mutable
+			{
+				state_ptr->value = std::move(value);
+				state_ptr->ep = ep;
+				state_ptr->done = true;
+				if (state_ptr->sched)
+				{
+					state_ptr->sched->schedule(handle, [state_ptr, handle]() mutable
+					{
+						state_ptr->value = T{};
+						state_ptr->ep = std::make_exception_ptr(std::runtime_error("the scheduler is stopped."));
+						handle.resume();
+					});
+				}
+				else
+				{
+					handle.resume();
+				}
+			});
+		}
+
+		T await_resume()
+		{
+			if (m_state_ptr->ep)
+				std::rethrow_exception(m_state_ptr->ep);
+			return std::move(m_state_ptr->value);
+		}
+
+		/**
+		 * create an awaitable which run the blocking function in the executor.
+		 */
+		template<typename F>
+		static awaitable offload(std::shared_ptr<executor> executor_ptr, std::shared_ptr<scheduler> sched, F fn)
+		{
+			return awaitable([executor_ptr, fn](handler_type handler)
+			{
+				post_or_run(executor_ptr, [fn, handler]()
+				{
+					T value{};
+					std::exception_ptr ep;
+					try
+					{
+						value = fn();
+					}
+					catch (...)
+					{
+						ep = std::current_exception();
+					}
+					handler(std::move(value), ep);
+				}, [handler]()
+				{
+					handler(T{}, std::make_exception_ptr(std::runtime_error("the executor is stopped.")));
+				});
+			}, sched);
+		}
+
+	protected:
+		struct state
+		{
+			operation_type op;
+			std::shared_ptr<scheduler> sched;
+			T value{};
+			std::exception_ptr ep;
+			bool done = false;
+		};
+
+		std::shared_ptr<state> m_state_ptr;
+	};
+
+	/**
+	 * resultset wrapper whose rows are fetched by co_await next_batch().
+	 */
+	class async_resultset
+	{
+	public:
+		async_resultset()
+		{
+		}
+
+		async_resultset(std::shared_ptr<resultset> rs_ptr, std::shared_ptr<executor> executor_ptr, std::shared_ptr<scheduler> sched)
+			: m_rs_ptr(rs_ptr), m_executor_ptr(executor_ptr), m_sched(sched)
+		{
+		}
+
+		/**
+		 * fetch at most max_rows rows,the returned batch is empty when there are no more rows.
+		 * if the resultset is already in memory,the rows are copied without suspend.
+		 */
+		awaitable<std::shared_ptr<materialized_result>> next_batch(std::size_t max_rows = 1000)
+		{
+			std::shared_ptr<resultset> rs_ptr = m_rs_ptr;
+			auto fetch = [rs_ptr, max_rows]()
+			{
+				return materialized_result::materialize(rs_ptr, max_rows);
+			};
+
+			if (!rs_ptr || std::dynamic_pointer_cast<materialized_result>(rs_ptr))
+				return awaitable<std::shared_ptr<materialized_result>>::ready(fetch());
+
+			return awaitable<std::shared_ptr<materialized_result>>::offload(m_executor_ptr, m_sched, fetch);
+		}
+
+		std::shared_ptr<resultset> get()
+		{
+			return m_rs_ptr;
+		}
+
+		explicit operator bool() const
+		{
+			return (m_rs_ptr != nullptr);
+		}
+
+	protected:
+		std::shared_ptr<resultset> m_rs_ptr;
+		std::shared_ptr<executor> m_executor_ptr;
+		std::shared_ptr<scheduler> m_sched;
+	};
+
+	/**
+	 * connection wrapper whose operations are co_awaited.the backend's non-blocking api is used
+	 * if the backend has one,otherwise the blocking call is run in the executor of the pool.
+	 */
+	class async_connection
+	{
+	public:
+		async_connection()
+		{
+		}
+
+		async_connection(std::shared_ptr<connection> conn_ptr, std::shared_ptr<executor> executor_ptr, std::shared_ptr<scheduler> sched)
+			: m_conn_ptr(conn_ptr), m_executor_ptr(executor_ptr), m_sched(sched)
+		{
+		}
+
+		template<typename... Args>
+		awaitable<async_resultset> query(const char * sql, Args... args)
+		{
+			std::string str = _format(sql, args...);
+			std::shared_ptr<connection> conn_ptr = m_conn_ptr;
+			std::shared_ptr<executor> executor_ptr = m_executor_ptr;
+			std::shared_ptr<scheduler> sched = m_sched;
+
+			return awaitable<async_resultset>([conn_ptr, executor_ptr, sched, str](awaitable<async_resultset>::handler_type handler)
+			{
+				auto wrap = [conn_ptr, executor_ptr, sched, handler](std::shared_ptr<resultset> rs, std::exception_ptr ep)
+				{
+					if (!rs && !ep)
+						ep = std::make_exception_ptr(std::runtime_error(_last_error(conn_ptr)));
+					handler(async_resultset(rs, executor_ptr, sched), ep);
+				};
+
+				if (!conn_ptr)
+				{
+					handler(async_resultset(), std::make_exception_ptr(std::runtime_error("invalid connection.")));
+					return;
+				}
+
+				if (conn_ptr->query_nonblocking(str, wrap))
+					return;
+
+				post_or_run(executor_ptr, [conn_ptr, str, wrap]()
+				{
+					std::shared_ptr<resultset> rs;
+					std::exception_ptr ep;
+					try
+					{
+						rs = conn_ptr->query("%s", str.c_str());
+					}
+					catch (...)
+					{
+						ep = std::current_exception();
+					}
+					wrap(rs, ep);
+				}, [handler]()
+				{
+					handler(async_resultset(), std::make_exception_ptr(std::runtime_error("the executor is stopped.")));
+				});
+			}, m_sched);
+		}
+
+		/**
+		 * @return the rows changed by the statement
+		 */
+		template<typename... Args>
+		awaitable<int64_t> execute(const char * sql, Args... args)
+		{
+			std::string str = _format(sql, args...);
+			std::shared_ptr<connection> conn_ptr = m_conn_ptr;
+			std::shared_ptr<executor> executor_ptr = m_executor_ptr;
+
+			return awaitable<int64_t>([conn_ptr, executor_ptr, str](awaitable<int64_t>::handler_type handler)
+			{
+				if (!conn_ptr)
+				{
+					handler(0, std::make_exception_ptr(std::runtime_error("invalid connection.")));
+					return;
+				}
+
+				if (conn_ptr->execute_nonblocking(str, handler))
+					return;
+
+				post_or_run(executor_ptr, [conn_ptr, str, handler]()
+				{
+					int64_t rows = 0;
+					std::exception_ptr ep;
+					try
+					{
+						if (conn_ptr->execute("%s", str.c_str()))
+							rows = conn_ptr->rows_changed();
+						else
+							ep = std::make_exception_ptr(std::runtime_error(_last_error(conn_ptr)));
+					}
+					catch (...)
+					{
+						ep = std::current_exception();
+					}
+					handler(rows, ep);
+				}, [handler]()
+				{
+					handler(0, std::make_exception_ptr(std::runtime_error("the executor is stopped.")));
+				});
+			}, m_sched);
+		}
+
+		std::shared_ptr<connection> get()
+		{
+			return m_conn_ptr;
+		}
+
+		explicit operator bool() const
+		{
+			return (m_conn_ptr != nullptr);
+		}
+
+		/**
+		 * return the connection to the pool before this object is destroyed.
+		 */
+		void release()
+		{
+			m_conn_ptr.reset();
+		}
+
+	protected:
+		/// format the sql the same way as connection::query() does
+		static std::string _format(const char * sql, ...)
+		{
+			if (!sql || sql[0] == '\0')
+				return std::string();
+
+			va_list ap, ap_copy;
+			va_start(ap, sql);
+
+			va_copy(ap_copy, ap);
+			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
+			va_end(ap_copy);
+
+			std::string str(len > 0 ? len : 0, '\0');
+
+			va_copy(ap_copy, ap);
+			std::vsnprintf((char*)str.data(), str.size() + 1, sql, ap_copy);
+			va_end(ap_copy);
+
+			va_end(ap);
+
+			return str;
+		}
+
+		static std::string _last_error(std::shared_ptr<connection> conn_ptr)
+		{
+			const char * err = conn_ptr->get_last_error();
+			return ((err && err[0] != '\0') ? err : "unknown database error.");
+		}
+
+	protected:
+		std::shared_ptr<connection> m_conn_ptr;
+		std::shared_ptr<executor> m_executor_ptr;
+		std::shared_ptr<scheduler> m_sched;
+	};
+
+	/**
+	 * pool wrapper,eg :
+	 *   zdb2::async_pool apool(pool_ptr, sched);
+	 *   // suspended until a connection is returned if all the connections are in use
+	 *   auto conn = co_await apool.get();
+	 *   auto rs = co_await conn.query("select * from tbl_anchor where id > %d", 10);
+	 *   for (auto batch = co_await rs.next_batch(); batch->get_row_count() > 0; batch = co_await rs.next_batch()) {...}
+	 */
+	class async_pool
+	{
+	public:
+		async_pool(std::shared_ptr<pool> pool_ptr, std::shared_ptr<scheduler> sched = nullptr)
+			: m_pool_ptr(pool_ptr), m_sched(sched), m_waiters_ptr(std::make_shared<waiter_queue>())
+		{
+			if (!m_pool_ptr)
+				throw std::runtime_error("invalid parameters.");
+
+			// the listener holds the queue by weak_ptr,the queue owns the listener
+			std::weak_ptr<waiter_queue> waiters_wptr = m_waiters_ptr;
+			m_waiters_ptr->listener = std::make_shared<std::function<void()>>([waiters_wptr]()
+			{
+				if (std::shared_ptr<waiter_queue> waiters_ptr = waiters_wptr.lock())
+					_wake_one(waiters_ptr);
+			});
+			m_pool_ptr->add_return_listener(m_waiters_ptr->listener);
+		}
+
+		/**
+		 * get a connection from the pool,a new connection may need to connect to the database
+		 * server,so it's run in the executor of the pool.if all the connections are in use,the
+		 * coroutine is suspended until a connection is returned to the pool.if the connection is
+		 * failed to open,or the async_pool is destroyed while waiting,the co_await throws a
+		 * std::runtime_error.
+		 */
+		awaitable<async_connection> get()
+		{
+			std::shared_ptr<pool> pool_ptr = m_pool_ptr;
+			std::shared_ptr<scheduler> sched = m_sched;
+			std::shared_ptr<waiter_queue> waiters_ptr = m_waiters_ptr;
+
+			return awaitable<async_connection>([pool_ptr, sched, waiters_ptr](awaitable<async_connection>::handler_type handler)
+			{
+				_try_get(pool_ptr, sched, waiters_ptr, handler);
+			}, sched);
+		}
+
+		/**
+		 * get the count of the coroutines which are waiting for a connection.
+		 */
+		std::size_t get_waiting_count()
+		{
+			std::lock_guard<std::mutex> g(m_waiters_ptr->mtx);
+			return m_waiters_ptr->waiters.size();
+		}
+
+		std::shared_ptr<pool> get_pool()
+		{
+			return m_pool_ptr;
+		}
+
+	protected:
+		struct waiter_queue
+		{
+			std::mutex mtx;
+
+			/// every waiter retries to get a connection,a waiter which is destroyed without being
+			/// called completes the co_await with an error
+			std::deque<std::function<void()>> waiters;
+
+			/// added to the pool,wake up a waiter when a connection is returned
+			std::shared_ptr<std::function<void()>> listener;
+		};
+
+		static void _try_get(std::shared_ptr<pool> pool_ptr, std::shared_ptr<scheduler> sched,
+			std::shared_ptr<waiter_queue> waiters_ptr, awaitable<async_connection>::handler_type handler)
+		{
+			std::shared_ptr<executor> executor_ptr = pool_ptr->get_executor();
+
+			post_or_run(executor_ptr, [pool_ptr, executor_ptr, sched, waiters_ptr, handler]()
+			{
+				bool exhausted = false;
+				std::shared_ptr<connection> conn_ptr;
+				try
+				{
+					conn_ptr = pool_ptr->try_get(exhausted);
+				}
+				catch (...)
+				{
+					handler(async_connection(), std::current_exception());
+					return;
+				}
+
+				if (conn_ptr)
+				{
+					handler(async_connection(conn_ptr, executor_ptr, sched), nullptr);
+					return;
+				}
+
+				if (!exhausted)
+				{
+					handler(async_connection(), std::make_exception_ptr(std::runtime_error("can't open a new connection.")));
+					return;
+				}
+
+				// all the connections are in use,wait until a connection is returned.the waiter holds
+				// the queue by weak_ptr,so the waiters are destroyed with the async_pool
+				std::weak_ptr<waiter_queue> waiters_wptr = waiters_ptr;
+				std::shared_ptr<task_guard> guard = std::make_shared<task_guard>([handler]()
+				{
+					handler(async_connection(), std::make_exception_ptr(std::runtime_error("the async pool is destroyed.")));
+				});
+
+				{
+					std::lock_guard<std::mutex> g(waiters_ptr->mtx);
+					waiters_ptr->waiters.emplace_back([pool_ptr, sched, waiters_wptr, handler, guard]()
+					{
+						guard->release();
+						if (std::shared_ptr<waiter_queue> waiters_ptr = waiters_wptr.lock())
+							_try_get(pool_ptr, sched, waiters_ptr, handler);
+						else
+							handler(async_connection(), std::make_exception_ptr(std::runtime_error("the async pool is destroyed.")));
+					});
+				}
+
+				// the connection may be returned before the waiter is queued,and nobody wakes it up
+				if (pool_ptr->get_idle_count() > 0 || pool_ptr->get_using_count() < pool_ptr->get_max_conn_count())
+					_wake_one(waiters_ptr);
+			}, [handler]()
+			{
+				handler(async_connection(), std::make_exception_ptr(std::runtime_error("the executor is stopped.")));
+			});
+		}
+
+		static void _wake_one(std::shared_ptr<waiter_queue> waiters_ptr)
+		{
+			std::function<void()> waiter;
+			{
+				std::lock_guard<std::mutex> g(waiters_ptr->mtx);
+				if (waiters_ptr->waiters.empty())
+					return;
+				waiter = std::move(waiters_ptr->waiters.front());
+				waiters_ptr->waiters.pop_front();
+			}
+			waiter();
+		}
+
+	protected:
+		std::shared_ptr<pool> m_pool_ptr;
+		std::shared_ptr<scheduler> m_sched;
+		std::shared_ptr<waiter_queue> m_waiters_ptr;
+	};
+
+}
+
+#endif // ZDB2_HAS_COROUTINE
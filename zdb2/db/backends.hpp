@@ -0,0 +1,69 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+/**
+ * Include the database backends which are compiled into the application,every included backend
+ * registers itself to zdb2::registry and needs it's client library when linking.
+ *
+ * By default all the backends are included,define one or more of the macros below before
+ * including zdb2 to select the backends,eg : only sqlite is linked
+ *
+ * #define ZDB2_USE_SQLITE
+ * #include <zdb2/zdb.hpp>
+ *
+ * ZDB2_USE_SQLITE     : sqlite3
+ * ZDB2_USE_MYSQL      : libmysqlclient or the MariaDB Connector/C
+ * ZDB2_USE_POSTGRESQL : libpq
+ * ZDB2_USE_ODBC       : unixODBC on linux,odbc32 on windows
+ * ZDB2_USE_SQLSERVER  : same as ZDB2_USE_ODBC
+ * ZDB2_USE_NULL       : no library,the simulated database for the benchmarks,it's not included
+ *                       by default
+ *
+ * Define ZDB2_USE_PLUGINS only (without any other macros) to include no backend,then all the
+ * backends are loaded from the plugins at the first time they are used,see zdb2/db/registry.hpp.
+ */
+
+#if !defined(ZDB2_USE_SQLITE) && !defined(ZDB2_USE_MYSQL) && !defined(ZDB2_USE_POSTGRESQL) && \
+	!defined(ZDB2_USE_ODBC) && !defined(ZDB2_USE_SQLSERVER) && !defined(ZDB2_USE_NULL) && \
+	!defined(ZDB2_USE_PLUGINS)
+#	define ZDB2_USE_SQLITE
+#	define ZDB2_USE_MYSQL
+#	define ZDB2_USE_POSTGRESQL
+#	define ZDB2_USE_ODBC
+#	define ZDB2_USE_SQLSERVER
+#endif
+
+#include <zdb2/db/registry.hpp>
+
+#if defined(ZDB2_USE_SQLITE)
+#	include <zdb2/db/sqlite/sqlite_connection.hpp>
+#endif
+
+#if defined(ZDB2_USE_MYSQL)
+#	include <zdb2/db/mysql/mysql_async_connection.hpp>
+#endif
+
+#if defined(ZDB2_USE_POSTGRESQL)
+#	include <zdb2/db/postgresql/postgresql_connection.hpp>
+#endif
+
+#if defined(ZDB2_USE_ODBC)
+#	include <zdb2/db/odbc/odbc_connection.hpp>
+#endif
+
+#if defined(ZDB2_USE_SQLSERVER)
+#	include <zdb2/db/sqlserver/sqlserver_connection.hpp>
+#endif
+
+#if defined(ZDB2_USE_NULL)
+#	include <zdb2/db/null/null_connection.hpp>
+#endif
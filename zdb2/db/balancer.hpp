@@ -0,0 +1,344 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <random>
+
+#include <zdb2/net/url.hpp>
+#include <zdb2/db/connection.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * Select the host for the new connections of a pool which url has a host list,eg :
+	 * mysql://db1:3306,db2:3306,db3:3306/test?user=root&password=swordfish&lb=least_conn
+	 *
+	 * url params :
+	 * lb             : the selection policy of the healthy hosts
+	 *                  round_robin (default) - the hosts are used in turn
+	 *                  least_conn            - the host which has the fewest open connections
+	 *                  latency               - random,weighted by 1 / average latency of the host
+	 * eject-time     : milliseconds a host is ejected after the first failure,default 1000,it is
+	 *                  doubled by every consecutive failure
+	 * max-eject-time : the upper limit of the eject time in milliseconds,default 30000
+	 * probe-interval : milliseconds between two checks of the ejected hosts,default 500
+	 *
+	 * A host is ejected when a connection to it can't be opened or a ping of it's connection is
+	 * failed,the ejected host is not selected until the pool probes it successfully,and the idle
+	 * connections to it are closed by the pool.
+	 */
+	class balancer
+	{
+	public:
+
+		enum policy
+		{
+			round_robin,
+			least_conn,
+			latency,
+		};
+
+		balancer(std::shared_ptr<url> url_ptr)
+		{
+			std::vector<std::pair<std::string, std::string>> hosts = url_ptr->get_hosts();
+			if (hosts.empty())
+				throw std::runtime_error("invalid parameters.");
+
+			for (std::size_t i = 0; i < hosts.size(); i++)
+			{
+				m_hosts.emplace_back();
+				m_hosts.back().url_ptr = url_ptr->get_host_url(i);
+			}
+
+			std::string lb = url_ptr->get_param_value("lb");
+			if (lb == "least_conn")
+				m_policy = least_conn;
+			else if (lb == "latency")
+				m_policy = latency;
+			else if (!lb.empty() && lb != "round_robin")
+				throw std::runtime_error("unknown load balancing policy.");
+
+			std::string value = url_ptr->get_param_value("eject-time");
+			if (!value.empty())
+				m_eject_time = std::chrono::milliseconds(std::strtoull(value.c_str(), nullptr, 10));
+
+			value = url_ptr->get_param_value("max-eject-time");
+			if (!value.empty())
+				m_max_eject_time = std::chrono::milliseconds(std::strtoull(value.c_str(), nullptr, 10));
+
+			value = url_ptr->get_param_value("probe-interval");
+			if (!value.empty())
+				m_probe_interval = std::chrono::milliseconds(std::strtoull(value.c_str(), nullptr, 10));
+
+			m_random.seed(std::random_device()());
+		}
+
+		std::size_t get_host_count()
+		{
+			return m_hosts.size();
+		}
+
+		std::shared_ptr<url> get_host_url(std::size_t index)
+		{
+			return m_hosts[index].url_ptr;
+		}
+
+		std::chrono::milliseconds get_probe_interval()
+		{
+			return m_probe_interval;
+		}
+
+		/**
+		 * Select a healthy host by the policy.
+		 * @return The host index,or -1 if all the hosts are ejected
+		 */
+		int select()
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+
+			const std::size_t count = m_hosts.size();
+
+			if (m_policy == round_robin)
+			{
+				for (std::size_t n = 0; n < count; n++)
+				{
+					std::size_t i = (m_next++) % count;
+					if (m_hosts[i].failures == 0)
+						return (int)i;
+				}
+				return -1;
+			}
+
+			if (m_policy == least_conn)
+			{
+				int best = -1;
+				for (std::size_t n = 0; n < count; n++)
+				{
+					// begin with a different host every time,so the hosts which have the same count
+					// are used in turn
+					std::size_t i = (m_next + n) % count;
+					if (m_hosts[i].failures > 0)
+						continue;
+					if (best < 0 || m_hosts[i].connections < m_hosts[best].connections)
+						best = (int)i;
+				}
+				m_next++;
+				return best;
+			}
+
+			// latency weighted,the host which has no sample yet is weighted as the fastest host,so
+			// it gets a sample soon
+			double min_latency = 0;
+			for (auto & host : m_hosts)
+			{
+				if (host.failures == 0 && host.latency_us > 0 && (min_latency == 0 || host.latency_us < min_latency))
+					min_latency = host.latency_us;
+			}
+			if (min_latency == 0)
+				min_latency = 1;
+
+			double total = 0;
+			std::vector<double> weights(count, 0);
+			for (std::size_t i = 0; i < count; i++)
+			{
+				if (m_hosts[i].failures > 0)
+					continue;
+				weights[i] = 1.0 / (m_hosts[i].latency_us > 0 ? m_hosts[i].latency_us : min_latency);
+				total += weights[i];
+			}
+			if (total <= 0)
+				return -1;
+
+			double r = std::uniform_real_distribution<double>(0, total)(m_random);
+			for (std::size_t i = 0; i < count; i++)
+			{
+				if (weights[i] <= 0)
+					continue;
+				if (r < weights[i])
+					return (int)i;
+				r -= weights[i];
+			}
+			for (std::size_t i = count; i > 0; i--)
+			{
+				if (weights[i - 1] > 0)
+					return (int)(i - 1);
+			}
+			return -1;
+		}
+
+		/**
+		 * Get the ejected hosts which should be probed now,the hosts are marked as probing until
+		 * on_success or on_failure is called,so a host is probed by one thread at the same time.
+		 */
+		std::vector<std::size_t> get_probe_hosts()
+		{
+			std::vector<std::size_t> hosts;
+
+			std::lock_guard<std::mutex> g(m_mtx);
+			auto now = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < m_hosts.size(); i++)
+			{
+				if (m_hosts[i].failures > 0 && m_hosts[i].ejected_until <= now && !m_hosts[i].probing)
+				{
+					m_hosts[i].probing = true;
+					hosts.emplace_back(i);
+				}
+			}
+			return hosts;
+		}
+
+		bool is_ejected(std::size_t index)
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			return (m_hosts[index].failures > 0);
+		}
+
+		/**
+		 * A connection to the host is opened or a probe is succeeded.
+		 * @param elapsed The time of the connecting or the ping
+		 */
+		void on_success(std::size_t index, std::chrono::steady_clock::duration elapsed)
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			host & h = m_hosts[index];
+			h.failures = 0;
+			h.probing = false;
+			h.ejected_until = std::chrono::steady_clock::time_point();
+			_sample(h, elapsed);
+		}
+
+		/**
+		 * A connection to the host can't be opened or a ping is failed,eject the host.
+		 */
+		void on_failure(std::size_t index)
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			host & h = m_hosts[index];
+
+			// the host is ejected already,the other connections to it are failed too
+			if (h.failures > 0 && !h.probing)
+				return;
+
+			h.probing = false;
+			h.failures = (std::min)(h.failures + 1, (std::size_t)30);
+
+			std::chrono::milliseconds eject = m_eject_time;
+			for (std::size_t i = 1; i < h.failures && eject < m_max_eject_time; i++)
+				eject *= 2;
+			eject = (std::min)(eject, m_max_eject_time);
+
+			h.ejected_until = std::chrono::steady_clock::now() + eject;
+		}
+
+		/**
+		 * Record the latency of the host,eg : the time of a ping.
+		 */
+		void on_latency(std::size_t index, std::chrono::steady_clock::duration elapsed)
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			_sample(m_hosts[index], elapsed);
+		}
+
+		/**
+		 * Bind an opened connection to the host.
+		 */
+		void attach(connection * conn, std::size_t index)
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			m_connections[conn] = index;
+			m_hosts[index].connections++;
+		}
+
+		/**
+		 * Unbind a connection which is closed.
+		 */
+		void detach(connection * conn)
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			auto it = m_connections.find(conn);
+			if (it == m_connections.end())
+				return;
+			m_hosts[it->second].connections--;
+			m_connections.erase(it);
+		}
+
+		/**
+		 * Get the host index of a connection.
+		 * @return The host index,or -1 if the connection is not attached
+		 */
+		int host_of(connection * conn)
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			auto it = m_connections.find(conn);
+			return (it == m_connections.end() ? -1 : (int)it->second);
+		}
+
+	protected:
+
+		struct host
+		{
+			std::shared_ptr<url> url_ptr;
+
+			/// the open connections to the host
+			std::size_t connections = 0;
+
+			/// the consecutive failures,the host is ejected when it's greater than 0
+			std::size_t failures = 0;
+
+			/// the host is not probed before this time
+			std::chrono::steady_clock::time_point ejected_until;
+
+			/// a probe of the host is running
+			bool probing = false;
+
+			/// the moving average of the latency in microseconds
+			double latency_us = 0;
+		};
+
+		static void _sample(host & h, std::chrono::steady_clock::duration elapsed)
+		{
+			double us = (double)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+			if (us < 1)
+				us = 1;
+			h.latency_us = (h.latency_us == 0 ? us : h.latency_us * 0.8 + us * 0.2);
+		}
+
+	protected:
+
+		std::mutex m_mtx;
+
+		std::vector<host> m_hosts;
+
+		std::unordered_map<connection *, std::size_t> m_connections;
+
+		policy m_policy = round_robin;
+
+		std::size_t m_next = 0;
+
+		std::chrono::milliseconds m_eject_time{ 1000 };
+		std::chrono::milliseconds m_max_eject_time{ 30000 };
+		std::chrono::milliseconds m_probe_interval{ 500 };
+
+		std::mt19937 m_random;
+
+	};
+
+}
@@ -0,0 +1,107 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdio>
+#include <cstdarg>
+#include <string>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+
+#include <zdb2/db/connection.hpp>
+#include <zdb2/db/batch_result.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * Queue several independent statements on a connection and send them together,eg :
+	 *
+	 * zdb2::batch b(conn_ptr);
+	 * b.add("insert into user(name) values('%s')", name);
+	 * b.add("update counter set n = n + 1 where id = %d", id);
+	 * b.add("select n from counter where id = %d", id);
+	 * std::vector<zdb2::batch_result> results = b.execute();
+	 *
+	 * The results are returned in the same order as the statements are added.MySQL sends all
+	 * the statements in one round trip,the other backends execute them one by one.
+	 */
+	class batch
+	{
+	public:
+		explicit batch(std::shared_ptr<connection> conn_ptr) : m_conn_ptr(conn_ptr)
+		{
+			if (!m_conn_ptr)
+				throw std::runtime_error("invalid parameters.");
+		}
+
+		virtual ~batch()
+		{
+		}
+
+		/**
+		 * Add a statement to the batch,the sql is a format string as connection::execute().
+		 * Each call must add exactly one statement.
+		 */
+		batch & add(const char * sql, ...)
+		{
+			if (!sql || sql[0] == '\0')
+				return (*this);
+
+			va_list ap, ap_copy;
+			va_start(ap, sql);
+
+			va_copy(ap_copy, ap);
+			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
+
+			std::string str(len, '\0');
+
+			va_copy(ap_copy, ap);
+			std::vsprintf((char*)str.data(), sql, ap_copy);
+
+			va_end(ap);
+
+			m_sqls.emplace_back(std::move(str));
+
+			return (*this);
+		}
+
+		/**
+		 * Execute all the queued statements,the queue is empty after that.
+		 * @return The results of the statements,in the order they are added
+		 */
+		std::vector<batch_result> execute()
+		{
+			std::vector<std::string> sqls;
+			sqls.swap(m_sqls);
+			return m_conn_ptr->execute_batch(sqls);
+		}
+
+		std::size_t size()
+		{
+			return m_sqls.size();
+		}
+
+		void clear()
+		{
+			m_sqls.clear();
+		}
+
+	protected:
+
+		std::shared_ptr<connection> m_conn_ptr;
+
+		std::vector<std::string> m_sqls;
+
+	};
+
+}
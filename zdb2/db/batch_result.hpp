@@ -0,0 +1,41 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <memory>
+
+#include <zdb2/db/materialized_result.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * The result of one statement of a batch,see connection::execute_batch().
+	 */
+	struct batch_result
+	{
+		/// whether the statement is executed successfully
+		bool ok = false;
+
+		/// the error message if the statement is failed or not executed
+		std::string error;
+
+		/// the rows changed and the last insert rowid after the statement is executed
+		int64_t rows_changed = 0;
+		int64_t last_rowid = 0;
+
+		/// the rows returned by the statement,nullptr if the statement doesn't return a result set
+		std::shared_ptr<materialized_result> rows;
+	};
+
+}
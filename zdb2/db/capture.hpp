@@ -0,0 +1,505 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <stdexcept>
+
+#include <zdb2/db/connection.hpp>
+#include <zdb2/db/hooks.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * Capture the statements of the application into a binary file,the file can be replayed
+	 * against a database by bench/zdb2_replay.cpp,eg :
+	 *
+	 * auto capture_ptr = std::make_shared<zdb2::capture>("/tmp/app.zcap");
+	 * zdb2::hooks::install(capture_ptr);
+	 * ...
+	 * zdb2::hooks::install(nullptr);
+	 * capture_ptr->stop();
+	 *
+	 * Every statement is recorded with it's start time,duration,connection,SQL and the parameters
+	 * of the PreparedStatement,the checkouts,the returns and the transactions of the connections
+	 * are recorded too,so the replay can keep the interleaving of the connections.The SQL text is
+	 * written once and referenced by an id,the numbers are written as varints.
+	 *
+	 * The records are appended under a lock and written to the file when the buffer is full,so
+	 * the capture costs much more than the stats,use it for a while,not all the time.The file
+	 * is complete only after stop() is called,the installed hooks are never destroyed.
+	 */
+	class capture : public hooks
+	{
+	public:
+
+		enum
+		{
+			/// the record types of the file
+			SQL       = 1,
+			STATEMENT = 2,
+			BEGIN     = 3,
+			COMMIT    = 4,
+			ROLLBACK  = 5,
+			CHECKOUT  = 6,
+			RETURN    = 7,
+
+			VERSION = 1,
+
+			/// the buffer is written to the file when it's larger than this
+			BUFFER_SIZE = 256 * 1024,
+
+			/// the SQL ids are forgotten when there are too many,eg : the parameters are in the SQL
+			/// text,then the SQL is written again when it's used again
+			MAX_SQL_IDS = 100000,
+		};
+
+		/**
+		 * a record read from the file by load().
+		 */
+		struct record
+		{
+			int type = STATEMENT;
+
+			/// the id of the connection,the ids are given in the order of the first events
+			uint32_t conn_id = 0;
+
+			/// the microseconds from the start of the capture,it's the start time of a statement
+			uint64_t offset_us = 0;
+
+			uint64_t duration_us = 0;
+
+			int64_t rows = 0;
+
+			bool ok = true;
+
+			/// the SQL of STATEMENT,the records of the same SQL share it
+			std::shared_ptr<const std::string> sql;
+
+			/// the parameters of a PreparedStatement,empty if the statement is not prepared
+			std::vector<hook_param> params;
+		};
+
+		/**
+		 * @param path The file is created or truncated
+		 */
+		capture(const std::string & path)
+		{
+			m_file = std::fopen(path.c_str(), "wb");
+			if (!m_file)
+				throw std::runtime_error("can't open the capture file " + path);
+
+			m_begin = std::chrono::steady_clock::now();
+
+			m_buffer.append(_magic(), 8);
+			_put_varint(m_buffer, VERSION);
+			_put_varint(m_buffer, (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count());
+		}
+
+		virtual ~capture()
+		{
+			stop();
+		}
+
+		/**
+		 * Write the records in the buffer and close the file,the later events are ignored.
+		 */
+		void stop()
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			if (!m_file)
+				return;
+			_write();
+			std::fclose(m_file);
+			m_file = nullptr;
+		}
+
+		/**
+		 * Write the records in the buffer to the file.
+		 */
+		void flush()
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			if (!m_file)
+				return;
+			_write();
+			std::fflush(m_file);
+		}
+
+		/**
+		 * Get the count of the recorded statements.
+		 */
+		uint64_t get_count()
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			return m_count;
+		}
+
+		/**
+		 * Get the bytes of the file,including the buffer which is not written yet.
+		 */
+		uint64_t get_size()
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			return m_written + m_buffer.size();
+		}
+
+		virtual void on_checkout(hook_event & ev) override { _add(CHECKOUT, ev); }
+
+		virtual void on_return(hook_event & ev) override { _add(RETURN, ev); }
+
+		virtual void on_txn_begin(hook_event & ev) override { if (ev.ok) _add(BEGIN, ev); }
+
+		virtual void on_txn_commit(hook_event & ev) override { _add(COMMIT, ev); }
+
+		virtual void on_txn_rollback(hook_event & ev) override { _add(ROLLBACK, ev); }
+
+		virtual void on_query_end(hook_event & ev) override
+		{
+			if (!ev.conn || !ev.sql)
+				return;
+
+			// the start time of the statement,the replay starts it at the same time
+			uint64_t offset_us = _offset_us(ev.time);
+			offset_us = (offset_us > ev.duration_us ? offset_us - ev.duration_us : 0);
+
+			std::lock_guard<std::mutex> g(m_mtx);
+			if (!m_file)
+				return;
+
+			uint64_t sql_id = _sql_id(ev.sql);
+
+			m_buffer.push_back((char)STATEMENT);
+			_put_varint(m_buffer, _conn_id(ev.conn));
+			_put_varint(m_buffer, offset_us);
+			_put_varint(m_buffer, ev.duration_us);
+			_put_varint(m_buffer, (uint64_t)(ev.rows > 0 ? ev.rows : 0));
+			m_buffer.push_back((char)(ev.ok ? 1 : 0));
+			_put_varint(m_buffer, sql_id);
+
+			std::size_t count = (ev.params ? ev.params->size() : 0);
+			_put_varint(m_buffer, count);
+			for (std::size_t i = 0; i < count; i++)
+				_put_param(m_buffer, (*ev.params)[i]);
+
+			m_count++;
+			if (m_buffer.size() >= BUFFER_SIZE)
+				_write();
+		}
+
+		/**
+		 * Read all the records of a capture file,the last record which is not written completely
+		 * (eg : the application is killed) is ignored.
+		 */
+		static std::vector<record> load(const std::string & path)
+		{
+			std::string data;
+			FILE * fp = std::fopen(path.c_str(), "rb");
+			if (!fp)
+				throw std::runtime_error("can't open the capture file " + path);
+			char buf[64 * 1024];
+			std::size_t n;
+			while ((n = std::fread(buf, 1, sizeof(buf), fp)) > 0)
+				data.append(buf, n);
+			std::fclose(fp);
+
+			if (data.size() < 8 || std::memcmp(data.data(), _magic(), 8) != 0)
+				throw std::runtime_error(path + " is not a capture file.");
+
+			reader r(data, 8);
+			uint64_t version = 0, start_time = 0;
+			if (!r.varint(version) || !r.varint(start_time) || version != VERSION)
+				throw std::runtime_error(path + " is of an unsupported version.");
+
+			std::vector<record> records;
+			std::unordered_map<uint64_t, std::shared_ptr<const std::string>> sqls;
+			while (!r.eof())
+			{
+				int type = (unsigned char)data[r.pos++];
+				if (type == SQL)
+				{
+					uint64_t id = 0;
+					std::string text;
+					if (!r.varint(id) || !r.bytes(text))
+						break;
+					sqls[id] = std::make_shared<const std::string>(std::move(text));
+					continue;
+				}
+
+				record rec;
+				rec.type = type;
+				uint64_t conn_id = 0;
+				if (!r.varint(conn_id) || !r.varint(rec.offset_us))
+					break;
+				rec.conn_id = (uint32_t)conn_id;
+
+				if (type == STATEMENT)
+				{
+					uint64_t rows = 0, sql_id = 0, count = 0;
+					if (!r.varint(rec.duration_us) || !r.varint(rows) || r.eof())
+						break;
+					rec.rows = (int64_t)rows;
+					rec.ok = (data[r.pos++] != 0);
+					if (!r.varint(sql_id) || !r.varint(count))
+						break;
+
+					auto it = sqls.find(sql_id);
+					if (it == sqls.end())
+						throw std::runtime_error(path + " is damaged,the SQL of a statement is not found.");
+					rec.sql = it->second;
+
+					bool complete = true;
+					for (uint64_t i = 0; i < count && complete; i++)
+					{
+						hook_param p;
+						complete = r.param(p);
+						rec.params.emplace_back(std::move(p));
+					}
+					if (!complete)
+						break;
+				}
+				else if (type < BEGIN || type > RETURN)
+				{
+					throw std::runtime_error(path + " is damaged,unknown record type.");
+				}
+
+				records.emplace_back(std::move(rec));
+			}
+			return records;
+		}
+
+	protected:
+
+		/**
+		 * decode the varints,every function returns false if the data is truncated.
+		 */
+		struct reader
+		{
+			const std::string & data;
+			std::size_t pos;
+
+			reader(const std::string & d, std::size_t p) : data(d), pos(p)
+			{
+			}
+
+			bool eof() const
+			{
+				return pos >= data.size();
+			}
+
+			bool varint(uint64_t & v)
+			{
+				v = 0;
+				for (int shift = 0; shift < 64; shift += 7)
+				{
+					if (eof())
+						return false;
+					unsigned char c = (unsigned char)data[pos++];
+					v |= ((uint64_t)(c & 0x7f) << shift);
+					if (!(c & 0x80))
+						return true;
+				}
+				return false;
+			}
+
+			bool bytes(std::string & s)
+			{
+				uint64_t len = 0;
+				if (!varint(len) || data.size() - pos < len)
+					return false;
+				s.assign(data, pos, (std::size_t)len);
+				pos += (std::size_t)len;
+				return true;
+			}
+
+			bool param(hook_param & p)
+			{
+				if (eof())
+					return false;
+				p.type = (unsigned char)data[pos++];
+
+				uint64_t v = 0;
+				switch (p.type)
+				{
+				case hook_param::NONE:
+					return true;
+				case hook_param::STRING:
+				case hook_param::BLOB:
+					return bytes(p.s);
+				case hook_param::DOUBLE:
+					if (!varint(v))
+						return false;
+					std::memcpy(&p.d, &v, sizeof(double));
+					return true;
+				default:
+					if (!varint(v))
+						return false;
+					p.i = _unzigzag(v);
+					return true;
+				}
+			}
+		};
+
+		static const char * _magic()
+		{
+			return "ZDB2CAP\n";
+		}
+
+		void _add(int type, hook_event & ev)
+		{
+			if (!ev.conn)
+				return;
+
+			// the start time of the BEGIN,COMMIT or ROLLBACK statement,the duration of the checkout
+			// and the return is the time before the event
+			uint64_t offset_us = _offset_us(ev.time);
+			if (type == BEGIN || type == COMMIT || type == ROLLBACK)
+				offset_us = (offset_us > ev.duration_us ? offset_us - ev.duration_us : 0);
+
+			std::lock_guard<std::mutex> g(m_mtx);
+			if (!m_file)
+				return;
+
+			m_buffer.push_back((char)type);
+			_put_varint(m_buffer, _conn_id(ev.conn));
+			_put_varint(m_buffer, offset_us);
+
+			if (m_buffer.size() >= BUFFER_SIZE)
+				_write();
+		}
+
+		uint64_t _offset_us(std::chrono::steady_clock::time_point time)
+		{
+			if (time <= m_begin)
+				return 0;
+			return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(time - m_begin).count();
+		}
+
+		/// must be called under the lock
+		uint64_t _conn_id(connection * conn)
+		{
+			auto it = m_conn_ids.find(conn);
+			if (it != m_conn_ids.end())
+				return it->second;
+			uint64_t id = m_conn_ids.size() + 1;
+			m_conn_ids.emplace(conn, id);
+			return id;
+		}
+
+		/// must be called under the lock,the SQL is written when it's not written yet
+		uint64_t _sql_id(const char * sql)
+		{
+			auto it = m_sql_ids.find(sql);
+			if (it != m_sql_ids.end())
+				return it->second;
+
+			if (m_sql_ids.size() >= MAX_SQL_IDS)
+				m_sql_ids.clear();
+
+			uint64_t id = ++m_next_sql_id;
+			std::size_t len = std::strlen(sql);
+			m_buffer.push_back((char)SQL);
+			_put_varint(m_buffer, id);
+			_put_varint(m_buffer, len);
+			m_buffer.append(sql, len);
+
+			m_sql_ids.emplace(std::string(sql, len), id);
+			return id;
+		}
+
+		/// must be called under the lock,so the records are written in order
+		void _write()
+		{
+			if (m_buffer.empty())
+				return;
+			std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+			m_written += m_buffer.size();
+			m_buffer.clear();
+		}
+
+		static void _put_varint(std::string & buf, uint64_t v)
+		{
+			while (v >= 0x80)
+			{
+				buf.push_back((char)((v & 0x7f) | 0x80));
+				v >>= 7;
+			}
+			buf.push_back((char)v);
+		}
+
+		static uint64_t _zigzag(int64_t v)
+		{
+			return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+		}
+
+		static int64_t _unzigzag(uint64_t v)
+		{
+			return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+		}
+
+		static void _put_param(std::string & buf, const hook_param & p)
+		{
+			buf.push_back((char)p.type);
+			switch (p.type)
+			{
+			case hook_param::NONE:
+				break;
+			case hook_param::STRING:
+			case hook_param::BLOB:
+				_put_varint(buf, p.s.size());
+				buf.append(p.s);
+				break;
+			case hook_param::DOUBLE:
+			{
+				uint64_t v = 0;
+				std::memcpy(&v, &p.d, sizeof(double));
+				_put_varint(buf, v);
+				break;
+			}
+			default:
+				_put_varint(buf, _zigzag(p.i));
+				break;
+			}
+		}
+
+	protected:
+
+		std::mutex m_mtx;
+
+		FILE * m_file = nullptr;
+
+		std::chrono::steady_clock::time_point m_begin;
+
+		/// the records which are not written to the file yet
+		std::string m_buffer;
+
+		uint64_t m_written = 0;
+
+		uint64_t m_count = 0;
+
+		std::unordered_map<connection *, uint64_t> m_conn_ids;
+
+		std::unordered_map<std::string, uint64_t> m_sql_ids;
+
+		uint64_t m_next_sql_id = 0;
+	};
+
+}
@@ -0,0 +1,205 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace zdb2
+{
+
+	/**
+	 * A batch of rows stored column by column,every column is a contiguous array of the same
+	 * type,so the values can be consumed without the per value virtual calls of the ResultSet.
+	 * The integer like types (bool,integer,date,time and timestamp) are stored as int64_t,the
+	 * floating point types as double,and all the other types as bytes.The batch can be reused
+	 * by clear(),the memory of the columns is kept.
+	 */
+	class column_batch
+	{
+	public:
+		enum column_type
+		{
+			type_int64,
+			type_double,
+			type_bytes,
+		};
+
+		struct column
+		{
+			std::string name;
+			column_type type = type_bytes;
+
+			/// the values of type_int64 and type_double,one value per row
+			std::vector<int64_t> ints;
+			std::vector<double> doubles;
+
+			/// the values of type_bytes,the value of row i is bytes[offsets[i],offsets[i+1])
+			std::string bytes;
+			std::vector<std::size_t> offsets;
+
+			/// one flag per row,not zero means SQL NULL
+			std::vector<char> nulls;
+		};
+
+		column_batch()
+		{
+		}
+
+		virtual ~column_batch()
+		{
+		}
+
+		/**
+		 * Add a column,all the columns must be added before the first row is added.
+		 */
+		void add_column(const std::string & name, column_type type)
+		{
+			if (m_row_count > 0)
+				throw std::runtime_error("columns must be added before rows.");
+
+			m_columns.emplace_back();
+			m_columns.back().name = name;
+			m_columns.back().type = type;
+			m_columns.back().offsets.emplace_back(0);
+		}
+
+		std::size_t get_column_count()
+		{
+			return m_columns.size();
+		}
+
+		std::size_t get_row_count()
+		{
+			return m_row_count;
+		}
+
+		column & get_column(std::size_t column_index)
+		{
+			return m_columns.at(column_index);
+		}
+
+		/**
+		 * Remove all the rows,the columns and the allocated memory are kept.
+		 */
+		void clear()
+		{
+			for (auto & col : m_columns)
+			{
+				col.ints.clear();
+				col.doubles.clear();
+				col.bytes.clear();
+				col.offsets.resize(1);
+				col.nulls.clear();
+			}
+			m_row_count = 0;
+		}
+
+		void reserve(std::size_t rows)
+		{
+			for (auto & col : m_columns)
+			{
+				if (col.type == type_int64)
+					col.ints.reserve(rows);
+				else if (col.type == type_double)
+					col.doubles.reserve(rows);
+				else
+					col.offsets.reserve(rows + 1);
+				col.nulls.reserve(rows);
+			}
+		}
+
+		/** @name Reading */
+		//@{
+
+		bool is_null(std::size_t column_index, std::size_t row)
+		{
+			return (m_columns[column_index].nulls[row] != 0);
+		}
+
+		int64_t get_int64(std::size_t column_index, std::size_t row)
+		{
+			return m_columns[column_index].ints[row];
+		}
+
+		double get_double(std::size_t column_index, std::size_t row)
+		{
+			return m_columns[column_index].doubles[row];
+		}
+
+		/**
+		 * Returns the bytes of a type_bytes value,it is not terminated by '\0'.
+		 */
+		const char * get_bytes(std::size_t column_index, std::size_t row, std::size_t * size)
+		{
+			column & col = m_columns[column_index];
+			if (size)
+				*size = col.offsets[row + 1] - col.offsets[row];
+			return col.bytes.data() + col.offsets[row];
+		}
+
+		//@}
+
+		/** @name Building,the values of a row are appended column by column,then end_row() */
+		//@{
+
+		void append_null(std::size_t column_index)
+		{
+			column & col = m_columns[column_index];
+			if (col.type == type_int64)
+				col.ints.emplace_back(0);
+			else if (col.type == type_double)
+				col.doubles.emplace_back(0);
+			else
+				col.offsets.emplace_back(col.bytes.size());
+			col.nulls.emplace_back(1);
+		}
+
+		void append_int64(std::size_t column_index, int64_t value)
+		{
+			column & col = m_columns[column_index];
+			col.ints.emplace_back(value);
+			col.nulls.emplace_back(0);
+		}
+
+		void append_double(std::size_t column_index, double value)
+		{
+			column & col = m_columns[column_index];
+			col.doubles.emplace_back(value);
+			col.nulls.emplace_back(0);
+		}
+
+		void append_bytes(std::size_t column_index, const char * data, std::size_t size)
+		{
+			column & col = m_columns[column_index];
+			col.bytes.append(data, size);
+			col.offsets.emplace_back(col.bytes.size());
+			col.nulls.emplace_back(0);
+		}
+
+		void end_row()
+		{
+			m_row_count++;
+		}
+
+		//@}
+
+	protected:
+
+		std::vector<column> m_columns;
+
+		std::size_t m_row_count = 0;
+
+	};
+
+}
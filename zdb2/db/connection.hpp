@@ -17,12 +17,19 @@
 #include <mutex>
 #include <atomic>
 #include <chrono>
+#include <functional>
+#include <exception>
 #include <stdexcept>
+#include <vector>
 
 #include <zdb2/config.hpp>
 #include <zdb2/net/url.hpp>
 #include <zdb2/db/stmt.hpp>
 #include <zdb2/db/resultset.hpp>
+#include <zdb2/db/batch_result.hpp>
+#include <zdb2/db/stats.hpp>
+#include <zdb2/db/hooks.hpp>
+#include <zdb2/db/instrumented.hpp>
 
 namespace zdb2
 {
@@ -155,8 +162,7 @@ namespace zdb2
 		 */
 		virtual bool begin_transaction()
 		{
-			m_transaction++;
-			return true;
+			return _transaction_begin([]() { return true; });
 		}
 
 
@@ -170,8 +176,7 @@ namespace zdb2
 		 */
 		virtual bool commit()
 		{
-			m_transaction = 0;
-			return true;
+			return _transaction_end(&hooks::on_txn_commit, []() { return true; });
 		}
 
 
@@ -186,8 +191,7 @@ namespace zdb2
 		 */
 		virtual bool rollback()
 		{
-			m_transaction = 0;
-			return true;
+			return _transaction_end(&hooks::on_txn_rollback, []() { return true; });
 		}
 
 
@@ -269,6 +273,100 @@ namespace zdb2
 		virtual std::shared_ptr<stmt> prepare_stmt(const char * sql, ...) = 0;
 
 
+		/**
+		 * Start the query by the non-blocking api of the database client library,
+		 * the calling thread is not blocked,the handler will be called in the event
+		 * loop thread of the backend when the query is completed,and the resultset
+		 * passed to the handler must not depend on the connection anymore.
+		 * @param sql A SQL statement,it is not a format string
+		 * @param handler The completion handler,if the query is failed the resultset
+		 * is nullptr and the exception_ptr is set
+		 * @return false if the backend doesn't have a non-blocking api,in this case
+		 * the handler will never be called
+		 */
+		virtual bool query_nonblocking(const std::string &,
+			std::function<void(std::shared_ptr<resultset>, std::exception_ptr)>)
+		{
+			return false;
+		}
+
+
+		/**
+		 * Start the statement by the non-blocking api of the database client library,
+		 * see query_nonblocking().
+		 * @param sql A SQL statement,it is not a format string
+		 * @param handler The completion handler,the int64_t is the rows changed by the
+		 * statement
+		 * @return false if the backend doesn't have a non-blocking api,in this case
+		 * the handler will never be called
+		 */
+		virtual bool execute_nonblocking(const std::string &,
+			std::function<void(int64_t, std::exception_ptr)>)
+		{
+			return false;
+		}
+
+
+		/**
+		 * Executes several independent SQL statements and returns the result
+		 * of each statement in order. The backends which support it (MySQL)
+		 * send all the statements in one round trip,the others execute them
+		 * one by one. When a statement is failed,the remaining statements are
+		 * not executed and their results are not ok.
+		 * @param sqls The SQL statements,each one must be a single statement
+		 * and they are not format strings
+		 * @return The results,one for each statement
+		 */
+		virtual std::vector<batch_result> execute_batch(const std::vector<std::string> & sqls)
+		{
+			std::vector<batch_result> results(sqls.size());
+			for (std::size_t i = 0; i < sqls.size(); i++)
+			{
+				batch_result & result = results[i];
+				if (!execute("%s", sqls[i].c_str()))
+				{
+					const char * err = get_last_error();
+					result.error = (err ? err : "unknown error.");
+					for (std::size_t j = i + 1; j < sqls.size(); j++)
+						results[j].error = "not executed because of the previous error.";
+					break;
+				}
+				result.ok = true;
+				result.rows_changed = rows_changed();
+				result.last_rowid = last_rowid();
+			}
+			return results;
+		}
+
+
+		/**
+		 * Cancel the statement which is executing on this connection.It is called by another
+		 * thread while the connection is used by the executing thread,so the implementations
+		 * must be thread safe.The canceled statement is failed with an error and the connection
+		 * can still be used.
+		 * @return false if the backend can't cancel the statement or the request is failed
+		 */
+		virtual bool cancel()
+		{
+			return false;
+		}
+
+
+		/**
+		 * Record the statements of this connection into the stats,nullptr to stop recording.It is
+		 * set by the pool when the stats of the pool is enabled,see pool::enable_stats().
+		 */
+		void set_stats(std::shared_ptr<statement_stats> stats_ptr)
+		{
+			m_stats_ptr = stats_ptr;
+		}
+
+		const std::shared_ptr<statement_stats> & get_stats()
+		{
+			return m_stats_ptr;
+		}
+
+
 		/**
 		 * This method can be used to obtain a string describing the last
 		 * error that occurred. Inside a CATCH-block you can also find
@@ -302,6 +400,172 @@ namespace zdb2
 
 		virtual bool _connect() = 0;
 
+		/**
+		 * start a statement,the backends call it before the statement is executed,and call one of
+		 * _statement_execute(),_statement_query() or _statement_end() after it.When neither the
+		 * stats nor the hooks is enabled it costs one branch.
+		 */
+		statement_context _statement_begin(const char * sql)
+		{
+			statement_context ctx;
+			ctx.hooks_ptr = hooks::get();
+			if (!m_stats_ptr && !ctx.hooks_ptr)
+				return ctx;
+
+			ctx.enabled = true;
+			ctx.begin = std::chrono::steady_clock::now();
+			ctx.fingerprint = sql_util::fingerprint(sql);
+			if (ctx.hooks_ptr)
+			{
+				ctx.id = hooks::next_id();
+				ctx.sql = (sql ? sql : "");
+				hook_event ev = ctx.make_event(this);
+				ev.time = ctx.begin;
+				ev.sql = sql;
+				ctx.hooks_ptr->on_query_start(ev);
+				ctx.tag = ev.tag;
+			}
+			return ctx;
+		}
+
+		/**
+		 * end the statement of execute().
+		 */
+		bool _statement_execute(statement_context & ctx, const char * sql, bool ok)
+		{
+			if (!ctx.enabled)
+				return ok;
+
+			return _statement_end(ctx, sql, ok, (ok ? rows_changed() : 0));
+		}
+
+		/**
+		 * end the statement whose rows are known when it's finished,eg : a statement of
+		 * execute_batch() or a non-blocking query which reads all the rows.
+		 */
+		bool _statement_end(const statement_context & ctx, const char * sql, bool ok, int64_t rows)
+		{
+			if (!ctx.enabled)
+				return ok;
+
+			auto end = std::chrono::steady_clock::now();
+			uint64_t us = statement_context::elapsed_us(ctx.begin, end);
+			if (rows < 0)
+				rows = 0;
+
+			if (m_stats_ptr)
+				m_stats_ptr->record(ctx.fingerprint, us, 0, (uint64_t)rows, 0, ok);
+
+			_hook_query_end(ctx, sql, end, us, rows, ok);
+			return ok;
+		}
+
+		/**
+		 * end the statement of query(),the ResultSet is wrapped to measure the fetching,and it's
+		 * recorded into the stats when it's closed.
+		 */
+		std::shared_ptr<resultset> _statement_query(statement_context & ctx, const char * sql, std::shared_ptr<resultset> rs)
+		{
+			if (!ctx.enabled)
+				return rs;
+
+			auto end = std::chrono::steady_clock::now();
+			uint64_t us = statement_context::elapsed_us(ctx.begin, end);
+
+			_hook_query_end(ctx, sql, end, us, 0, (rs != nullptr), (rs != nullptr));
+
+			if (!rs)
+			{
+				if (m_stats_ptr)
+					m_stats_ptr->record(ctx.fingerprint, us, 0, 0, 0, false);
+				return rs;
+			}
+			return std::make_shared<instrumented_resultset>(rs, m_stats_ptr, ctx, this, us);
+		}
+
+		/**
+		 * wrap the PreparedStatement to record every execute() if the stats or the hooks is enabled.
+		 */
+		std::shared_ptr<stmt> _statement_stmt(const char * sql, std::shared_ptr<stmt> stmt_ptr)
+		{
+			if ((!m_stats_ptr && !hooks::get()) || !stmt_ptr)
+				return stmt_ptr;
+			return std::make_shared<instrumented_stmt>(stmt_ptr, m_stats_ptr, this, sql, m_timeout);
+		}
+
+		/**
+		 * the rows of a statement of execute_batch() for the stats and the hooks.
+		 */
+		static int64_t _batch_rows(const batch_result & result)
+		{
+			return (result.rows ? (int64_t)result.rows->get_row_count() : result.rows_changed);
+		}
+
+		void _hook_query_end(const statement_context & ctx, const char * sql, std::chrono::steady_clock::time_point end,
+			uint64_t us, int64_t rows, bool ok, bool has_resultset = false)
+		{
+			if (!ctx.hooks_ptr)
+				return;
+
+			hook_event ev = ctx.make_event(this);
+			ev.time = end;
+			ev.sql = sql;
+			ev.duration_us = us;
+			ev.rows = rows;
+			ev.ok = ok;
+			ev.has_resultset = has_resultset;
+			ctx.hooks_ptr->on_query_end(ev);
+		}
+
+		/**
+		 * run the BEGIN statement of the backend by the function,the hook is called after it with
+		 * the time of the statement and it's result.
+		 */
+		template<class Function>
+		bool _transaction_begin(Function && statement)
+		{
+			hooks * hooks_ptr = hooks::get();
+			auto begin = (hooks_ptr ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point());
+
+			bool ok = statement();
+			if (ok)
+				m_transaction++;
+
+			_hook_transaction(hooks_ptr, &hooks::on_txn_begin, begin, ok);
+			return ok;
+		}
+
+		/**
+		 * run the COMMIT or ROLLBACK statement of the backend by the function,the transaction is
+		 * ended even if the statement is failed,see _transaction_begin().
+		 */
+		template<class Function>
+		bool _transaction_end(void (hooks::*fn)(hook_event &), Function && statement)
+		{
+			hooks * hooks_ptr = hooks::get();
+			auto begin = (hooks_ptr ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point());
+
+			bool ok = statement();
+			m_transaction = 0;
+
+			_hook_transaction(hooks_ptr, fn, begin, ok);
+			return ok;
+		}
+
+		void _hook_transaction(hooks * hooks_ptr, void (hooks::*fn)(hook_event &),
+			std::chrono::steady_clock::time_point begin, bool ok)
+		{
+			if (!hooks_ptr)
+				return;
+
+			hook_event ev;
+			ev.conn = this;
+			ev.time = std::chrono::steady_clock::now();
+			ev.duration_us = statement_context::elapsed_us(begin, ev.time);
+			ev.ok = ok;
+			(hooks_ptr->*fn)(ev);
+		}
+
 	protected:
 
 		std::shared_ptr<url> m_url_ptr;
@@ -314,6 +578,9 @@ namespace zdb2
 
 		/// c++ 11 time,http://blog.csdn.net/oncealong/article/details/28599655
 		std::chrono::system_clock::time_point m_last_access_time = std::chrono::system_clock::now();
+
+		/// the stats of the pool,nullptr if the stats is disabled
+		std::shared_ptr<statement_stats> m_stats_ptr;
 	};
 
 }
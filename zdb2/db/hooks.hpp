@@ -0,0 +1,243 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+namespace zdb2
+{
+
+	class connection;
+
+	/**
+	 * a parameter bound to a PreparedStatement,see hook_event::params.
+	 */
+	struct hook_param
+	{
+		enum
+		{
+			NONE = 0,
+			STRING,
+			INT,
+			INT64,
+			DOUBLE,
+			BLOB,
+			TIMESTAMP,
+		};
+
+		/// NONE means the parameter is not set or it's set to NULL
+		int type = NONE;
+
+		/// the value of INT,INT64 and TIMESTAMP
+		int64_t i = 0;
+
+		double d = 0;
+
+		/// the value of STRING and BLOB
+		std::string s;
+	};
+
+	/**
+	 * the event passed to the hooks.
+	 */
+	struct hook_event
+	{
+		/// the connection of the event,nullptr if a new connection is failed
+		connection * conn = nullptr;
+
+		/// the time when the event happened
+		std::chrono::steady_clock::time_point time;
+
+		/// the time of the operation,eg : the execute time of on_query_end,the wait time of on_checkout
+		uint64_t duration_us = 0;
+
+		/// the SQL of on_query_start and on_query_end,nullptr for the others
+		const char * sql = nullptr;
+
+		/// the fingerprint of the statement,see sql_util::fingerprint
+		const char * fingerprint = nullptr;
+
+		/// the rows changed by the statement,or the rows of the batch of on_fetch_batch
+		int64_t rows = 0;
+
+		bool ok = true;
+
+		/// the error of a failed connect
+		const char * error = nullptr;
+
+		/// the id of the statement,it's the same for all the events of a statement
+		uint64_t id = 0;
+
+		/// set by on_query_start,and passed to the other events of the statement,eg : a span id
+		uint64_t tag = 0;
+
+		/// the parameters of stmt::execute(),the first one is the parameter 1,nullptr for the
+		/// others.They are recorded only when the hooks are installed
+		const std::vector<hook_param> * params = nullptr;
+
+		/// true for the on_query_end of a query() which returns a ResultSet,the rows are not
+		/// fetched yet,the query is finished by on_query_close
+		bool has_resultset = false;
+	};
+
+	/**
+	 * The hook points of the pools,the connections and the statements,eg :
+	 *
+	 * class tracer : public zdb2::hooks
+	 * {
+	 * public:
+	 *     virtual void on_query_start(zdb2::hook_event & ev) override
+	 *     {
+	 *         ev.tag = start_span(current_span_id(), ev.fingerprint);
+	 *     }
+	 *     virtual void on_query_end(zdb2::hook_event & ev) override
+	 *     {
+	 *         end_span(ev.tag, ev.duration_us, ev.ok);
+	 *     }
+	 * };
+	 *
+	 * zdb2::hooks::install(std::make_shared<tracer>());
+	 *
+	 * The hooks are called in the thread of the operation,they must not throw and should be fast.
+	 * When no hooks are installed the cost is one branch on an atomic pointer,and when the macro
+	 * ZDB2_DISABLE_HOOKS is defined the hook points are removed by the compiler.
+	 */
+	class hooks
+	{
+	public:
+		hooks()
+		{
+		}
+
+		virtual ~hooks()
+		{
+		}
+
+		/// a connection is checked out of the pool,duration_us is the time spent in pool::get()
+		virtual void on_checkout(hook_event &) {}
+
+		/// a connection is returned to the pool,duration_us is the time it's checked out
+		virtual void on_return(hook_event &) {}
+
+		/// a new connection is opened or failed
+		virtual void on_connect(hook_event &) {}
+
+		/// a statement is started by execute(),query() or stmt::execute()
+		virtual void on_query_start(hook_event &) {}
+
+		/// a statement is finished,for query() it's called when the ResultSet is returned
+		virtual void on_query_end(hook_event &) {}
+
+		/// some rows are fetched from the ResultSet of query(),duration_us is the time of next_row()
+		virtual void on_fetch_batch(hook_event &) {}
+
+		/// the ResultSet of query() is closed,duration_us is the execute time and the fetch time,
+		/// rows is the rows fetched,ok is false if next_row() is failed
+		virtual void on_query_close(hook_event &) {}
+
+		/// the BEGIN,COMMIT or ROLLBACK statement is finished,duration_us is the time of the statement,
+		/// ok is false if it's failed,is_intransaction() is false after a failed COMMIT or ROLLBACK too
+		virtual void on_txn_begin(hook_event &) {}
+		virtual void on_txn_commit(hook_event &) {}
+		virtual void on_txn_rollback(hook_event &) {}
+
+		enum
+		{
+			/// the rows of every on_fetch_batch,the last batch may be less
+			FETCH_BATCH_ROWS = 256,
+		};
+
+		/**
+		 * the state of the hooks,it's shared by the application and the plugins,see attach().
+		 */
+		struct shared_state
+		{
+			std::atomic<hooks *> instance{ nullptr };
+
+			std::atomic<uint64_t> id{ 0 };
+
+			std::mutex mtx;
+
+			std::vector<std::shared_ptr<hooks>> installed;
+		};
+
+		/**
+		 * Install the hooks,nullptr to remove them.The hooks object is kept until the program
+		 * exits,because the other threads may be calling it.
+		 */
+		static void install(std::shared_ptr<hooks> hooks_ptr)
+		{
+			shared_state * state = _state();
+			std::lock_guard<std::mutex> g(state->mtx);
+			auto & installed = state->installed;
+			if (hooks_ptr && std::find(installed.begin(), installed.end(), hooks_ptr) == installed.end())
+				installed.emplace_back(hooks_ptr);
+			state->instance.store(hooks_ptr.get(), std::memory_order_release);
+		}
+
+		/**
+		 * Get the installed hooks,nullptr if no hooks are installed.
+		 */
+		static inline hooks * get()
+		{
+#if defined(ZDB2_DISABLE_HOOKS)
+			return nullptr;
+#else
+			return _state()->instance.load(std::memory_order_acquire);
+#endif
+		}
+
+		/**
+		 * Get a new statement id.
+		 */
+		static uint64_t next_id()
+		{
+			return ++_state()->id;
+		}
+
+		/**
+		 * Get the state of this module,it's passed to the plugins by the registry.
+		 */
+		static shared_state * get_shared_state()
+		{
+			return _state();
+		}
+
+		/**
+		 * Use the state of the application instead of the state of this module.The static objects
+		 * are not shared with a plugin which is loaded by dlopen(RTLD_LOCAL),so the plugin calls it
+		 * in zdb2_plugin_init,before any connection is created by it,see ZDB2_DECLARE_PLUGIN.
+		 */
+		static void attach(shared_state * state)
+		{
+			if (state)
+				_state() = state;
+		}
+
+	protected:
+
+		static shared_state *& _state()
+		{
+			static shared_state local;
+			static shared_state * state = &local;
+			return state;
+		}
+
+	};
+
+}
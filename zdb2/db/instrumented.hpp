@@ -0,0 +1,430 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <exception>
+
+#include <zdb2/db/resultset.hpp>
+#include <zdb2/db/stmt.hpp>
+#include <zdb2/db/sql_util.hpp>
+#include <zdb2/db/stats.hpp>
+#include <zdb2/db/hooks.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * the state of a statement between it's start and it's end,see connection::_statement_begin().
+	 */
+	struct statement_context
+	{
+		/// false if neither the stats nor the hooks is enabled,the other members are not set
+		bool enabled = false;
+
+		std::chrono::steady_clock::time_point begin;
+
+		hooks * hooks_ptr = nullptr;
+
+		std::string fingerprint;
+
+		/// the SQL of the query,it's kept for on_query_close only when the hooks are installed
+		std::string sql;
+
+		uint64_t id = 0;
+		uint64_t tag = 0;
+
+		/**
+		 * make an event of the statement.
+		 */
+		hook_event make_event(connection * conn) const
+		{
+			hook_event ev;
+			ev.conn = conn;
+			ev.time = std::chrono::steady_clock::now();
+			ev.fingerprint = fingerprint.c_str();
+			ev.id = id;
+			ev.tag = tag;
+			return ev;
+		}
+
+		static uint64_t elapsed_us(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+		}
+	};
+
+	/**
+	 * The ResultSet returned by the connection when the stats or the hooks is enabled,it measures
+	 * the time of next_row,calls on_fetch_batch every hooks::FETCH_BATCH_ROWS rows,and records the
+	 * query into the stats and calls on_query_close when it's closed.
+	 */
+	class instrumented_resultset : public resultset
+	{
+	public:
+		instrumented_resultset(
+			std::shared_ptr<resultset> rs,
+			std::shared_ptr<statement_stats> stats_ptr,
+			const statement_context & ctx,
+			connection * conn,
+			uint64_t execute_us
+		)
+			: m_rs(rs)
+			, m_stats_ptr(stats_ptr)
+			, m_ctx(ctx)
+			, m_conn(conn)
+			, m_execute_us(execute_us)
+		{
+			_init();
+		}
+
+		virtual ~instrumented_resultset()
+		{
+			close();
+		}
+
+		/**
+		 * Get the ResultSet of the backend,eg : to use the methods which are not in the interface.
+		 */
+		std::shared_ptr<resultset> get_resultset()
+		{
+			return m_rs;
+		}
+
+		virtual void close() override
+		{
+			if (m_closed)
+				return;
+			m_closed = true;
+
+			m_rs->close();
+
+			if (m_batch_rows > 0)
+				_fetch_batch();
+
+			if (m_ctx.hooks_ptr)
+			{
+				hook_event ev = m_ctx.make_event(m_conn);
+				ev.sql = m_ctx.sql.c_str();
+				ev.duration_us = m_execute_us + m_fetch_ns / 1000;
+				ev.rows = (int64_t)m_rows;
+				ev.ok = !m_failed;
+				m_ctx.hooks_ptr->on_query_close(ev);
+			}
+
+			if (m_stats_ptr)
+				m_stats_ptr->record(std::move(m_ctx.fingerprint), m_execute_us, m_fetch_ns / 1000, m_rows, m_bytes, !m_failed);
+		}
+
+		virtual int get_column_count() override { return m_rs->get_column_count(); }
+
+		virtual const char * get_column_name(int column_index) override { return m_rs->get_column_name(column_index); }
+
+		virtual int get_column_index(const char * column_name) override { return m_rs->get_column_index(column_name); }
+
+		virtual std::size_t get_column_size(int column_index) override { return m_rs->get_column_size(column_index); }
+
+		virtual bool next_row() override
+		{
+			auto begin = std::chrono::steady_clock::now();
+			bool ret = false;
+			try
+			{
+				ret = m_rs->next_row();
+			}
+			catch (std::exception &)
+			{
+				m_failed = true;
+				throw;
+			}
+			if (ret)
+			{
+				m_rows++;
+				m_batch_rows++;
+				int cols = m_rs->get_column_count();
+				for (int i = 0; i < cols; i++)
+					m_bytes += m_rs->get_column_size(i);
+			}
+			uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - begin).count();
+			m_fetch_ns += ns;
+			m_batch_ns += ns;
+
+			if (m_batch_rows >= hooks::FETCH_BATCH_ROWS)
+				_fetch_batch();
+			return ret;
+		}
+
+		virtual bool is_null(int column_index) override { return m_rs->is_null(column_index); }
+
+		virtual const char * get_string(int column_index) override { return m_rs->get_string(column_index); }
+
+		virtual const char * get_string(const char * column_name) override { return m_rs->get_string(column_name); }
+
+		virtual int get_int(int column_index) override { return m_rs->get_int(column_index); }
+
+		virtual int get_int(const char * column_name) override { return m_rs->get_int(column_name); }
+
+		virtual int64_t get_int64(int column_index) override { return m_rs->get_int64(column_index); }
+
+		virtual int64_t get_int64(const char * column_name) override { return m_rs->get_int64(column_name); }
+
+		virtual double get_double(int column_index) override { return m_rs->get_double(column_index); }
+
+		virtual double get_double(const char * column_name) override { return m_rs->get_double(column_name); }
+
+		virtual const void * get_blob(int column_index, std::size_t * size) override { return m_rs->get_blob(column_index, size); }
+
+		virtual const void * get_blob(const char * column_name, std::size_t * size) override { return m_rs->get_blob(column_name, size); }
+
+		virtual time_t get_timestamp(int column_index) override { return m_rs->get_timestamp(column_index); }
+
+		virtual time_t get_timestamp(const char * column_name) override { return m_rs->get_timestamp(column_name); }
+
+		virtual tm get_datetime(int column_index) override { return m_rs->get_datetime(column_index); }
+
+		virtual tm get_datetime(const char * column_name) override { return m_rs->get_datetime(column_name); }
+
+	protected:
+		virtual void _init() override
+		{
+		}
+
+		void _fetch_batch()
+		{
+			if (m_ctx.hooks_ptr)
+			{
+				hook_event ev = m_ctx.make_event(m_conn);
+				ev.duration_us = m_batch_ns / 1000;
+				ev.rows = (int64_t)m_batch_rows;
+				m_ctx.hooks_ptr->on_fetch_batch(ev);
+			}
+			m_batch_rows = 0;
+			m_batch_ns = 0;
+		}
+
+	protected:
+
+		std::shared_ptr<resultset> m_rs;
+
+		std::shared_ptr<statement_stats> m_stats_ptr;
+
+		statement_context m_ctx;
+
+		/// the connection of the ResultSet,the ResultSet must not be used after it's closed
+		connection * m_conn = nullptr;
+
+		uint64_t m_execute_us = 0;
+		uint64_t m_fetch_ns = 0;
+		uint64_t m_rows = 0;
+		uint64_t m_bytes = 0;
+
+		uint64_t m_batch_rows = 0;
+		uint64_t m_batch_ns = 0;
+
+		bool m_closed = false;
+
+		/// next_row() is failed,eg : the connection is lost while the rows are streamed
+		bool m_failed = false;
+	};
+
+	/**
+	 * The PreparedStatement returned by the connection when the stats or the hooks is enabled,it
+	 * records every execute() call.
+	 */
+	class instrumented_stmt : public stmt
+	{
+	public:
+		instrumented_stmt(
+			std::shared_ptr<stmt> stmt_ptr,
+			std::shared_ptr<statement_stats> stats_ptr,
+			connection * conn,
+			const std::string & sql,
+			std::size_t timeout
+		)
+			: stmt(sql.c_str(), timeout)
+			, m_stmt_ptr(stmt_ptr)
+			, m_stats_ptr(stats_ptr)
+			, m_conn(conn)
+			, m_sql(sql)
+			, m_fingerprint(sql_util::fingerprint(sql.c_str()))
+		{
+			_init();
+		}
+
+		virtual ~instrumented_stmt()
+		{
+		}
+
+		/**
+		 * Get the PreparedStatement of the backend.
+		 */
+		std::shared_ptr<stmt> get_stmt()
+		{
+			return m_stmt_ptr;
+		}
+
+		virtual void close() override { m_stmt_ptr->close(); }
+
+		virtual void set_string(int param_index, const char * x) override
+		{
+			m_stmt_ptr->set_string(param_index, x);
+			if (hook_param * p = _param(param_index))
+			{
+				p->type = (x ? hook_param::STRING : hook_param::NONE);
+				p->s = (x ? x : "");
+			}
+		}
+
+		virtual void set_int(int param_index, int x) override
+		{
+			m_stmt_ptr->set_int(param_index, x);
+			if (hook_param * p = _param(param_index))
+			{
+				p->type = hook_param::INT;
+				p->i = x;
+			}
+		}
+
+		virtual void set_int64(int param_index, int64_t x) override
+		{
+			m_stmt_ptr->set_int64(param_index, x);
+			if (hook_param * p = _param(param_index))
+			{
+				p->type = hook_param::INT64;
+				p->i = x;
+			}
+		}
+
+		virtual void set_double(int param_index, double x) override
+		{
+			m_stmt_ptr->set_double(param_index, x);
+			if (hook_param * p = _param(param_index))
+			{
+				p->type = hook_param::DOUBLE;
+				p->d = x;
+			}
+		}
+
+		virtual void set_blob(int param_index, const void * x, std::size_t size) override
+		{
+			m_stmt_ptr->set_blob(param_index, x, size);
+			if (hook_param * p = _param(param_index))
+			{
+				p->type = (x ? hook_param::BLOB : hook_param::NONE);
+				p->s.assign((const char *)x, (x ? size : 0));
+			}
+		}
+
+		virtual void set_timestamp(int param_index, time_t x) override
+		{
+			m_stmt_ptr->set_timestamp(param_index, x);
+			if (hook_param * p = _param(param_index))
+			{
+				p->type = hook_param::TIMESTAMP;
+				p->i = (int64_t)x;
+			}
+		}
+
+		virtual void execute() override
+		{
+			statement_context ctx;
+			ctx.begin = std::chrono::steady_clock::now();
+			ctx.hooks_ptr = hooks::get();
+			ctx.fingerprint = m_fingerprint;
+			if (ctx.hooks_ptr)
+			{
+				ctx.id = hooks::next_id();
+				hook_event ev = ctx.make_event(m_conn);
+				ev.sql = m_sql.c_str();
+				ev.params = &m_params;
+				ctx.hooks_ptr->on_query_start(ev);
+				ctx.tag = ev.tag;
+			}
+
+			try
+			{
+				m_stmt_ptr->execute();
+			}
+			catch (std::exception &)
+			{
+				_end(ctx, false, 0);
+				throw;
+			}
+
+			int64_t rows = m_stmt_ptr->rows_changed();
+			_end(ctx, true, (rows > 0 ? rows : 0));
+		}
+
+		virtual int64_t rows_changed() override { return m_stmt_ptr->rows_changed(); }
+
+		virtual int get_param_count() override { return m_stmt_ptr->get_param_count(); }
+
+	protected:
+		virtual void _init() override
+		{
+		}
+
+		/**
+		 * the recorded parameter,nullptr if no hooks are installed,the parameters are not needed
+		 * by the stats.
+		 */
+		hook_param * _param(int param_index)
+		{
+			if (param_index < 1 || !hooks::get())
+				return nullptr;
+			if ((std::size_t)param_index > m_params.size())
+				m_params.resize((std::size_t)param_index);
+			return &m_params[(std::size_t)param_index - 1];
+		}
+
+		void _end(statement_context & ctx, bool ok, int64_t rows)
+		{
+			auto end = std::chrono::steady_clock::now();
+			uint64_t us = statement_context::elapsed_us(ctx.begin, end);
+
+			if (m_stats_ptr)
+				m_stats_ptr->record(m_fingerprint, us, 0, (uint64_t)rows, 0, ok);
+
+			if (ctx.hooks_ptr)
+			{
+				hook_event ev = ctx.make_event(m_conn);
+				ev.time = end;
+				ev.sql = m_sql.c_str();
+				ev.params = &m_params;
+				ev.duration_us = us;
+				ev.rows = rows;
+				ev.ok = ok;
+				ctx.hooks_ptr->on_query_end(ev);
+			}
+		}
+
+	protected:
+
+		std::shared_ptr<stmt> m_stmt_ptr;
+
+		std::shared_ptr<statement_stats> m_stats_ptr;
+
+		connection * m_conn = nullptr;
+
+		std::string m_sql;
+
+		std::string m_fingerprint;
+
+		/// the parameters for the hooks,they are kept between the executions like the backends do
+		std::vector<hook_param> m_params;
+	};
+
+}
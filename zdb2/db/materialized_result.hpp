@@ -0,0 +1,353 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <ctime>
+#include <limits>
+#include <stdexcept>
+
+#include <zdb2/config.hpp>
+#include <zdb2/db/resultset.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * A ResultSet which hold all the rows in memory,it is not associated with any connection,so
+	 * it can be passed between threads and saved after the connection is returned to the pool.
+	 * The values are stored as the bytes returned by the database,the numeric getters convert
+	 * them the same way as the text protocol resultsets do.
+	 */
+	class materialized_result : public resultset
+	{
+	public:
+		materialized_result(std::size_t timeout = zdb2::DEFAULT_TIMEOUT) : resultset(timeout)
+		{
+			_init();
+		}
+
+		virtual ~materialized_result()
+		{
+			close();
+		}
+
+		/**
+		 * Copy the rows of the ResultSet into a new materialized_result.
+		 * @param rs The source ResultSet,it's cursor will be moved
+		 * @param max_rows The maximum rows to copy,the remaining rows can be copied by call this
+		 * function again
+		 * @return A materialized_result object,if the source has no more rows,the returned object
+		 * has the columns but no rows
+		 */
+		static std::shared_ptr<materialized_result> materialize(
+			std::shared_ptr<resultset> rs,
+			std::size_t max_rows = (std::numeric_limits<std::size_t>::max)())
+		{
+			std::shared_ptr<materialized_result> result = std::make_shared<materialized_result>();
+			if (rs)
+			{
+				int cols = rs->get_column_count();
+				for (int col = 0; col < cols; col++)
+				{
+					const char * name = rs->get_column_name(col);
+					result->add_column(name ? name : "");
+				}
+				result->fetch(rs, max_rows);
+			}
+			return result;
+		}
+
+		/**
+		 * Append at most max_rows rows of the ResultSet to this object.
+		 * @return The number of rows appended
+		 */
+		std::size_t fetch(std::shared_ptr<resultset> rs, std::size_t max_rows = (std::numeric_limits<std::size_t>::max)())
+		{
+			std::size_t count = 0;
+			if (!rs)
+				return count;
+
+			int cols = get_column_count();
+			while (count < max_rows && rs->next_row())
+			{
+				add_row();
+				for (int col = 0; col < cols; col++)
+				{
+					if (rs->is_null(col))
+					{
+						set_null(col);
+					}
+					else
+					{
+						std::size_t size = 0;
+						const void * data = rs->get_blob(col, &size);
+						set_value(col, data, size);
+					}
+				}
+				count++;
+			}
+			return count;
+		}
+
+		/** @name Building */
+		//@{
+
+		/**
+		 * Add a column,all the columns must be added before the first row is added.
+		 */
+		void add_column(const std::string & name)
+		{
+			if (!m_nulls.empty())
+				throw std::runtime_error("columns must be added before rows.");
+
+			m_column_name_map.emplace(name, (int)m_column_names.size());
+			m_column_names.emplace_back(name);
+		}
+
+		/**
+		 * Add a new row,all the values of the new row are SQL NULL.
+		 */
+		void add_row()
+		{
+			m_values.resize(m_values.size() + m_column_names.size());
+			m_nulls.resize(m_nulls.size() + m_column_names.size(), true);
+		}
+
+		/**
+		 * Set the value of the designated column in the last added row.
+		 */
+		void set_value(int column_index, const void * data, std::size_t size)
+		{
+			if (!data)
+			{
+				set_null(column_index);
+				return;
+			}
+			std::size_t i = _last_row_offset(column_index);
+			m_values[i].assign((const char *)data, size);
+			m_nulls[i] = false;
+		}
+
+		void set_null(int column_index)
+		{
+			std::size_t i = _last_row_offset(column_index);
+			m_values[i].clear();
+			m_nulls[i] = true;
+		}
+
+		//@}
+
+		/**
+		 * Returns the number of rows in this object.
+		 */
+		std::size_t get_row_count()
+		{
+			return (m_column_names.empty() ? 0 : m_nulls.size() / m_column_names.size());
+		}
+
+		/**
+		 * Move the cursor to before the first row,so the rows can be iterated again.
+		 */
+		void rewind()
+		{
+			m_row = -1;
+		}
+
+		virtual void close() override
+		{
+			m_row = -1;
+			m_values.clear();
+			m_nulls.clear();
+		}
+
+		virtual int get_column_count() override
+		{
+			return (int)m_column_names.size();
+		}
+
+		virtual const char * get_column_name(int column_index) override
+		{
+			if (column_index < 0 || column_index >= (int)m_column_names.size())
+				return nullptr;
+			return m_column_names[column_index].c_str();
+		}
+
+		virtual int get_column_index(const char * column_name) override
+		{
+			auto iterator = m_column_name_map.find(column_name);
+			if (iterator != m_column_name_map.end())
+				return iterator->second;
+			return -1;
+		}
+
+		virtual std::size_t get_column_size(int column_index) override
+		{
+			const std::string * value = _value(column_index);
+			return (value ? value->size() : 0);
+		}
+
+		virtual bool next_row() override
+		{
+			if ((std::size_t)(m_row + 1) >= get_row_count())
+			{
+				m_row = (long long)get_row_count();
+				return false;
+			}
+			m_row++;
+			return true;
+		}
+
+		virtual bool is_null(int column_index) override
+		{
+			return (_value(column_index) == nullptr);
+		}
+
+		virtual const char * get_string(int column_index) override
+		{
+			const std::string * value = _value(column_index);
+			return (value ? value->c_str() : nullptr);
+		}
+
+		virtual const char * get_string(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_string(col_index) : nullptr);
+		}
+
+		virtual int get_int(int column_index) override
+		{
+			auto s = get_string(column_index);
+			return (s ? std::atoi(s) : -1);
+		}
+
+		virtual int get_int(const char * column_name) override
+		{
+			auto s = get_string(column_name);
+			return (s ? std::atoi(s) : -1);
+		}
+
+		virtual int64_t get_int64(int column_index) override
+		{
+			auto s = get_string(column_index);
+			return (s ? (int64_t)std::atoll(s) : -1);
+		}
+
+		virtual int64_t get_int64(const char * column_name) override
+		{
+			auto s = get_string(column_name);
+			return (s ? (int64_t)std::atoll(s) : -1);
+		}
+
+		virtual double get_double(int column_index) override
+		{
+			auto s = get_string(column_index);
+			return (s ? std::atof(s) : -1.f);
+		}
+
+		virtual double get_double(const char * column_name) override
+		{
+			auto s = get_string(column_name);
+			return (s ? std::atof(s) : -1.f);
+		}
+
+		virtual const void * get_blob(int column_index, std::size_t * size) override
+		{
+			const std::string * value = _value(column_index);
+			if (size)
+				*size = (value ? value->size() : 0);
+			return (value ? (const void *)value->data() : nullptr);
+		}
+
+		virtual const void * get_blob(const char * column_name, std::size_t * size) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_blob(col_index, size) : nullptr);
+		}
+
+		virtual time_t get_timestamp(int column_index) override
+		{
+			auto s = get_string(column_index);
+			return (s ? (time_t)std::atoll(s) : (time_t)0);
+		}
+
+		virtual time_t get_timestamp(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_timestamp(col_index) : (time_t)0);
+		}
+
+		virtual tm get_datetime(int column_index) override
+		{
+			struct tm tm = { 0 };
+			if (is_null(column_index))
+				return tm;
+			time_t utc = get_timestamp(column_index);
+			struct tm * utc_tm = std::gmtime(&utc);
+			if (utc_tm)
+			{
+				tm = *utc_tm;
+				tm.tm_year += 1900; // Use year literal
+			}
+			return tm;
+		}
+
+		virtual tm get_datetime(const char * column_name) override
+		{
+			struct tm tm = { 0 };
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_datetime(col_index) : tm);
+		}
+
+	protected:
+		virtual void _init() override
+		{
+		}
+
+		std::size_t _last_row_offset(int column_index)
+		{
+			if (m_nulls.empty() || column_index < 0 || column_index >= (int)m_column_names.size())
+				throw std::runtime_error("column index is out of range.");
+			return m_nulls.size() - m_column_names.size() + column_index;
+		}
+
+		const std::string * _value(int column_index)
+		{
+			if (m_row < 0 || (std::size_t)m_row >= get_row_count() ||
+				column_index < 0 || column_index >= (int)m_column_names.size())
+				return nullptr;
+			std::size_t i = (std::size_t)m_row * m_column_names.size() + column_index;
+			return (m_nulls[i] ? nullptr : &m_values[i]);
+		}
+
+	protected:
+
+		std::vector<std::string> m_column_names;
+
+		std::unordered_map<std::string, int> m_column_name_map;
+
+		/// values of all rows,row by row
+		std::vector<std::string> m_values;
+
+		std::vector<bool> m_nulls;
+
+		/// the current row, -1 means before the first row
+		long long m_row = -1;
+
+	};
+
+}
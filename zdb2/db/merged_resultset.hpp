@@ -0,0 +1,909 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <algorithm>
+#include <unordered_map>
+#include <limits>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <stdexcept>
+
+#include <zdb2/db/resultset.hpp>
+#include <zdb2/db/connection.hpp>
+#include <zdb2/db/materialized_result.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * The ResultSet of scatter_gather::query(),it merges the rows of the same query which are
+	 * executed on several connections at the same time.The rows of every connection are fetched
+	 * by a thread in chunks,so the merged rows can be read before all the queries are finished.
+	 *
+	 * concat    : the rows of the first connection,then the rows of the second connection,...
+	 * merge     : every connection returns the rows sorted by the order keys (the SQL must have the
+	 *             same ORDER BY),the rows are merged by a heap,so the result is sorted too.
+	 * aggregate : the rows which have the same group by columns are combined,COUNT and SUM are
+	 *             added,MIN and MAX are compared,the result is sorted by the order keys if any.
+	 *
+	 * The values of an order key are compared by the value_type of the key,it must be the same
+	 * order as the ORDER BY of the databases (eg : as_text for a TEXT column of the BINARY
+	 * collation,as_collation with the function of a case insensitive collation),otherwise the
+	 * merged rows are not sorted.The NULL is less than any value.When a limit is set,every
+	 * connection fetches at most (offset + limit) rows,and the queries are canceled as soon as
+	 * the limit is reached.
+	 */
+	class merged_resultset : public resultset
+	{
+	public:
+
+		enum mode
+		{
+			concat,
+			merge,
+			aggregate,
+		};
+
+		enum aggregate_func
+		{
+			group_by,
+			count,
+			sum,
+			min,
+			max,
+		};
+
+		/**
+		 * how the values of a column are compared,the resultsets don't have the column types,so
+		 * it's chosen by the caller.
+		 */
+		enum value_type
+		{
+			/// the bytes are compared,the same as the BINARY collation
+			as_text,
+			/// the values are converted by strtoll
+			as_int,
+			/// the values are converted by strtod,NaN is less than the other numbers
+			as_double,
+			/// the values are compared by the collation function of the key
+			as_collation,
+		};
+
+		/**
+		 * the collation of as_collation.
+		 * @return <0 if a < b,0 if a == b,>0 if a > b
+		 */
+		typedef std::function<int(const char * a, std::size_t a_size, const char * b, std::size_t b_size)> collation_func;
+
+		struct order_key
+		{
+			int column = 0;
+			bool descending = false;
+			value_type type = as_text;
+			collation_func collation;
+		};
+
+		/**
+		 * the rows of one connection,filled by the fetching thread.
+		 */
+		struct stream
+		{
+			std::mutex mtx;
+			std::condition_variable cv;
+
+			std::deque<std::shared_ptr<materialized_result>> chunks;
+
+			/// the fetching thread doesn't fetch more chunks when the queue is full
+			std::size_t max_chunks = 4;
+
+			bool done = false;
+			bool canceled = false;
+			std::string error;
+
+			/// the connection which is executing the query,canceled by close()
+			std::shared_ptr<connection> executing;
+		};
+
+		merged_resultset(
+			mode m,
+			const std::vector<order_key> & order_keys = std::vector<order_key>(),
+			const std::vector<aggregate_func> & funcs = std::vector<aggregate_func>(),
+			std::size_t limit = (std::numeric_limits<std::size_t>::max)(),
+			std::size_t offset = 0,
+			const std::vector<value_type> & column_types = std::vector<value_type>()
+		)
+			: m_mode(m)
+			, m_order_keys(order_keys)
+			, m_funcs(funcs)
+			, m_column_types(column_types)
+			, m_limit(limit)
+			, m_offset(offset)
+		{
+			_init();
+		}
+
+		virtual ~merged_resultset()
+		{
+			close();
+		}
+
+		/**
+		 * Fetch the rows of the query on the connection by a new thread,used by scatter_gather.
+		 * @param conn_getter Returns the connection,it is called in the fetching thread
+		 * @param chunk_rows The rows of every chunk
+		 */
+		template<class Getter>
+		void add_stream(Getter conn_getter, const std::string & sql, std::size_t chunk_rows)
+		{
+			std::shared_ptr<stream> s = std::make_shared<stream>();
+			m_streams.emplace_back(s);
+			m_cursors.emplace_back();
+
+			std::size_t max_rows = _max_fetch_rows();
+			m_threads.emplace_back(std::make_shared<std::thread>([s, conn_getter, sql, chunk_rows, max_rows]()
+			{
+				merged_resultset::_fetch(s, conn_getter, sql, chunk_rows, max_rows);
+			}));
+		}
+
+		/**
+		 * Wait until every connection has returned it's first chunk,used by scatter_gather.
+		 * @return false if any query is failed,the error can be got by get_last_error()
+		 */
+		bool start()
+		{
+			for (auto & s : m_streams)
+			{
+				std::unique_lock<std::mutex> lck(s->mtx);
+				s->cv.wait(lck, [&s]() { return (!s->chunks.empty() || s->done); });
+
+				if (!s->error.empty())
+				{
+					m_error = s->error;
+					return false;
+				}
+				if (s->chunks.empty())
+				{
+					m_error = "the query returned no result.";
+					return false;
+				}
+
+				std::shared_ptr<materialized_result> & chunk = s->chunks.front();
+				if (m_column_names.empty())
+				{
+					for (int col = 0; col < chunk->get_column_count(); col++)
+					{
+						const char * name = chunk->get_column_name(col);
+						m_column_name_map.emplace(name ? name : "", (int)m_column_names.size());
+						m_column_names.emplace_back(name ? name : "");
+					}
+				}
+				else if (chunk->get_column_count() != (int)m_column_names.size())
+				{
+					m_error = "the queries returned different columns.";
+					return false;
+				}
+			}
+
+			for (auto & key : m_order_keys)
+			{
+				if (key.column < 0 || key.column >= (int)m_column_names.size())
+				{
+					m_error = "the order key column is out of range.";
+					return false;
+				}
+				if (key.type == as_collation && !key.collation)
+				{
+					m_error = "the collation of the order key is not set.";
+					return false;
+				}
+			}
+
+			if (m_mode == aggregate)
+			{
+				if (m_funcs.size() != m_column_names.size())
+				{
+					m_error = "the aggregate functions don't match the columns.";
+					return false;
+				}
+				if (!m_column_types.empty() && m_column_types.size() != m_column_names.size())
+				{
+					m_error = "the column types don't match the columns.";
+					return false;
+				}
+
+				// MIN and MAX compare the values by the type of the column,or by the order key of
+				// the column if the type is not given
+				m_value_keys.assign(m_column_names.size(), order_key());
+				for (std::size_t col = 0; col < m_column_names.size(); col++)
+				{
+					if (m_funcs[col] != min && m_funcs[col] != max)
+						continue;
+
+					bool found = false;
+					if (!m_column_types.empty() && m_column_types[col] != as_collation)
+					{
+						m_value_keys[col].type = m_column_types[col];
+						found = true;
+					}
+					for (auto & key : m_order_keys)
+					{
+						if (!found && key.column == (int)col)
+						{
+							m_value_keys[col] = key;
+							found = true;
+						}
+					}
+					if (!found)
+					{
+						m_error = "the value type of the MIN or MAX column " + std::to_string(col) + " is not set.";
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		/**
+		 * Get the error of the queries,if next_row() returns false and the error is not empty,the
+		 * rows are not complete.
+		 */
+		const char * get_last_error()
+		{
+			return m_error.c_str();
+		}
+
+		virtual void close() override
+		{
+			for (auto & s : m_streams)
+			{
+				std::lock_guard<std::mutex> g(s->mtx);
+				if (!s->canceled && !s->done && s->executing)
+					s->executing->cancel();
+				s->canceled = true;
+				s->chunks.clear();
+				s->cv.notify_all();
+			}
+
+			for (auto & thread_ptr : m_threads)
+			{
+				if (thread_ptr->joinable())
+					thread_ptr->join();
+			}
+			m_threads.clear();
+
+			m_current.reset();
+			m_cursors.assign(m_cursors.size(), nullptr);
+		}
+
+		virtual int get_column_count() override
+		{
+			return (int)m_column_names.size();
+		}
+
+		virtual const char * get_column_name(int column_index) override
+		{
+			if (column_index < 0 || column_index >= (int)m_column_names.size())
+				return nullptr;
+			return m_column_names[column_index].c_str();
+		}
+
+		virtual int get_column_index(const char * column_name) override
+		{
+			auto iterator = m_column_name_map.find(column_name);
+			if (iterator != m_column_name_map.end())
+				return iterator->second;
+			return -1;
+		}
+
+		virtual std::size_t get_column_size(int column_index) override
+		{
+			return (m_current ? m_current->get_column_size(column_index) : 0);
+		}
+
+		virtual bool next_row() override
+		{
+			if (m_emitted >= m_limit)
+			{
+				m_current.reset();
+				return false;
+			}
+
+			while (_next())
+			{
+				if (m_skipped < m_offset)
+				{
+					m_skipped++;
+					continue;
+				}
+
+				m_emitted++;
+				if (m_emitted >= m_limit)
+					_cancel();
+				return true;
+			}
+
+			m_current.reset();
+			return false;
+		}
+
+		virtual bool is_null(int column_index) override
+		{
+			return (m_current ? m_current->is_null(column_index) : true);
+		}
+
+		virtual const char * get_string(int column_index) override
+		{
+			return (m_current ? m_current->get_string(column_index) : nullptr);
+		}
+
+		virtual const char * get_string(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_string(col_index) : nullptr);
+		}
+
+		virtual int get_int(int column_index) override
+		{
+			return (m_current ? m_current->get_int(column_index) : -1);
+		}
+
+		virtual int get_int(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_int(col_index) : -1);
+		}
+
+		virtual int64_t get_int64(int column_index) override
+		{
+			return (m_current ? m_current->get_int64(column_index) : -1);
+		}
+
+		virtual int64_t get_int64(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_int64(col_index) : -1);
+		}
+
+		virtual double get_double(int column_index) override
+		{
+			return (m_current ? m_current->get_double(column_index) : -1.f);
+		}
+
+		virtual double get_double(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_double(col_index) : -1.f);
+		}
+
+		virtual const void * get_blob(int column_index, std::size_t * size) override
+		{
+			if (!m_current)
+			{
+				if (size)
+					*size = 0;
+				return nullptr;
+			}
+			return m_current->get_blob(column_index, size);
+		}
+
+		virtual const void * get_blob(const char * column_name, std::size_t * size) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_blob(col_index, size) : nullptr);
+		}
+
+		virtual time_t get_timestamp(int column_index) override
+		{
+			return (m_current ? m_current->get_timestamp(column_index) : (time_t)0);
+		}
+
+		virtual time_t get_timestamp(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_timestamp(col_index) : (time_t)0);
+		}
+
+		virtual tm get_datetime(int column_index) override
+		{
+			struct tm tm = { 0 };
+			return (m_current ? m_current->get_datetime(column_index) : tm);
+		}
+
+		virtual tm get_datetime(const char * column_name) override
+		{
+			struct tm tm = { 0 };
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_datetime(col_index) : tm);
+		}
+
+		/**
+		 * Compare two values by the value type of the key,the NULL (nullptr) is less than any value.
+		 * Every value is converted on it's own,so it's a strict weak order even if the values are
+		 * not of the type,eg : an as_int value "abc" is 0.
+		 * @return <0 if a < b,0 if a == b,>0 if a > b
+		 */
+		static int compare(const order_key & key, const char * a, std::size_t a_size, const char * b, std::size_t b_size)
+		{
+			if (!a || !b)
+				return (a ? 1 : (b ? -1 : 0));
+
+			switch (key.type)
+			{
+			case as_int:
+			{
+				long long x = _convert(a, a_size, [](const char * p) { return std::strtoll(p, nullptr, 10); });
+				long long y = _convert(b, b_size, [](const char * p) { return std::strtoll(p, nullptr, 10); });
+				return (x < y ? -1 : (x > y ? 1 : 0));
+			}
+			case as_double:
+			{
+				double x = _convert(a, a_size, [](const char * p) { return std::strtod(p, nullptr); });
+				double y = _convert(b, b_size, [](const char * p) { return std::strtod(p, nullptr); });
+				if (std::isnan(x) || std::isnan(y))
+					return (std::isnan(x) ? (std::isnan(y) ? 0 : -1) : 1);
+				return (x < y ? -1 : (x > y ? 1 : 0));
+			}
+			case as_collation:
+				if (key.collation)
+					return key.collation(a, a_size, b, b_size);
+				break;
+			default:
+				break;
+			}
+
+			int r = std::memcmp(a, b, (std::min)(a_size, b_size));
+			if (r != 0)
+				return r;
+			return (a_size < b_size ? -1 : (a_size > b_size ? 1 : 0));
+		}
+
+	protected:
+		virtual void _init() override
+		{
+		}
+
+		std::size_t _max_fetch_rows()
+		{
+			// the rows after the limit are never used,except the aggregated rows
+			if (m_mode == aggregate || m_limit == (std::numeric_limits<std::size_t>::max)())
+				return (std::numeric_limits<std::size_t>::max)();
+			return ((m_limit > (std::numeric_limits<std::size_t>::max)() - m_offset) ?
+				(std::numeric_limits<std::size_t>::max)() : m_limit + m_offset);
+		}
+
+		template<class Getter>
+		static void _fetch(std::shared_ptr<stream> s, Getter conn_getter, const std::string & sql,
+			std::size_t chunk_rows, std::size_t max_rows)
+		{
+			std::string err;
+			std::shared_ptr<connection> conn;
+			try
+			{
+				conn = conn_getter();
+				if (!conn)
+					err = "no available connection in the pool.";
+			}
+			catch (std::exception & e)
+			{
+				err = e.what();
+			}
+
+			if (conn)
+			{
+				std::unique_lock<std::mutex> lck(s->mtx);
+				if (s->canceled)
+					conn.reset();
+				else
+					s->executing = conn;
+			}
+
+			if (conn)
+			{
+				try
+				{
+					std::shared_ptr<resultset> rs = conn->query("%s", sql.c_str());
+					if (!rs)
+					{
+						const char * e = conn->get_last_error();
+						err = ((e && e[0] != '\0') ? e : "unknown database error.");
+					}
+
+					std::size_t fetched = 0;
+					bool first = true;
+					while (rs)
+					{
+						std::size_t rows = (std::min)(chunk_rows, max_rows - fetched);
+						std::shared_ptr<materialized_result> chunk = materialized_result::materialize(rs, rows);
+						std::size_t count = chunk->get_row_count();
+						fetched += count;
+
+						// the first chunk is passed even if it's empty,it has the columns
+						if (count == 0 && !first)
+							break;
+						first = false;
+
+						std::unique_lock<std::mutex> lck(s->mtx);
+						s->cv.wait(lck, [&s]() { return (s->chunks.size() < s->max_chunks || s->canceled); });
+						if (s->canceled)
+							break;
+						s->chunks.emplace_back(chunk);
+						s->cv.notify_all();
+
+						if (count < rows || fetched >= max_rows)
+							break;
+					}
+				}
+				catch (std::exception & e)
+				{
+					// eg : the stream is canceled by close(),or the connection is lost while the rows are read
+					err = e.what();
+				}
+			}
+
+			// the connection is returned to the pool after it is removed from the stream,so the
+			// statement of another user can't be canceled by close()
+			std::lock_guard<std::mutex> g(s->mtx);
+			s->executing.reset();
+			s->error = err;
+			s->done = true;
+			s->cv.notify_all();
+		}
+
+		/**
+		 * move the cursor of the stream to the next row.
+		 * @return false if the stream has no more rows
+		 */
+		bool _advance(std::size_t index)
+		{
+			std::shared_ptr<materialized_result> & cursor = m_cursors[index];
+			while (true)
+			{
+				if (cursor && cursor->next_row())
+					return true;
+
+				stream & s = *m_streams[index];
+				std::unique_lock<std::mutex> lck(s.mtx);
+				s.cv.wait(lck, [&s]() { return (!s.chunks.empty() || s.done); });
+				if (s.chunks.empty())
+				{
+					if (!s.error.empty() && m_error.empty())
+						m_error = s.error;
+					cursor.reset();
+					return false;
+				}
+				cursor = s.chunks.front();
+				s.chunks.pop_front();
+				s.cv.notify_all();
+			}
+		}
+
+		bool _next()
+		{
+			if (m_mode == concat)
+			{
+				while (m_active < m_streams.size())
+				{
+					if (_advance(m_active))
+					{
+						m_current = m_cursors[m_active];
+						return true;
+					}
+					m_active++;
+				}
+				return false;
+			}
+
+			if (m_mode == merge)
+			{
+				if (!m_heap_built)
+				{
+					m_heap_built = true;
+					for (std::size_t i = 0; i < m_streams.size(); i++)
+					{
+						if (_advance(i))
+							m_heap.emplace_back(i);
+					}
+					std::make_heap(m_heap.begin(), m_heap.end(), _heap_compare());
+				}
+				else if (m_top >= 0)
+				{
+					// the row of the top stream is used,move it to the next row
+					if (_advance((std::size_t)m_top))
+					{
+						m_heap.emplace_back((std::size_t)m_top);
+						std::push_heap(m_heap.begin(), m_heap.end(), _heap_compare());
+					}
+					m_top = -1;
+				}
+
+				if (m_heap.empty())
+					return false;
+
+				std::pop_heap(m_heap.begin(), m_heap.end(), _heap_compare());
+				m_top = (int)m_heap.back();
+				m_heap.pop_back();
+				m_current = m_cursors[m_top];
+				return true;
+			}
+
+			if (!m_aggregated_ptr)
+				_aggregate();
+			m_current = m_aggregated_ptr;
+			return m_aggregated_ptr->next_row();
+		}
+
+		int _compare_rows(resultset & a, resultset & b)
+		{
+			for (auto & key : m_order_keys)
+			{
+				std::size_t a_size = 0, b_size = 0;
+				const char * a_value = (a.is_null(key.column) ? nullptr : (const char *)a.get_blob(key.column, &a_size));
+				const char * b_value = (b.is_null(key.column) ? nullptr : (const char *)b.get_blob(key.column, &b_size));
+				int r = compare(key, a_value, a_size, b_value, b_size);
+				if (r != 0)
+					return (key.descending ? -r : r);
+			}
+			return 0;
+		}
+
+		std::function<bool(std::size_t, std::size_t)> _heap_compare()
+		{
+			// std heap is a max heap,the top is the last row in the order,so the compare is reversed,
+			// and the stream index makes the order stable
+			return [this](std::size_t a, std::size_t b)
+			{
+				int r = _compare_rows(*m_cursors[a], *m_cursors[b]);
+				return (r != 0 ? r > 0 : a > b);
+			};
+		}
+
+		/**
+		 * the value of an aggregated column.
+		 */
+		struct aggregate_value
+		{
+			bool null = true;
+
+			/// the value of COUNT and SUM,the others keep the original value in s
+			bool numeric = false;
+			bool integral = true;
+			int64_t i = 0;
+			double d = 0;
+			std::string s;
+		};
+
+		void _aggregate()
+		{
+			std::size_t cols = m_column_names.size();
+
+			std::vector<std::vector<aggregate_value>> groups;
+			std::unordered_map<std::string, std::size_t> group_map;
+
+			for (std::size_t index = 0; index < m_streams.size(); index++)
+			{
+				while (_advance(index))
+				{
+					resultset & row = *m_cursors[index];
+
+					// the key is the length prefixed group by values,so it's unique
+					std::string key;
+					for (std::size_t col = 0; col < cols; col++)
+					{
+						if (m_funcs[col] != group_by)
+							continue;
+						if (row.is_null((int)col))
+						{
+							key += "N;";
+							continue;
+						}
+						std::size_t size = 0;
+						const char * data = (const char *)row.get_blob((int)col, &size);
+						key += std::to_string(size) + ":";
+						key.append(data, size);
+					}
+
+					auto it = group_map.find(key);
+					if (it == group_map.end())
+					{
+						it = group_map.emplace(key, groups.size()).first;
+						groups.emplace_back(cols);
+					}
+
+					std::vector<aggregate_value> & group = groups[it->second];
+					for (std::size_t col = 0; col < cols; col++)
+						_combine(group[col], m_funcs[col], m_value_keys[col], row, (int)col);
+				}
+			}
+
+			m_aggregated_ptr = std::make_shared<materialized_result>();
+			for (auto & name : m_column_names)
+				m_aggregated_ptr->add_column(name);
+
+			if (!m_order_keys.empty())
+			{
+				std::stable_sort(groups.begin(), groups.end(),
+					[this](const std::vector<aggregate_value> & a, const std::vector<aggregate_value> & b)
+				{
+					for (auto & key : m_order_keys)
+					{
+						const aggregate_value & x = a[key.column];
+						const aggregate_value & y = b[key.column];
+						std::string xs = _to_string(x), ys = _to_string(y);
+						int r = compare(key, x.null ? nullptr : xs.data(), xs.size(), y.null ? nullptr : ys.data(), ys.size());
+						if (r != 0)
+							return (key.descending ? r > 0 : r < 0);
+					}
+					return false;
+				});
+			}
+
+			for (auto & group : groups)
+			{
+				m_aggregated_ptr->add_row();
+				for (std::size_t col = 0; col < cols; col++)
+				{
+					if (group[col].null)
+						continue;
+					std::string value = _to_string(group[col]);
+					m_aggregated_ptr->set_value((int)col, value.data(), value.size());
+				}
+			}
+		}
+
+		static void _combine(aggregate_value & v, aggregate_func func, const order_key & key, resultset & row, int col)
+		{
+			if (row.is_null(col))
+				return;
+
+			std::size_t size = 0;
+			const char * data = (const char *)row.get_blob(col, &size);
+			std::string s(data ? data : "", data ? size : 0);
+
+			if (func == group_by)
+			{
+				if (v.null)
+				{
+					v.null = false;
+					v.s = s;
+				}
+				return;
+			}
+
+			if (func == count || func == sum)
+			{
+				char * end = nullptr;
+				long long i = std::strtoll(s.c_str(), &end, 10);
+				bool integral = (!s.empty() && end && *end == '\0');
+				double d = (integral ? (double)i : std::atof(s.c_str()));
+
+				v.integral = (v.integral && integral);
+				v.i += (integral ? (int64_t)i : 0);
+				v.d += d;
+				v.null = false;
+				v.numeric = true;
+				return;
+			}
+
+			// min and max keep the original value
+			if (v.null)
+			{
+				v.null = false;
+				v.s = s;
+				return;
+			}
+			int r = compare(key, s.data(), s.size(), v.s.data(), v.s.size());
+			if ((func == min && r < 0) || (func == max && r > 0))
+				v.s = s;
+		}
+
+		static std::string _to_string(const aggregate_value & v)
+		{
+			if (v.null)
+				return std::string();
+			if (!v.numeric)
+				return v.s;
+			if (v.integral)
+				return std::to_string(v.i);
+
+			char buf[32] = { 0 };
+			std::snprintf(buf, sizeof(buf), "%.15g", v.d);
+			return buf;
+		}
+
+		/// the value may be not null terminated,it's copied to the stack if it's short
+		template<class F>
+		static auto _convert(const char * data, std::size_t size, F f) -> decltype(f(data))
+		{
+			char buf[64];
+			if (size < sizeof(buf))
+			{
+				std::memcpy(buf, data, size);
+				buf[size] = '\0';
+				return f(buf);
+			}
+			return f(std::string(data, size).c_str());
+		}
+
+		void _cancel()
+		{
+			for (auto & s : m_streams)
+			{
+				std::lock_guard<std::mutex> g(s->mtx);
+				if (!s->canceled && !s->done && s->executing)
+					s->executing->cancel();
+				s->canceled = true;
+				s->cv.notify_all();
+			}
+		}
+
+	protected:
+
+		mode m_mode = concat;
+
+		std::vector<order_key> m_order_keys;
+
+		std::vector<aggregate_func> m_funcs;
+
+		/// the value types of the columns of aggregate,used by MIN and MAX
+		std::vector<value_type> m_column_types;
+
+		/// how MIN and MAX compare the values of every column,set by start()
+		std::vector<order_key> m_value_keys;
+
+		std::size_t m_limit = (std::numeric_limits<std::size_t>::max)();
+		std::size_t m_offset = 0;
+
+		std::size_t m_emitted = 0;
+		std::size_t m_skipped = 0;
+
+		std::vector<std::shared_ptr<stream>> m_streams;
+
+		std::vector<std::shared_ptr<std::thread>> m_threads;
+
+		/// the current chunk of every stream
+		std::vector<std::shared_ptr<materialized_result>> m_cursors;
+
+		/// the resultset of the current row
+		std::shared_ptr<materialized_result> m_current;
+
+		/// the stream which is read by concat
+		std::size_t m_active = 0;
+
+		/// the streams which have rows,ordered by the current row of every stream
+		std::vector<std::size_t> m_heap;
+		bool m_heap_built = false;
+		int m_top = -1;
+
+		std::shared_ptr<materialized_result> m_aggregated_ptr;
+
+		std::vector<std::string> m_column_names;
+
+		std::unordered_map<std::string, int> m_column_name_map;
+
+		std::string m_error;
+
+	};
+
+}
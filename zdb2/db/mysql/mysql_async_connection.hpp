@@ -0,0 +1,325 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cctype>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <stdexcept>
+
+#include <mysql.h>
+#include <errmsg.h>
+
+#include <zdb2/db/mysql/mysql_connection.hpp>
+
+// the non-blocking api (mysql_real_query_start/_cont and so on) is only provided by the MariaDB
+// Connector/C,the MYSQL_WAIT_READ macro is defined by it's mysql.h
+#if defined(__linux__) && defined(MYSQL_WAIT_READ)
+
+#include <zdb2/net/reactor.hpp>
+#include <zdb2/db/materialized_result.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * MySQL connection which use the non-blocking api of the MariaDB Connector/C,the api is driven
+	 * by the epoll reactor,so a few reactor threads can keep hundreds of queries in flight.
+	 * The connection is created by the pool when the url has the "nonblocking=true" param,eg :
+	 * mysql://localhost:3306/test?user=root&password=swordfish&nonblocking=true
+	 * The blocking methods inherited from mysql_connection can still be used.
+	 */
+	class mysql_async_connection : public mysql_connection
+	{
+	public:
+		mysql_async_connection(
+			std::shared_ptr<url> url_ptr,
+			std::size_t timeout = zdb2::DEFAULT_TIMEOUT,
+			std::shared_ptr<reactor> reactor_ptr = reactor::get_default()
+		)
+			: mysql_connection(url_ptr, timeout)
+			, m_reactor_ptr(reactor_ptr)
+		{
+			if (!m_reactor_ptr)
+				throw std::runtime_error("invalid parameters.");
+		}
+
+		/**
+		 * the factory of the "mysql" protocol when this header is included,the url with the
+		 * "nonblocking=true" param creates a mysql_async_connection.
+		 */
+		static connection * create(std::shared_ptr<url> url_ptr, std::size_t timeout)
+		{
+			if (url_ptr && url_ptr->get_param_value("nonblocking") == "true")
+				return static_cast<connection *>(new mysql_async_connection(url_ptr, timeout));
+			return static_cast<connection *>(new mysql_connection(url_ptr, timeout));
+		}
+
+		virtual ~mysql_async_connection()
+		{
+			close();
+		}
+
+		virtual void close() override
+		{
+			if (m_db && m_reactor_ptr)
+			{
+				int fd = (int)mysql_get_socket(m_db);
+				if (fd >= 0)
+					m_reactor_ptr->cancel(fd);
+			}
+			mysql_connection::close();
+		}
+
+		/**
+		 * Start the query,the handler is called in the reactor thread with a materialized_result
+		 * which hold all the rows.Only one operation can be in flight on a connection,and the
+		 * connection must be alive until the handler is called.
+		 */
+		virtual bool query_nonblocking(const std::string & sql,
+			std::function<void(std::shared_ptr<resultset>, std::exception_ptr)> handler) override
+		{
+			if (!_begin_op(handler))
+				return true;
+
+			// the statement is ended in the reactor thread,the rows are all read by then
+			statement_context ctx = _statement_begin(sql.c_str());
+
+			_real_query(sql, [this, handler, ctx]()
+			{
+				if (m_err != mysql_util::MYSQL_OK)
+				{
+					std::exception_ptr ep = _error();
+					_statement_end(ctx, ctx.sql.c_str(), false, 0);
+					_end_op();
+					handler(nullptr, ep);
+					return;
+				}
+
+				_store_result([this, handler, ctx]()
+				{
+					if (!m_res)
+					{
+						std::exception_ptr ep = (mysql_field_count(m_db) == 0 ?
+							std::make_exception_ptr(std::runtime_error("the statement doesn't return a result set.")) : _error());
+						_statement_end(ctx, ctx.sql.c_str(), false, 0);
+						_end_op();
+						handler(nullptr, ep);
+						return;
+					}
+
+					std::shared_ptr<materialized_result> rs = _materialize(m_res);
+					mysql_free_result(m_res);
+					m_res = nullptr;
+
+					_statement_end(ctx, ctx.sql.c_str(), true, (int64_t)rs->get_row_count());
+					_end_op();
+					handler(rs, nullptr);
+				});
+			});
+
+			return true;
+		}
+
+		/**
+		 * Start the statement,the handler is called in the reactor thread with the rows changed.
+		 */
+		virtual bool execute_nonblocking(const std::string & sql,
+			std::function<void(int64_t, std::exception_ptr)> handler) override
+		{
+			if (!_begin_op(handler))
+				return true;
+
+			statement_context ctx = _statement_begin(sql.c_str());
+
+			_real_query(sql, [this, handler, ctx]()
+			{
+				if (m_err != mysql_util::MYSQL_OK)
+				{
+					std::exception_ptr ep = _error();
+					_statement_end(ctx, ctx.sql.c_str(), false, 0);
+					_end_op();
+					handler(0, ep);
+					return;
+				}
+
+				int64_t rows = (int64_t)mysql_affected_rows(m_db);
+
+				// the statement may return a result set,it must be read out,otherwise the next
+				// command on this connection will be failed with "commands out of sync"
+				if (mysql_field_count(m_db) == 0)
+				{
+					_statement_end(ctx, ctx.sql.c_str(), true, rows);
+					_end_op();
+					handler(rows, nullptr);
+					return;
+				}
+
+				_store_result([this, handler, ctx]()
+				{
+					int64_t rows = (int64_t)mysql_affected_rows(m_db);
+					if (m_res)
+					{
+						mysql_free_result(m_res);
+						m_res = nullptr;
+					}
+					_statement_end(ctx, ctx.sql.c_str(), true, rows);
+					_end_op();
+					handler(rows, nullptr);
+				});
+			});
+
+			return true;
+		}
+
+		std::shared_ptr<reactor> get_reactor()
+		{
+			return m_reactor_ptr;
+		}
+
+	protected:
+		template<typename H>
+		bool _begin_op(H & handler)
+		{
+			bool busy = false;
+			if (!m_db)
+			{
+				handler({}, std::make_exception_ptr(std::runtime_error("the connection is closed.")));
+				return false;
+			}
+			if (!m_busy.compare_exchange_strong(busy, true))
+			{
+				handler({}, std::make_exception_ptr(std::runtime_error("another operation is in progress on the connection.")));
+				return false;
+			}
+			m_last_access_time = std::chrono::system_clock::now();
+			return true;
+		}
+
+		void _end_op()
+		{
+			m_busy = false;
+		}
+
+		std::exception_ptr _error()
+		{
+			const char * err = mysql_error(m_db);
+			return std::make_exception_ptr(std::runtime_error((err && err[0] != '\0') ? err : "unknown mysql error."));
+		}
+
+		void _real_query(const std::string & sql, std::function<void()> done)
+		{
+			// the sql must be alive until the query is sent completely
+			std::shared_ptr<std::string> sql_ptr = std::make_shared<std::string>(sql);
+			m_round_trips++;
+			int status = mysql_real_query_start(&m_err, m_db, sql_ptr->c_str(), (unsigned long)sql_ptr->length());
+			_step(status, [this, sql_ptr](int ready)
+			{
+				return mysql_real_query_cont(&m_err, m_db, ready);
+			}, done);
+		}
+
+		void _store_result(std::function<void()> done)
+		{
+			int status = mysql_store_result_start(&m_res, m_db);
+			_step(status, [this](int ready)
+			{
+				return mysql_store_result_cont(&m_res, m_db, ready);
+			}, done);
+		}
+
+		/**
+		 * drive the _cont function of the non-blocking api until the operation is completed.
+		 */
+		void _step(int status, std::function<int(int)> cont, std::function<void()> done)
+		{
+			if (status == 0)
+			{
+				done();
+				return;
+			}
+
+			int events = 0;
+			if (status & MYSQL_WAIT_READ)   events |= reactor::event_read;
+			if (status & MYSQL_WAIT_WRITE)  events |= reactor::event_write;
+			if (status & MYSQL_WAIT_EXCEPT) events |= reactor::event_except;
+
+			std::size_t timeout = 0;
+			if (status & MYSQL_WAIT_TIMEOUT)
+				timeout = (std::size_t)mysql_get_timeout_value_ms(m_db);
+
+			m_reactor_ptr->async_wait((int)mysql_get_socket(m_db), events, timeout, [this, cont, done](int revents)
+			{
+				int ready = 0;
+				if (revents & reactor::event_read)    ready |= MYSQL_WAIT_READ;
+				if (revents & reactor::event_write)   ready |= MYSQL_WAIT_WRITE;
+				if (revents & reactor::event_except)  ready |= MYSQL_WAIT_EXCEPT;
+				if (revents & reactor::event_timeout) ready |= MYSQL_WAIT_TIMEOUT;
+
+				_step(cont(ready), cont, done);
+			});
+		}
+
+		/**
+		 * the rows of a stored result are in the client memory,reading them will not block.
+		 */
+		static std::shared_ptr<materialized_result> _materialize(MYSQL_RES * res)
+		{
+			std::shared_ptr<materialized_result> result = std::make_shared<materialized_result>();
+
+			unsigned int cols = mysql_num_fields(res);
+			for (unsigned int i = 0; i < cols; i++)
+			{
+				MYSQL_FIELD * field = mysql_fetch_field_direct(res, i);
+				result->add_column((field && field->name) ? field->name : "");
+			}
+
+			MYSQL_ROW row;
+			while ((row = mysql_fetch_row(res)) != nullptr)
+			{
+				unsigned long * lengths = mysql_fetch_lengths(res);
+
+				result->add_row();
+				for (unsigned int i = 0; i < cols; i++)
+				{
+					if (row[i])
+						result->set_value((int)i, row[i], lengths[i]);
+				}
+			}
+
+			return result;
+		}
+
+	protected:
+
+		std::shared_ptr<reactor> m_reactor_ptr;
+
+		/// only one operation can be in flight on a connection
+		std::atomic<bool> m_busy{ false };
+
+		/// the return values of the non-blocking api
+		int m_err = 0;
+		MYSQL_RES * m_res = nullptr;
+	};
+
+	namespace
+	{
+		/// replace the factory registered by mysql_connection.hpp
+		const registry::registrar _mysql_async_registrar("mysql", &mysql_async_connection::create, true);
+	}
+
+}
+
+#endif // __linux__ && MYSQL_WAIT_READ
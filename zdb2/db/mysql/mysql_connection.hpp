@@ -18,6 +18,7 @@
 #include <atomic>
 #include <chrono>
 #include <functional>
+#include <vector>
 
 #include <mysql.h>
 #include <errmsg.h>
@@ -25,10 +26,13 @@
 #include <zdb2/config.hpp>
 #include <zdb2/net/url.hpp>
 #include <zdb2/db/connection.hpp>
+#include <zdb2/db/registry.hpp>
+#include <zdb2/db/materialized_result.hpp>
 
 #include <zdb2/db/mysql/mysql_util.hpp>
 #include <zdb2/db/mysql/mysql_stmt.hpp>
 #include <zdb2/db/mysql/mysql_resultset.hpp>
+#include <zdb2/db/mysql/mysql_text_resultset.hpp>
 
 namespace zdb2
 {
@@ -77,7 +81,11 @@ namespace zdb2
 		 */
 		virtual bool ping() override
 		{
-			return (m_db ? (mysql_ping(m_db) == mysql_util::MYSQL_OK) : false);
+			if (!m_db)
+				return false;
+			_discard_results();
+			m_round_trips++;
+			return (mysql_ping(m_db) == mysql_util::MYSQL_OK);
 		}
 
 
@@ -90,7 +98,7 @@ namespace zdb2
 		 */
 		virtual void clear() override
 		{
-
+			_discard_results();
 		}
 
 
@@ -103,6 +111,8 @@ namespace zdb2
 		{
 			if (m_db)
 			{
+				// the unbuffered result must be freed before the handle
+				_discard_results();
 				mysql_close(m_db);
 				m_db = nullptr;
 			}
@@ -119,8 +129,7 @@ namespace zdb2
 		{
 			if (m_db)
 			{
-				if (mysql_util::MYSQL_OK == mysql_query(m_db, "START TRANSACTION;"))
-					return connection::begin_transaction();
+				return _transaction_begin([this]() { return (mysql_util::MYSQL_OK == _simple_query("START TRANSACTION;")); });
 			}
 			return false;
 		}
@@ -140,10 +149,8 @@ namespace zdb2
 			{
 				if (is_intransaction())
 				{
-					if (connection::commit())
-					{
-						return (mysql_util::MYSQL_OK == mysql_query(m_db, "COMMIT;"));
-					}
+					return _transaction_end(&hooks::on_txn_commit,
+						[this]() { return (mysql_util::MYSQL_OK == _simple_query("COMMIT;")); });
 				}
 			}
 			return false;
@@ -165,10 +172,8 @@ namespace zdb2
 			{
 				if (is_intransaction())
 				{
-					if (connection::rollback())
-					{
-						return (mysql_util::MYSQL_OK == mysql_query(m_db, "ROLLBACK;"));
-					}
+					return _transaction_end(&hooks::on_txn_rollback,
+						[this]() { return (mysql_util::MYSQL_OK == _simple_query("ROLLBACK;")); });
 				}
 			}
 			return false;
@@ -230,8 +235,21 @@ namespace zdb2
 			std::vsprintf((char*)str.data(), sql, ap_copy);
 
 			va_end(ap);
-			
-			return (mysql_util::MYSQL_OK == mysql_real_query(m_db, str.c_str(), (unsigned long)str.length()));
+
+			auto ctx = _statement_begin(str.c_str());
+
+			if (!m_db)
+				return _statement_execute(ctx, str.c_str(), false);
+
+			_discard_results();
+
+			m_round_trips++;
+			if (mysql_util::MYSQL_OK != mysql_real_query(m_db, str.c_str(), (unsigned long)str.length()))
+				return _statement_execute(ctx, str.c_str(), false);
+
+			// read out the results of all the statements,otherwise the next command will be failed
+			// with "commands out of sync"
+			return _statement_execute(ctx, str.c_str(), _read_results());
 		}
 
 		/**
@@ -271,28 +289,121 @@ namespace zdb2
 
 			va_end(ap);
 
-			MYSQL_STMT * stmt = mysql_stmt_init(m_db);
-			if (!stmt)
-				return nullptr;
+			auto ctx = _statement_begin(str.c_str());
+
+			_discard_results();
+
+			// use the text protocol,the query is sent and the result set is returned in one round
+			// trip,the prepare and execute of the binary protocol need two or three round trips.
+			m_round_trips++;
+			if (mysql_util::MYSQL_OK != mysql_real_query(m_db, str.c_str(), (unsigned long)str.length()))
+				return _statement_query(ctx, str.c_str(), nullptr);
 
-			if (mysql_util::MYSQL_OK != mysql_stmt_prepare(stmt, str.c_str(), (unsigned long)str.length()))
+			// the statement doesn't return a result set
+			if (mysql_field_count(m_db) == 0)
 			{
-				mysql_stmt_close(stmt);
+				_statement_execute(ctx, str.c_str(), _read_results());
 				return nullptr;
 			}
 
-#if MYSQL_VERSION_ID >= 50002
-			unsigned long cursor = CURSOR_TYPE_READ_ONLY;
-			mysql_stmt_attr_set(stmt, STMT_ATTR_CURSOR_TYPE, &cursor);
-#endif
+			MYSQL_RES * res = (m_store_result ? mysql_store_result(m_db) : mysql_use_result(m_db));
+			if (!res)
+				return _statement_query(ctx, str.c_str(), nullptr);
+
+			std::shared_ptr<resultset> rs = std::make_shared<mysql_text_resultset>(res, m_timeout,
+				(m_store_result ? nullptr : m_db));
+			m_active_rs = rs;
+			return _statement_query(ctx, str.c_str(), rs);
+		}
 
-			if ((mysql_util::MYSQL_OK != mysql_stmt_execute(stmt)))
+		/**
+		 * Sends all the statements in one round trip as a multi statement command
+		 * (the connection is opened with CLIENT_MULTI_STATEMENTS) and reads the
+		 * result of each statement by mysql_next_result. MySQL stops executing
+		 * the command at the first failed statement.
+		 */
+		virtual std::vector<batch_result> execute_batch(const std::vector<std::string> & sqls) override
+		{
+			std::vector<batch_result> results(sqls.size());
+			if (!m_db || sqls.empty())
+				return results;
+
+			std::string str;
+			for (auto & sql : sqls)
 			{
-				mysql_stmt_close(stmt);
-				return nullptr;
+				// remove the trailing separators,otherwise the empty statement is an error
+				std::size_t len = sql.length();
+				while (len > 0 && (sql[len - 1] == ';' || std::isspace((unsigned char)sql[len - 1])))
+					len--;
+				if (!str.empty())
+					str += ';';
+				str.append(sql, 0, len);
 			}
 
-			return std::dynamic_pointer_cast<resultset>(std::make_shared<mysql_resultset>(stmt, m_timeout));
+			_discard_results();
+
+			// the statements are executed in order by the server,every statement is recorded from
+			// the end of the previous one to the reading of it's result
+			auto ctx = _statement_begin(sqls[0].c_str());
+
+			m_round_trips++;
+			int status = mysql_real_query(m_db, str.c_str(), (unsigned long)str.length());
+
+			std::size_t i = 0;
+			for (; i < sqls.size(); i++)
+			{
+				batch_result & result = results[i];
+				if (status != mysql_util::MYSQL_OK)
+				{
+					result.error = mysql_error(m_db);
+					_statement_end(ctx, sqls[i].c_str(), false, 0);
+					break;
+				}
+
+				if (mysql_field_count(m_db) > 0)
+				{
+					MYSQL_RES * res = mysql_store_result(m_db);
+					if (!res)
+					{
+						result.error = mysql_error(m_db);
+						_statement_end(ctx, sqls[i].c_str(), false, 0);
+						break;
+					}
+					result.rows = materialized_result::materialize(std::make_shared<mysql_text_resultset>(res, m_timeout));
+				}
+				else
+				{
+					result.rows_changed = (int64_t)mysql_affected_rows(m_db);
+					result.last_rowid = (int64_t)mysql_insert_id(m_db);
+				}
+				result.ok = true;
+
+				_statement_end(ctx, sqls[i].c_str(), true, _batch_rows(result));
+
+				if (i + 1 < sqls.size())
+				{
+					ctx = _statement_begin(sqls[i + 1].c_str());
+
+					// 0 : more results, -1 : no more results, > 0 : error
+					status = mysql_next_result(m_db);
+					if (status == -1)
+					{
+						i++;
+						results[i].error = "no result returned for the statement.";
+						_statement_end(ctx, sqls[i].c_str(), false, 0);
+						break;
+					}
+				}
+			}
+
+			for (std::size_t j = i + 1; j < sqls.size(); j++)
+				results[j].error = "not executed because of the previous error.";
+
+			// the stored procedures may return more results than the statements
+			if (mysql_more_results(m_db) && mysql_next_result(m_db) == 0)
+				_read_results();
+
+			return results;
 		}
 
 		/**
@@ -332,7 +443,35 @@ namespace zdb2
 
 			va_end(ap);
 
-			return std::dynamic_pointer_cast<stmt>(std::make_shared<mysql_stmt>(m_db,str.c_str(),m_timeout));
+			if (!m_db)
+				return nullptr;
+
+			_discard_results();
+
+			return _statement_stmt(str.c_str(), std::dynamic_pointer_cast<stmt>(std::make_shared<mysql_stmt>(m_db, str.c_str(), m_timeout, &m_round_trips)));
+		}
+
+
+		/**
+		 * Cancel the statement which is executing on this connection,see connection::cancel().
+		 * The MYSQL handle can't be used by two threads,so "KILL QUERY" is sent by a temporary
+		 * connection to the same server.
+		 */
+		virtual bool cancel() override
+		{
+			unsigned long id = (m_db ? mysql_thread_id(m_db) : 0);
+			if (id == 0)
+				return false;
+
+			try
+			{
+				mysql_connection killer(m_url_ptr, m_timeout);
+				return killer.execute("KILL QUERY %lu", id);
+			}
+			catch (std::exception &)
+			{
+			}
+			return false;
 		}
 
 
@@ -370,12 +509,77 @@ namespace zdb2
 
 		// @}
 
+		/**
+		 * Returns the number of commands sent to the server by this connection,every command costs
+		 * one network round trip.
+		 */
+		uint64_t get_round_trips()
+		{
+			return m_round_trips.load();
+		}
+
+		void reset_round_trips()
+		{
+			m_round_trips = 0;
+		}
+
 	protected:
 		virtual bool _init() override
 		{
+			// by default the rows are read from the socket one by one when the ResultSet is iterated,
+			// if "store-result=true" all the rows are read into the client memory when query.
+			m_store_result = (m_url_ptr->get_param_value("store-result") == "true");
+
 			return _connect();
 		}
 
+		bool _simple_query(const char * sql)
+		{
+			_discard_results();
+			m_round_trips++;
+			return (mysql_util::MYSQL_OK == mysql_query(m_db, sql));
+		}
+
+		/**
+		 * read and free the results of all the statements of the last command.
+		 * @return false if any statement is failed
+		 */
+		bool _read_results()
+		{
+			int status = 0;
+			do
+			{
+				MYSQL_RES * res = mysql_store_result(m_db);
+				if (res)
+					mysql_free_result(res);
+				else if (mysql_field_count(m_db) != 0)
+					return false;
+
+				// 0 : more results, -1 : no more results, > 0 : error
+				status = mysql_next_result(m_db);
+			} while (status == 0);
+
+			return (status == -1);
+		}
+
+		/**
+		 * close the ResultSet returned by the last query and discard the pending results,the
+		 * connection can be used to send the next command after that.
+		 */
+		void _discard_results()
+		{
+			std::shared_ptr<resultset> rs = m_active_rs.lock();
+			if (rs)
+				rs->close();
+			m_active_rs.reset();
+
+			if (m_db && mysql_more_results(m_db))
+			{
+				if (mysql_next_result(m_db) == 0)
+					_read_results();
+			}
+		}
+
 		virtual bool _connect() override
 		{
 			unsigned long client_flags = CLIENT_MULTI_STATEMENTS;
@@ -453,6 +657,12 @@ namespace zdb2
 #if MYSQL_VERSION_ID >= 50013
 			mysql_options(m_db, MYSQL_OPT_RECONNECT, (const void*)&mysql_util::yes);
 #endif
+
+#if defined(MYSQL_WAIT_READ)
+			// enable the non-blocking api of MariaDB Connector/C,the blocking api can still be used
+			if (m_url_ptr->get_param_value("nonblocking") == "true")
+				mysql_options(m_db, MYSQL_OPT_NONBLOCK, 0);
+#endif
 			/* Connect */
 			if (mysql_real_connect(m_db, host.c_str(), user.c_str(), pass.c_str(), database.c_str(), (unsigned int)std::atoi(port.c_str()), unix_socket.c_str(), client_flags))
 				return true;
@@ -465,6 +675,19 @@ namespace zdb2
 	protected:
 
 		MYSQL * m_db = nullptr;
+
+		/// the ResultSet returned by the last query,it must be closed before the next command
+		std::weak_ptr<resultset> m_active_rs;
+
+		bool m_store_result = false;
+
+		std::atomic<uint64_t> m_round_trips{ 0 };
 	};
 
+	namespace
+	{
+		/// register the backend when this header is included
+		const registry::registrar _mysql_registrar("mysql", &registry::create<mysql_connection>);
+	}
+
 }
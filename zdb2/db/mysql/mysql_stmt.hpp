@@ -15,6 +15,7 @@
 #include <memory>
 #include <algorithm>
 #include <mutex>
+#include <atomic>
 
 #include <mysql.h>
 #include <errmsg.h>
@@ -31,10 +32,12 @@ namespace zdb2
 		mysql_stmt(
 			MYSQL * db,
 			const char * sql,
-			std::size_t timeout
+			std::size_t timeout,
+			std::atomic<uint64_t> * round_trips = nullptr
 		)
 			: stmt(sql, timeout)
 			, m_db(db)
+			, m_round_trips(round_trips)
 		{
 			if (!m_db)
 				throw std::runtime_error("invalid parameters.");
@@ -263,22 +266,27 @@ namespace zdb2
 		 */
 		virtual void execute() override
 		{
-			if (m_param_count > 0 && m_stmt && m_bind && m_params)
+			if (!m_stmt)
+				return;
+
+			// the param buffers are sent together with the COM_STMT_EXECUTE packet,so bind them is
+			// not a round trip.the cursor type is the default CURSOR_TYPE_NO_CURSOR already,and
+			// mysql_stmt_reset is only needed after mysql_stmt_send_long_data,so both are skipped.
+			if (m_param_count > 0 && m_bind && m_params)
 			{
 				if (mysql_util::MYSQL_OK != mysql_stmt_bind_param(m_stmt, m_bind))
 					throw std::runtime_error(mysql_stmt_error(m_stmt));
+			}
 
-#if MYSQL_VERSION_ID >= 50002
-				unsigned long cursor = CURSOR_TYPE_NO_CURSOR;
-				mysql_stmt_attr_set(m_stmt, STMT_ATTR_CURSOR_TYPE, &cursor);
-#endif
+			if (m_round_trips)
+				(*m_round_trips)++;
 
-				if ((mysql_util::MYSQL_OK != mysql_stmt_execute(m_stmt)))
-					throw std::runtime_error(mysql_stmt_error(m_stmt));
+			if ((mysql_util::MYSQL_OK != mysql_stmt_execute(m_stmt)))
+				throw std::runtime_error(mysql_stmt_error(m_stmt));
 
-				/* Discard prepared param data in client/server */
-				mysql_stmt_reset(m_stmt);
-			}
+			// discard the rows if the statement returns a result set,it is done in the client
+			if (mysql_stmt_field_count(m_stmt) > 0)
+				mysql_stmt_free_result(m_stmt);
 		}
 
 
@@ -311,6 +319,9 @@ namespace zdb2
 				m_stmt = mysql_stmt_init(m_db);
 				if (m_stmt)
 				{
+					if (m_round_trips)
+						(*m_round_trips)++;
+
 					if (mysql_util::MYSQL_OK == mysql_stmt_prepare(m_stmt, m_sql.c_str(), (unsigned long)m_sql.length()))
 					{
 						m_param_count = (int)mysql_stmt_param_count(m_stmt);
@@ -341,6 +352,9 @@ namespace zdb2
 		MYSQL_BIND * m_bind = nullptr;
 
 		mysql_util::param_t * m_params = nullptr;
+
+		/// the round trip counter of the connection which the statement belongs to
+		std::atomic<uint64_t> * m_round_trips = nullptr;
 	};
 
 }
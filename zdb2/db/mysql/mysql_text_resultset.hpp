@@ -0,0 +1,642 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cassert>
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <ctime>
+
+#include <mysql.h>
+#include <errmsg.h>
+
+#include <zdb2/db/resultset.hpp>
+#include <zdb2/db/mysql/mysql_util.hpp>
+
+namespace zdb2
+{
+
+#pragma warning(disable:4996)
+
+	/**
+	 * ResultSet of the text protocol (mysql_real_query),the rows are read by mysql_use_result
+	 * one by one from the socket,or by mysql_store_result into the client memory at once.
+	 * When mysql_use_result is used,the connection can't be used to send any other commands
+	 * until all the rows are read or the ResultSet is closed.
+	 */
+	class mysql_text_resultset : public resultset
+	{
+	public:
+		/**
+		 * @param db The connection of mysql_use_result,the fetch error is read from it,nullptr
+		 * for mysql_store_result
+		 */
+		mysql_text_resultset(
+			MYSQL_RES * res,
+			std::size_t timeout = zdb2::DEFAULT_TIMEOUT,
+			MYSQL * db = nullptr
+		)
+			: resultset(timeout)
+			, m_res(res)
+			, m_db(db)
+		{
+			assert(m_res);
+			if (!m_res)
+				throw std::runtime_error("invalid parameters.");
+
+			_init();
+		}
+
+		virtual ~mysql_text_resultset()
+		{
+			close();
+		}
+
+		virtual void close() override
+		{
+			if (m_res)
+			{
+				// for mysql_use_result,this will read and discard the remaining rows
+				mysql_free_result(m_res);
+				m_res = nullptr;
+			}
+			m_db = nullptr;
+			m_row = nullptr;
+			m_lengths = nullptr;
+		}
+
+		/**
+		 * Returns the number of columns in this ResultSet object.
+		 * @param R A ResultSet object
+		 * @return The number of columns
+		 */
+		virtual int get_column_count() override
+		{
+			return m_column_count;
+		}
+
+
+		/**
+		 * Get the designated column's name.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return Column name or NULL if the column does not exist. You
+		 * should use the method ResultSet_getColumnCount() to test for
+		 * the availability of columns in the result set.
+		 */
+		virtual const char * get_column_name(int column_index) override
+		{
+			if (!m_res || column_index < 0 || column_index >= m_column_count)
+				return nullptr;
+			MYSQL_FIELD * field = mysql_fetch_field_direct(m_res, (unsigned int)column_index);
+			return (field ? field->name : nullptr);
+		}
+
+		/**
+		 * @function : get column index by column name
+		 */
+		virtual int get_column_index(const char * column_name) override
+		{
+			auto iterator = m_column_name_map.find(column_name);
+			if (iterator != m_column_name_map.end())
+				return iterator->second;
+			return -1;
+		}
+
+		/**
+		 * Returns column size in bytes. If the column is a blob then
+		 * this method returns the number of bytes in that blob. No type
+		 * conversions occur. If the result is a string (or a number
+		 * since a number can be converted into a string) then return the
+		 * number of bytes in the resulting string.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return Column data size
+		 * @exception SQLException If columnIndex is outside the valid range
+		 * @see SQLException.h
+		 */
+		virtual std::size_t get_column_size(int column_index) override
+		{
+			if (!_is_valid(column_index) || !m_row[column_index])
+				return 0;
+			return (std::size_t)m_lengths[column_index];
+		}
+
+		//@}
+
+		/**
+		 * Moves the cursor down one row from its current position. A
+		 * ResultSet cursor is initially positioned before the first row; the
+		 * first call to this method makes the first row the current row; the
+		 * second call makes the second row the current row, and so on. When
+		 * there are not more available rows false is returned. An empty
+		 * ResultSet will return false on the first call to ResultSet_next().
+		 * @param R A ResultSet object
+		 * @return true if the new current row is valid; false if there are no
+		 * more rows
+		 * @exception SQLException If a database access error occurs
+		 */
+		virtual bool next_row() override
+		{
+			if (!m_res)
+				return false;
+
+			m_row = mysql_fetch_row(m_res);
+			if (!m_row)
+			{
+				m_lengths = nullptr;
+
+				// the rows of mysql_use_result are read from the socket,a NULL is returned when the
+				// connection is lost or the query is killed too,it's not the end of the rows
+				if (m_db && mysql_errno(m_db) != 0)
+					throw std::runtime_error(mysql_error(m_db));
+				return false;
+			}
+
+			m_lengths = mysql_fetch_lengths(m_res);
+			return true;
+		}
+
+		/** @name Columns */
+		//@{
+
+		/**
+		 * Returns true if the value of the designated column in the current row of
+		 * this ResultSet object is SQL NULL, otherwise false. If the column value is
+		 * SQL NULL, a Result Set returns the NULL pointer for string and blob values
+		 * and 0 for primitive data types. Use this method if you need to differ
+		 * between SQL NULL and the value NULL/0.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return True if column value is SQL NULL, otherwise false
+		 * @exception SQLException If a database access error occurs or
+		 * columnIndex is outside the valid range
+		 * @see SQLException.h
+		 */
+		virtual bool is_null(int column_index) override
+		{
+			return (!_is_valid(column_index) || !m_row[column_index]);
+		}
+
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a C-string. If <code>columnIndex</code>
+		 * is outside the range [1..ResultSet_getColumnCount()] this
+		 * method throws an SQLException. <i>The returned string may only be
+		 * valid until the next call to ResultSet_next() and if you plan to use
+		 * the returned value longer, you must make a copy.</i>
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is NULL
+		 * @exception SQLException If a database access error occurs or
+		 * columnIndex is outside the valid range
+		 * @see SQLException.h
+		 */
+		virtual const char * get_string(int column_index) override
+		{
+			// the text protocol values are always terminated by '\0'
+			return (_is_valid(column_index) ? m_row[column_index] : nullptr);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a C-string. If <code>columnName</code>
+		 * is not found this method throws an SQLException. <i>The returned string
+		 * may only be valid until the next call to ResultSet_next() and if you plan
+		 * to use the returned value longer, you must make a copy.</i>
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is NULL
+		 * @exception SQLException If a database access error occurs or
+		 * columnName does not exist
+		 * @see SQLException.h
+		 */
+		virtual const char * get_string(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_string(col_index) : nullptr);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of this
+		 * ResultSet object as an int. If <code>columnIndex</code> is outside the
+		 * range [1..ResultSet_getColumnCount()] this method throws an SQLException.
+		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
+		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
+		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
+		 * architecture and equal to <code>long long</code> on 64 bits architecture.
+		 * However, the width of integer types are architecture and compiler dependent.
+		 * The above is usually true, but not necessarily.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0
+		 * @exception SQLException If a database access error occurs, columnIndex
+		 * is outside the valid range or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual int get_int(int column_index) override
+		{
+			auto s = get_string(column_index);
+			return (s ? std::atoi(s) : -1);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as an int. If <code>columnName</code> is
+		 * not found this method throws an SQLException.
+		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
+		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
+		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
+		 * architecture and equal to <code>long long</code> on 64 bits architecture.
+		 * However, the width of integer types are architecture and compiler dependent.
+		 * The above is usually true, but not necessarily.
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0
+		 * @exception SQLException If a database access error occurs, columnName
+		 * does not exist or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual int get_int(const char * column_name) override
+		{
+			auto s = get_string(column_name);
+			return (s ? std::atoi(s) : -1);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a long long. If <code>columnIndex</code>
+		 * is outside the range [1..ResultSet_getColumnCount()] this
+		 * method throws an SQLException.
+		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
+		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
+		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
+		 * architecture and equal to <code>long long</code> on 64 bits architecture.
+		 * However, the width of integer types are architecture and compiler dependent.
+		 * The above is usually true, but not necessarily.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0
+		 * @exception SQLException If a database access error occurs,
+		 * columnIndex is outside the valid range or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual int64_t get_int64(int column_index) override
+		{
+			auto s = get_string(column_index);
+			return (s ? (int64_t)std::atoll(s) : -1);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a long long. If <code>columnName</code>
+		 * is not found this method throws an SQLException.
+		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
+		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
+		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
+		 * architecture and equal to <code>long long</code> on 64 bits architecture.
+		 * However, the width of integer types are architecture and compiler dependent.
+		 * The above is usually true, but not necessarily.
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0
+		 * @exception SQLException If a database access error occurs, columnName
+		 * does not exist or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual int64_t get_int64(const char * column_name) override
+		{
+			auto s = get_string(column_name);
+			return (s ? (int64_t)std::atoll(s) : -1);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a double. If <code>columnIndex</code>
+		 * is outside the range [1..ResultSet_getColumnCount()] this
+		 * method throws an SQLException.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0.0
+		 * @exception SQLException If a database access error occurs, columnIndex
+		 * is outside the valid range or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual double get_double(int column_index) override
+		{
+			auto s = get_string(column_index);
+			return (s ? std::atof(s) : -1.f);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a double. If <code>columnName</code> is
+		 * not found this method throws an SQLException.
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0.0
+		 * @exception SQLException If a database access error occurs, columnName
+		 * does not exist or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual double get_double(const char * column_name) override
+		{
+			auto s = get_string(column_name);
+			return (s ? std::atof(s) : -1.f);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a void pointer. If <code>columnIndex</code>
+		 * is outside the range [1..ResultSet_getColumnCount()] this method
+		 * throws an SQLException. <i>The returned blob may only be valid until
+		 * the next call to ResultSet_next() and if you plan to use the returned
+		 * value longer, you must make a copy.</i>
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @param size The number of bytes in the blob is stored in size
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is NULL
+		 * @exception SQLException If a database access error occurs or
+		 * columnIndex is outside the valid range
+		 * @see SQLException.h
+		 */
+		virtual const void * get_blob(int column_index, std::size_t * size) override
+		{
+			if (!_is_valid(column_index) || !m_row[column_index])
+			{
+				if (size)
+					*size = 0;
+				return nullptr;
+			}
+			if (size)
+				*size = (std::size_t)m_lengths[column_index];
+			return (const void *)m_row[column_index];
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a void pointer. If <code>columnName</code>
+		 * is not found this method throws an SQLException. <i>The returned
+		 * blob may only be valid until the next call to ResultSet_next() and if
+		 * you plan to use the returned value longer, you must make a copy.</i>
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @param size The number of bytes in the blob is stored in size
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is NULL
+		 * @exception SQLException If a database access error occurs or
+		 * columnName does not exist
+		 * @see SQLException.h
+		 */
+		virtual const void * get_blob(const char * column_name, std::size_t * size) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_blob(col_index, size) : nullptr);
+		}
+
+		//@}
+
+		/** @name Date and Time  */
+		//@{
+
+		/**
+		 * Retrieves the value of the designated column in the current row of this
+		 * ResultSet object as a Unix timestamp. The returned value is in Coordinated
+		 * Universal Time (UTC) and represent seconds since the <strong>epoch</strong>
+		 * (January 1, 1970, 00:00:00 GMT).
+		 *
+		 * Even though the underlying database might support timestamp ranges before
+		 * the epoch and after '2038-01-19 03:14:07 UTC' it is safest not to assume or
+		 * use values outside this range. Especially on a 32-bits system.
+		 *
+		 * <i class="textinfo">SQLite</i> does not have temporal SQL data types per se
+		 * and using this method with SQLite assume the column value in the Result Set
+		 * to be either a numerical value representing a Unix Time in UTC which is
+		 * returned as-is or an <a href="http://en.wikipedia.org/wiki/ISO_8601">ISO 8601</a>
+		 * time string which is converted to a time_t value.
+		 * See also PreparedStatement_setTimestamp()
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return The column value as seconds since the epoch in the
+		 * <i class="textinfo">GMT timezone</i>. If the value is SQL NULL, the
+		 * value returned is 0, i.e. January 1, 1970, 00:00:00 GMT
+		 * @exception SQLException If a database access error occurs, if
+		 * <code>columnIndex</code> is outside the range [1..ResultSet_getColumnCount()]
+		 * or if the column value cannot be converted to a valid timestamp
+		 * @see SQLException.h PreparedStatement_setTimestamp
+		 */
+		virtual time_t get_timestamp(int column_index) override
+		{
+			struct tm tm = get_datetime(column_index);
+			if (tm.tm_year == 0)
+				return (time_t)0;
+			tm.tm_year -= 1900;
+			return (time_t)_timegm(&tm);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of this
+		 * ResultSet object as a Unix timestamp. The returned value is in Coordinated
+		 * Universal Time (UTC) and represent seconds since the <strong>epoch</strong>
+		 * (January 1, 1970, 00:00:00 GMT).
+		 *
+		 * Even though the underlying database might support timestamp ranges before
+		 * the epoch and after '2038-01-19 03:14:07 UTC' it is safest not to assume or
+		 * use values outside this range. Especially on a 32-bits system.
+		 *
+		 * <i class="textinfo">SQLite</i> does not have temporal SQL data types per se
+		 * and using this method with SQLite assume the column value in the Result Set
+		 * to be either a numerical value representing a Unix Time in UTC which is
+		 * returned as-is or an <a href="http://en.wikipedia.org/wiki/ISO_8601">ISO 8601</a>
+		 * time string which is converted to a time_t value.
+		 * See also PreparedStatement_setTimestamp()
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return The column value as seconds since the epoch in the
+		 * <i class="textinfo">GMT timezone</i>. If the value is SQL NULL, the
+		 * value returned is 0, i.e. January 1, 1970, 00:00:00 GMT
+		 * @exception SQLException If a database access error occurs, if
+		 * <code>columnName</code> is not found or if the column value cannot be
+		 * converted to a valid timestamp
+		 * @see SQLException.h PreparedStatement_setTimestamp
+		 */
+		virtual time_t get_timestamp(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_timestamp(col_index) : (time_t)0);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of this
+		 * ResultSet object as a Date, Time or DateTime. This method can be used to
+		 * retrieve the value of columns with the SQL data type, Date, Time, DateTime
+		 * or Timestamp. The returned <code>tm</code> structure follows the convention
+		 * for usage with mktime(3) where, tm_hour = hours since midnight [0-23],
+		 * tm_min = minutes after the hour [0-59], tm_sec = seconds after the minute
+		 * [0-60], tm_mday = day of the month [1-31] and tm_mon = months since January
+		 * <b class="textnote">[0-11]</b>. If the column value contains timezone
+		 * information, tm_gmtoff is set to the offset from UTC in seconds, otherwise
+		 * tm_gmtoff is set to 0. <i>On systems without tm_gmtoff, (Solaris), the
+		 * member, tm_wday is set to gmt offset instead as this property is ignored
+		 * by mktime on input.</i> The exception to the above is <b class="textnote">tm_year</b>
+		 * which contains the year literal and <i>not years since 1900</i> which is the
+		 * convention. All other fields in the structure are set to zero. If the
+		 * column type is DateTime or Timestamp all the fields mentioned above are
+		 * set, if it is a Date or Time, only the relevant fields are set.
+		 *
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return A tm structure with fields for date and time. If the value
+		 * is SQL NULL, a zeroed tm structure is returned
+		 * @exception SQLException If a database access error occurs, if
+		 * <code>columnIndex</code> is outside the range [1..ResultSet_getColumnCount()]
+		 * or if the column value cannot be converted to a valid SQL Date, Time or
+		 * DateTime type
+		 * @see SQLException.h
+		 */
+		virtual tm get_datetime(int column_index) override
+		{
+			struct tm tm = { 0 };
+			auto s = get_string(column_index);
+			if (!s)
+				return tm;
+
+			// the text protocol format of DATE,DATETIME and TIMESTAMP is "YYYY-MM-DD hh:mm:ss"
+			int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+			int n = std::sscanf(s, "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second);
+			if (n >= 3)
+			{
+				tm.tm_year = year; // Use year literal
+				tm.tm_mon = month - 1;
+				tm.tm_mday = day;
+				tm.tm_hour = hour;
+				tm.tm_min = minute;
+				tm.tm_sec = second;
+			}
+			else if (std::sscanf(s, "%d:%d:%d", &hour, &minute, &second) == 3)
+			{
+				tm.tm_hour = hour;
+				tm.tm_min = minute;
+				tm.tm_sec = second;
+			}
+			return tm;
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of this
+		 * ResultSet object as a Date, Time or DateTime. This method can be used to
+		 * retrieve the value of columns with the SQL data type, Date, Time, DateTime
+		 * or Timestamp. The returned <code>tm</code> structure follows the convention
+		 * for usage with mktime(3) where, tm_hour = hours since midnight [0-23],
+		 * tm_min = minutes after the hour [0-59], tm_sec = seconds after the minute
+		 * [0-60], tm_mday = day of the month [1-31] and tm_mon = months since January
+		 * <b class="textnote">[0-11]</b>. If the column value contains timezone
+		 * information, tm_gmtoff is set to the offset from UTC in seconds, otherwise
+		 * tm_gmtoff is set to 0. <i>On systems without tm_gmtoff, (Solaris), the
+		 * member, tm_wday is set to gmt offset instead as this property is ignored
+		 * by mktime on input.</i> The exception to the above is <b class="textnote">tm_year</b>
+		 * which contains the year literal and <i>not years since 1900</i> which is the
+		 * convention. All other fields in the structure are set to zero. If the
+		 * column type is DateTime or Timestamp all the fields mentioned above are
+		 * set, if it is a Date or Time, only the relevant fields are set.
+		 *
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return A tm structure with fields for date and time. If the value
+		 * is SQL NULL, a zeroed tm structure is returned
+		 * @exception SQLException If a database access error occurs, if
+		 * <code>columnName</code> is not found or if the column value cannot be
+		 * converted to a valid SQL Date, Time or DateTime type
+		 * @see SQLException.h
+		 */
+		virtual tm get_datetime(const char * column_name) override
+		{
+			struct tm tm = { 0 };
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_datetime(col_index) : tm);
+		}
+
+	protected:
+
+		bool _is_valid(int column_index)
+		{
+			return (m_res && m_row && column_index >= 0 && column_index < m_column_count);
+		}
+
+		static time_t _timegm(struct tm * tm)
+		{
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_)
+			return _mkgmtime(tm);
+#else
+			return timegm(tm);
+#endif
+		}
+
+		virtual void _init() override
+		{
+			if (m_res)
+			{
+				m_column_count = (int)mysql_num_fields(m_res);
+
+				for (int col = 0; col < m_column_count; col++)
+				{
+					const char * col_name = get_column_name(col);
+					m_column_name_map.emplace(std::string(col_name ? col_name : ""), col);
+				}
+			}
+		}
+
+	protected:
+
+		MYSQL_RES * m_res = nullptr;
+
+		/// the connection of mysql_use_result,nullptr for mysql_store_result
+		MYSQL * m_db = nullptr;
+
+		/// the current row and the lengths of it's values
+		MYSQL_ROW m_row = nullptr;
+		unsigned long * m_lengths = nullptr;
+
+		std::unordered_map<std::string, int> m_column_name_map;
+
+		int m_column_count = 0;
+
+	};
+
+}
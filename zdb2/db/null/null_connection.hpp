@@ -0,0 +1,219 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdio>
+#include <cstdarg>
+#include <string>
+#include <memory>
+
+#include <zdb2/config.hpp>
+#include <zdb2/net/url.hpp>
+#include <zdb2/db/connection.hpp>
+#include <zdb2/db/registry.hpp>
+
+#include <zdb2/db/null/null_util.hpp>
+#include <zdb2/db/null/null_stmt.hpp>
+#include <zdb2/db/null/null_resultset.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * The connection of the null backend,it doesn't connect to any database,every operation only
+	 * waits the simulated latency of the url,see null_util.It's used to measure the cost of the
+	 * pool and the instrumentation without the cost of a database,eg : bench/pool_bench.cpp
+	 *
+	 * null:///bench?latency_us=100
+	 */
+	class null_connection : public connection
+	{
+	public:
+		null_connection(
+			std::shared_ptr<url> url_ptr,
+			std::size_t timeout = zdb2::DEFAULT_TIMEOUT
+		)
+			: connection(url_ptr, timeout)
+		{
+			_init();
+		}
+
+		virtual ~null_connection()
+		{
+			close();
+		}
+
+		virtual bool ping() override
+		{
+			null_util::delay(m_settings.latency_us, m_settings.spin);
+			return true;
+		}
+
+		virtual void clear() override
+		{
+		}
+
+		virtual void close() override
+		{
+		}
+
+		virtual bool begin_transaction() override
+		{
+			return _transaction_begin([this]() { null_util::delay(m_settings.latency_us, m_settings.spin); return true; });
+		}
+
+		virtual bool commit() override
+		{
+			if (!is_intransaction())
+				return false;
+			return _transaction_end(&hooks::on_txn_commit,
+				[this]() { null_util::delay(m_settings.latency_us, m_settings.spin); return true; });
+		}
+
+		virtual bool rollback() override
+		{
+			if (!is_intransaction())
+				return false;
+			return _transaction_end(&hooks::on_txn_rollback,
+				[this]() { null_util::delay(m_settings.latency_us, m_settings.spin); return true; });
+		}
+
+		virtual int64_t last_rowid() override
+		{
+			return m_last_rowid;
+		}
+
+		virtual int64_t rows_changed() override
+		{
+			return m_rows_changed;
+		}
+
+		virtual bool execute(const char * sql, ...) override
+		{
+			if (!sql || sql[0] == '\0')
+				return false;
+
+			va_list ap, ap_copy;
+			va_start(ap, sql);
+
+			va_copy(ap_copy, ap);
+			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
+
+			std::string str(len, '\0');
+
+			va_copy(ap_copy, ap);
+			std::vsprintf((char*)str.data(), sql, ap_copy);
+
+			va_end(ap);
+
+			auto ctx = _statement_begin(str.c_str());
+
+			null_util::delay(m_settings.latency_us, m_settings.spin);
+			m_rows_changed = 1;
+			m_last_rowid++;
+
+			return _statement_execute(ctx, str.c_str(), true);
+		}
+
+		virtual std::shared_ptr<resultset> query(const char *sql, ...) override
+		{
+			if (!sql || sql[0] == '\0')
+				return nullptr;
+
+			va_list ap, ap_copy;
+			va_start(ap, sql);
+
+			va_copy(ap_copy, ap);
+			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
+
+			std::string str(len, '\0');
+
+			va_copy(ap_copy, ap);
+			std::vsprintf((char*)str.data(), sql, ap_copy);
+
+			va_end(ap);
+
+			auto ctx = _statement_begin(str.c_str());
+
+			null_util::delay(m_settings.latency_us, m_settings.spin);
+			m_rows_changed = 0;
+
+			return _statement_query(ctx, str.c_str(), std::make_shared<null_resultset>(m_settings.rows, m_timeout));
+		}
+
+		virtual std::shared_ptr<stmt> prepare_stmt(const char * sql, ...) override
+		{
+			if (!sql || sql[0] == '\0')
+				return nullptr;
+
+			va_list ap, ap_copy;
+			va_start(ap, sql);
+
+			va_copy(ap_copy, ap);
+			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
+
+			std::string str(len, '\0');
+
+			va_copy(ap_copy, ap);
+			std::vsprintf((char*)str.data(), sql, ap_copy);
+
+			va_end(ap);
+
+			return _statement_stmt(str.c_str(), std::make_shared<null_stmt>(str.c_str(), m_settings, m_timeout));
+		}
+
+		virtual const char * get_last_error() override
+		{
+			return "";
+		}
+
+		virtual bool is_supported(const char *url) override
+		{
+			return true;
+		}
+
+		/**
+		 * Get the settings parsed from the url.
+		 */
+		const null_util::settings & get_settings()
+		{
+			return m_settings;
+		}
+
+	protected:
+		virtual bool _init() override
+		{
+			m_settings = null_util::parse(m_url_ptr);
+			return _connect();
+		}
+
+		virtual bool _connect() override
+		{
+			null_util::delay(m_settings.connect_us, m_settings.spin);
+			return true;
+		}
+
+	protected:
+
+		null_util::settings m_settings;
+
+		int64_t m_rows_changed = 0;
+
+		int64_t m_last_rowid = 0;
+	};
+
+	namespace
+	{
+		/// register the backend when this header is included
+		const registry::registrar _null_registrar("null", &registry::create<null_connection>);
+	}
+
+}
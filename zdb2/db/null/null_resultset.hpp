@@ -0,0 +1,192 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <ctime>
+
+#include <zdb2/db/resultset.hpp>
+#include <zdb2/db/null/null_util.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * the ResultSet of the null backend,it has two columns "id" (1,2,3...) and "value" ("value1",
+	 * "value2"...),every next_row() costs nothing.
+	 */
+	class null_resultset : public resultset
+	{
+	public:
+		null_resultset(
+			std::size_t rows,
+			std::size_t timeout = zdb2::DEFAULT_TIMEOUT
+		)
+			: resultset(timeout)
+			, m_rows(rows)
+		{
+			_init();
+		}
+
+		virtual ~null_resultset()
+		{
+			close();
+		}
+
+		virtual void close() override
+		{
+			m_closed = true;
+		}
+
+		virtual int get_column_count() override
+		{
+			return 2;
+		}
+
+		virtual const char * get_column_name(int column_index) override
+		{
+			return (column_index == 0 ? "id" : (column_index == 1 ? "value" : nullptr));
+		}
+
+		virtual int get_column_index(const char * column_name) override
+		{
+			if (!column_name)
+				return -1;
+			if (std::strcmp(column_name, "id") == 0)
+				return 0;
+			if (std::strcmp(column_name, "value") == 0)
+				return 1;
+			return -1;
+		}
+
+		virtual std::size_t get_column_size(int column_index) override
+		{
+			const char * s = get_string(column_index);
+			return (s ? std::strlen(s) : 0);
+		}
+
+		virtual bool next_row() override
+		{
+			if (m_closed || m_row >= m_rows)
+				return false;
+
+			m_row++;
+			std::snprintf(m_id, sizeof(m_id), "%llu", (unsigned long long)m_row);
+			std::snprintf(m_value, sizeof(m_value), "value%llu", (unsigned long long)m_row);
+			return true;
+		}
+
+		virtual bool is_null(int column_index) override
+		{
+			return (get_string(column_index) == nullptr);
+		}
+
+		virtual const char * get_string(int column_index) override
+		{
+			if (m_row == 0)
+				return nullptr;
+			return (column_index == 0 ? m_id : (column_index == 1 ? m_value : nullptr));
+		}
+
+		virtual const char * get_string(const char * column_name) override
+		{
+			return get_string(get_column_index(column_name));
+		}
+
+		virtual int get_int(int column_index) override
+		{
+			return (int)get_int64(column_index);
+		}
+
+		virtual int get_int(const char * column_name) override
+		{
+			return get_int(get_column_index(column_name));
+		}
+
+		virtual int64_t get_int64(int column_index) override
+		{
+			return ((m_row > 0 && column_index == 0) ? (int64_t)m_row : 0);
+		}
+
+		virtual int64_t get_int64(const char * column_name) override
+		{
+			return get_int64(get_column_index(column_name));
+		}
+
+		virtual double get_double(int column_index) override
+		{
+			return (double)get_int64(column_index);
+		}
+
+		virtual double get_double(const char * column_name) override
+		{
+			return get_double(get_column_index(column_name));
+		}
+
+		virtual const void * get_blob(int column_index, std::size_t * size) override
+		{
+			const char * s = get_string(column_index);
+			if (size)
+				*size = (s ? std::strlen(s) : 0);
+			return s;
+		}
+
+		virtual const void * get_blob(const char * column_name, std::size_t * size) override
+		{
+			return get_blob(get_column_index(column_name), size);
+		}
+
+		virtual time_t get_timestamp(int column_index) override
+		{
+			return (time_t)get_int64(column_index);
+		}
+
+		virtual time_t get_timestamp(const char * column_name) override
+		{
+			return get_timestamp(get_column_index(column_name));
+		}
+
+		virtual tm get_datetime(int column_index) override
+		{
+			tm t;
+			std::memset(&t, 0, sizeof(t));
+			return t;
+		}
+
+		virtual tm get_datetime(const char * column_name) override
+		{
+			return get_datetime(get_column_index(column_name));
+		}
+
+	protected:
+		virtual void _init() override
+		{
+			m_id[0] = '\0';
+			m_value[0] = '\0';
+		}
+
+	protected:
+
+		std::size_t m_rows = 0;
+
+		/// the current row,0 means before the first row
+		std::size_t m_row = 0;
+
+		bool m_closed = false;
+
+		char m_id[24];
+		char m_value[32];
+	};
+
+}
@@ -0,0 +1,93 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+#include <zdb2/db/stmt.hpp>
+#include <zdb2/db/null/null_util.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * the PreparedStatement of the null backend,the parameters are checked and dropped,and
+	 * execute() only waits the simulated latency.
+	 */
+	class null_stmt : public stmt
+	{
+	public:
+		null_stmt(
+			const char * sql,
+			const null_util::settings & s,
+			std::size_t timeout
+		)
+			: stmt(sql, timeout)
+			, m_settings(s)
+		{
+			_init();
+		}
+
+		virtual ~null_stmt()
+		{
+			close();
+		}
+
+		virtual void close() override
+		{
+		}
+
+		virtual void set_string(int param_index, const char * x) override { _check(param_index); }
+
+		virtual void set_int(int param_index, int x) override { _check(param_index); }
+
+		virtual void set_int64(int param_index, int64_t x) override { _check(param_index); }
+
+		virtual void set_double(int param_index, double x) override { _check(param_index); }
+
+		virtual void set_blob(int param_index, const void * x, std::size_t size) override { _check(param_index); }
+
+		virtual void set_timestamp(int param_index, time_t x) override { _check(param_index); }
+
+		virtual void execute() override
+		{
+			null_util::delay(m_settings.latency_us, m_settings.spin);
+			m_rows_changed = 1;
+		}
+
+		virtual int64_t rows_changed() override
+		{
+			return m_rows_changed;
+		}
+
+	protected:
+		virtual void _init() override
+		{
+			m_param_count = (int)std::count(m_sql.begin(), m_sql.end(), '?');
+		}
+
+		void _check(int param_index)
+		{
+			if (param_index < 1 || param_index > m_param_count)
+				throw std::runtime_error("parameter index is out of range.");
+		}
+
+	protected:
+
+		null_util::settings m_settings;
+
+		int64_t m_rows_changed = 0;
+	};
+
+}
@@ -0,0 +1,87 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdlib>
+#include <string>
+#include <memory>
+#include <thread>
+#include <chrono>
+
+#include <zdb2/net/url.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * the settings of the null backend,they are read from the url params once when the
+	 * connection is created,eg :
+	 *
+	 * null:///bench?latency_us=200&connect_us=5000&rows=10&spin=true
+	 *
+	 * latency_us : the time of every statement,ping,begin/commit/rollback,default 0
+	 * connect_us : the time of opening a connection,default 0
+	 * rows       : the rows returned by query(),default 1
+	 * spin       : "true" to busy wait instead of sleeping,the sleep of the system may be much
+	 *              longer than a short latency,default false
+	 */
+	class null_util
+	{
+	public:
+
+		struct settings
+		{
+			std::size_t latency_us = 0;
+			std::size_t connect_us = 0;
+			std::size_t rows = 1;
+			bool spin = false;
+		};
+
+		static settings parse(std::shared_ptr<url> url_ptr)
+		{
+			settings s;
+			s.latency_us = _to_size(url_ptr->get_param_value("latency_us"), 0);
+			s.connect_us = _to_size(url_ptr->get_param_value("connect_us"), 0);
+			s.rows       = _to_size(url_ptr->get_param_value("rows"), 1);
+			s.spin       = (url_ptr->get_param_value("spin") == "true");
+			return s;
+		}
+
+		/**
+		 * simulate the time of a round trip to the database.
+		 */
+		static void delay(std::size_t us, bool spin)
+		{
+			if (us == 0)
+				return;
+
+			if (!spin)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(us));
+				return;
+			}
+
+			auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+			while (std::chrono::steady_clock::now() < end)
+			{
+			}
+		}
+
+	protected:
+
+		static std::size_t _to_size(const std::string & value, std::size_t default_value)
+		{
+			return (value.empty() ? default_value : (std::size_t)std::strtoull(value.c_str(), nullptr, 10));
+		}
+
+	};
+
+}
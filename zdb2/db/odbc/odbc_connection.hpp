@@ -0,0 +1,753 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cctype>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include <zdb2/config.hpp>
+#include <zdb2/net/url.hpp>
+#include <zdb2/db/connection.hpp>
+#include <zdb2/db/registry.hpp>
+
+#include <zdb2/db/odbc/odbc_util.hpp>
+#include <zdb2/db/odbc/odbc_stmt.hpp>
+#include <zdb2/db/odbc/odbc_resultset.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * ODBC connection,it is built against unixODBC on linux and the ODBC driver manager of
+	 * windows.The url :
+	 * odbc://localhost:1433/test?driver=FreeTDS&user=sa&password=swordfish
+	 * odbc:///dsn?user=root&password=swordfish             : the data source name of odbc.ini
+	 * odbc:///?driver=SQLite3&database=/var/sqlite/test.db : no data source name
+	 * The url params :
+	 * user,password         : the login user and password (UID and PWD)
+	 * driver                : the driver name of odbcinst.ini
+	 * login-timeout         : the login timeout in seconds
+	 * fetch-size            : the rows fetched by a SQLFetch call,default 64
+	 * paramset-size         : the max rows of params sent by a SQLExecute call,default 1024
+	 * query-timeout         : the query timeout in milliseconds,default 0 (no limit)
+	 * async=true            : execute the statements in the async mode of ODBC if the driver
+	 *                         supports it,the statements are polled and canceled by SQLCancel
+	 *                         when the query timeout is exceeded
+	 * All the other params are passed to the driver in the connection string,eg : "database",
+	 * "encrypt".
+	 */
+	class odbc_connection : public connection
+	{
+	public:
+		odbc_connection(
+			std::shared_ptr<url> url_ptr,
+			std::size_t timeout = zdb2::DEFAULT_TIMEOUT
+		)
+			: odbc_connection(url_ptr, timeout, true)
+		{
+		}
+
+		virtual ~odbc_connection()
+		{
+			close();
+		}
+
+		/**
+		 * Ping the database server and returns true if this Connection is
+		 * alive, otherwise false in which case the Connection should be closed.
+		 * @param C A Connection object
+		 * @return true if Connection is connected to a database server
+		 * otherwise false
+		 */
+		virtual bool ping() override
+		{
+			if (!m_hdbc)
+				return false;
+
+			// the attribute of ODBC 3.8,it doesn't cost a round trip
+			SQLUINTEGER dead = SQL_CD_FALSE;
+			if (odbc_util::is_ok(SQLGetConnectAttr(m_hdbc, SQL_ATTR_CONNECTION_DEAD, &dead, 0, nullptr)) && dead == SQL_CD_TRUE)
+				return false;
+
+			std::string name(m_dbms_name);
+			std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+			return _execute_sql(name.find("oracle") != std::string::npos ? "SELECT 1 FROM DUAL" : "SELECT 1");
+		}
+
+
+		/**
+		 * Close any ResultSet and PreparedStatements in the Connection.
+		 * Normally it is not necessary to call this method, but for some
+		 * implementation (SQLite) it <i>may, in some situations,</i> be
+		 * necessary to call this method if a execution sequence error occurs.
+		 * @param C A Connection object
+		 */
+		virtual void clear() override
+		{
+			m_session_ptr->close_active();
+		}
+
+
+		/**
+		 * Return connection to the connection pool. The same as calling
+		 * ConnectionPool_returnConnection() on a connection.
+		 * @param C A Connection object
+		 */
+		virtual void close() override
+		{
+			if (m_hdbc)
+			{
+				m_session_ptr->close_active();
+
+				if (m_exec_stmt)
+				{
+					SQLFreeHandle(SQL_HANDLE_STMT, m_exec_stmt);
+					m_exec_stmt = nullptr;
+				}
+
+				// the disconnect is failed when a transaction is in progress
+				if (is_intransaction())
+				{
+					SQLEndTran(SQL_HANDLE_DBC, m_hdbc, SQL_ROLLBACK);
+					connection::rollback();
+				}
+
+				m_session_ptr->dbc = nullptr;
+
+				SQLDisconnect(m_hdbc);
+				SQLFreeHandle(SQL_HANDLE_DBC, m_hdbc);
+				m_hdbc = nullptr;
+			}
+			if (m_henv)
+			{
+				SQLFreeHandle(SQL_HANDLE_ENV, m_henv);
+				m_henv = nullptr;
+			}
+		}
+
+
+		/**
+		 * Start a transaction.
+		 * @param C A Connection object
+		 * @exception SQLException If a database error occurs
+		 * @see SQLException.h
+		 */
+		virtual bool begin_transaction() override
+		{
+			if (!m_hdbc)
+				return false;
+
+			m_session_ptr->close_active();
+
+			// the statements of ODBC are committed by the driver unless the auto commit is off
+			return _transaction_begin([this]() { return _set_autocommit(false); });
+		}
+
+
+		/**
+		 * Makes all changes made since the previous commit/rollback permanent
+		 * and releases any database locks currently held by this Connection
+		 * object.
+		 * @param C A Connection object
+		 * @exception SQLException If a database error occurs
+		 * @see SQLException.h
+		 */
+		virtual bool commit() override
+		{
+			if (is_intransaction())
+				return _transaction_end(&hooks::on_txn_commit, [this]() { return _end_transaction(SQL_COMMIT); });
+			return false;
+		}
+
+
+		/**
+		 * Undoes all changes made in the current transaction and releases any
+		 * database locks currently held by this Connection object. This method
+		 * will first call Connection_clear() before performing the rollback to
+		 * clear any statements in progress such as selects.
+		 * @param C A Connection object
+		 * @exception SQLException If a database error occurs
+		 * @see SQLException.h
+		 */
+		virtual bool rollback() override
+		{
+			if (is_intransaction())
+				return _transaction_end(&hooks::on_txn_rollback, [this]() { return _end_transaction(SQL_ROLLBACK); });
+			return false;
+		}
+
+
+		/**
+		 * Returns the value for the most recent INSERT statement into a
+		 * table with an AUTO_INCREMENT or INTEGER PRIMARY KEY column.
+		 * @param C A Connection object
+		 * @return The value of the rowid from the last insert statement
+		 */
+		virtual int64_t last_rowid() override
+		{
+			// ODBC has no api for it,the statement is selected by the DBMS name
+			const char * sql = odbc_util::last_rowid_sql(m_dbms_name);
+			if (!sql)
+				return 0;
+
+			int64_t rows_changed = m_rows_changed;
+			std::shared_ptr<resultset> rs = query("%s", sql);
+			m_rows_changed = rows_changed;
+
+			return ((rs && rs->next_row()) ? rs->get_int64(0) : 0);
+		}
+
+
+		/**
+		 * Returns the number of rows that was inserted, deleted or modified
+		 * by the last Connection_execute() statement. If used with a
+		 * transaction, this method should be called <i>before</i> commit is
+		 * executed, otherwise 0 is returned.
+		 * @param C A Connection object
+		 * @return The number of rows changed by the last (DIM) SQL statement
+		 */
+		virtual int64_t rows_changed() override
+		{
+			return m_rows_changed;
+		}
+
+
+		/**
+		 * Executes the given SQL statement, which may be an INSERT, UPDATE,
+		 * or DELETE statement or an SQL statement that returns nothing, such
+		 * as an SQL DDL statement. Several SQL statements can be used in the
+		 * sql parameter string, each separated with the <i>;</i> SQL
+		 * statement separator character. <b>Note</b>, calling this method
+		 * clears any previous ResultSets associated with the Connection.
+		 * @param C A Connection object
+		 * @param sql A SQL statement
+		 * @exception SQLException If a database error occurs.
+		 * @see SQLException.h
+		 */
+		virtual bool execute(const char * sql, ...) override
+		{
+			if (!m_hdbc || !sql || sql[0] == '\0')
+				return false;
+
+			va_list ap, ap_copy;
+			va_start(ap, sql);
+
+			va_copy(ap_copy, ap);
+			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
+
+			std::string str(len, '\0');
+
+			va_copy(ap_copy, ap);
+			std::vsprintf((char*)str.data(), sql, ap_copy);
+
+			va_end(ap);
+
+			auto ctx = _statement_begin(str.c_str());
+
+			return _statement_execute(ctx, str.c_str(), _execute_sql(str.c_str()));
+		}
+
+		/**
+		 * Executes the given SQL statement, which returns a single ResultSet
+		 * object. You may <b>only</b> use one SQL statement with this method.
+		 * This is different from the behavior of Connection_execute() which
+		 * executes all SQL statements in its input string. If the sql
+		 * parameter string contains more than one SQL statement, only the
+		 * first statement is executed, the others are silently ignored.
+		 * A ResultSet "lives" only until the next call to
+		 * Connection_executeQuery(), Connection_execute() or until the
+		 * Connection is returned to the Connection Pool. <i>This means that
+		 * Result Sets cannot be saved between queries</i>.
+		 * @param C A Connection object
+		 * @param sql A SQL statement
+		 * @return A ResultSet object that contains the data produced by the
+		 * given query.
+		 * @exception SQLException If a database error occurs.
+		 * @see ResultSet.h
+		 * @see SQLException.h
+		 */
+		virtual std::shared_ptr<resultset> query(const char *sql, ...) override
+		{
+			if (!m_hdbc || !sql || sql[0] == '\0')
+				return nullptr;
+
+			va_list ap, ap_copy;
+			va_start(ap, sql);
+
+			va_copy(ap_copy, ap);
+			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
+
+			std::string str(len, '\0');
+
+			va_copy(ap_copy, ap);
+			std::vsprintf((char*)str.data(), sql, ap_copy);
+
+			va_end(ap);
+
+			auto ctx = _statement_begin(str.c_str());
+
+			m_session_ptr->close_active();
+
+			// the ResultSet owns the statement handle
+			SQLHSTMT stmt = _alloc_stmt();
+			if (!stmt)
+				return _statement_query(ctx, str.c_str(), nullptr);
+
+			SQLRETURN status;
+			{
+				odbc_util::session::executing_guard g(*m_session_ptr, stmt);
+				status = odbc_util::execute(stmt, m_session_ptr->query_timeout, SQLExecDirect, stmt, (SQLCHAR *)str.c_str(), (SQLINTEGER)SQL_NTS);
+			}
+			if (!odbc_util::is_ok(status) && status != SQL_NO_DATA)
+			{
+				m_error = odbc_util::get_error(SQL_HANDLE_STMT, stmt);
+				SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+				return _statement_query(ctx, str.c_str(), nullptr);
+			}
+
+			SQLSMALLINT cols = 0;
+			if (status == SQL_NO_DATA || !odbc_util::is_ok(SQLNumResultCols(stmt, &cols)) || cols == 0)
+			{
+				SQLLEN rows = 0;
+				if (odbc_util::is_ok(SQLRowCount(stmt, &rows)) && rows >= 0)
+					m_rows_changed = (int64_t)rows;
+				SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+				return _statement_query(ctx, str.c_str(), nullptr);
+			}
+
+			try
+			{
+				std::shared_ptr<resultset> rs = std::make_shared<odbc_resultset>(stmt, m_session_ptr, m_timeout);
+				m_session_ptr->active_rs = rs;
+				return _statement_query(ctx, str.c_str(), rs);
+			}
+			catch (std::exception & e)
+			{
+				m_error = e.what();
+				SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+			}
+			return _statement_query(ctx, str.c_str(), nullptr);
+		}
+
+		/**
+		 * Creates a PreparedStatement object for sending parameterized SQL
+		 * statements to the database. The <code>sql</code> parameter may
+		 * contain IN parameter placeholders. An IN placeholder is specified
+		 * with a '?' character in the sql string. The placeholders are
+		 * then replaced with actual values by using the PreparedStatement's
+		 * setXXX methods. Only <i>one</i> SQL statement may be used in the sql
+		 * parameter, this in difference to Connection_execute() which may
+		 * take several statements. A PreparedStatement "lives" until the
+		 * Connection is returned to the Connection Pool.
+		 * @param C A Connection object
+		 * @param sql A single SQL statement that may contain one or more '?'
+		 * IN parameter placeholders
+		 * @return A new PreparedStatement object containing the pre-compiled
+		 * SQL statement.
+		 * @exception SQLException If a database error occurs.
+		 * @see PreparedStatement.h
+		 * @see SQLException.h
+		 */
+		virtual std::shared_ptr<stmt> prepare_stmt(const char * sql, ...) override
+		{
+			if (!m_hdbc || !sql || sql[0] == '\0')
+				return nullptr;
+
+			va_list ap, ap_copy;
+			va_start(ap, sql);
+
+			va_copy(ap_copy, ap);
+			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
+
+			std::string str(len, '\0');
+
+			va_copy(ap_copy, ap);
+			std::vsprintf((char*)str.data(), sql, ap_copy);
+
+			va_end(ap);
+
+			try
+			{
+				return _statement_stmt(str.c_str(), std::dynamic_pointer_cast<stmt>(std::make_shared<odbc_stmt>(m_session_ptr, str.c_str(), m_timeout)));
+			}
+			catch (std::exception & e)
+			{
+				m_error = e.what();
+			}
+			return nullptr;
+		}
+
+
+		/**
+		 * Cancel the statement which is executing on this connection by SQLCancel,see
+		 * connection::cancel().
+		 */
+		virtual bool cancel() override
+		{
+			return m_session_ptr->cancel();
+		}
+
+
+		/**
+		 * This method can be used to obtain a string describing the last
+		 * error that occurred. Inside a CATCH-block you can also find
+		 * the error message directly in the variable Exception_frame.message.
+		 * It is recommended to use this variable instead since it contains both
+		 * SQL errors and API errors such as parameter index out of range etc,
+		 * while Connection_getLastError() might only show SQL errors
+		 * @param C A Connection object
+		 * @return A string explaining the last error
+		 */
+		virtual const char * get_last_error() override
+		{
+			return m_error.c_str();
+		}
+
+
+		/**
+		 * Returns the DBMS name reported by the driver,eg : "Microsoft SQL Server","SQLite".
+		 */
+		const char * get_dbms_name()
+		{
+			return m_dbms_name.c_str();
+		}
+
+
+		/** @name Class methods */
+		//@{
+
+		/**
+		 * <b>Class method</b>, test if the specified database system is
+		 * supported by this library. Clients may pass a full Connection URL,
+		 * for example using URL_toString(), or for convenience only the protocol
+		 * part of the URL. E.g. "mysql" or "sqlite".
+		 * @param url A database url string
+		 * @return true if supported otherwise false
+		 */
+		virtual bool is_supported(const char *url) override
+		{
+			return (url && std::strncmp(url, "odbc", 4) == 0);
+		}
+
+		// @}
+
+	protected:
+		/**
+		 * the derived classes must call _init() in their constructor,the virtual functions
+		 * can't be called in the constructor of the base class.
+		 */
+		odbc_connection(
+			std::shared_ptr<url> url_ptr,
+			std::size_t timeout,
+			bool init
+		)
+			: connection(url_ptr, timeout)
+		{
+			if (init)
+				_init();
+		}
+
+		virtual bool _init() override
+		{
+			m_session_ptr = std::make_shared<odbc_util::session>();
+
+			std::string fetch_size = m_url_ptr->get_param_value("fetch-size");
+			if (!fetch_size.empty() && std::atoi(fetch_size.c_str()) > 0)
+				m_session_ptr->row_array_size = (std::size_t)std::atoi(fetch_size.c_str());
+
+			std::string paramset_size = m_url_ptr->get_param_value("paramset-size");
+			if (!paramset_size.empty() && std::atoi(paramset_size.c_str()) > 0)
+				m_session_ptr->paramset_size = (std::size_t)std::atoi(paramset_size.c_str());
+
+			std::string query_timeout = m_url_ptr->get_param_value("query-timeout");
+			if (!query_timeout.empty() && std::atoi(query_timeout.c_str()) > 0)
+				m_session_ptr->query_timeout = (std::size_t)std::atoi(query_timeout.c_str());
+
+			return _connect();
+		}
+
+		virtual bool _connect() override
+		{
+			close();
+
+			// the statements of the previous connection can't be used anymore
+			if (m_session_ptr.use_count() > 1)
+			{
+				std::shared_ptr<odbc_util::session> session_ptr = std::make_shared<odbc_util::session>();
+				session_ptr->async = m_session_ptr->async;
+				session_ptr->query_timeout = m_session_ptr->query_timeout;
+				session_ptr->row_array_size = m_session_ptr->row_array_size;
+				session_ptr->paramset_size = m_session_ptr->paramset_size;
+				m_session_ptr = session_ptr;
+			}
+
+			if (!odbc_util::is_ok(SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &m_henv)))
+			{
+				m_henv = nullptr;
+				m_error = "failed to allocate the odbc environment handle.";
+				return false;
+			}
+			SQLSetEnvAttr(m_henv, SQL_ATTR_ODBC_VERSION, (SQLPOINTER)SQL_OV_ODBC3, 0);
+
+			if (!odbc_util::is_ok(SQLAllocHandle(SQL_HANDLE_DBC, m_henv, &m_hdbc)))
+			{
+				m_hdbc = nullptr;
+				m_error = odbc_util::get_error(SQL_HANDLE_ENV, m_henv);
+				close();
+				return false;
+			}
+
+			std::string timeout = m_url_ptr->get_param_value("login-timeout");
+			SQLULEN login_timeout = (SQLULEN)((timeout.empty() || std::atoi(timeout.c_str()) <= 0) ?
+				zdb2::DEFAULT_TCP_TIMEOUT : std::atoi(timeout.c_str()));
+			SQLSetConnectAttr(m_hdbc, SQL_ATTR_LOGIN_TIMEOUT, (SQLPOINTER)login_timeout, 0);
+
+			std::string connection_string = _connection_string();
+
+			SQLRETURN status = SQLDriverConnect(m_hdbc, nullptr, (SQLCHAR *)connection_string.c_str(), SQL_NTS,
+				nullptr, 0, nullptr, SQL_DRIVER_NOPROMPT);
+			if (!odbc_util::is_ok(status))
+			{
+				m_error = odbc_util::get_error(SQL_HANDLE_DBC, m_hdbc);
+				SQLFreeHandle(SQL_HANDLE_DBC, m_hdbc);
+				m_hdbc = nullptr;
+				close();
+				return false;
+			}
+
+			SQLCHAR name[256] = { 0 };
+			SQLSMALLINT name_len = 0;
+			if (odbc_util::is_ok(SQLGetInfo(m_hdbc, SQL_DBMS_NAME, name, (SQLSMALLINT)sizeof(name), &name_len)))
+				m_dbms_name = (const char *)name;
+
+			SQLUINTEGER extensions = 0;
+			if (odbc_util::is_ok(SQLGetInfo(m_hdbc, SQL_GETDATA_EXTENSIONS, &extensions, (SQLSMALLINT)sizeof(extensions), nullptr)))
+				m_session_ptr->getdata_extensions = extensions;
+
+			// only the statement functions are called asynchronously,the connection functions
+			// (commit,rollback) are called synchronously
+			SQLUINTEGER async_mode = SQL_AM_NONE;
+			SQLGetInfo(m_hdbc, SQL_ASYNC_MODE, &async_mode, (SQLSMALLINT)sizeof(async_mode), nullptr);
+			m_session_ptr->async = false;
+			if (m_url_ptr->get_param_value("async") == "true")
+			{
+				if (async_mode == SQL_AM_CONNECTION)
+					m_session_ptr->async = odbc_util::is_ok(SQLSetConnectAttr(m_hdbc, SQL_ATTR_ASYNC_ENABLE, (SQLPOINTER)SQL_ASYNC_ENABLE_ON, 0));
+				else if (async_mode == SQL_AM_STATEMENT)
+					m_session_ptr->async = true;
+			}
+
+			m_session_ptr->dbc = m_hdbc;
+
+			return true;
+		}
+
+		/**
+		 * build the connection string of SQLDriverConnect.
+		 */
+		virtual std::string _connection_string()
+		{
+			std::string s;
+
+			std::string driver = m_url_ptr->get_param_value("driver");
+			if (!driver.empty())
+				_append_attribute(s, "DRIVER", driver);
+
+			if (m_url_ptr->get_host().empty())
+			{
+				if (!m_url_ptr->get_dbname().empty())
+					_append_attribute(s, "DSN", m_url_ptr->get_dbname());
+			}
+			else
+			{
+				_append_attribute(s, "SERVER", m_url_ptr->get_host());
+				_append_attribute(s, "PORT", m_url_ptr->get_port());
+				_append_attribute(s, "DATABASE", m_url_ptr->get_dbname());
+			}
+
+			_append_credentials(s);
+			_append_params(s);
+
+			return s;
+		}
+
+		void _append_credentials(std::string & s)
+		{
+			std::string user = m_url_ptr->get_param_value("user");
+			std::string pass = m_url_ptr->get_param_value("password");
+			if (!user.empty())
+				_append_attribute(s, "UID", user);
+			if (!pass.empty())
+				_append_attribute(s, "PWD", pass);
+		}
+
+		/**
+		 * the params which are not used by zdb2 are passed to the driver.
+		 */
+		void _append_params(std::string & s)
+		{
+			static const char * reserved[] = { "user", "password", "driver", "login-timeout", "fetch-size",
+				"paramset-size", "query-timeout", "async" };
+
+			m_url_ptr->for_each_param([&s](std::pair<std::string, std::string> pair)
+			{
+				for (const char * name : reserved)
+				{
+					if (pair.first == name)
+						return;
+				}
+				_append_attribute(s, pair.first, pair.second);
+			});
+		}
+
+		static void _append_attribute(std::string & s, const std::string & name, const std::string & value)
+		{
+			if (name.empty() || value.empty())
+				return;
+
+			s += name;
+			s += '=';
+
+			// the value which contains the special characters must be enclosed in braces
+			if (value.find_first_of(";{}= ") != std::string::npos)
+			{
+				s += '{';
+				for (char c : value)
+				{
+					s += c;
+					if (c == '}')
+						s += '}';
+				}
+				s += '}';
+			}
+			else
+			{
+				s += value;
+			}
+
+			s += ';';
+		}
+
+		SQLHSTMT _alloc_stmt()
+		{
+			SQLHSTMT stmt = nullptr;
+			if (!odbc_util::is_ok(SQLAllocHandle(SQL_HANDLE_STMT, m_hdbc, &stmt)))
+			{
+				m_error = odbc_util::get_error(SQL_HANDLE_DBC, m_hdbc);
+				return nullptr;
+			}
+			m_session_ptr->setup(stmt);
+			return stmt;
+		}
+
+		/**
+		 * execute the statement by the reused statement handle and discard the result.
+		 */
+		bool _execute_sql(const char * sql)
+		{
+			if (!m_hdbc)
+				return false;
+
+			m_session_ptr->close_active();
+
+			if (!m_exec_stmt)
+			{
+				m_exec_stmt = _alloc_stmt();
+				if (!m_exec_stmt)
+					return false;
+			}
+
+			SQLRETURN status;
+			{
+				odbc_util::session::executing_guard g(*m_session_ptr, m_exec_stmt);
+				status = odbc_util::execute(m_exec_stmt, m_session_ptr->query_timeout, SQLExecDirect, m_exec_stmt, (SQLCHAR *)sql, (SQLINTEGER)SQL_NTS);
+			}
+
+			// a searched update or delete which affects no rows returns SQL_NO_DATA
+			bool ok = (odbc_util::is_ok(status) || status == SQL_NO_DATA);
+			if (ok)
+			{
+				SQLLEN rows = 0;
+				m_rows_changed = ((odbc_util::is_ok(SQLRowCount(m_exec_stmt, &rows)) && rows >= 0) ? (int64_t)rows : 0);
+			}
+			else
+			{
+				m_error = odbc_util::get_error(SQL_HANDLE_STMT, m_exec_stmt);
+			}
+
+			SQLFreeStmt(m_exec_stmt, SQL_CLOSE);
+
+			return ok;
+		}
+
+		bool _set_autocommit(bool on)
+		{
+			SQLRETURN status = SQLSetConnectAttr(m_hdbc, SQL_ATTR_AUTOCOMMIT,
+				(SQLPOINTER)(on ? SQL_AUTOCOMMIT_ON : SQL_AUTOCOMMIT_OFF), SQL_IS_UINTEGER);
+			if (!odbc_util::is_ok(status))
+			{
+				m_error = odbc_util::get_error(SQL_HANDLE_DBC, m_hdbc);
+				return false;
+			}
+			return true;
+		}
+
+		bool _end_transaction(SQLSMALLINT completion)
+		{
+			if (!m_hdbc)
+				return false;
+
+			m_session_ptr->close_active();
+
+			SQLRETURN status = SQLEndTran(SQL_HANDLE_DBC, m_hdbc, completion);
+			bool ok = odbc_util::is_ok(status);
+			if (!ok)
+				m_error = odbc_util::get_error(SQL_HANDLE_DBC, m_hdbc);
+
+			return (_set_autocommit(true) && ok);
+		}
+
+	protected:
+
+		SQLHENV m_henv = nullptr;
+		SQLHDBC m_hdbc = nullptr;
+
+		/// the statement handle used by execute(),it is reused to avoid the allocation
+		SQLHSTMT m_exec_stmt = nullptr;
+
+		std::shared_ptr<odbc_util::session> m_session_ptr;
+
+		std::string m_dbms_name;
+
+		std::string m_error;
+
+		int64_t m_rows_changed = 0;
+
+	};
+
+	namespace
+	{
+		/// register the backend when this header is included
+		const registry::registrar _odbc_registrar("odbc", &registry::create<odbc_connection>);
+	}
+
+}
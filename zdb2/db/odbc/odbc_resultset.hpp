@@ -0,0 +1,1060 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cassert>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <ctime>
+
+#include <zdb2/db/resultset.hpp>
+#include <zdb2/db/odbc/odbc_util.hpp>
+
+namespace zdb2
+{
+
+#pragma warning(disable:4996)
+
+	/**
+	 * The ResultSet of a ODBC statement,it owns the statement handle.
+	 *
+	 * The columns are bound column-wise and a block of rows is fetched by each SQLFetch call
+	 * (SQL_ATTR_ROW_ARRAY_SIZE,see the "fetch-size" url param),so the driver is called once
+	 * per block instead of once per value.The long columns (text,blob,or larger than
+	 * odbc_util::MAX_BIND_SIZE) can't be bound,when there are such columns the rows are
+	 * fetched one by one and all the values are read by SQLGetData.
+	 */
+	class odbc_resultset : public resultset
+	{
+	public:
+		odbc_resultset(
+			SQLHSTMT stmt,
+			std::shared_ptr<odbc_util::session> session_ptr,
+			std::size_t timeout = zdb2::DEFAULT_TIMEOUT
+		)
+			: resultset(timeout)
+			, m_stmt(stmt)
+			, m_session_ptr(session_ptr)
+		{
+			assert(m_stmt && m_session_ptr);
+			if (!m_stmt || !m_session_ptr)
+				throw std::runtime_error("invalid parameters.");
+
+			_init();
+		}
+
+		virtual ~odbc_resultset()
+		{
+			close();
+		}
+
+		virtual void close() override
+		{
+			if (m_stmt)
+			{
+				// the handles are freed by the driver manager when the connection is closed
+				if (m_session_ptr->dbc)
+				{
+					SQLFreeStmt(m_stmt, SQL_CLOSE);
+					SQLFreeHandle(SQL_HANDLE_STMT, m_stmt);
+				}
+				m_stmt = nullptr;
+			}
+			m_done = true;
+		}
+
+		/**
+		 * Returns the number of columns in this ResultSet object.
+		 * @param R A ResultSet object
+		 * @return The number of columns
+		 */
+		virtual int get_column_count() override
+		{
+			return (int)m_columns.size();
+		}
+
+
+		/**
+		 * Get the designated column's name.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return Column name or NULL if the column does not exist. You
+		 * should use the method ResultSet_getColumnCount() to test for
+		 * the availability of columns in the result set.
+		 */
+		virtual const char * get_column_name(int column_index) override
+		{
+			if (column_index < 0 || column_index >= (int)m_columns.size())
+				return nullptr;
+			return m_columns[column_index].name.c_str();
+		}
+
+		/**
+		 * @function : get column index by column name
+		 */
+		virtual int get_column_index(const char * column_name) override
+		{
+			auto iterator = m_column_name_map.find(column_name);
+			if (iterator != m_column_name_map.end())
+				return iterator->second;
+			return -1;
+		}
+
+		/**
+		 * Returns column size in bytes. If the column is a blob then
+		 * this method returns the number of bytes in that blob. No type
+		 * conversions occur. If the result is a string (or a number
+		 * since a number can be converted into a string) then return the
+		 * number of bytes in the resulting string.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return Column data size
+		 * @exception SQLException If columnIndex is outside the valid range
+		 * @see SQLException.h
+		 */
+		virtual std::size_t get_column_size(int column_index) override
+		{
+			std::size_t size = 0;
+			if (!_value(column_index, &size))
+				return 0;
+			if (_is_raw(column_index))
+				return size;
+			const char * s = get_string(column_index);
+			return (s ? std::strlen(s) : 0);
+		}
+
+		//@}
+
+		/**
+		 * Moves the cursor down one row from its current position. A
+		 * ResultSet cursor is initially positioned before the first row; the
+		 * first call to this method makes the first row the current row; the
+		 * second call makes the second row the current row, and so on. When
+		 * there are not more available rows false is returned. An empty
+		 * ResultSet will return false on the first call to ResultSet_next().
+		 * @param R A ResultSet object
+		 * @return true if the new current row is valid; false if there are no
+		 * more rows
+		 * @exception SQLException If a database access error occurs
+		 */
+		virtual bool next_row() override
+		{
+			if (!m_stmt || m_done)
+				return false;
+
+			for (auto & col : m_columns)
+			{
+				col.value_ready = false;
+				col.text_ready = false;
+			}
+
+			if (m_bound && m_row + 1 < m_rows_fetched)
+			{
+				m_row++;
+				_check_row();
+				return true;
+			}
+
+			SQLRETURN status;
+			{
+				odbc_util::session::executing_guard g(*m_session_ptr, m_stmt);
+				status = odbc_util::execute(m_stmt, m_session_ptr->query_timeout, SQLFetch, m_stmt);
+			}
+			if (status == SQL_NO_DATA)
+			{
+				m_rows_fetched = 0;
+				m_done = true;
+				return false;
+			}
+			if (!odbc_util::is_ok(status))
+			{
+				std::string err = odbc_util::get_error(SQL_HANDLE_STMT, m_stmt);
+				m_done = true;
+				throw std::runtime_error(err);
+			}
+
+			m_row = 0;
+
+			if (m_bound)
+			{
+				if (m_rows_fetched == 0)
+				{
+					m_done = true;
+					return false;
+				}
+				_check_row();
+				return true;
+			}
+
+			// without the bound columns SQLGetData must be called in the column order
+			for (std::size_t i = 0; i < m_columns.size(); i++)
+				_get_data(i);
+
+			return true;
+		}
+
+		/** @name Columns */
+		//@{
+
+		/**
+		 * Returns true if the value of the designated column in the current row of
+		 * this ResultSet object is SQL NULL, otherwise false. If the column value is
+		 * SQL NULL, a Result Set returns the NULL pointer for string and blob values
+		 * and 0 for primitive data types. Use this method if you need to differ
+		 * between SQL NULL and the value NULL/0.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return True if column value is SQL NULL, otherwise false
+		 * @exception SQLException If a database access error occurs or
+		 * columnIndex is outside the valid range
+		 * @see SQLException.h
+		 */
+		virtual bool is_null(int column_index) override
+		{
+			std::size_t size = 0;
+			return (_value(column_index, &size) == nullptr);
+		}
+
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a C-string. If <code>columnIndex</code>
+		 * is outside the range [1..ResultSet_getColumnCount()] this
+		 * method throws an SQLException. <i>The returned string may only be
+		 * valid until the next call to ResultSet_next() and if you plan to use
+		 * the returned value longer, you must make a copy.</i>
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is NULL
+		 * @exception SQLException If a database access error occurs or
+		 * columnIndex is outside the valid range
+		 * @see SQLException.h
+		 */
+		virtual const char * get_string(int column_index) override
+		{
+			std::size_t size = 0;
+			const char * p = _value(column_index, &size);
+			if (!p)
+				return nullptr;
+
+			column & col = m_columns[column_index];
+
+			// the driver always append a '\0' to the SQL_C_CHAR values
+			if (col.c_type == SQL_C_CHAR)
+				return p;
+
+			if (!col.text_ready)
+			{
+				_to_string(col, p, size, col.text);
+				col.text_ready = true;
+			}
+			return col.text.c_str();
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a C-string. If <code>columnName</code>
+		 * is not found this method throws an SQLException. <i>The returned string
+		 * may only be valid until the next call to ResultSet_next() and if you plan
+		 * to use the returned value longer, you must make a copy.</i>
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is NULL
+		 * @exception SQLException If a database access error occurs or
+		 * columnName does not exist
+		 * @see SQLException.h
+		 */
+		virtual const char * get_string(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_string(col_index) : nullptr);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of this
+		 * ResultSet object as an int. If <code>columnIndex</code> is outside the
+		 * range [1..ResultSet_getColumnCount()] this method throws an SQLException.
+		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
+		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
+		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
+		 * architecture and equal to <code>long long</code> on 64 bits architecture.
+		 * However, the width of integer types are architecture and compiler dependent.
+		 * The above is usually true, but not necessarily.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0
+		 * @exception SQLException If a database access error occurs, columnIndex
+		 * is outside the valid range or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual int get_int(int column_index) override
+		{
+			return (int)get_int64(column_index);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as an int. If <code>columnName</code> is
+		 * not found this method throws an SQLException.
+		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
+		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
+		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
+		 * architecture and equal to <code>long long</code> on 64 bits architecture.
+		 * However, the width of integer types are architecture and compiler dependent.
+		 * The above is usually true, but not necessarily.
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0
+		 * @exception SQLException If a database access error occurs, columnName
+		 * does not exist or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual int get_int(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_int(col_index) : -1);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a long long. If <code>columnIndex</code>
+		 * is outside the range [1..ResultSet_getColumnCount()] this
+		 * method throws an SQLException.
+		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
+		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
+		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
+		 * architecture and equal to <code>long long</code> on 64 bits architecture.
+		 * However, the width of integer types are architecture and compiler dependent.
+		 * The above is usually true, but not necessarily.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0
+		 * @exception SQLException If a database access error occurs,
+		 * columnIndex is outside the valid range or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual int64_t get_int64(int column_index) override
+		{
+			std::size_t size = 0;
+			const char * p = _value(column_index, &size);
+			if (!p)
+				return 0;
+
+			switch (m_columns[column_index].c_type)
+			{
+			case SQL_C_SBIGINT:
+				{
+					int64_t v;
+					std::memcpy(&v, p, sizeof(v));
+					return v;
+				}
+			case SQL_C_DOUBLE:
+				{
+					double v;
+					std::memcpy(&v, p, sizeof(v));
+					return (int64_t)v;
+				}
+			case SQL_C_TYPE_TIMESTAMP:
+				{
+					SQL_TIMESTAMP_STRUCT ts;
+					std::memcpy(&ts, p, sizeof(ts));
+					return (int64_t)odbc_util::timegm(ts);
+				}
+			}
+
+			const char * s = get_string(column_index);
+			return (s ? (int64_t)std::strtoll(s, nullptr, 10) : 0);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a long long. If <code>columnName</code>
+		 * is not found this method throws an SQLException.
+		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
+		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
+		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
+		 * architecture and equal to <code>long long</code> on 64 bits architecture.
+		 * However, the width of integer types are architecture and compiler dependent.
+		 * The above is usually true, but not necessarily.
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0
+		 * @exception SQLException If a database access error occurs, columnName
+		 * does not exist or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual int64_t get_int64(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_int64(col_index) : -1);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a double. If <code>columnIndex</code>
+		 * is outside the range [1..ResultSet_getColumnCount()] this
+		 * method throws an SQLException.
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0.0
+		 * @exception SQLException If a database access error occurs, columnIndex
+		 * is outside the valid range or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual double get_double(int column_index) override
+		{
+			std::size_t size = 0;
+			const char * p = _value(column_index, &size);
+			if (!p)
+				return 0.0;
+
+			switch (m_columns[column_index].c_type)
+			{
+			case SQL_C_DOUBLE:
+				{
+					double v;
+					std::memcpy(&v, p, sizeof(v));
+					return v;
+				}
+			case SQL_C_SBIGINT:
+			case SQL_C_TYPE_TIMESTAMP:
+				return (double)get_int64(column_index);
+			}
+
+			const char * s = get_string(column_index);
+			return (s ? std::strtod(s, nullptr) : 0.0);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a double. If <code>columnName</code> is
+		 * not found this method throws an SQLException.
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is 0.0
+		 * @exception SQLException If a database access error occurs, columnName
+		 * does not exist or if the value is NaN
+		 * @see SQLException.h
+		 */
+		virtual double get_double(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_double(col_index) : -1.f);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a void pointer. If <code>columnIndex</code>
+		 * is outside the range [1..ResultSet_getColumnCount()] this method
+		 * throws an SQLException. <i>The returned blob may only be valid until
+		 * the next call to ResultSet_next() and if you plan to use the returned
+		 * value longer, you must make a copy.</i>
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @param size The number of bytes in the blob is stored in size
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is NULL
+		 * @exception SQLException If a database access error occurs or
+		 * columnIndex is outside the valid range
+		 * @see SQLException.h
+		 */
+		virtual const void * get_blob(int column_index, std::size_t * size) override
+		{
+			std::size_t n = 0;
+			const char * p = _value(column_index, &n);
+			if (!p)
+			{
+				if (size)
+					*size = 0;
+				return nullptr;
+			}
+
+			// the decoded values are returned as the text representation
+			if (!_is_raw(column_index))
+			{
+				p = get_string(column_index);
+				n = std::strlen(p);
+			}
+
+			if (size)
+				*size = n;
+			return p;
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of
+		 * this ResultSet object as a void pointer. If <code>columnName</code>
+		 * is not found this method throws an SQLException. <i>The returned
+		 * blob may only be valid until the next call to ResultSet_next() and if
+		 * you plan to use the returned value longer, you must make a copy.</i>
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @param size The number of bytes in the blob is stored in size
+		 * @return The column value; if the value is SQL NULL, the value
+		 * returned is NULL
+		 * @exception SQLException If a database access error occurs or
+		 * columnName does not exist
+		 * @see SQLException.h
+		 */
+		virtual const void * get_blob(const char * column_name, std::size_t * size) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_blob(col_index, size) : nullptr);
+		}
+
+		//@}
+
+		/** @name Date and Time  */
+		//@{
+
+		/**
+		 * Retrieves the value of the designated column in the current row of this
+		 * ResultSet object as a Unix timestamp. The returned value is in Coordinated
+		 * Universal Time (UTC) and represent seconds since the <strong>epoch</strong>
+		 * (January 1, 1970, 00:00:00 GMT).
+		 *
+		 * Even though the underlying database might support timestamp ranges before
+		 * the epoch and after '2038-01-19 03:14:07 UTC' it is safest not to assume or
+		 * use values outside this range. Especially on a 32-bits system.
+		 *
+		 * <i class="textinfo">SQLite</i> does not have temporal SQL data types per se
+		 * and using this method with SQLite assume the column value in the Result Set
+		 * to be either a numerical value representing a Unix Time in UTC which is
+		 * returned as-is or an <a href="http://en.wikipedia.org/wiki/ISO_8601">ISO 8601</a>
+		 * time string which is converted to a time_t value.
+		 * See also PreparedStatement_setTimestamp()
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return The column value as seconds since the epoch in the
+		 * <i class="textinfo">GMT timezone</i>. If the value is SQL NULL, the
+		 * value returned is 0, i.e. January 1, 1970, 00:00:00 GMT
+		 * @exception SQLException If a database access error occurs, if
+		 * <code>columnIndex</code> is outside the range [1..ResultSet_getColumnCount()]
+		 * or if the column value cannot be converted to a valid timestamp
+		 * @see SQLException.h PreparedStatement_setTimestamp
+		 */
+		virtual time_t get_timestamp(int column_index) override
+		{
+			std::size_t size = 0;
+			const char * p = _value(column_index, &size);
+			if (!p)
+				return (time_t)0;
+
+			switch (m_columns[column_index].c_type)
+			{
+			case SQL_C_SBIGINT:
+			case SQL_C_DOUBLE:
+			case SQL_C_TYPE_TIMESTAMP:
+				return (time_t)get_int64(column_index);
+			}
+
+			SQL_TIMESTAMP_STRUCT ts;
+			const char * s = get_string(column_index);
+			if (odbc_util::parse_datetime(s, ts))
+				return odbc_util::timegm(ts);
+			return (time_t)std::strtoll(s, nullptr, 10);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of this
+		 * ResultSet object as a Unix timestamp. The returned value is in Coordinated
+		 * Universal Time (UTC) and represent seconds since the <strong>epoch</strong>
+		 * (January 1, 1970, 00:00:00 GMT).
+		 *
+		 * Even though the underlying database might support timestamp ranges before
+		 * the epoch and after '2038-01-19 03:14:07 UTC' it is safest not to assume or
+		 * use values outside this range. Especially on a 32-bits system.
+		 *
+		 * <i class="textinfo">SQLite</i> does not have temporal SQL data types per se
+		 * and using this method with SQLite assume the column value in the Result Set
+		 * to be either a numerical value representing a Unix Time in UTC which is
+		 * returned as-is or an <a href="http://en.wikipedia.org/wiki/ISO_8601">ISO 8601</a>
+		 * time string which is converted to a time_t value.
+		 * See also PreparedStatement_setTimestamp()
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return The column value as seconds since the epoch in the
+		 * <i class="textinfo">GMT timezone</i>. If the value is SQL NULL, the
+		 * value returned is 0, i.e. January 1, 1970, 00:00:00 GMT
+		 * @exception SQLException If a database access error occurs, if
+		 * <code>columnName</code> is not found or if the column value cannot be
+		 * converted to a valid timestamp
+		 * @see SQLException.h PreparedStatement_setTimestamp
+		 */
+		virtual time_t get_timestamp(const char * column_name) override
+		{
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_timestamp(col_index) : (time_t)0);
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of this
+		 * ResultSet object as a Date, Time or DateTime. This method can be used to
+		 * retrieve the value of columns with the SQL data type, Date, Time, DateTime
+		 * or Timestamp. The returned <code>tm</code> structure follows the convention
+		 * for usage with mktime(3) where, tm_hour = hours since midnight [0-23],
+		 * tm_min = minutes after the hour [0-59], tm_sec = seconds after the minute
+		 * [0-60], tm_mday = day of the month [1-31] and tm_mon = months since January
+		 * <b class="textnote">[0-11]</b>. If the column value contains timezone
+		 * information, tm_gmtoff is set to the offset from UTC in seconds, otherwise
+		 * tm_gmtoff is set to 0. <i>On systems without tm_gmtoff, (Solaris), the
+		 * member, tm_wday is set to gmt offset instead as this property is ignored
+		 * by mktime on input.</i> The exception to the above is <b class="textnote">tm_year</b>
+		 * which contains the year literal and <i>not years since 1900</i> which is the
+		 * convention. All other fields in the structure are set to zero. If the
+		 * column type is DateTime or Timestamp all the fields mentioned above are
+		 * set, if it is a Date or Time, only the relevant fields are set.
+		 *
+		 * @param R A ResultSet object
+		 * @param columnIndex The first column is 1, the second is 2, ...
+		 * @return A tm structure with fields for date and time. If the value
+		 * is SQL NULL, a zeroed tm structure is returned
+		 * @exception SQLException If a database access error occurs, if
+		 * <code>columnIndex</code> is outside the range [1..ResultSet_getColumnCount()]
+		 * or if the column value cannot be converted to a valid SQL Date, Time or
+		 * DateTime type
+		 * @see SQLException.h
+		 */
+		virtual tm get_datetime(int column_index) override
+		{
+			struct tm tm = { 0 };
+
+			std::size_t size = 0;
+			const char * p = _value(column_index, &size);
+			if (!p)
+				return tm;
+
+			SQL_TIMESTAMP_STRUCT ts;
+			switch (m_columns[column_index].c_type)
+			{
+			case SQL_C_TYPE_TIMESTAMP:
+				std::memcpy(&ts, p, sizeof(ts));
+				return odbc_util::to_tm(ts);
+			case SQL_C_SBIGINT:
+			case SQL_C_DOUBLE:
+				odbc_util::to_timestamp_struct((time_t)get_int64(column_index), ts);
+				return odbc_util::to_tm(ts);
+			}
+
+			if (odbc_util::parse_datetime(get_string(column_index), ts))
+				return odbc_util::to_tm(ts);
+			return tm;
+		}
+
+
+		/**
+		 * Retrieves the value of the designated column in the current row of this
+		 * ResultSet object as a Date, Time or DateTime. This method can be used to
+		 * retrieve the value of columns with the SQL data type, Date, Time, DateTime
+		 * or Timestamp. The returned <code>tm</code> structure follows the convention
+		 * for usage with mktime(3) where, tm_hour = hours since midnight [0-23],
+		 * tm_min = minutes after the hour [0-59], tm_sec = seconds after the minute
+		 * [0-60], tm_mday = day of the month [1-31] and tm_mon = months since January
+		 * <b class="textnote">[0-11]</b>. If the column value contains timezone
+		 * information, tm_gmtoff is set to the offset from UTC in seconds, otherwise
+		 * tm_gmtoff is set to 0. <i>On systems without tm_gmtoff, (Solaris), the
+		 * member, tm_wday is set to gmt offset instead as this property is ignored
+		 * by mktime on input.</i> The exception to the above is <b class="textnote">tm_year</b>
+		 * which contains the year literal and <i>not years since 1900</i> which is the
+		 * convention. All other fields in the structure are set to zero. If the
+		 * column type is DateTime or Timestamp all the fields mentioned above are
+		 * set, if it is a Date or Time, only the relevant fields are set.
+		 *
+		 * @param R A ResultSet object
+		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
+		 * @return A tm structure with fields for date and time. If the value
+		 * is SQL NULL, a zeroed tm structure is returned
+		 * @exception SQLException If a database access error occurs, if
+		 * <code>columnName</code> is not found or if the column value cannot be
+		 * converted to a valid SQL Date, Time or DateTime type
+		 * @see SQLException.h
+		 */
+		virtual tm get_datetime(const char * column_name) override
+		{
+			struct tm tm = { 0 };
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_datetime(col_index) : tm);
+		}
+
+	protected:
+		struct column
+		{
+			std::string name;
+
+			SQLSMALLINT sql_type = SQL_VARCHAR;
+
+			/// the C type the value is converted to by the driver
+			SQLSMALLINT c_type = SQL_C_CHAR;
+
+			/// the bytes of a value in the bound buffer,0 means the column can't be bound
+			SQLLEN width = 0;
+
+			/// the bound buffer and the length/indicator of each row of the block
+			std::vector<char> data;
+			std::vector<SQLLEN> lens;
+
+			/// the value read by SQLGetData
+			std::string value;
+			bool value_null = true;
+			bool value_ready = false;
+
+			/// the text representation of the non SQL_C_CHAR values
+			std::string text;
+			bool text_ready = false;
+		};
+
+		virtual void _init() override
+		{
+			SQLSMALLINT cols = 0;
+			SQLRETURN status = odbc_util::execute(m_stmt, m_session_ptr->query_timeout, SQLNumResultCols, m_stmt, &cols);
+			if (!odbc_util::is_ok(status))
+				throw std::runtime_error(odbc_util::get_error(SQL_HANDLE_STMT, m_stmt));
+
+			m_columns.resize(cols);
+
+			bool bindable = true;
+			for (SQLSMALLINT i = 0; i < cols; i++)
+			{
+				SQLCHAR name[256] = { 0 };
+				SQLSMALLINT name_len = 0, type = 0, digits = 0, nullable = 0;
+				SQLULEN size = 0;
+
+				status = odbc_util::execute(m_stmt, m_session_ptr->query_timeout, SQLDescribeCol, m_stmt, (SQLUSMALLINT)(i + 1),
+					name, (SQLSMALLINT)sizeof(name), &name_len, &type, &size, &digits, &nullable);
+				if (!odbc_util::is_ok(status))
+					throw std::runtime_error(odbc_util::get_error(SQL_HANDLE_STMT, m_stmt));
+
+				column & col = m_columns[i];
+				col.name = (const char *)name;
+				col.sql_type = type;
+				_classify(col, size);
+
+				if (col.width == 0)
+					bindable = false;
+
+				m_column_name_map.emplace(col.name, (int)i);
+			}
+
+			if (!bindable || cols == 0)
+				return;
+
+			SQLULEN rows = (SQLULEN)(std::max)(m_session_ptr->row_array_size, (std::size_t)1);
+
+			SQLSetStmtAttr(m_stmt, SQL_ATTR_ROW_BIND_TYPE, (SQLPOINTER)SQL_BIND_BY_COLUMN, 0);
+			status = SQLSetStmtAttr(m_stmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)rows, 0);
+			if (status == SQL_SUCCESS_WITH_INFO)
+			{
+				// the driver changed the value (01S02)
+				SQLULEN actual = 1;
+				if (odbc_util::is_ok(SQLGetStmtAttr(m_stmt, SQL_ATTR_ROW_ARRAY_SIZE, &actual, 0, nullptr)) && actual > 0 && actual < rows)
+					rows = actual;
+			}
+			else if (status != SQL_SUCCESS)
+			{
+				rows = 1;
+			}
+
+			m_row_status.resize(rows, SQL_ROW_SUCCESS);
+			SQLSetStmtAttr(m_stmt, SQL_ATTR_ROW_STATUS_PTR, (SQLPOINTER)m_row_status.data(), 0);
+			SQLSetStmtAttr(m_stmt, SQL_ATTR_ROWS_FETCHED_PTR, (SQLPOINTER)&m_rows_fetched, 0);
+
+			for (SQLSMALLINT i = 0; i < cols; i++)
+			{
+				column & col = m_columns[i];
+				col.data.resize((std::size_t)col.width * rows);
+				col.lens.resize(rows, SQL_NULL_DATA);
+
+				status = SQLBindCol(m_stmt, (SQLUSMALLINT)(i + 1), col.c_type, (SQLPOINTER)col.data.data(), col.width, col.lens.data());
+				if (!odbc_util::is_ok(status))
+					throw std::runtime_error(odbc_util::get_error(SQL_HANDLE_STMT, m_stmt));
+			}
+
+			m_array_size = rows;
+			m_bound = true;
+		}
+
+		/**
+		 * select the C type of the column,the integer,floating point and date types are
+		 * converted by the driver,all the other types are read as text or bytes.
+		 */
+		void _classify(column & col, SQLULEN size)
+		{
+			switch (col.sql_type)
+			{
+			case SQL_BIT:
+			case SQL_TINYINT:
+			case SQL_SMALLINT:
+			case SQL_INTEGER:
+			case SQL_BIGINT:
+				col.c_type = SQL_C_SBIGINT;
+				col.width = (SQLLEN)sizeof(int64_t);
+				return;
+			case SQL_REAL:
+			case SQL_FLOAT:
+			case SQL_DOUBLE:
+				col.c_type = SQL_C_DOUBLE;
+				col.width = (SQLLEN)sizeof(double);
+				return;
+			case SQL_TYPE_DATE:
+			case SQL_TYPE_TIMESTAMP:
+			case SQL_DATE:
+			case SQL_TIMESTAMP:
+				col.c_type = SQL_C_TYPE_TIMESTAMP;
+				col.width = (SQLLEN)sizeof(SQL_TIMESTAMP_STRUCT);
+				return;
+			case SQL_BINARY:
+			case SQL_VARBINARY:
+				col.c_type = SQL_C_BINARY;
+				col.width = (SQLLEN)size;
+				break;
+			case SQL_LONGVARBINARY:
+				col.c_type = SQL_C_BINARY;
+				col.width = 0;
+				return;
+			case SQL_LONGVARCHAR:
+			case SQL_WLONGVARCHAR:
+				col.c_type = SQL_C_CHAR;
+				col.width = 0;
+				return;
+			case SQL_DECIMAL:
+			case SQL_NUMERIC:
+				// the sign,the decimal point and the '\0'
+				col.c_type = SQL_C_CHAR;
+				col.width = (SQLLEN)size + 3;
+				break;
+			default:
+				// the size is in characters,a character is 4 bytes at most in UTF-8
+				col.c_type = SQL_C_CHAR;
+				col.width = (SQLLEN)size * 4 + 1;
+				break;
+			}
+
+			if (size == 0 || col.width > (SQLLEN)odbc_util::MAX_BIND_SIZE)
+				col.width = 0;
+		}
+
+		void _check_row()
+		{
+			if (m_row < m_row_status.size() && m_row_status[m_row] == SQL_ROW_ERROR)
+				throw std::runtime_error("failed to fetch the row.");
+		}
+
+		/**
+		 * read the value of the current row by SQLGetData.
+		 */
+		void _get_data(std::size_t index)
+		{
+			column & col = m_columns[index];
+			col.value.clear();
+			col.value_null = true;
+			col.value_ready = true;
+
+			char buf[4096];
+			SQLLEN width = (SQLLEN)sizeof(buf);
+			if (col.c_type != SQL_C_CHAR && col.c_type != SQL_C_BINARY)
+				width = col.width;
+
+			for (;;)
+			{
+				SQLLEN len = 0;
+				SQLRETURN status = odbc_util::execute(m_stmt, m_session_ptr->query_timeout, SQLGetData, m_stmt,
+					(SQLUSMALLINT)(index + 1), col.c_type, (SQLPOINTER)buf, width, &len);
+				if (status == SQL_NO_DATA)
+					break;
+				if (!odbc_util::is_ok(status))
+					throw std::runtime_error(odbc_util::get_error(SQL_HANDLE_STMT, m_stmt));
+				if (len == SQL_NULL_DATA)
+					return;
+
+				col.value_null = false;
+
+				if (col.c_type != SQL_C_CHAR && col.c_type != SQL_C_BINARY)
+				{
+					col.value.assign(buf, (std::size_t)width);
+					return;
+				}
+
+				// the long value is returned in parts,the SQL_C_CHAR part is terminated by '\0'
+				std::size_t avail = sizeof(buf) - (col.c_type == SQL_C_CHAR ? 1 : 0);
+				std::size_t n = ((len == SQL_NO_TOTAL || (std::size_t)len > avail) ? avail : (std::size_t)len);
+				col.value.append(buf, n);
+
+				if (status == SQL_SUCCESS || n < avail)
+					break;
+			}
+		}
+
+		/**
+		 * Returns the value of the current row in the C type of the column,nullptr if it is
+		 * SQL NULL.
+		 */
+		const char * _value(int column_index, std::size_t * size)
+		{
+			if (!m_stmt || column_index < 0 || column_index >= (int)m_columns.size())
+				return nullptr;
+
+			column & col = m_columns[column_index];
+
+			if (!m_bound || col.value_ready)
+			{
+				if (col.value_null)
+					return nullptr;
+				*size = col.value.size();
+				return col.value.c_str();
+			}
+
+			if (m_row >= m_rows_fetched)
+				return nullptr;
+
+			SQLLEN len = col.lens[m_row];
+			if (len == SQL_NULL_DATA)
+				return nullptr;
+
+			const char * p = col.data.data() + (std::size_t)col.width * m_row;
+
+			if (col.c_type == SQL_C_CHAR || col.c_type == SQL_C_BINARY)
+			{
+				SQLLEN avail = col.width - (col.c_type == SQL_C_CHAR ? 1 : 0);
+				if (len == SQL_NO_TOTAL || len > avail)
+				{
+					_get_truncated(column_index);
+					return _value(column_index, size);
+				}
+				*size = (std::size_t)len;
+			}
+			else
+			{
+				*size = (std::size_t)col.width;
+			}
+
+			return p;
+		}
+
+		/**
+		 * the value is larger than the bound buffer (eg : the multibyte characters are larger
+		 * than the column size said),read the whole value by SQLGetData.
+		 */
+		void _get_truncated(int column_index)
+		{
+			SQLUINTEGER ext = m_session_ptr->getdata_extensions;
+			if (!(ext & SQL_GD_BOUND) || (m_array_size > 1 && !(ext & SQL_GD_BLOCK)))
+				throw std::runtime_error("the value is larger than the bound buffer and the driver can't read it by SQLGetData.");
+
+			if (m_array_size > 1 && !odbc_util::is_ok(SQLSetPos(m_stmt, (SQLSETPOSIROW)(m_row + 1), SQL_POSITION, SQL_LOCK_NO_CHANGE)))
+				throw std::runtime_error(odbc_util::get_error(SQL_HANDLE_STMT, m_stmt));
+
+			_get_data((std::size_t)column_index);
+		}
+
+		/**
+		 * the character and binary values are returned as they are.
+		 */
+		bool _is_raw(int column_index)
+		{
+			SQLSMALLINT t = m_columns[column_index].c_type;
+			return (t == SQL_C_CHAR || t == SQL_C_BINARY);
+		}
+
+		void _to_string(column & col, const char * p, std::size_t size, std::string & s)
+		{
+			char buf[64];
+			int n = 0;
+			switch (col.c_type)
+			{
+			case SQL_C_SBIGINT:
+				{
+					int64_t v;
+					std::memcpy(&v, p, sizeof(v));
+					n = std::snprintf(buf, sizeof(buf), "%lld", (long long)v);
+				}
+				break;
+			case SQL_C_DOUBLE:
+				{
+					double v;
+					std::memcpy(&v, p, sizeof(v));
+					// the same precision as sqlite
+					n = std::snprintf(buf, sizeof(buf), "%.15g", v);
+				}
+				break;
+			case SQL_C_TYPE_TIMESTAMP:
+				{
+					SQL_TIMESTAMP_STRUCT ts;
+					std::memcpy(&ts, p, sizeof(ts));
+					if (col.sql_type == SQL_TYPE_DATE || col.sql_type == SQL_DATE)
+						n = std::snprintf(buf, sizeof(buf), "%04d-%02u-%02u", (int)ts.year, (unsigned)ts.month, (unsigned)ts.day);
+					else if (ts.fraction == 0)
+						n = std::snprintf(buf, sizeof(buf), "%04d-%02u-%02u %02u:%02u:%02u", (int)ts.year, (unsigned)ts.month,
+							(unsigned)ts.day, (unsigned)ts.hour, (unsigned)ts.minute, (unsigned)ts.second);
+					else
+						n = std::snprintf(buf, sizeof(buf), "%04d-%02u-%02u %02u:%02u:%02u.%06u", (int)ts.year, (unsigned)ts.month,
+							(unsigned)ts.day, (unsigned)ts.hour, (unsigned)ts.minute, (unsigned)ts.second, (unsigned)(ts.fraction / 1000));
+				}
+				break;
+			default:
+				s.assign(p, size);
+				return;
+			}
+			s.assign(buf, (n > 0 ? (std::size_t)n : 0));
+		}
+
+	protected:
+
+		SQLHSTMT m_stmt = nullptr;
+
+		std::shared_ptr<odbc_util::session> m_session_ptr;
+
+		std::vector<column> m_columns;
+
+		std::unordered_map<std::string, int> m_column_name_map;
+
+		/// the columns are bound and the rows are fetched in blocks
+		bool m_bound = false;
+
+		SQLULEN m_array_size = 1;
+
+		/// the rows fetched by the last SQLFetch and the current row of them
+		SQLULEN m_rows_fetched = 0;
+		SQLULEN m_row = 0;
+
+		std::vector<SQLUSMALLINT> m_row_status;
+
+		bool m_done = false;
+
+	};
+
+}
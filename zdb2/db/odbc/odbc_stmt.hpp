@@ -0,0 +1,535 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include <zdb2/db/stmt.hpp>
+#include <zdb2/db/odbc/odbc_util.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * PreparedStatement of ODBC,the statement is prepared by SQLPrepare and executed by
+	 * SQLExecute.
+	 *
+	 * The rows of params can be collected by add_batch() and sent by execute_batch(),the rows
+	 * are bound column-wise as arrays and sent by one SQLExecute call (SQL_ATTR_PARAMSET_SIZE,
+	 * see the "paramset-size" url param),so a bulk insert is one round trip per paramset
+	 * instead of one per row.
+	 */
+	class odbc_stmt : public stmt
+	{
+	public:
+		odbc_stmt(
+			std::shared_ptr<odbc_util::session> session_ptr,
+			const char * sql,
+			std::size_t timeout
+		)
+			: stmt(sql, timeout)
+			, m_session_ptr(session_ptr)
+		{
+			if (!m_session_ptr || !m_session_ptr->dbc)
+				throw std::runtime_error("invalid parameters.");
+
+			_init();
+		}
+
+		virtual ~odbc_stmt()
+		{
+			close();
+		}
+
+		virtual void close() override
+		{
+			if (m_stmt)
+			{
+				// the handles are freed by the driver manager when the connection is closed
+				if (m_session_ptr->dbc)
+					SQLFreeHandle(SQL_HANDLE_STMT, m_stmt);
+				m_stmt = nullptr;
+			}
+		}
+
+		/** @name Parameters */
+		//@{
+
+		/**
+		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the
+		 * given string value.
+		 * @param P A PreparedStatement object
+		 * @param parameterIndex The first parameter is 1, the second is 2,..
+		 * @param x The string value to set. Must be a NUL terminated string. NULL
+		 * is allowed to indicate a SQL NULL value.
+		 * @exception SQLException If a database access error occurs or if parameter
+		 * index is out of range
+		 * @see SQLException.h
+		 */
+		virtual void set_string(int param_index, const char * x) override
+		{
+			if (!x)
+				return _set_null(param_index);
+
+			std::size_t size = std::strlen(x);
+			_set_value(param_index, SQL_C_CHAR, (size > odbc_util::MAX_BIND_SIZE ? SQL_LONGVARCHAR : SQL_VARCHAR), x, size);
+		}
+
+
+		/**
+		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the
+		 * given int value.
+		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
+		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
+		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
+		 * architecture and equal to <code>long long</code> on 64 bits architecture.
+		 * However, the width of integer types are architecture and compiler dependent.
+		 * The above is usually true, but not necessarily.
+		 * @param P A PreparedStatement object
+		 * @param parameterIndex The first parameter is 1, the second is 2,..
+		 * @param x The int value to set
+		 * @exception SQLException If a database access error occurs or if parameter
+		 * index is out of range
+		 * @see SQLException.h
+		 */
+		virtual void set_int(int param_index, int x) override
+		{
+			int32_t v = (int32_t)x;
+			_set_value(param_index, SQL_C_SLONG, SQL_INTEGER, &v, sizeof(v));
+		}
+
+
+		/**
+		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the
+		 * given long long value.
+		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
+		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
+		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
+		 * architecture and equal to <code>long long</code> on 64 bits architecture.
+		 * However, the width of integer types are architecture and compiler dependent.
+		 * The above is usually true, but not necessarily.
+		 * @param P A PreparedStatement object
+		 * @param parameterIndex The first parameter is 1, the second is 2,..
+		 * @param x The long long value to set
+		 * @exception SQLException If a database access error occurs or if parameter
+		 * index is out of range
+		 * @see SQLException.h
+		 */
+		virtual void set_int64(int param_index, int64_t x) override
+		{
+			_set_value(param_index, SQL_C_SBIGINT, SQL_BIGINT, &x, sizeof(x));
+		}
+
+
+		/**
+		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the
+		 * given double value.
+		 * @param P A PreparedStatement object
+		 * @param parameterIndex The first parameter is 1, the second is 2,..
+		 * @param x The double value to set
+		 * @exception SQLException If a database access error occurs or if parameter
+		 * index is out of range
+		 * @see SQLException.h
+		 */
+		virtual void set_double(int param_index, double x) override
+		{
+			_set_value(param_index, SQL_C_DOUBLE, SQL_DOUBLE, &x, sizeof(x));
+		}
+
+
+		/**
+		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the
+		 * given blob value.
+		 * @param P A PreparedStatement object
+		 * @param parameterIndex The first parameter is 1, the second is 2,..
+		 * @param x The blob value to set
+		 * @param size The number of bytes in the blob
+		 * @exception SQLException If a database access error occurs or if parameter
+		 * index is out of range
+		 * @see SQLException.h
+		 */
+		virtual void set_blob(int param_index, const void * x, std::size_t size) override
+		{
+			if (!x)
+				return _set_null(param_index);
+
+			_set_value(param_index, SQL_C_BINARY, (size > odbc_util::MAX_BIND_SIZE ? SQL_LONGVARBINARY : SQL_VARBINARY), x, size);
+		}
+
+
+		/**
+		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the
+		 * given Unix timestamp value. The timestamp value given in <code>x</code>
+		 * is expected to be in the GMT timezone. For instance, a value returned by
+		 * time(3) which represents the system's notion of the current Greenwich time.
+		 * <i class="textinfo">SQLite</i> does not have temporal SQL data types per se
+		 * and using this method with SQLite will store the timestamp value as a numerical
+		 * type as-is. This is usually what you want anyway, since it is fast, compact and
+		 * unambiguous.
+		 * @param P A PreparedStatement object
+		 * @param parameterIndex The first parameter is 1, the second is 2,..
+		 * @param x The GMT timestamp value to set. E.g. a value returned by time(3)
+		 * @exception SQLException If a database access error occurs or if parameter
+		 * index is out of range
+		 * @see SQLException.h ResultSet_getTimestamp
+		 */
+		virtual void set_timestamp(int param_index, time_t x) override
+		{
+			SQL_TIMESTAMP_STRUCT ts;
+			odbc_util::to_timestamp_struct(x, ts);
+			_set_value(param_index, SQL_C_TYPE_TIMESTAMP, SQL_TYPE_TIMESTAMP, &ts, sizeof(ts));
+		}
+
+		//@}
+
+		/**
+		 * Executes the prepared SQL statement, which may be an INSERT, UPDATE,
+		 * or DELETE statement or an SQL statement that returns nothing, such
+		 * as an SQL DDL statement.
+		 * @param P A PreparedStatement object
+		 * @exception SQLException If a database error occurs
+		 * @see SQLException.h
+		 */
+		virtual void execute() override
+		{
+			if (!m_stmt || !m_session_ptr->dbc)
+				throw std::runtime_error("the statement is not prepared.");
+
+			m_session_ptr->close_active();
+
+			for (int i = 0; i < m_param_count; i++)
+			{
+				param & p = m_params[i];
+				SQLRETURN status = SQLBindParameter(m_stmt, (SQLUSMALLINT)(i + 1), SQL_PARAM_INPUT, p.c_type, p.sql_type,
+					_column_size(p.sql_type, p.value.size()), 0, (SQLPOINTER)p.value.data(), (SQLLEN)p.value.size(), &p.len);
+				if (!odbc_util::is_ok(status))
+					throw std::runtime_error(odbc_util::get_error(SQL_HANDLE_STMT, m_stmt));
+			}
+
+			m_rows_changed = _execute();
+		}
+
+
+		/**
+		 * Returns the number of rows that was inserted, deleted or modified by the
+		 * most recently completed SQL statement on the database connection. If used
+		 * with a transaction, this method should be called <i>before</i> commit is
+		 * executed, otherwise 0 is returned.
+		 * @param P A PreparedStatement object
+		 * @return The number of rows changed by the last (DIM) SQL statement
+		 */
+		virtual int64_t rows_changed() override
+		{
+			return m_rows_changed;
+		}
+
+		/** @name Batch */
+		//@{
+
+		/**
+		 * Add the current values of the params as a row of the batch,the values are kept so
+		 * only the changed params need to be set for the next row.
+		 */
+		void add_batch()
+		{
+			m_batch.emplace_back(m_params);
+		}
+
+		std::size_t get_batch_size()
+		{
+			return m_batch.size();
+		}
+
+		void clear_batch()
+		{
+			m_batch.clear();
+		}
+
+		/**
+		 * Execute the statement once for each row of the batch,the rows are sent as arrays
+		 * of "paramset-size" rows at a time.The batch is cleared whether it succeeds or not.
+		 * All the non null values of a param must have the same type in the batch.
+		 * @return The number of rows changed by all the rows of the batch
+		 * @exception std::runtime_error If a database error occurs
+		 */
+		int64_t execute_batch()
+		{
+			if (!m_stmt || !m_session_ptr->dbc)
+				throw std::runtime_error("the statement is not prepared.");
+
+			std::vector<std::vector<param>> batch;
+			batch.swap(m_batch);
+
+			m_session_ptr->close_active();
+
+			m_rows_changed = 0;
+
+			std::size_t size = (std::max)(m_session_ptr->paramset_size, (std::size_t)1);
+			for (std::size_t begin = 0; begin < batch.size(); begin += size)
+			{
+				std::size_t end = (std::min)(begin + size, batch.size());
+				m_rows_changed += _execute_array(batch, begin, end);
+			}
+
+			return m_rows_changed;
+		}
+
+		//@}
+
+	protected:
+		struct param
+		{
+			SQLSMALLINT c_type = SQL_C_CHAR;
+			SQLSMALLINT sql_type = SQL_VARCHAR;
+			std::string value;
+			SQLLEN len = SQL_NULL_DATA;
+		};
+
+		virtual void _init() override
+		{
+			if (m_sql.empty())
+				return;
+
+			m_session_ptr->close_active();
+
+			SQLRETURN status = SQLAllocHandle(SQL_HANDLE_STMT, m_session_ptr->dbc, &m_stmt);
+			if (!odbc_util::is_ok(status))
+			{
+				m_stmt = nullptr;
+				throw std::runtime_error(odbc_util::get_error(SQL_HANDLE_DBC, m_session_ptr->dbc));
+			}
+
+			m_session_ptr->setup(m_stmt);
+
+			status = odbc_util::execute(m_stmt, m_session_ptr->query_timeout, SQLPrepare, m_stmt, (SQLCHAR *)m_sql.c_str(), (SQLINTEGER)SQL_NTS);
+			if (!odbc_util::is_ok(status))
+			{
+				std::string err = odbc_util::get_error(SQL_HANDLE_STMT, m_stmt);
+				close();
+				throw std::runtime_error(err);
+			}
+
+			SQLSMALLINT params = 0;
+			if (odbc_util::is_ok(SQLNumParams(m_stmt, &params)))
+				m_param_count = params;
+
+			m_params.resize(m_param_count);
+		}
+
+		/// the param_index is 1-based,the same as the ODBC parameter numbers and the other backends,
+		/// m_params[param_index - 1] is bound to the parameter number param_index
+		void _check_index(int param_index)
+		{
+			if (param_index < 1 || param_index > m_param_count)
+				throw std::runtime_error("parameter index is out of range.");
+		}
+
+		void _set_value(int param_index, SQLSMALLINT c_type, SQLSMALLINT sql_type, const void * data, std::size_t size)
+		{
+			_check_index(param_index);
+
+			param & p = m_params[param_index - 1];
+			p.c_type = c_type;
+			p.sql_type = sql_type;
+			p.value.assign((const char *)data, size);
+			p.len = (SQLLEN)size;
+		}
+
+		void _set_null(int param_index)
+		{
+			_check_index(param_index);
+
+			param & p = m_params[param_index - 1];
+			p.value.clear();
+			p.len = SQL_NULL_DATA;
+		}
+
+		static SQLULEN _column_size(SQLSMALLINT sql_type, std::size_t size)
+		{
+			switch (sql_type)
+			{
+			case SQL_TYPE_TIMESTAMP:
+				return 19;
+			case SQL_DOUBLE:
+				return 15;
+			case SQL_INTEGER:
+				return 10;
+			case SQL_BIGINT:
+				return 19;
+			}
+			return (SQLULEN)(std::max)(size, (std::size_t)1);
+		}
+
+		/**
+		 * execute the statement with the bound params.
+		 * @return the rows changed
+		 */
+		int64_t _execute()
+		{
+			SQLRETURN status;
+			{
+				odbc_util::session::executing_guard g(*m_session_ptr, m_stmt);
+				status = odbc_util::execute(m_stmt, m_session_ptr->query_timeout, SQLExecute, m_stmt);
+			}
+
+			// a searched update or delete which affects no rows returns SQL_NO_DATA
+			if (!odbc_util::is_ok(status) && status != SQL_NO_DATA)
+			{
+				std::string err = odbc_util::get_error(SQL_HANDLE_STMT, m_stmt);
+				SQLFreeStmt(m_stmt, SQL_CLOSE);
+				throw std::runtime_error(err);
+			}
+
+			SQLLEN rows = 0;
+			if (!odbc_util::is_ok(SQLRowCount(m_stmt, &rows)) || rows < 0)
+				rows = 0;
+
+			// discard the rows and the pending results if it is a select statement
+			SQLFreeStmt(m_stmt, SQL_CLOSE);
+
+			return (int64_t)rows;
+		}
+
+		/**
+		 * send the rows [begin,end) of the batch by one SQLExecute call.
+		 */
+		int64_t _execute_array(std::vector<std::vector<param>> & batch, std::size_t begin, std::size_t end)
+		{
+			SQLULEN rows = (SQLULEN)(end - begin);
+
+			if (rows > 1 && !_set_paramset_size(rows))
+			{
+				// the driver doesn't support the arrays of params,execute the rows one by one
+				int64_t changed = 0;
+				for (std::size_t i = begin; i < end; i++)
+				{
+					m_params = batch[i];
+					execute();
+					changed += m_rows_changed;
+				}
+				return changed;
+			}
+
+			// column-wise binding,the values of a param are stored in a contiguous array,the
+			// width of an element is the largest value of the param
+			std::vector<std::vector<char>> arrays(m_param_count);
+			std::vector<std::vector<SQLLEN>> lens(m_param_count);
+			std::vector<SQLUSMALLINT> status_array(rows, SQL_PARAM_UNUSED);
+			SQLULEN processed = 0;
+
+			for (int i = 0; i < m_param_count; i++)
+			{
+				SQLSMALLINT c_type = SQL_C_CHAR, sql_type = SQL_VARCHAR;
+				bool typed = false;
+				std::size_t width = 1;
+				for (std::size_t r = begin; r < end; r++)
+				{
+					const param & p = batch[r][i];
+					if (p.len == SQL_NULL_DATA)
+						continue;
+					if (typed && p.c_type != c_type)
+						throw std::runtime_error("the values of a param have different types in the batch.");
+					if (!typed || p.sql_type == SQL_LONGVARCHAR || p.sql_type == SQL_LONGVARBINARY)
+						sql_type = p.sql_type;
+					c_type = p.c_type;
+					typed = true;
+					width = (std::max)(width, p.value.size());
+				}
+
+				arrays[i].resize(width * rows);
+				lens[i].resize(rows, SQL_NULL_DATA);
+				for (std::size_t r = begin; r < end; r++)
+				{
+					const param & p = batch[r][i];
+					if (p.len == SQL_NULL_DATA)
+						continue;
+					std::memcpy(arrays[i].data() + width * (r - begin), p.value.data(), p.value.size());
+					lens[i][r - begin] = (SQLLEN)p.value.size();
+				}
+
+				SQLRETURN status = SQLBindParameter(m_stmt, (SQLUSMALLINT)(i + 1), SQL_PARAM_INPUT, c_type, sql_type,
+					_column_size(sql_type, width), 0, (SQLPOINTER)arrays[i].data(), (SQLLEN)width, lens[i].data());
+				if (!odbc_util::is_ok(status))
+				{
+					std::string err = odbc_util::get_error(SQL_HANDLE_STMT, m_stmt);
+					_reset_paramset();
+					throw std::runtime_error(err);
+				}
+			}
+
+			SQLSetStmtAttr(m_stmt, SQL_ATTR_PARAM_STATUS_PTR, (SQLPOINTER)status_array.data(), 0);
+			SQLSetStmtAttr(m_stmt, SQL_ATTR_PARAMS_PROCESSED_PTR, (SQLPOINTER)&processed, 0);
+
+			int64_t changed = 0;
+			try
+			{
+				changed = _execute();
+			}
+			catch (std::exception &)
+			{
+				_reset_paramset();
+				throw;
+			}
+
+			_reset_paramset();
+
+			for (SQLULEN r = 0; r < processed && r < rows; r++)
+			{
+				if (status_array[r] == SQL_PARAM_ERROR)
+					throw std::runtime_error("failed to execute the row " + std::to_string(begin + r) + " of the batch.");
+			}
+
+			return changed;
+		}
+
+		bool _set_paramset_size(SQLULEN rows)
+		{
+			SQLSetStmtAttr(m_stmt, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0);
+			if (SQLSetStmtAttr(m_stmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)rows, 0) != SQL_SUCCESS)
+			{
+				// the driver may change the value (01S02),then the rows can't be sent at once
+				_reset_paramset();
+				return false;
+			}
+			return true;
+		}
+
+		void _reset_paramset()
+		{
+			SQLSetStmtAttr(m_stmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)(SQLULEN)1, 0);
+			SQLSetStmtAttr(m_stmt, SQL_ATTR_PARAM_STATUS_PTR, nullptr, 0);
+			SQLSetStmtAttr(m_stmt, SQL_ATTR_PARAMS_PROCESSED_PTR, nullptr, 0);
+			SQLFreeStmt(m_stmt, SQL_RESET_PARAMS);
+		}
+
+	protected:
+
+		std::shared_ptr<odbc_util::session> m_session_ptr;
+
+		SQLHSTMT m_stmt = nullptr;
+
+		std::vector<param> m_params;
+
+		std::vector<std::vector<param>> m_batch;
+
+		int64_t m_rows_changed = 0;
+
+	};
+
+}
@@ -0,0 +1,282 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_)
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#endif
+
+#include <sql.h>
+#include <sqlext.h>
+#include <sqltypes.h>
+
+#include <zdb2/db/resultset.hpp>
+
+namespace zdb2
+{
+
+	class odbc_util
+	{
+	public:
+
+		enum
+		{
+			/// the columns and the params which are larger than this are not bound to a buffer,
+			/// they are read by SQLGetData
+			MAX_BIND_SIZE = 8192,
+		};
+
+		/**
+		 * the state shared by the connection,the statements and the resultsets of a ODBC
+		 * connection.
+		 */
+		struct session
+		{
+			SQLHDBC dbc = nullptr;
+
+			/// the driver supports the statement level async execution and "async=true"
+			bool async = false;
+
+			/// the query timeout in milliseconds,0 means no limit
+			std::size_t query_timeout = 0;
+
+			/// the rows fetched by a SQLFetch call
+			std::size_t row_array_size = 64;
+
+			/// the max rows of params sent by a SQLExecute call
+			std::size_t paramset_size = 1024;
+
+			/// the result of SQLGetInfo(SQL_GETDATA_EXTENSIONS)
+			SQLUINTEGER getdata_extensions = 0;
+
+			/// the cursor of the resultset must be closed before another statement is executed,
+			/// most drivers allow only one active cursor per connection
+			std::weak_ptr<resultset> active_rs;
+
+			/// the statement which is executing,it's canceled by cancel() from another thread
+			SQLHSTMT executing = nullptr;
+			std::mutex executing_mtx;
+
+			/**
+			 * mark the statement as executing in the scope.
+			 */
+			struct executing_guard
+			{
+				executing_guard(session & s, SQLHSTMT stmt) : m_session(s)
+				{
+					std::lock_guard<std::mutex> g(m_session.executing_mtx);
+					m_session.executing = stmt;
+				}
+				~executing_guard()
+				{
+					std::lock_guard<std::mutex> g(m_session.executing_mtx);
+					m_session.executing = nullptr;
+				}
+				session & m_session;
+			};
+
+			bool cancel()
+			{
+				std::lock_guard<std::mutex> g(executing_mtx);
+				return (executing && is_ok(SQLCancel(executing)));
+			}
+
+			void close_active()
+			{
+				std::shared_ptr<resultset> rs = active_rs.lock();
+				if (rs)
+					rs->close();
+				active_rs.reset();
+			}
+
+			/**
+			 * set the attributes of a new statement handle.
+			 */
+			void setup(SQLHSTMT stmt)
+			{
+				if (async)
+					SQLSetStmtAttr(stmt, SQL_ATTR_ASYNC_ENABLE, (SQLPOINTER)SQL_ASYNC_ENABLE_ON, 0);
+				else if (query_timeout > 0)
+					SQLSetStmtAttr(stmt, SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER)(SQLULEN)((query_timeout + 999) / 1000), 0);
+			}
+		};
+
+		static inline bool is_ok(SQLRETURN status)
+		{
+			return (status == SQL_SUCCESS || status == SQL_SUCCESS_WITH_INFO);
+		}
+
+		/**
+		 * Returns the diagnostic records of the handle,eg : "[42S02] no such table: user"
+		 */
+		static std::string get_error(SQLSMALLINT handle_type, SQLHANDLE handle)
+		{
+			std::string err;
+			if (!handle)
+				return err;
+
+			SQLCHAR state[8] = { 0 };
+			SQLCHAR msg[SQL_MAX_MESSAGE_LENGTH + 1] = { 0 };
+			SQLINTEGER native = 0;
+			SQLSMALLINT len = 0;
+
+			for (SQLSMALLINT i = 1; SQLGetDiagRec(handle_type, handle, i, state, &native, msg, (SQLSMALLINT)sizeof(msg), &len) == SQL_SUCCESS; i++)
+			{
+				if (!err.empty())
+					err += "\n";
+				err += "[";
+				err += (const char *)state;
+				err += "] ";
+				err += (const char *)msg;
+			}
+			return err;
+		}
+
+		/**
+		 * Call a statement function,when the statement is in async mode the function returns
+		 * SQL_STILL_EXECUTING and it must be called again with the same arguments until it is
+		 * completed.If the timeout is exceeded the statement is canceled by SQLCancel,then the
+		 * function returns SQL_ERROR with SQLSTATE HY008.
+		 */
+		template<typename _handler, typename... Args>
+		static inline SQLRETURN execute(SQLHSTMT stmt, std::size_t timeout, _handler handler, Args... handler_args)
+		{
+			SQLRETURN status = handler(handler_args...);
+			if (status != SQL_STILL_EXECUTING)
+				return status;
+
+			auto begin = std::chrono::steady_clock::now();
+			bool canceled = false;
+			std::size_t sleep_us = 20;
+			while ((status = handler(handler_args...)) == SQL_STILL_EXECUTING)
+			{
+				if (!canceled && timeout > 0 && std::chrono::steady_clock::now() - begin > std::chrono::milliseconds(timeout))
+				{
+					SQLCancel(stmt);
+					canceled = true;
+				}
+
+				// poll quickly at first,most statements are finished in a few milliseconds
+				std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
+				sleep_us = (std::min)(sleep_us * 2, (std::size_t)5000);
+			}
+			return status;
+		}
+
+		/**
+		 * the DBMS name is used to select the statement of last_rowid().
+		 */
+		static const char * last_rowid_sql(const std::string & dbms_name)
+		{
+			std::string name(dbms_name);
+			std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+			if (name.find("sql server") != std::string::npos)
+				return "SELECT @@IDENTITY";
+			if (name.find("sqlite") != std::string::npos)
+				return "SELECT last_insert_rowid()";
+			if (name.find("mysql") != std::string::npos || name.find("mariadb") != std::string::npos)
+				return "SELECT LAST_INSERT_ID()";
+			if (name.find("postgres") != std::string::npos)
+				return "SELECT lastval()";
+			return nullptr;
+		}
+
+		static void to_timestamp_struct(time_t x, SQL_TIMESTAMP_STRUCT & ts)
+		{
+			struct tm tm = { 0 };
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_)
+			gmtime_s(&tm, &x);
+#else
+			gmtime_r(&x, &tm);
+#endif
+			ts.year = (SQLSMALLINT)(tm.tm_year + 1900);
+			ts.month = (SQLUSMALLINT)(tm.tm_mon + 1);
+			ts.day = (SQLUSMALLINT)tm.tm_mday;
+			ts.hour = (SQLUSMALLINT)tm.tm_hour;
+			ts.minute = (SQLUSMALLINT)tm.tm_min;
+			ts.second = (SQLUSMALLINT)tm.tm_sec;
+			ts.fraction = 0;
+		}
+
+		/**
+		 * tm_year is the year literal and tm_mon is [0-11],see resultset::get_datetime
+		 */
+		static struct tm to_tm(const SQL_TIMESTAMP_STRUCT & ts)
+		{
+			struct tm tm = { 0 };
+			tm.tm_year = ts.year;
+			tm.tm_mon = ts.month - 1;
+			tm.tm_mday = ts.day;
+			tm.tm_hour = ts.hour;
+			tm.tm_min = ts.minute;
+			tm.tm_sec = ts.second;
+			return tm;
+		}
+
+		/**
+		 * parse "YYYY-MM-DD HH:MM:SS","YYYY-MM-DD" and "HH:MM:SS",the fraction of the seconds is
+		 * ignored.
+		 */
+		static bool parse_datetime(const char * s, SQL_TIMESTAMP_STRUCT & ts)
+		{
+			std::memset(&ts, 0, sizeof(ts));
+			if (!s)
+				return false;
+
+			int y = 0, mon = 0, d = 0, h = 0, min = 0, sec = 0;
+			int n = std::sscanf(s, "%d-%d-%d%*[ T]%d:%d:%d", &y, &mon, &d, &h, &min, &sec);
+			if (n < 3)
+			{
+				y = 1970, mon = 1, d = 1;
+				n = std::sscanf(s, "%d:%d:%d", &h, &min, &sec);
+				if (n != 3)
+					return false;
+			}
+
+			ts.year = (SQLSMALLINT)y;
+			ts.month = (SQLUSMALLINT)mon;
+			ts.day = (SQLUSMALLINT)d;
+			ts.hour = (SQLUSMALLINT)h;
+			ts.minute = (SQLUSMALLINT)min;
+			ts.second = (SQLUSMALLINT)sec;
+			return true;
+		}
+
+		static time_t timegm(const SQL_TIMESTAMP_STRUCT & ts)
+		{
+			// days from civil,the timegm function is not portable
+			int y = ts.year - (ts.month <= 2 ? 1 : 0);
+			int era = (y >= 0 ? y : y - 399) / 400;
+			unsigned yoe = (unsigned)(y - era * 400);
+			unsigned doy = (153 * (ts.month + (ts.month > 2 ? -3 : 9)) + 2) / 5 + ts.day - 1;
+			unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+			int64_t days = (int64_t)era * 146097 + (int64_t)doe - 719468;
+			return (time_t)(days * 86400 + ts.hour * 3600 + ts.minute * 60 + ts.second);
+		}
+
+	};
+
+}
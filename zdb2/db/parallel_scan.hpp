@@ -0,0 +1,413 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <stdexcept>
+
+#include <zdb2/net/url.hpp>
+#include <zdb2/db/connection.hpp>
+#include <zdb2/db/resultset.hpp>
+#include <zdb2/db/pool.hpp>
+#include <zdb2/db/merged_resultset.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * Scan a large table by several connections at the same time,the table is split into key
+	 * ranges,and every range is scanned by it's own connection,eg :
+	 *
+	 * zdb2::parallel_scan scan(pool_ptr, "orders", "id", std::thread::hardware_concurrency());
+	 * scan.set_columns("id,user_id,amount");
+	 *
+	 * // every partition is consumed by it's own thread
+	 * bool ok = scan.run([](std::size_t partition, zdb2::resultset & rs)
+	 * {
+	 *     while (rs.next_row())
+	 *         ...;
+	 *     return true;
+	 * });
+	 *
+	 * // or all the rows in the key order,the partitions are fetched ahead by their threads
+	 * auto rs = scan.query();
+	 *
+	 * The ranges are split by the MIN and MAX of the key when it is an integer,otherwise by the
+	 * keys sampled at every (count / partitions) rows.The rows which key is NULL are not scanned.
+	 *
+	 * For sqlite the scan uses it's own pool of read only connections without the shared cache
+	 * ("open_mode=ro&shared_cache=false"),the connections of the shared cache are serialized,the
+	 * database should be in the WAL journal mode so the scan doesn't block the writers.
+	 */
+	class parallel_scan
+	{
+	public:
+
+		/**
+		 * a key range of the table,an empty bound means no limit.
+		 */
+		struct range
+		{
+			std::string lower;
+			std::string upper;
+		};
+
+		/**
+		 * @param table The table name,it's used in the SQL as is
+		 * @param key The integer or ordered key column,it should be the primary key or indexed
+		 * @param partitions The max count of the ranges and the connections
+		 */
+		parallel_scan(std::shared_ptr<pool> pool_ptr, const std::string & table, const std::string & key, std::size_t partitions)
+			: m_pool_ptr(pool_ptr)
+			, m_table(table)
+			, m_key(key)
+			, m_partitions(partitions)
+		{
+			if (!m_pool_ptr || m_table.empty() || m_key.empty() || m_partitions == 0)
+				throw std::runtime_error("invalid parameters.");
+
+			std::shared_ptr<url> url_ptr = m_pool_ptr->get_url();
+			if (url_ptr->get_dbtype() == "sqlite")
+			{
+				std::shared_ptr<url> ro_url_ptr = std::make_shared<url>(*url_ptr);
+				ro_url_ptr->set_param_value("open_mode", "ro");
+				ro_url_ptr->set_param_value("shared_cache", "false");
+				m_scan_pool_ptr = std::make_shared<pool>(ro_url_ptr, 1,
+					zdb2::DEFAULT_CONNECTION_TIMEOUT, zdb2::DEFAULT_TIMEOUT, m_partitions);
+			}
+			else
+			{
+				m_scan_pool_ptr = m_pool_ptr;
+			}
+		}
+
+		/**
+		 * Set the columns of the select list,default "*".
+		 */
+		parallel_scan & set_columns(const std::string & columns)
+		{
+			m_columns = columns;
+			return (*this);
+		}
+
+		/**
+		 * Set an extra condition of the rows,eg : "status = 1".
+		 */
+		parallel_scan & set_where(const std::string & where)
+		{
+			m_where = where;
+			m_ranges.clear();
+			return (*this);
+		}
+
+		/**
+		 * Split the integer key by sampling too,use it when the integer keys are not uniform.
+		 */
+		parallel_scan & set_sampling(bool sampling)
+		{
+			m_sampling = sampling;
+			m_ranges.clear();
+			return (*this);
+		}
+
+		/**
+		 * Set the rows of every chunk fetched ahead by query().
+		 */
+		parallel_scan & set_chunk_rows(std::size_t chunk_rows)
+		{
+			m_chunk_rows = (chunk_rows == 0 ? 1 : chunk_rows);
+			return (*this);
+		}
+
+		/**
+		 * Get the key ranges,they are computed at the first time.
+		 * @return The ranges in the key order,empty if failed,the error can be got by get_last_error()
+		 */
+		std::vector<range> get_ranges()
+		{
+			if (m_ranges.empty())
+				_split();
+			return m_ranges;
+		}
+
+		/**
+		 * Get the SQL which scans a range.
+		 */
+		std::string get_sql(const range & r)
+		{
+			std::string sql = "SELECT " + m_columns + " FROM " + m_table + " WHERE " + m_key + " IS NOT NULL";
+			if (!r.lower.empty())
+				sql += " AND " + m_key + " >= " + r.lower;
+			if (!r.upper.empty())
+				sql += " AND " + m_key + " < " + r.upper;
+			if (!m_where.empty())
+				sql += " AND (" + m_where + ")";
+			sql += " ORDER BY " + m_key;
+			return sql;
+		}
+
+		/**
+		 * Scan all the ranges at the same time,the consumer is called once for every range in the
+		 * thread of the range,the ResultSet is positioned before the first row.
+		 * @param consumer bool(std::size_t partition, zdb2::resultset & rs),returns false if failed
+		 * @return true if all the ranges are scanned and consumed successfully
+		 */
+		bool run(std::function<bool(std::size_t, resultset &)> consumer)
+		{
+			std::vector<range> ranges = get_ranges();
+			if (ranges.empty())
+				return false;
+
+			std::mutex mtx;
+			std::string error;
+
+			std::vector<std::shared_ptr<std::thread>> threads;
+			for (std::size_t i = 0; i < ranges.size(); i++)
+			{
+				std::string sql = get_sql(ranges[i]);
+				threads.emplace_back(std::make_shared<std::thread>([this, i, sql, &consumer, &mtx, &error]()
+				{
+					std::string err;
+					try
+					{
+						std::shared_ptr<connection> conn = m_scan_pool_ptr->get();
+						if (!conn)
+						{
+							err = "no available connection in the pool.";
+						}
+						else
+						{
+							std::shared_ptr<resultset> rs = conn->query("%s", sql.c_str());
+							if (!rs)
+							{
+								const char * e = conn->get_last_error();
+								err = ((e && e[0] != '\0') ? e : "unknown database error.");
+							}
+							else if (!consumer(i, *rs))
+							{
+								err = "the consumer of the partition " + std::to_string(i) + " is failed.";
+							}
+						}
+					}
+					catch (std::exception & e)
+					{
+						err = e.what();
+					}
+
+					if (!err.empty())
+					{
+						std::lock_guard<std::mutex> g(mtx);
+						if (error.empty())
+							error = err;
+					}
+				}));
+			}
+
+			for (auto & thread_ptr : threads)
+				thread_ptr->join();
+
+			m_error = error;
+			return error.empty();
+		}
+
+		/**
+		 * Scan all the ranges at the same time,and return the rows in the key order.
+		 * @return The merged ResultSet,or nullptr if failed,the error can be got by get_last_error()
+		 */
+		std::shared_ptr<merged_resultset> query()
+		{
+			std::vector<range> ranges = get_ranges();
+			if (ranges.empty())
+				return nullptr;
+
+			// the ranges are ordered,so the concatenation of the ordered ranges is ordered
+			std::shared_ptr<merged_resultset> rs = std::make_shared<merged_resultset>(merged_resultset::concat);
+
+			std::shared_ptr<pool> pool_ptr = m_scan_pool_ptr;
+			for (auto & r : ranges)
+			{
+				rs->add_stream([pool_ptr]() { return pool_ptr->get(); }, get_sql(r), m_chunk_rows);
+			}
+
+			if (!rs->start())
+			{
+				m_error = rs->get_last_error();
+				return nullptr;
+			}
+			return rs;
+		}
+
+		const char * get_last_error()
+		{
+			return m_error.c_str();
+		}
+
+	protected:
+
+		void _split()
+		{
+			m_ranges.clear();
+
+			std::shared_ptr<connection> conn = m_pool_ptr->get();
+			if (!conn)
+			{
+				m_error = "no available connection in the pool.";
+				return;
+			}
+
+			std::string where = " WHERE " + m_key + " IS NOT NULL";
+			if (!m_where.empty())
+				where += " AND (" + m_where + ")";
+
+			std::vector<std::string> bounds;
+			bool sampling = m_sampling;
+			if (!sampling)
+			{
+				std::shared_ptr<resultset> rs = conn->query("SELECT MIN(%s),MAX(%s) FROM %s%s",
+					m_key.c_str(), m_key.c_str(), m_table.c_str(), where.c_str());
+				if (!rs)
+				{
+					m_error = conn->get_last_error();
+					return;
+				}
+
+				// no row to scan,one empty range
+				if (!rs->next_row() || rs->is_null(0) || rs->is_null(1))
+				{
+					m_ranges.emplace_back();
+					return;
+				}
+
+				int64_t lo = 0, hi = 0;
+				if (_to_int64(rs->get_string(0), lo) && _to_int64(rs->get_string(1), hi))
+				{
+					// the width of every range,rounded up,so there are at most m_partitions ranges
+					uint64_t span = (uint64_t)hi - (uint64_t)lo + 1;
+					uint64_t width = span / m_partitions + (span % m_partitions ? 1 : 0);
+					for (std::size_t i = 1; i < m_partitions && width > 0 && (uint64_t)i * width < span; i++)
+						bounds.emplace_back(std::to_string((int64_t)((uint64_t)lo + (uint64_t)i * width)));
+				}
+				else
+				{
+					sampling = true;
+				}
+			}
+
+			if (sampling)
+			{
+				std::shared_ptr<resultset> rs = conn->query("SELECT COUNT(*) FROM %s%s", m_table.c_str(), where.c_str());
+				if (!rs || !rs->next_row())
+				{
+					m_error = conn->get_last_error();
+					return;
+				}
+				int64_t count = rs->get_int64(0);
+				rs.reset();
+
+				for (std::size_t i = 1; i < m_partitions && count > 0; i++)
+				{
+					int64_t offset = (int64_t)((uint64_t)count * i / m_partitions);
+					rs = conn->query("SELECT %s FROM %s%s ORDER BY %s LIMIT 1 OFFSET %lld",
+						m_key.c_str(), m_table.c_str(), where.c_str(), m_key.c_str(), (long long)offset);
+					if (!rs)
+					{
+						m_error = conn->get_last_error();
+						return;
+					}
+					if (!rs->next_row())
+						break;
+
+					std::string bound = _literal(rs);
+					rs.reset();
+
+					// the same key may be sampled twice when it has many rows
+					if (bounds.empty() || bounds.back() != bound)
+						bounds.emplace_back(bound);
+				}
+			}
+
+			range r;
+			for (auto & bound : bounds)
+			{
+				r.upper = bound;
+				m_ranges.emplace_back(r);
+				r.lower = bound;
+			}
+			r.upper.clear();
+			m_ranges.emplace_back(r);
+		}
+
+		/**
+		 * the key value as a quoted SQL literal,even it looks like a number : the key may be a text
+		 * column (eg : "00123"),and all the databases convert a quoted literal to the type of an
+		 * integer key.
+		 */
+		static std::string _literal(std::shared_ptr<resultset> & rs)
+		{
+			std::size_t size = 0;
+			const char * data = (const char *)rs->get_blob(0, &size);
+			std::string value(data ? data : "", data ? size : 0);
+
+			std::string literal = "'";
+			for (char c : value)
+			{
+				if (c == '\'')
+					literal += '\'';
+				literal += c;
+			}
+			literal += '\'';
+			return literal;
+		}
+
+		/**
+		 * only the canonical integers,a text key like "00123" or "+5" is split by sampling.
+		 */
+		static bool _to_int64(const char * s, int64_t & v)
+		{
+			if (!s || *s == '\0')
+				return false;
+			char * end = nullptr;
+			v = (int64_t)std::strtoll(s, &end, 10);
+			return (end && *end == '\0' && std::to_string(v) == s);
+		}
+
+	protected:
+
+		std::shared_ptr<pool> m_pool_ptr;
+
+		/// the pool of the scanning connections,a read only pool for sqlite
+		std::shared_ptr<pool> m_scan_pool_ptr;
+
+		std::string m_table;
+		std::string m_key;
+		std::string m_columns = "*";
+		std::string m_where;
+
+		std::size_t m_partitions = 1;
+
+		bool m_sampling = false;
+
+		std::size_t m_chunk_rows = 256;
+
+		std::vector<range> m_ranges;
+
+		std::string m_error;
+
+	};
+
+}
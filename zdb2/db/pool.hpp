@@ -15,21 +15,33 @@
 #include <string>
 #include <memory>
 #include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <chrono>
 #include <deque>
+#include <vector>
+#include <exception>
+#include <future>
+#include <functional>
 #include <stdexcept>
 
 #include <zdb2/config.hpp>
 
 #include <zdb2/net/url.hpp>
-#include <zdb2/util/spin_lock.hpp>
+#include <zdb2/util/adaptive_mutex.hpp>
+#include <zdb2/util/executor.hpp>
 
 #include <zdb2/db/connection.hpp>
-#include <zdb2/db/sqlite/sqlite_connection.hpp>
-#include <zdb2/db/mysql/mysql_connection.hpp>
-#include <zdb2/db/sqlserver/sqlserver_connection.hpp>
+#include <zdb2/db/sql_util.hpp>
+#include <zdb2/db/stats.hpp>
+#include <zdb2/db/pool_metrics.hpp>
+#include <zdb2/db/hooks.hpp>
+#include <zdb2/db/materialized_result.hpp>
+#include <zdb2/db/registry.hpp>
+#include <zdb2/db/balancer.hpp>
+#include <zdb2/db/backends.hpp>
 
 namespace zdb2 
 {
@@ -52,6 +64,7 @@ namespace zdb2
 			, m_max_conn_count(max_conn_count)
 			, m_sweep_interval(sweep_interval)
 		{
+			m_lock.set_name("pool");
 			_init();
 		}
 
@@ -69,7 +82,18 @@ namespace zdb2
 
 		std::shared_ptr<connection> get()
 		{
-			std::lock_guard<spin_lock> g(m_lock);
+			bool exhausted = false;
+			return try_get(exhausted);
+		}
+
+		/**
+		 * The same as get(),if nullptr is returned,exhausted is set to true when all the connections
+		 * are in use,and false when the new connection is failed to open.The waiting callers can
+		 * retry when a connection is returned,see add_return_listener().
+		 */
+		std::shared_ptr<connection> try_get(bool & exhausted)
+		{
+			exhausted = false;
 
 			// [important] : 
 			// if we make this_ptr by shared_from_this and passed it to the lumbda function,and the lumbda function
@@ -86,39 +110,309 @@ namespace zdb2
 			// so pass a this_ptr by shared_from_this to the custom deleter,can make sure the "this" pool obejct is 
 			// destructed after the the connection shared_ptr destructed.
 			auto this_ptr = this->shared_from_this();
-			auto deleter = [this_ptr](connection * conn)
-			{
-				std::lock_guard<spin_lock> g(this_ptr->m_lock);
-				this_ptr->m_connections.emplace_back(conn);
-				this_ptr->m_using_count--;
-			};
+			auto begin = std::chrono::steady_clock::now();
+
+			connection * conn = nullptr;
+			bool reserved = false;
+			std::vector<connection *> ejected;
 
-			if (m_connections.size() > 0)
 			{
-				auto conn = m_connections.front();
-				m_connections.pop_front();
+				std::lock_guard<adaptive_mutex> g(m_lock);
+
+				while (m_connections.size() > 0)
+				{
+					auto idle = m_connections.front();
+					m_connections.pop_front();
+
+					// the idle connections to the ejected host are closed
+					if (_is_ejected(idle))
+					{
+						ejected.emplace_back(idle);
+						continue;
+					}
+
+					conn = idle;
+					break;
+				}
+
+				// reserve the place of the new connection,the connection is opened without the lock,
+				// so the other threads are not blocked by the connecting
+				if (!conn && m_using_count < m_max_conn_count)
+					reserved = true;
 
-				m_using_count++;
+				if (conn || reserved)
+					m_using_count++;
+			}
 
-				return std::shared_ptr<connection>(conn, deleter);
+			_delete_connections(ejected);
+
+			if (!conn && !reserved)
+			{
+				m_counters.exhausted++;
+				exhausted = true;
+				return nullptr;
 			}
 
-			if (m_using_count < m_max_conn_count)
+			if (!conn)
 			{
-				connection * conn = new_connection();
-				if (conn)
+				try
 				{
-					m_using_count++;
+					conn = new_connection();
+				}
+				catch (std::exception &)
+				{
+					m_counters.checkout_errors++;
+					_release_place();
+					throw;
+				}
 
-					return std::shared_ptr<connection>(conn, deleter);
+				if (!conn)
+				{
+					m_counters.checkout_errors++;
+					_release_place();
+					return nullptr;
 				}
 			}
 
-			return nullptr;
+			// the connections record the statements into the stats of the pool.only the raw pointer
+			// is loaded here,the connection holds the old stats,so the address can't be reused by a
+			// new stats while they are compared,and the mutex is locked only when the stats changed
+			if (conn->get_stats().get() != m_stats.load(std::memory_order_acquire))
+				conn->set_stats(get_stats());
+
+			auto checkout = std::chrono::steady_clock::now();
+			uint64_t wait_us = _elapsed_us(begin, checkout);
+			m_counters.checkouts++;
+			m_counters.wait_us.record(wait_us);
+
+			if (hooks * hooks_ptr = hooks::get())
+			{
+				hook_event ev;
+				ev.conn = conn;
+				ev.time = checkout;
+				ev.duration_us = wait_us;
+				hooks_ptr->on_checkout(ev);
+			}
+
+			auto deleter = [this_ptr, checkout](connection * conn)
+			{
+				auto now = std::chrono::steady_clock::now();
+				uint64_t hold_us = _elapsed_us(checkout, now);
+				this_ptr->m_counters.hold_us.record(hold_us);
+
+				if (hooks * hooks_ptr = hooks::get())
+				{
+					hook_event ev;
+					ev.conn = conn;
+					ev.time = now;
+					ev.duration_us = hold_us;
+					hooks_ptr->on_return(ev);
+				}
+
+				this_ptr->_release_place(conn);
+			};
+
+			return std::shared_ptr<connection>(conn, deleter);
+		}
+
+		/**
+		 * Executes the query on a pooled connection in the async executor of the pool,the rows
+		 * are copied into a materialized_result,so the connection is returned to the pool as soon
+		 * as the query is finished.The sql and args are the same as connection::query().
+		 * @return A future of the result,if no connection is available or the async task queue
+		 * is full,the future will throw a std::runtime_error.
+		 */
+		template<typename... Args>
+		std::future<std::shared_ptr<materialized_result>> async_query(const char * sql, Args... args)
+		{
+			// format on the calling thread,the args (eg : a const char * of %s) may be destroyed
+			// before the task is run
+			std::string sql_str = sql_util::format(sql, args...);
+			std::weak_ptr<pool> this_wptr = this->shared_from_this();
+			return _async(std::function<std::shared_ptr<materialized_result>()>([this_wptr, sql_str]()
+			{
+				std::shared_ptr<pool> this_ptr = this_wptr.lock();
+				if (!this_ptr)
+					throw std::runtime_error("the pool is destroyed.");
+
+				std::shared_ptr<connection> conn = this_ptr->get();
+				if (!conn)
+					throw std::runtime_error("no available connection in the pool.");
+
+				std::shared_ptr<resultset> rs = conn->query("%s", sql_str.c_str());
+				if (!rs)
+					throw std::runtime_error(_last_error(conn));
+
+				return materialized_result::materialize(rs);
+			}));
+		}
+
+		/**
+		 * Executes the statement on a pooled connection in the async executor of the pool.
+		 * The sql and args are the same as connection::execute().
+		 * @return A future of the number of rows changed by the statement,if the statement is
+		 * failed,no connection is available or the async task queue is full,the future will 
+		 * throw a std::runtime_error.
+		 */
+		template<typename... Args>
+		std::future<int64_t> async_execute(const char * sql, Args... args)
+		{
+			// format on the calling thread,the args (eg : a const char * of %s) may be destroyed
+			// before the task is run
+			std::string sql_str = sql_util::format(sql, args...);
+			std::weak_ptr<pool> this_wptr = this->shared_from_this();
+			return _async(std::function<int64_t()>([this_wptr, sql_str]()
+			{
+				std::shared_ptr<pool> this_ptr = this_wptr.lock();
+				if (!this_ptr)
+					throw std::runtime_error("the pool is destroyed.");
+
+				std::shared_ptr<connection> conn = this_ptr->get();
+				if (!conn)
+					throw std::runtime_error("no available connection in the pool.");
+
+				if (!conn->execute("%s", sql_str.c_str()))
+					throw std::runtime_error(_last_error(conn));
+
+				return conn->rows_changed();
+			}));
+		}
+
+		/**
+		 * Add a function which is called after a connection is returned to the pool,or the place of
+		 * a connection which is failed to open is released,eg : async_pool resumes a coroutine which
+		 * is waiting for a connection.The function is called without the lock of the pool,and it's
+		 * removed when the listener is destroyed.
+		 */
+		void add_return_listener(std::weak_ptr<std::function<void()>> listener)
+		{
+			std::lock_guard<adaptive_mutex> g(m_lock);
+			m_return_listeners.emplace_back(std::move(listener));
+		}
+
+		/**
+		 * Get the count of the connections which are checked out of the pool.
+		 */
+		std::size_t get_using_count()
+		{
+			std::lock_guard<adaptive_mutex> g(m_lock);
+			return m_using_count;
+		}
+
+		/**
+		 * Get the count of the idle connections in the pool.
+		 */
+		std::size_t get_idle_count()
+		{
+			std::lock_guard<adaptive_mutex> g(m_lock);
+			return m_connections.size();
+		}
+
+		std::size_t get_max_conn_count()
+		{
+			return m_max_conn_count;
+		}
+
+		/**
+		 * Get the connection counts and a copy of the counters of the pool,they can be rendered
+		 * in the Prometheus text format by zdb2::prometheus.
+		 */
+		pool_metrics get_metrics()
+		{
+			pool_metrics m;
+			{
+				std::lock_guard<adaptive_mutex> g(m_lock);
+				m.idle_count  = m_connections.size();
+				m.using_count = m_using_count;
+			}
+			m.max_count = m_max_conn_count;
+
+			m.checkouts        = m_counters.checkouts;
+			m.exhausted        = m_counters.exhausted;
+			m.checkout_errors  = m_counters.checkout_errors;
+			m.connects         = m_counters.connects;
+			m.connect_failures = m_counters.connect_failures;
+			m.reaped           = m_counters.reaped;
+			m.ping_failures    = m_counters.ping_failures;
+
+			m.wait_us    = std::make_shared<histogram>();
+			m.hold_us    = std::make_shared<histogram>();
+			m.connect_us = std::make_shared<histogram>();
+			m.wait_us->merge(m_counters.wait_us);
+			m.hold_us->merge(m_counters.hold_us);
+			m.connect_us->merge(m_counters.connect_us);
+			return m;
+		}
+
+		/**
+		 * Enable or disable recording the latency of the statements executed by the connections of
+		 * the pool,the statements are grouped by their fingerprints,see statement_stats.The
+		 * connections which are checked out already start or stop recording at the next get().
+		 * @param max_fingerprints The max count of the different fingerprints
+		 */
+		void enable_stats(bool enable, std::size_t max_fingerprints = 1000)
+		{
+			std::lock_guard<std::mutex> g(m_stats_mtx);
+			if (enable)
+			{
+				if (!m_stats_ptr)
+					m_stats_ptr = std::make_shared<statement_stats>(max_fingerprints);
+			}
+			else
+			{
+				m_stats_ptr.reset();
+			}
+			m_stats.store(m_stats_ptr.get(), std::memory_order_release);
+		}
+
+		/**
+		 * Get the statement stats of the pool,nullptr if the stats is disabled.
+		 */
+		std::shared_ptr<statement_stats> get_stats()
+		{
+			std::lock_guard<std::mutex> g(m_stats_mtx);
+			return m_stats_ptr;
+		}
+
+		/**
+		 * Get the stats of every fingerprint,the most expensive statements are the first.
+		 */
+		std::vector<statement_stats::entry_snapshot> get_stats_snapshot()
+		{
+			std::shared_ptr<statement_stats> stats_ptr = get_stats();
+			if (!stats_ptr)
+				return std::vector<statement_stats::entry_snapshot>();
+			return stats_ptr->snapshot();
+		}
+
+		void reset_stats()
+		{
+			std::shared_ptr<statement_stats> stats_ptr = get_stats();
+			if (stats_ptr)
+				stats_ptr->reset();
+		}
+
+		/**
+		 * Get the async executor of the pool,the executor is created when it is used at the first
+		 * time.It has max_conn_count threads,so every thread can hold a connection at the same time,
+		 * and the max pending tasks is max_conn_count too.
+		 */
+		std::shared_ptr<executor> get_executor()
+		{
+			std::lock_guard<std::mutex> g(m_executor_mtx);
+			if (!m_executor_ptr && !m_stopped)
+				m_executor_ptr = std::make_shared<executor>(m_max_conn_count, m_max_conn_count);
+			return m_executor_ptr;
 		}
 
 		void destroy()
 		{
+			{
+				std::lock_guard<std::mutex> g(m_executor_mtx);
+				if (m_executor_ptr)
+					m_executor_ptr->stop();
+			}
+
 			if (m_sweep_thread_ptr && m_sweep_thread_ptr->joinable())
 			{
 				{
@@ -131,11 +425,11 @@ namespace zdb2
 			}
 			if (m_connections.size() > 0)
 			{
-				std::lock_guard<spin_lock> g(m_lock);
+				std::lock_guard<adaptive_mutex> g(m_lock);
 
 				for (auto & conn : m_connections)
 				{
-					delete conn;
+					_delete_connection(conn);
 				}
 
 				m_connections.clear();
@@ -145,16 +439,20 @@ namespace zdb2
 	protected:
 		bool _init()
 		{
-			std::lock_guard<spin_lock> g(m_lock);
+			// find the factory once,the plugin of the database type may be loaded here
+			std::string err;
+			m_factory = registry::instance().find(m_url_ptr->get_dbtype(), &err);
+			if (!m_factory)
+				throw std::runtime_error("unknown database type " + m_url_ptr->get_dbtype() + " : " + err);
 
-			for (std::size_t i = 0; i < m_init_conn_count; i++)
-			{
-				connection * conn = new_connection();
-				if (conn)
-				{
-					m_connections.emplace_back(conn);
-				}
-			}
+			if (m_url_ptr->get_hosts().size() > 1)
+				m_balancer_ptr = std::make_shared<balancer>(m_url_ptr);
+
+			std::vector<connection *> conns = _new_connections(m_init_conn_count);
+
+			std::lock_guard<adaptive_mutex> g(m_lock);
+
+			m_connections.insert(m_connections.end(), conns.begin(), conns.end());
 
 			if (m_connections.size() == 0)
 			{
@@ -169,17 +467,34 @@ namespace zdb2
 
 		void _sweep_func()
 		{
+			// the ejected hosts are probed more frequently than the connections are reaped
+			std::chrono::milliseconds interval = std::chrono::seconds(m_sweep_interval);
+			if (m_balancer_ptr)
+				interval = (std::min)(interval, m_balancer_ptr->get_probe_interval());
+
+			auto last_reap = std::chrono::steady_clock::now();
+
 			while (!m_stopped)
 			{
 				{
 					std::unique_lock <std::mutex> lck(m_mtx);
-					m_cv.wait_for(lck, std::chrono::seconds(m_sweep_interval));
+					m_cv.wait_for(lck, interval);
 				}
 
 				if (m_stopped)
 					break;
 
-				_reap_connections();
+				if (m_balancer_ptr)
+				{
+					_probe_hosts();
+					_fill_connections();
+				}
+
+				if (std::chrono::steady_clock::now() - last_reap >= std::chrono::seconds(m_sweep_interval))
+				{
+					_reap_connections();
+					last_reap = std::chrono::steady_clock::now();
+				}
 			}
 		}
 
@@ -187,15 +502,22 @@ namespace zdb2
 		{
 			if (m_connections.size() > 0)
 			{
-				std::lock_guard<spin_lock> g(m_lock);
+				std::lock_guard<adaptive_mutex> g(m_lock);
 
 				for (auto begin = m_connections.begin(); begin != m_connections.end();)
 				{
 					auto time_diff = std::chrono::system_clock::now() - (*begin)->get_last_access_time();
 					auto seconds = std::chrono::duration_cast<std::chrono::seconds>(time_diff).count();
-					if ((std::size_t)seconds > m_conn_timeout || !(*begin)->ping())
+					bool reap = ((std::size_t)seconds > m_conn_timeout || _is_ejected(*begin));
+					if (!reap && !_ping(*begin))
 					{
-						delete (*begin);
+						m_counters.ping_failures++;
+						reap = true;
+					}
+					if (reap)
+					{
+						m_counters.reaped++;
+						_delete_connection(*begin);
 
 						// when erase a elem,the iterator will auto point to the next element
 						begin = m_connections.erase(begin);
@@ -208,30 +530,348 @@ namespace zdb2
 			}
 		}
 
+		template<typename R>
+		std::future<R> _async(std::function<R()> fn)
+		{
+			std::shared_ptr<std::packaged_task<R()>> task_ptr = std::make_shared<std::packaged_task<R()>>(std::move(fn));
+			std::future<R> future = task_ptr->get_future();
+
+			std::shared_ptr<executor> executor_ptr = get_executor();
+			if (executor_ptr && executor_ptr->post([task_ptr]() { (*task_ptr)(); }))
+				return future;
+
+			std::promise<R> promise;
+			promise.set_exception(std::make_exception_ptr(std::runtime_error("the async task queue of the pool is full.")));
+			return promise.get_future();
+		}
+
+		static std::string _last_error(std::shared_ptr<connection> & conn)
+		{
+			const char * err = conn->get_last_error();
+			return ((err && err[0] != '\0') ? err : "unknown database error.");
+		}
+
 		connection * new_connection()
 		{
-			std::string _db_type = m_url_ptr->get_dbtype();
-			if (_db_type == "mysql")
-				return dynamic_cast<connection *>(new mysql_connection(m_url_ptr, m_execute_timeout));
-			else if (_db_type == "oracle")
-				return dynamic_cast<connection *>(new sqlite_connection(m_url_ptr, m_execute_timeout));
-			else if (_db_type == "postgresql")
-				return dynamic_cast<connection *>(new sqlite_connection(m_url_ptr, m_execute_timeout));
-			else if (_db_type == "sqlite")
-				return dynamic_cast<connection *>(new sqlite_connection(m_url_ptr, m_execute_timeout));
-			else if (_db_type == "sqlserver")
-				return dynamic_cast<connection *>(new sqlserver_connection(m_url_ptr, m_execute_timeout));
-			else
+			if (!m_factory)
 				throw std::runtime_error("unknown database type.");
+
+			if (!m_balancer_ptr)
+				return _open(m_url_ptr, false);
+
+			// try the healthy hosts one by one,the failed host is ejected so it's not selected
+			// again,if all the hosts are failed the last exception is thrown
+			std::exception_ptr e;
+			for (std::size_t n = 0; n < m_balancer_ptr->get_host_count(); n++)
+			{
+				int i = m_balancer_ptr->select();
+				if (i < 0)
+					break;
+
+				connection * conn = _new_host_connection((std::size_t)i, e);
+				if (conn)
+					return conn;
+			}
+
+			if (e)
+				std::rethrow_exception(e);
+			return nullptr;
+		}
+
+		/**
+		 * create a connection by the factory and count it in the counters of the pool.
+		 */
+		connection * _open(std::shared_ptr<url> url_ptr, bool ping)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			try
+			{
+				std::unique_ptr<connection> conn(m_factory(url_ptr, m_execute_timeout));
+				if (conn && (!ping || conn->ping()))
+				{
+					m_counters.connects++;
+					m_counters.connect_us.record(_hook_connect(begin, conn.get(), nullptr));
+					return conn.release();
+				}
+			}
+			catch (std::exception & e)
+			{
+				m_counters.connect_failures++;
+				_hook_connect(begin, nullptr, e.what());
+				throw;
+			}
+
+			m_counters.connect_failures++;
+			_hook_connect(begin, nullptr, "failed to connect to the database.");
+			return nullptr;
+		}
+
+		/**
+		 * call the on_connect hook,returns the connect time.
+		 */
+		uint64_t _hook_connect(std::chrono::steady_clock::time_point begin, connection * conn, const char * error)
+		{
+			auto now = std::chrono::steady_clock::now();
+			uint64_t us = _elapsed_us(begin, now);
+			if (hooks * hooks_ptr = hooks::get())
+			{
+				hook_event ev;
+				ev.conn = conn;
+				ev.time = now;
+				ev.duration_us = us;
+				ev.ok = (conn != nullptr);
+				ev.error = error;
+				hooks_ptr->on_connect(ev);
+			}
+			return us;
+		}
+
+		static uint64_t _elapsed_us(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+		}
+
+		connection * _new_host_connection(std::size_t index, std::exception_ptr & e)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			try
+			{
+				// the connection object is created even if the server can't be connected,so it's
+				// pinged before it's used
+				connection * conn = _open(m_balancer_ptr->get_host_url(index), true);
+				if (conn)
+				{
+					m_balancer_ptr->on_success(index, std::chrono::steady_clock::now() - begin);
+					m_balancer_ptr->attach(conn, index);
+					return conn;
+				}
+			}
+			catch (std::exception &)
+			{
+				e = std::current_exception();
+			}
+
+			m_balancer_ptr->on_failure(index);
 			return nullptr;
 		}
 
+		/**
+		 * open the connections,when the url has a host list they are opened in parallel,so a dead
+		 * host costs one connect timeout instead of one per connection.
+		 */
+		std::vector<connection *> _new_connections(std::size_t count)
+		{
+			std::vector<connection *> conns;
+			if (count == 0)
+				return conns;
+
+			// the first connection is opened alone,so the client library which is initialized by
+			// the first connection (eg : mysql_library_init) isn't initialized by multi threads
+			connection * conn = new_connection();
+			if (conn)
+				conns.emplace_back(conn);
+
+			if (!m_balancer_ptr)
+			{
+				for (std::size_t i = 1; i < count; i++)
+				{
+					conn = new_connection();
+					if (conn)
+						conns.emplace_back(conn);
+				}
+				return conns;
+			}
+
+			std::vector<connection *> results(count - 1, nullptr);
+			std::vector<std::exception_ptr> errors(count - 1);
+			std::vector<std::thread> threads;
+			for (std::size_t i = 0; i < count - 1; i++)
+			{
+				threads.emplace_back([this, &results, &errors, i]()
+				{
+					try
+					{
+						results[i] = new_connection();
+					}
+					catch (std::exception &)
+					{
+						errors[i] = std::current_exception();
+					}
+				});
+			}
+			for (auto & thread : threads)
+				thread.join();
+
+			for (auto c : results)
+			{
+				if (c)
+					conns.emplace_back(c);
+			}
+			if (conns.empty())
+			{
+				for (auto & e : errors)
+				{
+					if (e)
+						std::rethrow_exception(e);
+				}
+			}
+			return conns;
+		}
+
+		/**
+		 * probe the ejected hosts in parallel,the connection of a successful probe is kept in
+		 * the pool.
+		 */
+		void _probe_hosts()
+		{
+			std::vector<std::size_t> hosts = m_balancer_ptr->get_probe_hosts();
+			if (hosts.empty())
+				return;
+
+			std::vector<connection *> conns(hosts.size(), nullptr);
+			std::vector<std::thread> threads;
+			for (std::size_t n = 0; n < hosts.size(); n++)
+			{
+				threads.emplace_back([this, &conns, &hosts, n]()
+				{
+					std::exception_ptr e;
+					conns[n] = _new_host_connection(hosts[n], e);
+				});
+			}
+			for (auto & thread : threads)
+				thread.join();
+
+			_add_connections(conns);
+		}
+
+		/**
+		 * reopen the connections which are closed because of the ejected hosts on the healthy
+		 * hosts,until the pool has init_conn_count connections again.
+		 */
+		void _fill_connections()
+		{
+			std::size_t count = 0;
+			{
+				std::lock_guard<adaptive_mutex> g(m_lock);
+				std::size_t total = m_connections.size() + m_using_count;
+				if (total < m_init_conn_count)
+					count = m_init_conn_count - total;
+			}
+			if (count == 0)
+				return;
+
+			std::vector<connection *> conns;
+			try
+			{
+				conns = _new_connections(count);
+			}
+			catch (std::exception &)
+			{
+			}
+
+			_add_connections(conns);
+		}
+
+		void _add_connections(std::vector<connection *> & conns)
+		{
+			std::vector<connection *> extra;
+			{
+				std::lock_guard<adaptive_mutex> g(m_lock);
+				for (auto conn : conns)
+				{
+					if (!conn)
+						continue;
+					if (m_connections.size() + m_using_count < m_max_conn_count)
+						m_connections.emplace_back(conn);
+					else
+						extra.emplace_back(conn);
+				}
+			}
+			_delete_connections(extra);
+		}
+
+		bool _ping(connection * conn)
+		{
+			if (!m_balancer_ptr)
+				return conn->ping();
+
+			int index = m_balancer_ptr->host_of(conn);
+			auto begin = std::chrono::steady_clock::now();
+			bool ok = conn->ping();
+			if (index >= 0)
+			{
+				if (ok)
+					m_balancer_ptr->on_latency((std::size_t)index, std::chrono::steady_clock::now() - begin);
+				else
+					m_balancer_ptr->on_failure((std::size_t)index);
+			}
+			return ok;
+		}
+
+		bool _is_ejected(connection * conn)
+		{
+			if (!m_balancer_ptr)
+				return false;
+
+			int index = m_balancer_ptr->host_of(conn);
+			return (index >= 0 && m_balancer_ptr->is_ejected((std::size_t)index));
+		}
+
+		void _delete_connection(connection * conn)
+		{
+			if (m_balancer_ptr)
+				m_balancer_ptr->detach(conn);
+			delete conn;
+		}
+
+		void _delete_connections(std::vector<connection *> & conns)
+		{
+			for (auto conn : conns)
+				_delete_connection(conn);
+			conns.clear();
+		}
+
+		/// return the connection to the idle list,or only release the place if conn is nullptr,
+		/// then call the return listeners
+		void _release_place(connection * conn = nullptr)
+		{
+			std::vector<std::shared_ptr<std::function<void()>>> listeners;
+			{
+				std::lock_guard<adaptive_mutex> g(m_lock);
+				if (conn)
+					m_connections.emplace_back(conn);
+				m_using_count--;
+
+				for (auto it = m_return_listeners.begin(); it != m_return_listeners.end();)
+				{
+					if (std::shared_ptr<std::function<void()>> listener = it->lock())
+					{
+						listeners.emplace_back(std::move(listener));
+						++it;
+					}
+					else
+					{
+						it = m_return_listeners.erase(it);
+					}
+				}
+			}
+
+			for (auto & listener : listeners)
+				(*listener)();
+		}
+
 	protected:
 
 		std::shared_ptr<url> m_url_ptr;
 
+		/// the connection factory of the database type,found when the pool is created
+		registry::factory m_factory = nullptr;
+
+		/// select the host of the new connections when the url has a host list
+		std::shared_ptr<balancer> m_balancer_ptr;
+
 		/// lock used to insure pool multi thread safe
-		spin_lock m_lock;
+		adaptive_mutex m_lock;
 
 		/// below three members used to safe destroy the pool and exit
 		volatile bool m_stopped = false;
@@ -241,12 +881,28 @@ namespace zdb2
 		/// the thread shared_ptr of reap the connections
 		std::shared_ptr<std::thread> m_sweep_thread_ptr;
 
+		/// the executor of async_query and async_execute,created at the first time used
+		std::shared_ptr<executor> m_executor_ptr;
+		std::mutex m_executor_mtx;
+
 		/// idle count of connections 
 		std::deque<connection *> m_connections;
 
 		/// using count of connections
 		std::size_t m_using_count = 0;
 
+		/// called when a connection is returned,see add_return_listener()
+		std::vector<std::weak_ptr<std::function<void()>>> m_return_listeners;
+
+		/// the statement stats of the connections,nullptr if the stats is disabled,m_stats is the
+		/// raw pointer of it which is loaded by get() without the lock
+		std::shared_ptr<statement_stats> m_stats_ptr;
+		std::atomic<statement_stats *> m_stats{ nullptr };
+		std::mutex m_stats_mtx;
+
+		/// the counters of the checkouts and the connections,see get_metrics()
+		pool_counters m_counters;
+
 		std::size_t m_init_conn_count = zdb2::DEFAULT_INIT_CONNECTIONS;
 		std::size_t m_conn_timeout    = zdb2::DEFAULT_CONNECTION_TIMEOUT;
 		std::size_t m_execute_timeout = zdb2::DEFAULT_TIMEOUT;
@@ -0,0 +1,75 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <atomic>
+
+#include <zdb2/util/histogram.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * the counters of a pool,they are updated by the pool,see pool::get_metrics().
+	 */
+	struct pool_counters
+	{
+		/// the successful get() calls
+		std::atomic<uint64_t> checkouts{ 0 };
+
+		/// the get() calls which return nullptr because max_conn_count connections are using
+		std::atomic<uint64_t> exhausted{ 0 };
+
+		/// the get() calls which return nullptr or throw because the new connection is failed
+		std::atomic<uint64_t> checkout_errors{ 0 };
+
+		std::atomic<uint64_t> connects{ 0 };
+		std::atomic<uint64_t> connect_failures{ 0 };
+
+		/// the idle connections closed by the sweep thread,include the ping failures
+		std::atomic<uint64_t> reaped{ 0 };
+		std::atomic<uint64_t> ping_failures{ 0 };
+
+		/// the time spent in get(),include opening a new connection
+		histogram wait_us;
+
+		/// the time from get() to the connection is returned to the pool
+		histogram hold_us;
+
+		/// the time of opening the new connections
+		histogram connect_us;
+	};
+
+	/**
+	 * a copy of the state and the counters of a pool,see pool::get_metrics().
+	 */
+	struct pool_metrics
+	{
+		std::size_t idle_count  = 0;
+		std::size_t using_count = 0;
+		std::size_t max_count   = 0;
+
+		uint64_t checkouts        = 0;
+		uint64_t exhausted        = 0;
+		uint64_t checkout_errors  = 0;
+		uint64_t connects         = 0;
+		uint64_t connect_failures = 0;
+		uint64_t reaped           = 0;
+		uint64_t ping_failures    = 0;
+
+		std::shared_ptr<histogram> wait_us;
+		std::shared_ptr<histogram> hold_us;
+		std::shared_ptr<histogram> connect_us;
+	};
+
+}
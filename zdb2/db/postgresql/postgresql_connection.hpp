@@ -4,15 +4,18 @@
  * Author   : zhllxt
  * QQ       : 37792738
  * Email    : 37792738@qq.com
- * 
+ *
  */
 
 
 #pragma once
 
 #include <cctype>
+#include <cstdio>
+#include <cstdarg>
 #include <string>
 #include <memory>
+#include <vector>
 #include <algorithm>
 #include <mutex>
 #include <atomic>
@@ -24,14 +27,31 @@
 #include <zdb2/config.hpp>
 #include <zdb2/net/url.hpp>
 #include <zdb2/db/connection.hpp>
+#include <zdb2/db/registry.hpp>
+#include <zdb2/db/materialized_result.hpp>
 
 #include <zdb2/db/postgresql/postgresql_util.hpp>
 #include <zdb2/db/postgresql/postgresql_stmt.hpp>
 #include <zdb2/db/postgresql/postgresql_resultset.hpp>
+#include <zdb2/db/postgresql/postgresql_copy_writer.hpp>
+#include <zdb2/db/postgresql/postgresql_copy_reader.hpp>
 
 namespace zdb2
 {
 
+	/**
+	 * PostgreSQL connection based on libpq,the queries use the extended query protocol and
+	 * return the values in the binary format.The url params :
+	 * user,password         : the login user and password
+	 * unix-socket           : the directory of the unix socket,the host is ignored if it is set
+	 * connect-timeout       : the connect timeout in seconds
+	 * use-ssl=true          : require the ssl connection
+	 * application-name      : the application_name reported to the server
+	 * fetch-size            : 0 (default) read all the rows of a query into the client memory;
+	 *                         1 stream the rows one by one (single row mode);
+	 *                         N stream the rows N by N (chunked mode of libpq 17,single row mode
+	 *                         if the libpq doesn't support it)
+	 */
 	class postgresql_connection : public connection
 	{
 	public:
@@ -68,33 +88,35 @@ namespace zdb2
 		//@}
 
 		/**
-		 * Ping the database server and returns true if this Connection is 
-		 * alive, otherwise false in which case the Connection should be closed. 
+		 * Ping the database server and returns true if this Connection is
+		 * alive, otherwise false in which case the Connection should be closed.
 		 * @param C A Connection object
-		 * @return true if Connection is connected to a database server 
+		 * @return true if Connection is connected to a database server
 		 * otherwise false
 		 */
 		virtual bool ping() override
 		{
-			return (m_db ? (mysql_ping(m_db) == mysql_util::MYSQL_OK) : false);
+			if (!m_db || PQstatus(m_db) != CONNECTION_OK)
+				return false;
+			return _command("");
 		}
 
 
 		/**
-		 * Close any ResultSet and PreparedStatements in the Connection. 
+		 * Close any ResultSet and PreparedStatements in the Connection.
 		 * Normally it is not necessary to call this method, but for some
-		 * implementation (SQLite) it <i>may, in some situations,</i> be 
+		 * implementation (SQLite) it <i>may, in some situations,</i> be
 		 * necessary to call this method if a execution sequence error occurs.
 		 * @param C A Connection object
 		 */
 		virtual void clear() override
 		{
-
+			m_session_ptr->discard_results();
 		}
 
 
 		/**
-		 * Return connection to the connection pool. The same as calling 
+		 * Return connection to the connection pool. The same as calling
 		 * ConnectionPool_returnConnection() on a connection.
 		 * @param C A Connection object
 		 */
@@ -102,14 +124,25 @@ namespace zdb2
 		{
 			if (m_db)
 			{
-				mysql_close(m_db);
+				// the streaming ResultSet must be read out before the handle is freed
+				m_session_ptr->discard_results();
+				m_session_ptr->conn = nullptr;
+
+				{
+					std::lock_guard<std::mutex> g(m_cancel_mtx);
+					if (m_cancel)
+						PQfreeCancel(m_cancel);
+					m_cancel = nullptr;
+				}
+
+				PQfinish(m_db);
 				m_db = nullptr;
 			}
 		}
 
 
 		/**
-		 * Start a transaction. 
+		 * Start a transaction.
 		 * @param C A Connection object
 		 * @exception SQLException If a database error occurs
 		 * @see SQLException.h
@@ -118,8 +151,7 @@ namespace zdb2
 		{
 			if (m_db)
 			{
-				if (mysql_util::MYSQL_OK == mysql_query(m_db, "START TRANSACTION;"))
-					return connection::begin_transaction();
+				return _transaction_begin([this]() { return _command("BEGIN TRANSACTION;"); });
 			}
 			return false;
 		}
@@ -139,10 +171,7 @@ namespace zdb2
 			{
 				if (is_intransaction())
 				{
-					if (connection::commit())
-					{
-						return (mysql_util::MYSQL_OK == mysql_query(m_db, "COMMIT;"));
-					}
+					return _transaction_end(&hooks::on_txn_commit, [this]() { return _command("COMMIT TRANSACTION;"); });
 				}
 			}
 			return false;
@@ -164,10 +193,7 @@ namespace zdb2
 			{
 				if (is_intransaction())
 				{
-					if (connection::rollback())
-					{
-						return (mysql_util::MYSQL_OK == mysql_query(m_db, "ROLLBACK;"));
-					}
+					return _transaction_end(&hooks::on_txn_rollback, [this]() { return _command("ROLLBACK TRANSACTION;"); });
 				}
 			}
 			return false;
@@ -175,14 +201,16 @@ namespace zdb2
 
 
 		/**
-		 * Returns the value for the most recent INSERT statement into a 
+		 * Returns the value for the most recent INSERT statement into a
 		 * table with an AUTO_INCREMENT or INTEGER PRIMARY KEY column.
 		 * @param C A Connection object
 		 * @return The value of the rowid from the last insert statement
 		 */
 		virtual int64_t last_rowid() override
 		{
-			return (m_db ? (int64_t)mysql_insert_id(m_db) : 0);
+			// PostgreSQL has no rowid,the oid of the inserted row is returned,it is 0 unless the
+			// table is created WITH OIDS,use "INSERT ... RETURNING id" instead.
+			return m_last_oid;
 		}
 
 
@@ -196,7 +224,7 @@ namespace zdb2
 		 */
 		virtual int64_t rows_changed() override
 		{
-			return (m_db ? (int64_t)mysql_affected_rows(m_db) : 0);
+			return m_rows_changed;
 		}
 
 
@@ -209,7 +237,7 @@ namespace zdb2
 		 * clears any previous ResultSets associated with the Connection.
 		 * @param C A Connection object
 		 * @param sql A SQL statement
-		 * @exception SQLException If a database error occurs. 
+		 * @exception SQLException If a database error occurs.
 		 * @see SQLException.h
 		 */
 		virtual bool execute(const char * sql, ...) override
@@ -219,7 +247,7 @@ namespace zdb2
 
 			va_list ap, ap_copy;
 			va_start(ap, sql);
-			
+
 			va_copy(ap_copy, ap);
 			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
 
@@ -229,8 +257,11 @@ namespace zdb2
 			std::vsprintf((char*)str.data(), sql, ap_copy);
 
 			va_end(ap);
-			
-			return (mysql_util::MYSQL_OK == mysql_real_query(m_db, str.c_str(), (unsigned long)str.length()));
+
+			auto ctx = _statement_begin(str.c_str());
+
+			// PQexec use the simple query protocol,so several statements can be used
+			return _statement_execute(ctx, str.c_str(), _command(str.c_str()));
 		}
 
 		/**
@@ -241,14 +272,14 @@ namespace zdb2
 		 * parameter string contains more than one SQL statement, only the
 		 * first statement is executed, the others are silently ignored.
 		 * A ResultSet "lives" only until the next call to
-		 * Connection_executeQuery(), Connection_execute() or until the 
-		 * Connection is returned to the Connection Pool. <i>This means that 
+		 * Connection_executeQuery(), Connection_execute() or until the
+		 * Connection is returned to the Connection Pool. <i>This means that
 		 * Result Sets cannot be saved between queries</i>.
 		 * @param C A Connection object
 		 * @param sql A SQL statement
 		 * @return A ResultSet object that contains the data produced by the
-		 * given query. 
-		 * @exception SQLException If a database error occurs. 
+		 * given query.
+		 * @exception SQLException If a database error occurs.
 		 * @see ResultSet.h
 		 * @see SQLException.h
 		 */
@@ -270,52 +301,89 @@ namespace zdb2
 
 			va_end(ap);
 
-			MYSQL_STMT * stmt = mysql_stmt_init(m_db);
-			if (!stmt)
-				return nullptr;
+			auto ctx = _statement_begin(str.c_str());
 
-			if (mysql_util::MYSQL_OK != mysql_stmt_prepare(stmt, str.c_str(), (unsigned long)str.length()))
+			m_session_ptr->discard_results();
+
+			// the unnamed statement of the extended query protocol is parsed,bound and executed
+			// in one round trip,and the values can be returned in the binary format
+			if (m_fetch_size <= 0)
 			{
-				mysql_stmt_close(stmt);
-				return nullptr;
+				PGresult * res = PQexecParams(m_db, str.c_str(), 0, nullptr, nullptr, nullptr, nullptr, postgresql_util::BINARY_FORMAT);
+				if (!res)
+					return _statement_query(ctx, str.c_str(), nullptr);
+
+				if (PQresultStatus(res) != PGRES_TUPLES_OK)
+				{
+					_set_result(res);
+					PQclear(res);
+					return _statement_query(ctx, str.c_str(), nullptr);
+				}
+
+				return _statement_query(ctx, str.c_str(), std::dynamic_pointer_cast<resultset>(std::make_shared<postgresql_resultset>(res, nullptr, m_timeout)));
 			}
 
-#if MYSQL_VERSION_ID >= 50002
-			unsigned long cursor = CURSOR_TYPE_READ_ONLY;
-			mysql_stmt_attr_set(stmt, STMT_ATTR_CURSOR_TYPE, &cursor);
+			if (!PQsendQueryParams(m_db, str.c_str(), 0, nullptr, nullptr, nullptr, nullptr, postgresql_util::BINARY_FORMAT))
+				return _statement_query(ctx, str.c_str(), nullptr);
+
+#if defined(LIBPQ_HAS_CHUNK_MODE)
+			if (m_fetch_size > 1)
+				PQsetChunkedRowsMode(m_db, m_fetch_size);
+			else
+#endif
+				PQsetSingleRowMode(m_db);
+
+			PGresult * res = PQgetResult(m_db);
+			ExecStatusType status = (res ? PQresultStatus(res) : PGRES_FATAL_ERROR);
+			if (status == PGRES_SINGLE_TUPLE || status == PGRES_TUPLES_OK
+#if defined(LIBPQ_HAS_CHUNK_MODE)
+				|| status == PGRES_TUPLES_CHUNK
 #endif
+				)
+			{
+				std::shared_ptr<resultset> rs = std::make_shared<postgresql_resultset>(res, m_session_ptr, m_timeout);
+				m_session_ptr->active_rs = rs;
+				return _statement_query(ctx, str.c_str(), rs);
+			}
 
-			if ((mysql_util::MYSQL_OK != mysql_stmt_execute(stmt)))
+			// the statement is failed or doesn't return rows
+			if (res)
 			{
-				mysql_stmt_close(stmt);
-				return nullptr;
+				_set_result(res);
+				PQclear(res);
 			}
+			_drain();
 
-			return std::dynamic_pointer_cast<resultset>(std::make_shared<mysql_resultset>(stmt, m_timeout));
+			if (status == PGRES_COMMAND_OK)
+			{
+				_statement_execute(ctx, str.c_str(), true);
+				return nullptr;
+			}
+			return _statement_query(ctx, str.c_str(), nullptr);
 		}
 
 		/**
-		 * Creates a PreparedStatement object for sending parameterized SQL 
-		 * statements to the database. The <code>sql</code> parameter may 
-		 * contain IN parameter placeholders. An IN placeholder is specified 
-		 * with a '?' character in the sql string. The placeholders are 
-		 * then replaced with actual values by using the PreparedStatement's 
-		 * setXXX methods. Only <i>one</i> SQL statement may be used in the sql 
-		 * parameter, this in difference to Connection_execute() which may 
-		 * take several statements. A PreparedStatement "lives" until the 
-		 * Connection is returned to the Connection Pool. 
+		 * Creates a PreparedStatement object for sending parameterized SQL
+		 * statements to the database. The <code>sql</code> parameter may
+		 * contain IN parameter placeholders. An IN placeholder is specified
+		 * with a '?' character in the sql string. The placeholders are
+		 * then replaced with actual values by using the PreparedStatement's
+		 * setXXX methods. Only <i>one</i> SQL statement may be used in the sql
+		 * parameter, this in difference to Connection_execute() which may
+		 * take several statements. A PreparedStatement "lives" until the
+		 * Connection is returned to the Connection Pool.
 		 * @param C A Connection object
-		 * @param sql A single SQL statement that may contain one or more '?' 
+		 * @param sql A single SQL statement that may contain one or more '?'
 		 * IN parameter placeholders
 		 * @return A new PreparedStatement object containing the pre-compiled
 		 * SQL statement.
-		 * @exception SQLException If a database error occurs. 
+		 * @exception SQLException If a database error occurs.
 		 * @see PreparedStatement.h
 		 * @see SQLException.h
 		 */
 		virtual std::shared_ptr<stmt> prepare_stmt(const char * sql, ...) override
 		{
-			if (!sql || sql[0] == '\0')
+			if (!m_db || !sql || sql[0] == '\0')
 				return nullptr;
 
 			va_list ap, ap_copy;
@@ -331,7 +399,117 @@ namespace zdb2
 
 			va_end(ap);
 
-			return std::dynamic_pointer_cast<stmt>(std::make_shared<mysql_stmt>(m_db,str.c_str(),m_timeout));
+			return _statement_stmt(str.c_str(), std::dynamic_pointer_cast<stmt>(std::make_shared<postgresql_stmt>(m_session_ptr, str.c_str(), m_timeout)));
+		}
+
+
+		/**
+		 * Sends all the statements in the pipeline mode of libpq,the statements are sent without
+		 * waiting for the results,and the results are read in order after a single sync,so the
+		 * batch costs one round trip.The statements between two syncs are executed in a implicit
+		 * transaction,if a statement is failed the remaining statements are not executed,and the
+		 * previous statements are rolled back unless the batch is in a explicit transaction.
+		 * Without the pipeline mode (libpq older than 14),the statements are executed one by one.
+		 */
+		virtual std::vector<batch_result> execute_batch(const std::vector<std::string> & sqls) override
+		{
+			std::vector<batch_result> results(sqls.size());
+			if (!m_db || sqls.empty())
+				return results;
+
+			m_session_ptr->discard_results();
+
+#if defined(LIBPQ_HAS_PIPELINING)
+			if (!PQenterPipelineMode(m_db))
+				return connection::execute_batch(sqls);
+
+			// every statement is recorded from the end of the previous one to the reading of it's
+			// result,the first one includes the sending of all the statements
+			auto ctx = _statement_begin(sqls[0].c_str());
+
+			// the statements are small,so the sending will not be blocked by the results which the
+			// client doesn't read yet
+			std::size_t sent = 0;
+			for (; sent < sqls.size(); sent++)
+			{
+				if (!PQsendQueryParams(m_db, sqls[sent].c_str(), 0, nullptr, nullptr, nullptr, nullptr, postgresql_util::BINARY_FORMAT))
+					break;
+			}
+			PQpipelineSync(m_db);
+
+			bool failed = false;
+			for (std::size_t i = 0; i < sent; i++)
+			{
+				// the results of a statement are terminated by a nullptr
+				PGresult * res;
+				while ((res = PQgetResult(m_db)) != nullptr)
+					_read_batch_result(res, results[i]);
+				if (!results[i].ok)
+					failed = true;
+
+				_statement_end(ctx, sqls[i].c_str(), results[i].ok, _batch_rows(results[i]));
+				if (i + 1 < sent)
+					ctx = _statement_begin(sqls[i + 1].c_str());
+			}
+			if (sent == 0)
+				_statement_end(ctx, sqls[0].c_str(), false, 0);
+
+			// read the results until the sync point
+			PGresult * res;
+			while ((res = PQgetResult(m_db)) != nullptr)
+			{
+				bool sync = (PQresultStatus(res) == PGRES_PIPELINE_SYNC);
+				PQclear(res);
+				if (sync)
+					break;
+			}
+			PQexitPipelineMode(m_db);
+
+			for (std::size_t i = sent; i < sqls.size(); i++)
+				results[i].error = PQerrorMessage(m_db);
+
+			if (failed && !is_intransaction())
+			{
+				for (auto & result : results)
+				{
+					if (result.ok)
+					{
+						result.ok = false;
+						result.error = "rolled back because of the error of the other statement.";
+					}
+				}
+			}
+#else
+			for (std::size_t i = 0; i < sqls.size(); i++)
+			{
+				auto ctx = _statement_begin(sqls[i].c_str());
+				_read_batch_result(PQexecParams(m_db, sqls[i].c_str(), 0, nullptr, nullptr, nullptr, nullptr,
+					postgresql_util::BINARY_FORMAT), results[i]);
+				_statement_end(ctx, sqls[i].c_str(), results[i].ok, _batch_rows(results[i]));
+				if (!results[i].ok)
+				{
+					for (std::size_t j = i + 1; j < sqls.size(); j++)
+						results[j].error = "not executed because of the previous error.";
+					break;
+				}
+			}
+#endif
+
+			return results;
+		}
+
+
+		/**
+		 * Cancel the statement which is executing on this connection by PQcancel,see
+		 * connection::cancel().
+		 */
+		virtual bool cancel() override
+		{
+			std::lock_guard<std::mutex> g(m_cancel_mtx);
+			if (!m_cancel)
+				return false;
+			char err[256] = { 0 };
+			return (PQcancel(m_cancel, err, (int)sizeof(err)) == 1);
 		}
 
 
@@ -340,14 +518,88 @@ namespace zdb2
 		 * error that occurred. Inside a CATCH-block you can also find
 		 * the error message directly in the variable Exception_frame.message.
 		 * It is recommended to use this variable instead since it contains both
-		 * SQL errors and API errors such as parameter index out of range etc, 
+		 * SQL errors and API errors such as parameter index out of range etc,
 		 * while Connection_getLastError() might only show SQL errors
 		 * @param C A Connection object
 		 * @return A string explaining the last error
 		 */
 		virtual const char * get_last_error() override
 		{
-			return mysql_error(m_db);
+			return (m_db ? PQerrorMessage(m_db) : "the connection is closed.");
+		}
+
+
+		/**
+		 * Set the number of rows which are read from the server at a time by the ResultSet,see
+		 * the "fetch-size" url param.
+		 */
+		void set_fetch_size(int rows)
+		{
+			m_fetch_size = (rows < 0 ? 0 : rows);
+		}
+
+		int get_fetch_size()
+		{
+			return m_fetch_size;
+		}
+
+		/**
+		 * Start a "COPY ... FROM STDIN (FORMAT binary)" bulk ingest,the rows are written by the
+		 * returned writer.
+		 * @return nullptr if the statement is not a COPY FROM STDIN or failed
+		 */
+		std::shared_ptr<postgresql_copy_writer> copy_in(const char *sql, ...)
+		{
+			if (!m_db || !sql || sql[0] == '\0')
+				return nullptr;
+
+			va_list ap, ap_copy;
+			va_start(ap, sql);
+
+			va_copy(ap_copy, ap);
+			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
+
+			std::string str(len, '\0');
+
+			va_copy(ap_copy, ap);
+			std::vsprintf((char*)str.data(), sql, ap_copy);
+
+			va_end(ap);
+
+			if (!_start_copy(str.c_str(), PGRES_COPY_IN))
+				return nullptr;
+
+			return std::make_shared<postgresql_copy_writer>(m_session_ptr);
+		}
+
+		/**
+		 * Start a "COPY ... TO STDOUT (FORMAT binary)" export,the rows are read into column_batch
+		 * by the returned reader.
+		 * @param types The type oids of the columns,eg : postgresql_util::INT8OID
+		 * @return nullptr if the statement is not a COPY TO STDOUT or failed
+		 */
+		std::shared_ptr<postgresql_copy_reader> copy_out(const std::vector<unsigned int> & types, const char *sql, ...)
+		{
+			if (!m_db || !sql || sql[0] == '\0' || types.empty())
+				return nullptr;
+
+			va_list ap, ap_copy;
+			va_start(ap, sql);
+
+			va_copy(ap_copy, ap);
+			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
+
+			std::string str(len, '\0');
+
+			va_copy(ap_copy, ap);
+			std::vsprintf((char*)str.data(), sql, ap_copy);
+
+			va_end(ap);
+
+			if (!_start_copy(str.c_str(), PGRES_COPY_OUT))
+				return nullptr;
+
+			return std::make_shared<postgresql_copy_reader>(m_session_ptr, types);
 		}
 
 
@@ -355,8 +607,8 @@ namespace zdb2
 		//@{
 
 		/**
-		 * <b>Class method</b>, test if the specified database system is 
-		 * supported by this library. Clients may pass a full Connection URL, 
+		 * <b>Class method</b>, test if the specified database system is
+		 * supported by this library. Clients may pass a full Connection URL,
 		 * for example using URL_toString(), or for convenience only the protocol
 		 * part of the URL. E.g. "mysql" or "sqlite".
 		 * @param url A database url string
@@ -372,14 +624,17 @@ namespace zdb2
 	protected:
 		virtual bool _init() override
 		{
+			m_session_ptr = std::make_shared<postgresql_util::session>();
+
+			std::string fetch_size = m_url_ptr->get_param_value("fetch-size");
+			if (!fetch_size.empty())
+				set_fetch_size(std::atoi(fetch_size.c_str()));
+
 			return _connect();
 		}
 
 		virtual bool _connect() override
 		{
-			unsigned long client_flags = CLIENT_MULTI_STATEMENTS;
-			int connect_timeout = zdb2::DEFAULT_TCP_TIMEOUT;
-
 			std::string unix_socket = m_url_ptr->get_param_value("unix-socket");
 			std::string user = m_url_ptr->get_param_value("user");
 			std::string pass = m_url_ptr->get_param_value("password");
@@ -387,11 +642,11 @@ namespace zdb2
 			std::string port = m_url_ptr->get_port();
 			std::string database = m_url_ptr->get_dbname();
 			std::string timeout = m_url_ptr->get_param_value("connect-timeout");
-			std::string charset = m_url_ptr->get_param_value("charset");
+			std::string application_name = m_url_ptr->get_param_value("application-name");
 
 			if (!unix_socket.empty())
 			{
-				host = "localhost"; // Make sure host is localhost if unix socket is to be used
+				host = unix_socket; // libpq treats the host which begins with a slash as the socket directory
 			}
 			else if (host.empty())
 			{
@@ -413,64 +668,170 @@ namespace zdb2
 				throw std::runtime_error("no username specified in url.");
 				return false;
 			}
-			if (pass.empty())
+
+			if (timeout.empty() || std::atoi(timeout.c_str()) <= 0)
+				timeout = std::to_string(zdb2::DEFAULT_TCP_TIMEOUT);
+
+			std::vector<const char *> keywords, values;
+			auto add = [&keywords, &values](const char * keyword, const std::string & value)
 			{
-				throw std::runtime_error("no password specified in url.");
-				return false;
+				if (!value.empty())
+				{
+					keywords.emplace_back(keyword);
+					values.emplace_back(value.c_str());
+				}
+			};
+
+			std::string sslmode = (m_url_ptr->get_param_value("use-ssl") == "true" ? "require" : "");
+
+			add("host", host);
+			add("port", port);
+			add("dbname", database);
+			add("user", user);
+			add("password", pass);
+			add("connect_timeout", timeout);
+			add("application_name", application_name);
+			add("sslmode", sslmode);
+			keywords.emplace_back(nullptr);
+			values.emplace_back(nullptr);
+
+			/* Connect */
+			m_db = PQconnectdbParams(keywords.data(), values.data(), 0);
+			if (m_db && PQstatus(m_db) == CONNECTION_OK)
+			{
+				m_session_ptr->conn = m_db;
+
+				std::lock_guard<std::mutex> g(m_cancel_mtx);
+				m_cancel = PQgetCancel(m_db);
+				return true;
 			}
 
-			m_db = mysql_init(nullptr);
-			if (!m_db)
+			if (m_db)
 			{
-				throw std::runtime_error("unable to allocate mysql handler.");
-				return false;
+				PQfinish(m_db);
+				m_db = nullptr;
 			}
-			
-			/* Options */
-			if (m_url_ptr->get_param_value("compress") == "true")
-				client_flags |= CLIENT_COMPRESS;
 
-			if (m_url_ptr->get_param_value("use-ssl") == "true")
-				mysql_ssl_set(m_db, nullptr, nullptr, nullptr, nullptr, nullptr);
+			return false;
+		}
 
-			if (m_url_ptr->get_param_value("secure-auth") == "true")
-				mysql_options(m_db, MYSQL_SECURE_AUTH, (const void*)&mysql_util::yes);
-			else
-				mysql_options(m_db, MYSQL_SECURE_AUTH, (const void*)&mysql_util::no);
+		/**
+		 * execute the command by the simple query protocol and discard the result.
+		 */
+		bool _command(const char * sql)
+		{
+			if (!m_db)
+				return false;
 
-			if (!timeout.empty())
-			{
-				int _timeout = std::atoi(timeout.c_str());
-				if (_timeout > 0)
-					connect_timeout = _timeout;
-			}
-			mysql_options(m_db, MYSQL_OPT_CONNECT_TIMEOUT, (const void *)&connect_timeout);
+			m_session_ptr->discard_results();
 
-			if (!charset.empty())
-				mysql_options(m_db, MYSQL_SET_CHARSET_NAME, (const void *)charset.c_str());
+			PGresult * res = PQexec(m_db, sql);
+			if (!res)
+				return false;
 
-#if MYSQL_VERSION_ID >= 50013
-			mysql_options(m_db, MYSQL_OPT_RECONNECT, (const void*)&mysql_util::yes);
-#endif
-			/* Connect */
-			if (mysql_real_connect(m_db, host.c_str(), user.c_str(), pass.c_str(), database.c_str(), (unsigned int)std::atoi(port.c_str()), unix_socket.c_str(), client_flags))
-				return true;
+			bool ok = postgresql_util::is_ok(res);
+			_set_result(res);
+			PQclear(res);
+			return ok;
+		}
+
+		void _set_result(PGresult * res)
+		{
+			const char * rows = PQcmdTuples(res);
+			m_rows_changed = ((rows && rows[0] != '\0') ? (int64_t)std::atoll(rows) : 0);
+			Oid oid = PQoidValue(res);
+			m_last_oid = (oid != InvalidOid ? (int64_t)oid : 0);
+		}
+
+		bool _start_copy(const char * sql, ExecStatusType expected)
+		{
+			m_session_ptr->discard_results();
+
+			PGresult * res = PQexec(m_db, sql);
+			if (!res)
+				return false;
 
-			mysql_close(m_db);
+			ExecStatusType status = PQresultStatus(res);
+			PQclear(res);
 
+			if (status == expected)
+				return true;
+
+			// a statement which is not the expected COPY direction is ended here,so the
+			// connection stays usable
+			m_session_ptr->discard_results();
 			return false;
 		}
 
+		void _drain()
+		{
+			PGresult * res;
+			while ((res = PQgetResult(m_db)) != nullptr)
+				PQclear(res);
+		}
+
+		/**
+		 * fill the batch_result by the result of the statement,the result is freed.
+		 */
+		void _read_batch_result(PGresult * res, batch_result & result)
+		{
+			if (!res)
+			{
+				result.error = PQerrorMessage(m_db);
+				return;
+			}
+
+			switch (PQresultStatus(res))
+			{
+			case PGRES_TUPLES_OK:
+				result.ok = true;
+				_set_result(res);
+				result.rows_changed = m_rows_changed;
+				// the ResultSet owns the result and free it
+				result.rows = materialized_result::materialize(std::make_shared<postgresql_resultset>(res, nullptr, m_timeout));
+				return;
+			case PGRES_COMMAND_OK:
+			case PGRES_EMPTY_QUERY:
+				result.ok = true;
+				_set_result(res);
+				result.rows_changed = m_rows_changed;
+				result.last_rowid = m_last_oid;
+				break;
+#if defined(LIBPQ_HAS_PIPELINING)
+			case PGRES_PIPELINE_ABORTED:
+				result.error = "not executed because of the previous error.";
+				break;
+#endif
+			default:
+				result.error = PQresultErrorMessage(res);
+				break;
+			}
+
+			PQclear(res);
+		}
+
 	protected:
 
-		OCIEnv*        m_env;
-		OCIError*      m_err;
-		OCISvcCtx*     m_svc;
-		OCISession*    m_usr;
-		OCIServer*     m_srv;
-		OCITrans*      m_txnhp;
-		char           m_erb[ERB_SIZE];
+		PGconn * m_db = nullptr;
+
+		/// the cancel object is created when connected,PQcancel can be called by any thread
+		PGcancel * m_cancel = nullptr;
+		std::mutex m_cancel_mtx;
 
+		/// shared with the statements
+		std::shared_ptr<postgresql_util::session> m_session_ptr;
+
+		int64_t m_rows_changed = 0;
+
+		int64_t m_last_oid = 0;
+
+		int m_fetch_size = 0;
 	};
 
+	namespace
+	{
+		/// register the backend when this header is included
+		const registry::registrar _postgresql_registrar("postgresql", &registry::create<postgresql_connection>);
+	}
+
 }
@@ -0,0 +1,336 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+
+#include <libpq-fe.h>
+
+#include <zdb2/db/column_batch.hpp>
+#include <zdb2/db/postgresql/postgresql_util.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * Read the rows of "COPY ... TO STDOUT (FORMAT binary)" into column_batch,eg :
+	 *
+	 * auto reader = conn->copy_out({ zdb2::postgresql_util::INT8OID, zdb2::postgresql_util::TEXTOID },
+	 *     "COPY (SELECT id, name FROM user) TO STDOUT (FORMAT binary)");
+	 * zdb2::column_batch batch;
+	 * while (reader->read(batch) > 0)
+	 * {
+	 *     for (std::size_t row = 0; row < batch.get_row_count(); row++)
+	 *         ... batch.get_int64(0, row) ...
+	 * }
+	 *
+	 * The binary COPY data doesn't contain the types of the columns,so they must be passed by
+	 * the caller.The bool,integer,date,time and timestamp columns are decoded to type_int64
+	 * (the date is days since 1970-01-01,the time and the timestamp are microseconds since
+	 * midnight and since 1970-01-01 UTC),the float columns to type_double,the numeric columns
+	 * to the text representation and all the other columns to the raw bytes.
+	 * The connection can't be used to send any other commands until all the rows are read or
+	 * the reader is closed.
+	 */
+	class postgresql_copy_reader
+	{
+	public:
+		postgresql_copy_reader(
+			std::shared_ptr<postgresql_util::session> session_ptr,
+			const std::vector<unsigned int> & types
+		)
+			: m_session_ptr(session_ptr)
+			, m_types(types)
+		{
+			if (!m_session_ptr || !m_session_ptr->conn || m_types.empty())
+				throw std::runtime_error("invalid parameters.");
+
+			m_command_seq = m_session_ptr->command_seq;
+		}
+
+		virtual ~postgresql_copy_reader()
+		{
+			close();
+		}
+
+		/**
+		 * Read out the remaining rows and end the COPY.
+		 */
+		void close()
+		{
+			if (m_done)
+				return;
+			m_done = true;
+
+			if (m_command_seq != m_session_ptr->command_seq || !m_session_ptr->conn)
+				return;
+
+			char * buf = nullptr;
+			while (PQgetCopyData(m_session_ptr->conn, &buf, 0) > 0)
+				PQfreemem(buf);
+
+			PGresult * res;
+			while ((res = PQgetResult(m_session_ptr->conn)) != nullptr)
+				PQclear(res);
+		}
+
+		/**
+		 * Read at most max_rows rows into the batch,the rows in the batch are removed first,and
+		 * the columns are added if the batch has no columns.
+		 * @return The number of rows read,0 means all the rows are read
+		 */
+		std::size_t read(column_batch & batch, std::size_t max_rows = 64 * 1024)
+		{
+			if (batch.get_column_count() == 0)
+			{
+				for (std::size_t i = 0; i < m_types.size(); i++)
+					batch.add_column(std::to_string(i), _column_type(m_types[i]));
+			}
+			else if (batch.get_column_count() != m_types.size())
+			{
+				throw std::runtime_error("the column count of the batch is not matched.");
+			}
+
+			batch.clear();
+
+			while (!m_done && batch.get_row_count() < max_rows)
+			{
+				if (m_command_seq != m_session_ptr->command_seq || !m_session_ptr->conn)
+				{
+					m_done = true;
+					throw std::runtime_error("the copy is interrupted by another command.");
+				}
+
+				char * buf = nullptr;
+				int len = PQgetCopyData(m_session_ptr->conn, &buf, 0);
+				if (len == -1)
+				{
+					_end();
+					break;
+				}
+				if (len < 0)
+				{
+					m_done = true;
+					throw std::runtime_error(PQerrorMessage(m_session_ptr->conn));
+				}
+
+				// the server sends a row per message usually,but the header is sent together
+				// with the first row,and the format doesn't require it,so the bytes which are
+				// not a complete row are kept for the next message
+				try
+				{
+					if (m_pending.empty())
+					{
+						std::size_t used = _parse(buf, (std::size_t)len, batch);
+						m_pending.assign(buf + used, (std::size_t)len - used);
+					}
+					else
+					{
+						m_pending.append(buf, (std::size_t)len);
+						std::size_t used = _parse(m_pending.data(), m_pending.size(), batch);
+						m_pending.erase(0, used);
+					}
+				}
+				catch (std::exception &)
+				{
+					PQfreemem(buf);
+					close();
+					throw;
+				}
+
+				PQfreemem(buf);
+			}
+
+			return batch.get_row_count();
+		}
+
+		bool is_done()
+		{
+			return m_done;
+		}
+
+	protected:
+		static column_batch::column_type _column_type(unsigned int type)
+		{
+			switch (type)
+			{
+			case postgresql_util::BOOLOID:
+			case postgresql_util::INT2OID:
+			case postgresql_util::INT4OID:
+			case postgresql_util::INT8OID:
+			case postgresql_util::OIDOID:
+			case postgresql_util::DATEOID:
+			case postgresql_util::TIMEOID:
+			case postgresql_util::TIMESTAMPOID:
+			case postgresql_util::TIMESTAMPTZOID:
+				return column_batch::type_int64;
+			case postgresql_util::FLOAT4OID:
+			case postgresql_util::FLOAT8OID:
+				return column_batch::type_double;
+			}
+			return column_batch::type_bytes;
+		}
+
+		/**
+		 * parse the complete rows in the data.
+		 * @return the number of bytes parsed
+		 */
+		std::size_t _parse(const char * data, std::size_t size, column_batch & batch)
+		{
+			std::size_t pos = 0;
+
+			if (!m_header_parsed)
+			{
+				if (size < 19)
+					return 0;
+				if (std::memcmp(data, "PGCOPY\n\377\r\n\0", 11) != 0)
+					throw std::runtime_error("invalid binary copy signature.");
+				std::size_t ext = postgresql_util::get_uint32(data + 15);
+				if (size < 19 + ext)
+					return 0;
+				pos = 19 + ext;
+				m_header_parsed = true;
+			}
+
+			const std::size_t cols = m_types.size();
+
+			while (pos + 2 <= size)
+			{
+				int16_t fields = (int16_t)postgresql_util::get_uint16(data + pos);
+				if (fields == -1)
+				{
+					// the trailer
+					pos += 2;
+					continue;
+				}
+				if ((std::size_t)fields != cols)
+					throw std::runtime_error("the column count of the copy data is not matched.");
+
+				// make sure the row is complete
+				std::size_t end = pos + 2;
+				for (std::size_t i = 0; i < cols; i++)
+				{
+					if (end + 4 > size)
+						return pos;
+					int32_t len = (int32_t)postgresql_util::get_uint32(data + end);
+					end += 4 + (len > 0 ? (std::size_t)len : 0);
+				}
+				if (end > size)
+					return pos;
+
+				std::size_t p = pos + 2;
+				for (std::size_t i = 0; i < cols; i++)
+				{
+					int32_t len = (int32_t)postgresql_util::get_uint32(data + p);
+					p += 4;
+					if (len < 0)
+						batch.append_null(i);
+					else
+						_append(batch, i, data + p, len);
+					p += (len > 0 ? (std::size_t)len : 0);
+				}
+				batch.end_row();
+
+				pos = end;
+			}
+
+			return pos;
+		}
+
+		void _append(column_batch & batch, std::size_t col, const char * value, int length)
+		{
+			unsigned int type = m_types[col];
+
+			int64_t i = 0;
+			double d = 0;
+			if (postgresql_util::decode_integer(type, value, length, i))
+			{
+				batch.append_int64(col, i);
+			}
+			else if (postgresql_util::decode_float(type, value, length, d))
+			{
+				batch.append_double(col, d);
+			}
+			else if ((type == postgresql_util::TIMESTAMPOID || type == postgresql_util::TIMESTAMPTZOID) && length == 8)
+			{
+				batch.append_int64(col, (int64_t)postgresql_util::get_uint64(value) +
+					postgresql_util::POSTGRES_EPOCH * postgresql_util::USECS_PER_SEC);
+			}
+			else if (type == postgresql_util::TIMEOID && length == 8)
+			{
+				batch.append_int64(col, (int64_t)postgresql_util::get_uint64(value));
+			}
+			else if (type == postgresql_util::DATEOID && length == 4)
+			{
+				batch.append_int64(col, (int64_t)(int32_t)postgresql_util::get_uint32(value) +
+					postgresql_util::POSTGRES_EPOCH / postgresql_util::SECS_PER_DAY);
+			}
+			else if (type == postgresql_util::NUMERICOID)
+			{
+				std::string s = postgresql_util::decode_numeric(value, length);
+				batch.append_bytes(col, s.data(), s.length());
+			}
+			else if (_column_type(type) == column_batch::type_bytes)
+			{
+				batch.append_bytes(col, value, (std::size_t)length);
+			}
+			else
+			{
+				throw std::runtime_error("the value doesn't match the type of the column.");
+			}
+		}
+
+		void _end()
+		{
+			m_done = true;
+
+			std::string err;
+			PGresult * res;
+			while ((res = PQgetResult(m_session_ptr->conn)) != nullptr)
+			{
+				if (PQresultStatus(res) != PGRES_COMMAND_OK && err.empty())
+					err = PQresultErrorMessage(res);
+				PQclear(res);
+			}
+
+			if (!err.empty())
+				throw std::runtime_error(err);
+		}
+
+	protected:
+
+		std::shared_ptr<postgresql_util::session> m_session_ptr;
+
+		std::vector<unsigned int> m_types;
+
+		/// the bytes of the incomplete row
+		std::string m_pending;
+
+		bool m_header_parsed = false;
+
+		bool m_done = false;
+
+		uint64_t m_command_seq = 0;
+
+	private:
+		/// no copy construct function
+		postgresql_copy_reader(const postgresql_copy_reader&) = delete;
+
+		/// no operator equal function
+		postgresql_copy_reader& operator=(const postgresql_copy_reader&) = delete;
+	};
+
+}
@@ -0,0 +1,375 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <memory>
+#include <stdexcept>
+
+#include <libpq-fe.h>
+
+#include <zdb2/db/postgresql/postgresql_util.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * Write the rows of "COPY ... FROM STDIN (FORMAT binary)",the values are encoded to the
+	 * binary COPY format directly,eg :
+	 *
+	 * auto writer = conn->copy_in("COPY user (id, name, score) FROM STDIN (FORMAT binary)");
+	 * for (...)
+	 * {
+	 *     writer->add_int8(id).add_text(name).add_float8(score).end_row();
+	 * }
+	 * int64_t rows = writer->finish();
+	 *
+	 * The binary format doesn't convert the values,so the adder must match the type of the
+	 * column exactly,eg : add_int4 for a integer column,add_int8 for a bigint column.
+	 * The connection can't be used to send any other commands until finish() or abort().
+	 */
+	class postgresql_copy_writer
+	{
+	public:
+		postgresql_copy_writer(
+			std::shared_ptr<postgresql_util::session> session_ptr,
+			std::size_t buffer_size = 64 * 1024
+		)
+			: m_session_ptr(session_ptr)
+			, m_buffer_size(buffer_size)
+		{
+			if (!m_session_ptr || !m_session_ptr->conn)
+				throw std::runtime_error("invalid parameters.");
+
+			m_command_seq = m_session_ptr->command_seq;
+
+			m_buffer.reserve(m_buffer_size + 1024);
+
+			// the header : signature,flags and the length of the header extension
+			m_buffer.append("PGCOPY\n\377\r\n\0", 11);
+			_put_uint32(0);
+			_put_uint32(0);
+		}
+
+		virtual ~postgresql_copy_writer()
+		{
+			if (!m_finished)
+			{
+				try
+				{
+					abort();
+				}
+				catch (std::exception &)
+				{
+				}
+			}
+		}
+
+		/** @name Values of the current row */
+		//@{
+
+		postgresql_copy_writer & add_null()
+		{
+			_begin_field();
+			_put_uint32((uint32_t)-1);
+			return (*this);
+		}
+
+		postgresql_copy_writer & add_bool(bool x)
+		{
+			_begin_field();
+			_put_uint32(1);
+			m_buffer += (char)(x ? 1 : 0);
+			return (*this);
+		}
+
+		postgresql_copy_writer & add_int2(int16_t x)
+		{
+			_begin_field();
+			_put_uint32(2);
+			_put_uint16((uint16_t)x);
+			return (*this);
+		}
+
+		postgresql_copy_writer & add_int4(int32_t x)
+		{
+			_begin_field();
+			_put_uint32(4);
+			_put_uint32((uint32_t)x);
+			return (*this);
+		}
+
+		postgresql_copy_writer & add_int8(int64_t x)
+		{
+			_begin_field();
+			_put_uint32(8);
+			_put_uint64((uint64_t)x);
+			return (*this);
+		}
+
+		postgresql_copy_writer & add_float4(float x)
+		{
+			uint32_t i;
+			std::memcpy(&i, &x, sizeof(i));
+			_begin_field();
+			_put_uint32(4);
+			_put_uint32(i);
+			return (*this);
+		}
+
+		postgresql_copy_writer & add_float8(double x)
+		{
+			uint64_t i;
+			std::memcpy(&i, &x, sizeof(i));
+			_begin_field();
+			_put_uint32(8);
+			_put_uint64(i);
+			return (*this);
+		}
+
+		/**
+		 * the text,varchar,char,name,json and bytea values,the binary format of them is the
+		 * raw bytes.a nullptr is written as SQL NULL.
+		 */
+		postgresql_copy_writer & add_text(const char * x, std::size_t size)
+		{
+			if (!x)
+				return add_null();
+			_begin_field();
+			_put_uint32((uint32_t)size);
+			m_buffer.append(x, size);
+			return (*this);
+		}
+
+		postgresql_copy_writer & add_text(const char * x)
+		{
+			return add_text(x, x ? std::strlen(x) : 0);
+		}
+
+		postgresql_copy_writer & add_text(const std::string & x)
+		{
+			return add_text(x.data(), x.length());
+		}
+
+		postgresql_copy_writer & add_bytea(const void * x, std::size_t size)
+		{
+			return add_text((const char *)x, size);
+		}
+
+		/**
+		 * the timestamp and timestamptz values,x is the seconds since the epoch in UTC.
+		 */
+		postgresql_copy_writer & add_timestamp(time_t x)
+		{
+			return add_timestamp_us((int64_t)x * postgresql_util::USECS_PER_SEC);
+		}
+
+		/**
+		 * the timestamp and timestamptz values,x is the microseconds since the epoch in UTC.
+		 */
+		postgresql_copy_writer & add_timestamp_us(int64_t x)
+		{
+			return add_int8(x - postgresql_util::POSTGRES_EPOCH * postgresql_util::USECS_PER_SEC);
+		}
+
+		/**
+		 * the date values,x is the days since 1970-01-01.
+		 */
+		postgresql_copy_writer & add_date(int32_t x)
+		{
+			return add_int4(x - (int32_t)(postgresql_util::POSTGRES_EPOCH / postgresql_util::SECS_PER_DAY));
+		}
+
+		//@}
+
+		/**
+		 * End the current row,the buffered rows are sent when the buffer is full.
+		 */
+		void end_row()
+		{
+			if (m_field_count == 0 && m_field_count_pos == std::string::npos)
+				throw std::runtime_error("the row is empty.");
+
+			if (m_field_count > 0x7fff)
+				throw std::runtime_error("too many columns in the row.");
+
+			postgresql_util::put_uint16(&m_buffer[m_field_count_pos], (uint16_t)m_field_count);
+			m_field_count = 0;
+			m_field_count_pos = std::string::npos;
+			m_rows++;
+
+			if (m_buffer.size() >= m_buffer_size)
+				_flush();
+		}
+
+		/**
+		 * Send the remaining rows and end the COPY.
+		 * @return The number of rows copied
+		 */
+		int64_t finish()
+		{
+			if (m_finished)
+				throw std::runtime_error("the copy is finished already.");
+			if (m_field_count_pos != std::string::npos)
+				throw std::runtime_error("the last row is not ended.");
+
+			// the trailer
+			_put_uint16((uint16_t)-1);
+			_flush();
+
+			m_finished = true;
+
+			PGconn * conn = m_session_ptr->conn;
+			if (PQputCopyEnd(conn, nullptr) != 1)
+				throw std::runtime_error(PQerrorMessage(conn));
+
+			return _result();
+		}
+
+		/**
+		 * Abort the COPY,none of the rows are inserted.
+		 */
+		void abort(const char * reason = "the copy is aborted by the client.")
+		{
+			if (m_finished)
+				return;
+			m_finished = true;
+
+			if (m_command_seq != m_session_ptr->command_seq || !m_session_ptr->conn)
+				return;
+
+			PQputCopyEnd(m_session_ptr->conn, reason);
+			PGresult * res;
+			while ((res = PQgetResult(m_session_ptr->conn)) != nullptr)
+				PQclear(res);
+		}
+
+		/**
+		 * Returns the number of rows written.
+		 */
+		int64_t get_row_count()
+		{
+			return m_rows;
+		}
+
+	protected:
+		void _begin_field()
+		{
+			if (m_field_count_pos == std::string::npos)
+			{
+				// the field count is filled by end_row
+				m_field_count_pos = m_buffer.size();
+				_put_uint16(0);
+			}
+			m_field_count++;
+		}
+
+		void _put_uint16(uint16_t v)
+		{
+			char b[2];
+			postgresql_util::put_uint16(b, v);
+			m_buffer.append(b, 2);
+		}
+
+		void _put_uint32(uint32_t v)
+		{
+			char b[4];
+			postgresql_util::put_uint32(b, v);
+			m_buffer.append(b, 4);
+		}
+
+		void _put_uint64(uint64_t v)
+		{
+			char b[8];
+			postgresql_util::put_uint64(b, v);
+			m_buffer.append(b, 8);
+		}
+
+		void _flush()
+		{
+			if (m_buffer.empty())
+				return;
+
+			if (m_command_seq != m_session_ptr->command_seq || !m_session_ptr->conn)
+			{
+				m_finished = true;
+				throw std::runtime_error("the copy is interrupted by another command.");
+			}
+
+			PGconn * conn = m_session_ptr->conn;
+			if (PQputCopyData(conn, m_buffer.data(), (int)m_buffer.size()) != 1)
+			{
+				std::string err = PQerrorMessage(conn);
+				abort(err.c_str());
+				throw std::runtime_error(err);
+			}
+			m_buffer.clear();
+		}
+
+		int64_t _result()
+		{
+			PGconn * conn = m_session_ptr->conn;
+
+			int64_t rows = -1;
+			std::string err;
+
+			PGresult * res;
+			while ((res = PQgetResult(conn)) != nullptr)
+			{
+				if (PQresultStatus(res) == PGRES_COMMAND_OK)
+				{
+					const char * s = PQcmdTuples(res);
+					rows = ((s && s[0] != '\0') ? (int64_t)std::atoll(s) : m_rows);
+				}
+				else if (err.empty())
+				{
+					err = PQresultErrorMessage(res);
+				}
+				PQclear(res);
+			}
+
+			if (!err.empty() || rows < 0)
+				throw std::runtime_error(err.empty() ? "the copy is failed." : err);
+
+			return rows;
+		}
+
+	protected:
+
+		std::shared_ptr<postgresql_util::session> m_session_ptr;
+
+		std::size_t m_buffer_size = 64 * 1024;
+
+		std::string m_buffer;
+
+		/// the position of the field count of the current row in the buffer
+		std::size_t m_field_count_pos = std::string::npos;
+		int m_field_count = 0;
+
+		int64_t m_rows = 0;
+
+		uint64_t m_command_seq = 0;
+
+		bool m_finished = false;
+
+	private:
+		/// no copy construct function
+		postgresql_copy_writer(const postgresql_copy_writer&) = delete;
+
+		/// no operator equal function
+		postgresql_copy_writer& operator=(const postgresql_copy_writer&) = delete;
+	};
+
+}
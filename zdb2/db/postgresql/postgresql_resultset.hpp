@@ -4,7 +4,7 @@
  * Author   : zhllxt
  * QQ       : 37792738
  * Email    : 37792738@qq.com
- * 
+ *
  */
 
 
@@ -12,8 +12,12 @@
 
 #include <cassert>
 #include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <memory>
+#include <vector>
 #include <algorithm>
 #include <mutex>
 #include <unordered_map>
@@ -29,18 +33,27 @@ namespace zdb2
 
 #pragma warning(disable:4996)
 
+	/**
+	 * ResultSet of libpq,the values are in the binary format usually.When the session is passed
+	 * to the constructor,the rows are streamed in the single row mode or the chunked mode,the
+	 * next rows are read by PQgetResult when the current rows are consumed,and the connection
+	 * can't be used to send any other commands until all the rows are read or the ResultSet
+	 * is closed.
+	 */
 	class postgresql_resultset : public resultset
 	{
 	public:
 		postgresql_resultset(
-			MYSQL_STMT * stmt,
+			PGresult * res,
+			std::shared_ptr<postgresql_util::session> session_ptr = nullptr,
 			std::size_t timeout = zdb2::DEFAULT_TIMEOUT
 		)
 			: resultset(timeout)
-			, m_stmt(stmt)
+			, m_res(res)
+			, m_session_ptr(session_ptr)
 		{
-			assert(m_stmt);
-			if (!m_stmt)
+			assert(m_res);
+			if (!m_res)
 				throw std::runtime_error("invalid parameters.");
 
 			_init();
@@ -53,33 +66,14 @@ namespace zdb2
 
 		virtual void close() override
 		{
-			if (m_stmt)
-			{
-				mysql_stmt_free_result(m_stmt);
-				mysql_stmt_close(m_stmt);
-				m_stmt = nullptr;
-			}
-			if (m_meta)
-			{
-				mysql_free_result(m_meta);
-				m_meta = nullptr;
-			}
-			if (m_bind)
+			if (m_res)
 			{
-				delete[]m_bind;
-				m_bind = nullptr;
-			}
-			if (m_columns)
-			{
-				for (int i = 0; i < m_column_count; i++)
-				{
-					std::free((void *)m_columns[i].buffer);
-				}
-				delete[]m_columns;
-				m_columns = nullptr;
+				PQclear(m_res);
+				m_res = nullptr;
 			}
+			_finish();
 		}
-		
+
 		/**
 		 * Returns the number of columns in this ResultSet object.
 		 * @param R A ResultSet object
@@ -87,7 +81,7 @@ namespace zdb2
 		 */
 		virtual int get_column_count() override
 		{
-			return (m_stmt ? (int)mysql_stmt_field_count(m_stmt) : 0);
+			return m_column_count;
 		}
 
 
@@ -95,15 +89,15 @@ namespace zdb2
 		 * Get the designated column's name.
 		 * @param R A ResultSet object
 		 * @param columnIndex The first column is 1, the second is 2, ...
-		 * @return Column name or NULL if the column does not exist. You 
-		 * should use the method ResultSet_getColumnCount() to test for 
+		 * @return Column name or NULL if the column does not exist. You
+		 * should use the method ResultSet_getColumnCount() to test for
 		 * the availability of columns in the result set.
 		 */
 		virtual const char * get_column_name(int column_index) override
 		{
-			if (m_column_count <= 0 || column_index < 0 || column_index >= m_column_count)
+			if (column_index < 0 || column_index >= m_column_count)
 				return nullptr;
-			return m_columns[column_index].field->name;
+			return m_column_names[column_index].c_str();
 		}
 
 		/**
@@ -118,11 +112,11 @@ namespace zdb2
 		}
 
 		/**
-		 * Returns column size in bytes. If the column is a blob then 
-		 * this method returns the number of bytes in that blob. No type 
-		 * conversions occur. If the result is a string (or a number 
-		 * since a number can be converted into a string) then return the 
-		 * number of bytes in the resulting string. 
+		 * Returns column size in bytes. If the column is a blob then
+		 * this method returns the number of bytes in that blob. No type
+		 * conversions occur. If the result is a string (or a number
+		 * since a number can be converted into a string) then return the
+		 * number of bytes in the resulting string.
 		 * @param R A ResultSet object
 		 * @param columnIndex The first column is 1, the second is 2, ...
 		 * @return Column data size
@@ -131,11 +125,12 @@ namespace zdb2
 		 */
 		virtual std::size_t get_column_size(int column_index) override
 		{
-			if (m_column_count <= 0 || column_index < 0 || column_index >= m_column_count)
+			if (is_null(column_index))
 				return 0;
-			if (m_columns[column_index].is_null)
-				return 0;
-			return m_columns[column_index].length;
+			if (_is_raw(column_index))
+				return (std::size_t)PQgetlength(m_res, m_row, column_index);
+			const char * s = get_string(column_index);
+			return (s ? std::strlen(s) : 0);
 		}
 
 		//@}
@@ -154,21 +149,59 @@ namespace zdb2
 		 */
 		virtual bool next_row() override
 		{
-			if (!m_stmt || !m_meta || m_column_count <= 0)
+			if (!m_res)
 				return false;
 
-			if (m_need_rebind)
+			std::fill(m_cached.begin(), m_cached.end(), false);
+
+			if (m_row < PQntuples(m_res))
+				m_row++;
+			if (m_row < PQntuples(m_res))
+				return true;
+
+			if (!m_session_ptr || m_done)
+				return false;
+
+			// the rows of the current result are consumed,read the next result
+			for (;;)
 			{
-				if ((mysql_util::MYSQL_OK != mysql_stmt_bind_result(m_stmt, m_bind)))
-					throw std::runtime_error(mysql_stmt_error(m_stmt));
-				m_need_rebind = false;
-			}
+				PGresult * res = (m_session_ptr->conn ? PQgetResult(m_session_ptr->conn) : nullptr);
+				if (!res)
+				{
+					m_done = true;
+					return false;
+				}
+
+				ExecStatusType status = PQresultStatus(res);
+				if (status == PGRES_SINGLE_TUPLE
+#if defined(LIBPQ_HAS_CHUNK_MODE)
+					|| status == PGRES_TUPLES_CHUNK
+#endif
+					)
+				{
+					PQclear(m_res);
+					m_res = res;
+					m_row = 0;
+					if (PQntuples(m_res) > 0)
+						return true;
+					continue;
+				}
 
-			int status = mysql_stmt_fetch(m_stmt);
-			if (1 == status)
-				throw std::runtime_error(mysql_stmt_error(m_stmt));
+				if (status == PGRES_TUPLES_OK)
+				{
+					// the last result has no rows,it is kept for the column descriptions
+					PQclear(m_res);
+					m_res = res;
+					m_row = 0;
+					_finish();
+					return false;
+				}
 
-			return ((status == mysql_util::MYSQL_OK) || (status == MYSQL_DATA_TRUNCATED));
+				std::string err = PQresultErrorMessage(res);
+				PQclear(res);
+				_finish();
+				throw std::runtime_error(err);
+			}
 		}
 
 		/** @name Columns */
@@ -176,9 +209,9 @@ namespace zdb2
 
 		/**
 		 * Returns true if the value of the designated column in the current row of
-		 * this ResultSet object is SQL NULL, otherwise false. If the column value is 
+		 * this ResultSet object is SQL NULL, otherwise false. If the column value is
 		 * SQL NULL, a Result Set returns the NULL pointer for string and blob values
-		 * and 0 for primitive data types. Use this method if you need to differ 
+		 * and 0 for primitive data types. Use this method if you need to differ
 		 * between SQL NULL and the value NULL/0.
 		 * @param R A ResultSet object
 		 * @param columnIndex The first column is 1, the second is 2, ...
@@ -189,10 +222,7 @@ namespace zdb2
 		 */
 		virtual bool is_null(int column_index) override
 		{
-			if (m_column_count <= 0 || column_index < 0 || column_index >= m_column_count)
-				return true;
-
-			return (m_columns[column_index].is_null);
+			return (!_is_valid(column_index) || PQgetisnull(m_res, m_row, column_index));
 		}
 
 
@@ -201,7 +231,7 @@ namespace zdb2
 		 * Retrieves the value of the designated column in the current row of
 		 * this ResultSet object as a C-string. If <code>columnIndex</code>
 		 * is outside the range [1..ResultSet_getColumnCount()] this
-		 * method throws an SQLException. <i>The returned string may only be 
+		 * method throws an SQLException. <i>The returned string may only be
 		 * valid until the next call to ResultSet_next() and if you plan to use
 		 * the returned value longer, you must make a copy.</i>
 		 * @param R A ResultSet object
@@ -214,17 +244,19 @@ namespace zdb2
 		 */
 		virtual const char * get_string(int column_index) override
 		{
-			if (m_stmt && m_bind && m_columns && column_index >= 0 && column_index < m_column_count)
-			{
-				if (m_columns[column_index].is_null)
-					return nullptr;
+			if (is_null(column_index))
+				return nullptr;
 
-				_ensure_capacity(column_index);
+			// libpq always append a '\0' to the value,even if it is in binary format
+			if (_is_raw(column_index))
+				return PQgetvalue(m_res, m_row, column_index);
 
-				m_columns[column_index].buffer[m_columns[column_index].length] = 0;
-				return m_columns[column_index].buffer;
+			if (!m_cached[column_index])
+			{
+				m_cache[column_index] = _to_string(column_index);
+				m_cached[column_index] = true;
 			}
-			return nullptr;
+			return m_cache[column_index].c_str();
 		}
 
 
@@ -250,9 +282,9 @@ namespace zdb2
 
 
 		/**
-		 * Retrieves the value of the designated column in the current row of this 
-		 * ResultSet object as an int. If <code>columnIndex</code> is outside the 
-		 * range [1..ResultSet_getColumnCount()] this method throws an SQLException. 
+		 * Retrieves the value of the designated column in the current row of this
+		 * ResultSet object as an int. If <code>columnIndex</code> is outside the
+		 * range [1..ResultSet_getColumnCount()] this method throws an SQLException.
 		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
 		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
 		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
@@ -269,8 +301,7 @@ namespace zdb2
 		 */
 		virtual int get_int(int column_index) override
 		{
-			auto s = get_string(column_index);
-			return (s ? std::atoi(s) : -1);
+			return (int)get_int64(column_index);
 		}
 
 
@@ -294,8 +325,8 @@ namespace zdb2
 		 */
 		virtual int get_int(const char * column_name) override
 		{
-			auto s = get_string(column_name);
-			return (s ? std::atoi(s) : -1);
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_int(col_index) : -1);
 		}
 
 
@@ -305,8 +336,8 @@ namespace zdb2
 		 * is outside the range [1..ResultSet_getColumnCount()] this
 		 * method throws an SQLException.
 		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
-		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A 
-		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits 
+		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
+		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
 		 * architecture and equal to <code>long long</code> on 64 bits architecture.
 		 * However, the width of integer types are architecture and compiler dependent.
 		 * The above is usually true, but not necessarily.
@@ -320,6 +351,16 @@ namespace zdb2
 		 */
 		virtual int64_t get_int64(int column_index) override
 		{
+			if (is_null(column_index))
+				return -1;
+
+			int64_t i = 0;
+			double d = 0;
+			if (_decode_integer(column_index, i))
+				return i;
+			if (_decode_float(column_index, d))
+				return (int64_t)d;
+
 			auto s = get_string(column_index);
 			return (s ? (int64_t)std::atoll(s) : -1);
 		}
@@ -345,8 +386,8 @@ namespace zdb2
 		 */
 		virtual int64_t get_int64(const char * column_name) override
 		{
-			auto s = get_string(column_name);
-			return (s ? (int64_t)std::atoll(s) : -1);
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_int64(col_index) : -1);
 		}
 
 
@@ -365,6 +406,16 @@ namespace zdb2
 		 */
 		virtual double get_double(int column_index) override
 		{
+			if (is_null(column_index))
+				return -1.f;
+
+			int64_t i = 0;
+			double d = 0;
+			if (_decode_float(column_index, d))
+				return d;
+			if (_decode_integer(column_index, i))
+				return (double)i;
+
 			auto s = get_string(column_index);
 			return (s ? std::atof(s) : -1.f);
 		}
@@ -384,41 +435,49 @@ namespace zdb2
 		 */
 		virtual double get_double(const char * column_name) override
 		{
-			auto s = get_string(column_name);
-			return (s ? std::atof(s) : -1.f);
+			int col_index = get_column_index(column_name);
+			return ((col_index >= 0) ? get_double(col_index) : -1.f);
 		}
 
 
 		/**
 		 * Retrieves the value of the designated column in the current row of
 		 * this ResultSet object as a void pointer. If <code>columnIndex</code>
-		 * is outside the range [1..ResultSet_getColumnCount()] this method 
+		 * is outside the range [1..ResultSet_getColumnCount()] this method
 		 * throws an SQLException. <i>The returned blob may only be valid until
 		 * the next call to ResultSet_next() and if you plan to use the returned
-		 * value longer, you must make a copy.</i> 
+		 * value longer, you must make a copy.</i>
 		 * @param R A ResultSet object
 		 * @param columnIndex The first column is 1, the second is 2, ...
-		 * @param size The number of bytes in the blob is stored in size 
+		 * @param size The number of bytes in the blob is stored in size
 		 * @return The column value; if the value is SQL NULL, the value
 		 * returned is NULL
-		 * @exception SQLException If a database access error occurs or 
+		 * @exception SQLException If a database access error occurs or
 		 * columnIndex is outside the valid range
 		 * @see SQLException.h
 		 */
 		virtual const void * get_blob(int column_index, std::size_t * size) override
 		{
-			if (m_stmt && m_bind && m_columns && column_index >= 0 && column_index < m_column_count)
+			if (is_null(column_index))
 			{
-				if (m_columns[column_index].is_null)
-					return nullptr;
-
-				_ensure_capacity(column_index);
-
-				*size = m_columns[column_index].length;
+				if (size)
+					*size = 0;
+				return nullptr;
+			}
 
-				return (const void *)m_columns[column_index].buffer;
+			// the bytea and the text types are returned as is,the other types are returned as
+			// the text representation,so the bytes can be converted back by the text getters
+			if (_is_raw(column_index))
+			{
+				if (size)
+					*size = (std::size_t)PQgetlength(m_res, m_row, column_index);
+				return (const void *)PQgetvalue(m_res, m_row, column_index);
 			}
-			return nullptr;
+
+			const char * s = get_string(column_index);
+			if (size)
+				*size = (s ? std::strlen(s) : 0);
+			return (const void *)s;
 		}
 
 
@@ -426,14 +485,14 @@ namespace zdb2
 		 * Retrieves the value of the designated column in the current row of
 		 * this ResultSet object as a void pointer. If <code>columnName</code>
 		 * is not found this method throws an SQLException. <i>The returned
-		 * blob may only be valid until the next call to ResultSet_next() and if 
+		 * blob may only be valid until the next call to ResultSet_next() and if
 		 * you plan to use the returned value longer, you must make a copy.</i>
 		 * @param R A ResultSet object
 		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
-		 * @param size The number of bytes in the blob is stored in size 
+		 * @param size The number of bytes in the blob is stored in size
 		 * @return The column value; if the value is SQL NULL, the value
 		 * returned is NULL
-		 * @exception SQLException If a database access error occurs or 
+		 * @exception SQLException If a database access error occurs or
 		 * columnName does not exist
 		 * @see SQLException.h
 		 */
@@ -466,18 +525,41 @@ namespace zdb2
 		 * See also PreparedStatement_setTimestamp()
 		 * @param R A ResultSet object
 		 * @param columnIndex The first column is 1, the second is 2, ...
-		 * @return The column value as seconds since the epoch in the 
+		 * @return The column value as seconds since the epoch in the
 		 * <i class="textinfo">GMT timezone</i>. If the value is SQL NULL, the
 		 * value returned is 0, i.e. January 1, 1970, 00:00:00 GMT
-		 * @exception SQLException If a database access error occurs, if 
+		 * @exception SQLException If a database access error occurs, if
 		 * <code>columnIndex</code> is outside the range [1..ResultSet_getColumnCount()]
 		 * or if the column value cannot be converted to a valid timestamp
 		 * @see SQLException.h PreparedStatement_setTimestamp
 		 */
 		virtual time_t get_timestamp(int column_index) override
 		{
-			// Not integer storage class, try to parse as time string
-			return (time_t)0;
+			if (is_null(column_index))
+				return (time_t)0;
+
+			const char * value = PQgetvalue(m_res, m_row, column_index);
+			int length = PQgetlength(m_res, m_row, column_index);
+
+			if (PQfformat(m_res, column_index) == postgresql_util::BINARY_FORMAT)
+			{
+				unsigned int type = (unsigned int)m_column_types[column_index];
+				if ((type == postgresql_util::TIMESTAMPOID || type == postgresql_util::TIMESTAMPTZOID) && length == 8)
+					return postgresql_util::to_unix_time((int64_t)postgresql_util::get_uint64(value));
+				if (type == postgresql_util::DATEOID && length == 4)
+					return (time_t)((int64_t)(int32_t)postgresql_util::get_uint32(value) * postgresql_util::SECS_PER_DAY +
+						postgresql_util::POSTGRES_EPOCH);
+
+				int64_t i = 0;
+				if (_decode_integer(column_index, i))
+					return (time_t)i;
+			}
+
+			struct tm tm = get_datetime(column_index);
+			if (tm.tm_year == 0)
+				return (time_t)0;
+			tm.tm_year -= 1900;
+			return postgresql_util::timegm(&tm);
 		}
 
 
@@ -493,7 +575,7 @@ namespace zdb2
 		 *
 		 * <i class="textinfo">SQLite</i> does not have temporal SQL data types per se
 		 * and using this method with SQLite assume the column value in the Result Set
-		 * to be either a numerical value representing a Unix Time in UTC which is 
+		 * to be either a numerical value representing a Unix Time in UTC which is
 		 * returned as-is or an <a href="http://en.wikipedia.org/wiki/ISO_8601">ISO 8601</a>
 		 * time string which is converted to a time_t value.
 		 * See also PreparedStatement_setTimestamp()
@@ -502,8 +584,8 @@ namespace zdb2
 		 * @return The column value as seconds since the epoch in the
 		 * <i class="textinfo">GMT timezone</i>. If the value is SQL NULL, the
 		 * value returned is 0, i.e. January 1, 1970, 00:00:00 GMT
-		 * @exception SQLException If a database access error occurs, if 
-		 * <code>columnName</code> is not found or if the column value cannot be 
+		 * @exception SQLException If a database access error occurs, if
+		 * <code>columnName</code> is not found or if the column value cannot be
 		 * converted to a valid timestamp
 		 * @see SQLException.h PreparedStatement_setTimestamp
 		 */
@@ -522,14 +604,14 @@ namespace zdb2
 		 * for usage with mktime(3) where, tm_hour = hours since midnight [0-23],
 		 * tm_min = minutes after the hour [0-59], tm_sec = seconds after the minute
 		 * [0-60], tm_mday = day of the month [1-31] and tm_mon = months since January
-		 * <b class="textnote">[0-11]</b>. If the column value contains timezone 
+		 * <b class="textnote">[0-11]</b>. If the column value contains timezone
 		 * information, tm_gmtoff is set to the offset from UTC in seconds, otherwise
-		 * tm_gmtoff is set to 0. <i>On systems without tm_gmtoff, (Solaris), the 
-		 * member, tm_wday is set to gmt offset instead as this property is ignored 
-		 * by mktime on input.</i> The exception to the above is <b class="textnote">tm_year</b> 
+		 * tm_gmtoff is set to 0. <i>On systems without tm_gmtoff, (Solaris), the
+		 * member, tm_wday is set to gmt offset instead as this property is ignored
+		 * by mktime on input.</i> The exception to the above is <b class="textnote">tm_year</b>
 		 * which contains the year literal and <i>not years since 1900</i> which is the
-		 * convention. All other fields in the structure are set to zero. If the 
-		 * column type is DateTime or Timestamp all the fields mentioned above are 
+		 * convention. All other fields in the structure are set to zero. If the
+		 * column type is DateTime or Timestamp all the fields mentioned above are
 		 * set, if it is a Date or Time, only the relevant fields are set.
 		 *
 		 * @param R A ResultSet object
@@ -537,29 +619,48 @@ namespace zdb2
 		 * @return A tm structure with fields for date and time. If the value
 		 * is SQL NULL, a zeroed tm structure is returned
 		 * @exception SQLException If a database access error occurs, if
-		 * <code>columnIndex</code> is outside the range [1..ResultSet_getColumnCount()] 
-		 * or if the column value cannot be converted to a valid SQL Date, Time or 
+		 * <code>columnIndex</code> is outside the range [1..ResultSet_getColumnCount()]
+		 * or if the column value cannot be converted to a valid SQL Date, Time or
 		 * DateTime type
 		 * @see SQLException.h
 		 */
 		virtual tm get_datetime(int column_index) override
 		{
 			struct tm tm = { 0 };
-			if (!m_stmt)
+			if (is_null(column_index))
 				return tm;
-			//if (sqlite3_column_type(m_stmt, column_index) == SQLITE_INTEGER)
-			//{
-			//	time_t utc = (time_t)sqlite3_column_int64(m_stmt, column_index);
-			//	struct tm * utc_tm = std::gmtime(&utc);
-			//	if (utc_tm)
-			//		utc_tm->tm_year += 1900; // Use year literal
-			//	return (*utc_tm);
-			//}
-			//else
-			//{
-			//	// Not integer storage class, try to parse as time string
-
-			//}
+
+			unsigned int type = (unsigned int)m_column_types[column_index];
+			if (PQfformat(m_res, column_index) == postgresql_util::BINARY_FORMAT &&
+				(type == postgresql_util::TIMESTAMPOID || type == postgresql_util::TIMESTAMPTZOID || type == postgresql_util::DATEOID))
+			{
+				time_t utc = get_timestamp(column_index);
+				if (postgresql_util::gmtime(&utc, &tm))
+					tm.tm_year += 1900; // Use year literal
+				return tm;
+			}
+
+			auto s = get_string(column_index);
+			if (!s)
+				return tm;
+
+			int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+			int n = std::sscanf(s, "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second);
+			if (n >= 3)
+			{
+				tm.tm_year = year; // Use year literal
+				tm.tm_mon = month - 1;
+				tm.tm_mday = day;
+				tm.tm_hour = hour;
+				tm.tm_min = minute;
+				tm.tm_sec = second;
+			}
+			else if (std::sscanf(s, "%d:%d:%d", &hour, &minute, &second) == 3)
+			{
+				tm.tm_hour = hour;
+				tm.tm_min = minute;
+				tm.tm_sec = second;
+			}
 			return tm;
 		}
 
@@ -586,8 +687,8 @@ namespace zdb2
 		 * @param columnName The SQL name of the column. <i>case-sensitive</i>
 		 * @return A tm structure with fields for date and time. If the value
 		 * is SQL NULL, a zeroed tm structure is returned
-		 * @exception SQLException If a database access error occurs, if 
-		 * <code>columnName</code> is not found or if the column value cannot be 
+		 * @exception SQLException If a database access error occurs, if
+		 * <code>columnName</code> is not found or if the column value cannot be
 		 * converted to a valid SQL Date, Time or DateTime type
 		 * @see SQLException.h
 		 */
@@ -600,43 +701,108 @@ namespace zdb2
 
 	protected:
 
-		void _ensure_capacity(int i)
+		bool _is_valid(int column_index)
 		{
-			if ((m_columns[i].length > m_bind[i].buffer_length))
-			{
-				/* Column was truncated, resize and fetch column directly. */
-				std::realloc(m_columns[i].buffer, m_columns[i].length + 1);
+			return (m_res && m_row >= 0 && m_row < PQntuples(m_res) && column_index >= 0 && column_index < m_column_count);
+		}
 
-				m_bind[i].buffer = m_columns[i].buffer;
-				m_bind[i].buffer_length = m_columns[i].length;
+		/**
+		 * whether the value is returned as is,the text format values,the bytea,the text types and
+		 * json are returned as is,and the types which we don't known how to decode too.
+		 */
+		bool _is_raw(int column_index)
+		{
+			if (PQfformat(m_res, column_index) != postgresql_util::BINARY_FORMAT)
+				return true;
 
-				if ((mysql_util::MYSQL_OK != mysql_stmt_fetch_column(m_stmt, &m_bind[i], i, 0)))
-					throw std::runtime_error(mysql_stmt_error(m_stmt));
+			return !postgresql_util::is_decoded_type((unsigned int)m_column_types[column_index]);
+		}
+
+		bool _decode_integer(int column_index, int64_t & result)
+		{
+			if (PQfformat(m_res, column_index) != postgresql_util::BINARY_FORMAT)
+				return false;
+			return postgresql_util::decode_integer((unsigned int)m_column_types[column_index],
+				PQgetvalue(m_res, m_row, column_index), PQgetlength(m_res, m_row, column_index), result);
+		}
+
+		bool _decode_float(int column_index, double & result)
+		{
+			if (PQfformat(m_res, column_index) != postgresql_util::BINARY_FORMAT)
+				return false;
+			return postgresql_util::decode_float((unsigned int)m_column_types[column_index],
+				PQgetvalue(m_res, m_row, column_index), PQgetlength(m_res, m_row, column_index), result);
+		}
+
+		/**
+		 * convert the binary value to the same text representation as the text protocol.
+		 */
+		std::string _to_string(int column_index)
+		{
+			std::string s;
+			postgresql_util::decode_text((unsigned int)m_column_types[column_index],
+				PQgetvalue(m_res, m_row, column_index), PQgetlength(m_res, m_row, column_index), s);
+			return s;
+		}
 
-				m_need_rebind = true;
+		void _finish()
+		{
+			if (m_session_ptr && !m_done)
+			{
+				// read out the remaining results,otherwise the connection can't be used anymore
+				if (m_session_ptr->conn)
+				{
+					PGresult * res;
+					while ((res = PQgetResult(m_session_ptr->conn)) != nullptr)
+						PQclear(res);
+				}
 			}
+			m_done = true;
 		}
 
 		virtual void _init() override
 		{
+			m_column_count = PQnfields(m_res);
+
+			for (int col = 0; col < m_column_count; col++)
+			{
+				const char * col_name = PQfname(m_res, col);
+				m_column_names.emplace_back(col_name ? col_name : "");
+				m_column_types.emplace_back(PQftype(m_res, col));
+				m_column_name_map.emplace(m_column_names.back(), col);
+			}
 
+			m_cache.resize(m_column_count);
+			m_cached.resize(m_column_count, false);
+
+			// the cursor is before the first row
+			m_row = -1;
 		}
 
 	protected:
 
-		MYSQL_STMT * m_stmt = nullptr;
-
-		MYSQL_RES * m_meta = nullptr;
+		PGresult * m_res = nullptr;
 
-		std::unordered_map<std::string, int> m_column_name_map;
+		/// not nullptr if the rows are streamed
+		std::shared_ptr<postgresql_util::session> m_session_ptr;
 
-		MYSQL_BIND * m_bind = nullptr;
+		/// whether all the results of the query are read
+		bool m_done = false;
 
-		mysql_util::column_t * m_columns = nullptr;
+		/// the current row in m_res
+		int m_row = -1;
 
 		int m_column_count = 0;
 
-		bool m_need_rebind = false;
+		std::vector<std::string> m_column_names;
+
+		std::vector<Oid> m_column_types;
+
+		std::unordered_map<std::string, int> m_column_name_map;
+
+		/// the text representation of the binary values of the current row
+		std::vector<std::string> m_cache;
+		std::vector<bool> m_cached;
 
 	};
 
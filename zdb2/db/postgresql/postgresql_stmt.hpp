@@ -4,15 +4,20 @@
  * Author   : zhllxt
  * QQ       : 37792738
  * Email    : 37792738@qq.com
- * 
+ *
  */
 
 
 #pragma once
 
 #include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <string>
 #include <memory>
+#include <vector>
 #include <algorithm>
 #include <mutex>
 
@@ -24,18 +29,23 @@
 namespace zdb2
 {
 
+	/**
+	 * PreparedStatement of libpq,the statement is prepared by PQprepare with a generated name,
+	 * and executed by PQexecPrepared,the params are sent in the binary format when the type of
+	 * the param is known,otherwise in the text format and converted by the server.
+	 */
 	class postgresql_stmt : public stmt
 	{
 	public:
 		postgresql_stmt(
-			MYSQL * db,
+			std::shared_ptr<postgresql_util::session> session_ptr,
 			const char * sql,
 			std::size_t timeout
 		)
 			: stmt(sql, timeout)
-			, m_db(db)
+			, m_session_ptr(session_ptr)
 		{
-			if (!m_db)
+			if (!m_session_ptr || !m_session_ptr->conn)
 				throw std::runtime_error("invalid parameters.");
 
 			_init();
@@ -48,20 +58,17 @@ namespace zdb2
 
 		virtual void close() override
 		{
-			if (m_stmt)
-			{
-				mysql_stmt_close(m_stmt);
-				m_stmt = nullptr;
-			}
-			if (m_bind)
-			{
-				delete[]m_bind;
-				m_bind = nullptr;
-			}
-			if (m_params)
+			if (!m_name.empty())
 			{
-				delete[]m_params;
-				m_params = nullptr;
+				if (m_session_ptr && m_session_ptr->conn)
+				{
+					m_session_ptr->discard_results();
+					std::string sql = "DEALLOCATE " + m_name;
+					PGresult * res = PQexec(m_session_ptr->conn, sql.c_str());
+					if (res)
+						PQclear(res);
+				}
+				m_name.clear();
 			}
 		}
 
@@ -69,42 +76,32 @@ namespace zdb2
 		//@{
 
 		/**
-		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the 
-		 * given string value. 
+		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the
+		 * given string value.
 		 * @param P A PreparedStatement object
 		 * @param parameterIndex The first parameter is 1, the second is 2,..
 		 * @param x The string value to set. Must be a NUL terminated string. NULL
-		 * is allowed to indicate a SQL NULL value. 
-		 * @exception SQLException If a database access error occurs or if parameter 
+		 * is allowed to indicate a SQL NULL value.
+		 * @exception SQLException If a database access error occurs or if parameter
 		 * index is out of range
 		 * @see SQLException.h
-		*/
+		 */
 		virtual void set_string(int param_index, const char * x) override
 		{
-			if (m_stmt && m_bind && m_params && param_index >= 0)
-			{
-				m_bind[param_index].buffer_type = MYSQL_TYPE_STRING;
-				m_bind[param_index].buffer = (char*)x;
-
-				if (!x)
-				{
-					m_params[param_index].length = 0;
-					m_bind[param_index].is_null = const_cast<my_bool *>(&mysql_util::yes);
-				}
-				else
-				{
-					m_params[param_index].length = (unsigned long)std::strlen(x);
-					m_bind[param_index].is_null = const_cast<my_bool *>(&mysql_util::no);
-				}
-
-				m_bind[param_index].length = &m_params[param_index].length;
-			}
+			if (!_is_valid(param_index))
+				return;
+
+			// the server converts the text to the type of the param
+			if (!x)
+				_set_null(param_index);
+			else
+				_set_value(param_index, x, std::strlen(x), postgresql_util::TEXT_FORMAT);
 		}
 
 
 		/**
 		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the
-		 * given int value. 
+		 * given int value.
 		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
 		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
 		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
@@ -120,19 +117,13 @@ namespace zdb2
 		 */
 		virtual void set_int(int param_index, int x) override
 		{
-			if (m_stmt && m_bind && m_params && param_index >= 0)
-			{
-				m_params[param_index].type.integer = x;
-				m_bind[param_index].buffer_type = MYSQL_TYPE_LONG;
-				m_bind[param_index].buffer = &m_params[param_index].type.integer;
-				m_bind[param_index].is_null = const_cast<my_bool *>(&mysql_util::no);
-			}
+			set_int64(param_index, (int64_t)x);
 		}
 
 
 		/**
-		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the 
-		 * given long long value. 
+		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the
+		 * given long long value.
 		 * In general, on both 32 and 64 bits architecture, <code>int</code> is 4 bytes
 		 * or 32 bits and <code>long long</code> is 8 bytes or 64 bits. A
 		 * <code>long</code> type is usually equal to <code>int</code> on 32 bits
@@ -142,75 +133,107 @@ namespace zdb2
 		 * @param P A PreparedStatement object
 		 * @param parameterIndex The first parameter is 1, the second is 2,..
 		 * @param x The long long value to set
-		 * @exception SQLException If a database access error occurs or if parameter 
+		 * @exception SQLException If a database access error occurs or if parameter
 		 * index is out of range
 		 * @see SQLException.h
 		 */
 		virtual void set_int64(int param_index, int64_t x) override
 		{
-			if (m_stmt && m_bind && m_params && param_index >= 0)
+			if (!_is_valid(param_index))
+				return;
+
+			char buf[8];
+			switch ((unsigned int)m_param_types[param_index - 1])
 			{
-				m_params[param_index].type.llong = x;
-				m_bind[param_index].buffer_type = MYSQL_TYPE_LONGLONG;
-				m_bind[param_index].buffer = &m_params[param_index].type.llong;
-				m_bind[param_index].is_null = const_cast<my_bool *>(&mysql_util::no);
+			case postgresql_util::INT2OID:
+				postgresql_util::put_uint16(buf, (uint16_t)(int16_t)x);
+				_set_value(param_index, buf, 2, postgresql_util::BINARY_FORMAT);
+				break;
+			case postgresql_util::INT4OID:
+			case postgresql_util::OIDOID:
+				postgresql_util::put_uint32(buf, (uint32_t)(int32_t)x);
+				_set_value(param_index, buf, 4, postgresql_util::BINARY_FORMAT);
+				break;
+			case postgresql_util::INT8OID:
+				postgresql_util::put_uint64(buf, (uint64_t)x);
+				_set_value(param_index, buf, 8, postgresql_util::BINARY_FORMAT);
+				break;
+			case postgresql_util::FLOAT4OID:
+			case postgresql_util::FLOAT8OID:
+				set_double(param_index, (double)x);
+				break;
+			case postgresql_util::BOOLOID:
+				buf[0] = (x ? 1 : 0);
+				_set_value(param_index, buf, 1, postgresql_util::BINARY_FORMAT);
+				break;
+			default:
+				{
+					std::string s = std::to_string(x);
+					_set_value(param_index, s.data(), s.length(), postgresql_util::TEXT_FORMAT);
+				}
+				break;
 			}
 		}
 
 
 		/**
-		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the 
-		 * given double value. 
+		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the
+		 * given double value.
 		 * @param P A PreparedStatement object
 		 * @param parameterIndex The first parameter is 1, the second is 2,..
 		 * @param x The double value to set
-		 * @exception SQLException If a database access error occurs or if parameter 
+		 * @exception SQLException If a database access error occurs or if parameter
 		 * index is out of range
 		 * @see SQLException.h
 		 */
 		virtual void set_double(int param_index, double x) override
 		{
-			if (m_stmt && m_bind && m_params && param_index >= 0)
+			if (!_is_valid(param_index))
+				return;
+
+			char buf[32];
+			switch ((unsigned int)m_param_types[param_index - 1])
 			{
-				m_params[param_index].type.real = x;
-				m_bind[param_index].buffer_type = MYSQL_TYPE_DOUBLE;
-				m_bind[param_index].buffer = &m_params[param_index].type.real;
-				m_bind[param_index].is_null = const_cast<my_bool *>(&mysql_util::no);
+			case postgresql_util::FLOAT4OID:
+				postgresql_util::put_float4(buf, (float)x);
+				_set_value(param_index, buf, 4, postgresql_util::BINARY_FORMAT);
+				break;
+			case postgresql_util::FLOAT8OID:
+				postgresql_util::put_float8(buf, x);
+				_set_value(param_index, buf, 8, postgresql_util::BINARY_FORMAT);
+				break;
+			default:
+				{
+					int n = std::snprintf(buf, sizeof(buf), "%.17g", x);
+					_set_value(param_index, buf, (std::size_t)n, postgresql_util::TEXT_FORMAT);
+				}
+				break;
 			}
 		}
 
 
 		/**
-		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the 
-		 * given blob value. 
+		 * Sets the <i>in</i> parameter at index <code>parameterIndex</code> to the
+		 * given blob value.
 		 * @param P A PreparedStatement object
 		 * @param parameterIndex The first parameter is 1, the second is 2,..
 		 * @param x The blob value to set
-		 * @param size The number of bytes in the blob 
-		 * @exception SQLException If a database access error occurs or if parameter 
+		 * @param size The number of bytes in the blob
+		 * @exception SQLException If a database access error occurs or if parameter
 		 * index is out of range
 		 * @see SQLException.h
 		 */
 		virtual void set_blob(int param_index, const void * x, std::size_t size) override
 		{
-			if (m_stmt && m_bind && m_params && param_index >= 0)
-			{
-				m_bind[param_index].buffer_type = MYSQL_TYPE_BLOB;
-				m_bind[param_index].buffer = (void*)x;
-
-				if (!x)
-				{
-					m_params[param_index].length = 0;
-					m_bind[param_index].is_null = const_cast<my_bool *>(&mysql_util::yes);
-				}
-				else
-				{
-					m_params[param_index].length = (unsigned long)size;
-					m_bind[param_index].is_null = const_cast<my_bool *>(&mysql_util::no);
-				}
-
-				m_bind[param_index].length = &m_params[param_index].length;
-			}
+			if (!_is_valid(param_index))
+				return;
+
+			// the binary format of bytea is the raw bytes
+			if (!x)
+				_set_null(param_index);
+			else
+				_set_value(param_index, (const char *)x, size,
+					(m_param_types[param_index - 1] == postgresql_util::BYTEAOID ? postgresql_util::BINARY_FORMAT : postgresql_util::TEXT_FORMAT));
 		}
 
 
@@ -232,21 +255,25 @@ namespace zdb2
 		 */
 		virtual void set_timestamp(int param_index, time_t x) override
 		{
-			if (m_stmt && m_bind && m_params && param_index >= 0)
-			{
-				struct tm * ptm = std::gmtime(const_cast<const time_t *>(&x));
+			if (!_is_valid(param_index))
+				return;
 
-				m_params[param_index].type.timestamp.year = ptm->tm_year + 1900;
-				m_params[param_index].type.timestamp.month = ptm->tm_mon + 1;
-				m_params[param_index].type.timestamp.day = ptm->tm_mday;
-				m_params[param_index].type.timestamp.hour = ptm->tm_hour;
-				m_params[param_index].type.timestamp.minute = ptm->tm_min;
-				m_params[param_index].type.timestamp.second = ptm->tm_sec;
-
-				m_bind[param_index].buffer_type = MYSQL_TYPE_TIMESTAMP;
-				m_bind[param_index].buffer = &m_params[param_index].type.timestamp;
-
-				m_bind[param_index].is_null = const_cast<my_bool *>(&mysql_util::no);
+			char buf[64];
+			switch ((unsigned int)m_param_types[param_index - 1])
+			{
+			case postgresql_util::TIMESTAMPOID:
+			case postgresql_util::TIMESTAMPTZOID:
+				postgresql_util::put_uint64(buf, (uint64_t)(((int64_t)x - postgresql_util::POSTGRES_EPOCH) * postgresql_util::USECS_PER_SEC));
+				_set_value(param_index, buf, 8, postgresql_util::BINARY_FORMAT);
+				break;
+			default:
+				{
+					struct tm tm = { 0 };
+					postgresql_util::gmtime(&x, &tm);
+					std::size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S+00", &tm);
+					_set_value(param_index, buf, n, postgresql_util::TEXT_FORMAT);
+				}
+				break;
 			}
 		}
 
@@ -255,29 +282,41 @@ namespace zdb2
 		/**
 		 * Executes the prepared SQL statement, which may be an INSERT, UPDATE,
 		 * or DELETE statement or an SQL statement that returns nothing, such
-		 * as an SQL DDL statement. 
+		 * as an SQL DDL statement.
 		 * @param P A PreparedStatement object
 		 * @exception SQLException If a database error occurs
 		 * @see SQLException.h
 		 */
 		virtual void execute() override
 		{
-			if (m_param_count > 0 && m_stmt && m_bind && m_params)
-			{
-				if (mysql_util::MYSQL_OK != mysql_stmt_bind_param(m_stmt, m_bind))
-					throw std::runtime_error(mysql_stmt_error(m_stmt));
+			if (m_name.empty() || !m_session_ptr->conn)
+				throw std::runtime_error("the statement is not prepared.");
+
+			m_session_ptr->discard_results();
 
-#if MYSQL_VERSION_ID >= 50002
-				unsigned long cursor = CURSOR_TYPE_NO_CURSOR;
-				mysql_stmt_attr_set(m_stmt, STMT_ATTR_CURSOR_TYPE, &cursor);
-#endif
+			std::vector<const char *> values(m_param_count);
+			std::vector<int> lengths(m_param_count);
+			for (int i = 0; i < m_param_count; i++)
+			{
+				values[i] = (m_nulls[i] ? nullptr : m_values[i].data());
+				lengths[i] = (int)m_values[i].length();
+			}
 
-				if ((mysql_util::MYSQL_OK != mysql_stmt_execute(m_stmt)))
-					throw std::runtime_error(mysql_stmt_error(m_stmt));
+			PGresult * res = PQexecPrepared(m_session_ptr->conn, m_name.c_str(), m_param_count,
+				values.data(), lengths.data(), m_formats.data(), postgresql_util::BINARY_FORMAT);
 
-				/* Discard prepared param data in client/server */
-				mysql_stmt_reset(m_stmt);
+			if (!postgresql_util::is_ok(res))
+			{
+				std::string err = (res ? PQresultErrorMessage(res) : PQerrorMessage(m_session_ptr->conn));
+				if (res)
+					PQclear(res);
+				throw std::runtime_error(err);
 			}
+
+			const char * rows = PQcmdTuples(res);
+			m_rows_changed = ((rows && rows[0] != '\0') ? (int64_t)std::atoll(rows) : 0);
+
+			PQclear(res);
 		}
 
 
@@ -291,7 +330,7 @@ namespace zdb2
 		 */
 		virtual int64_t rows_changed() override
 		{
-			return (m_stmt ? (int64_t)mysql_stmt_affected_rows(m_stmt) : 0);
+			return m_rows_changed;
 		}
 
 
@@ -303,19 +342,80 @@ namespace zdb2
 
 
 	protected:
+		/// the param_index is 1-based,the same as the other backends
+		bool _is_valid(int param_index)
+		{
+			return (!m_name.empty() && param_index >= 1 && param_index <= m_param_count);
+		}
+
+		void _set_value(int param_index, const char * data, std::size_t size, int format)
+		{
+			m_values[param_index - 1].assign(data, size);
+			m_nulls[param_index - 1] = false;
+			m_formats[param_index - 1] = format;
+		}
+
+		void _set_null(int param_index)
+		{
+			m_values[param_index - 1].clear();
+			m_nulls[param_index - 1] = true;
+			m_formats[param_index - 1] = postgresql_util::TEXT_FORMAT;
+		}
+
 		virtual void _init() override
 		{
+			if (m_sql.empty())
+				return;
+
+			PGconn * conn = m_session_ptr->conn;
 
+			m_session_ptr->discard_results();
+
+			std::string sql;
+			postgresql_util::convert_placeholders(m_sql, sql);
+
+			std::string name = "zdb2_stmt_" + std::to_string(++m_session_ptr->stmt_seq);
+
+			PGresult * res = PQprepare(conn, name.c_str(), sql.c_str(), 0, nullptr);
+			bool ok = (res && PQresultStatus(res) == PGRES_COMMAND_OK);
+			if (res)
+				PQclear(res);
+			if (!ok)
+				return;
+
+			m_name = name;
+
+			// the types of the params are inferred by the server,they are used to encode the
+			// params in the binary format
+			res = PQdescribePrepared(conn, m_name.c_str());
+			if (res && PQresultStatus(res) == PGRES_COMMAND_OK)
+			{
+				m_param_count = PQnparams(res);
+				for (int i = 0; i < m_param_count; i++)
+					m_param_types.emplace_back(PQparamtype(res, i));
+			}
+			if (res)
+				PQclear(res);
+
+			m_param_types.resize(m_param_count, 0);
+			m_values.resize(m_param_count);
+			m_nulls.resize(m_param_count, true);
+			m_formats.resize(m_param_count, postgresql_util::TEXT_FORMAT);
 		}
 
 	protected:
-		MYSQL * m_db = nullptr;
+		std::shared_ptr<postgresql_util::session> m_session_ptr;
+
+		/// the name of the prepared statement,empty if the prepare is failed
+		std::string m_name;
 
-		MYSQL_STMT * m_stmt = nullptr;
+		std::vector<Oid> m_param_types;
 
-		MYSQL_BIND * m_bind = nullptr;
+		std::vector<std::string> m_values;
+		std::vector<bool> m_nulls;
+		std::vector<int> m_formats;
 
-		mysql_util::param_t * m_params = nullptr;
+		int64_t m_rows_changed = 0;
 	};
 
 }
@@ -4,22 +4,26 @@
  * Author   : zhllxt
  * QQ       : 37792738
  * Email    : 37792738@qq.com
- * 
+ *
  */
 
 
 #pragma once
 
 #include <cctype>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <memory>
 #include <algorithm>
-#include <mutex>
-#include <thread>
-#include <condition_variable>
+#include <ctime>
+#include <limits>
 
 #include <libpq-fe.h>
 
+#include <zdb2/db/resultset.hpp>
+
 namespace zdb2
 {
 
@@ -27,30 +31,889 @@ namespace zdb2
 	{
 	public:
 
-		const static my_bool yes = true;
+		/// the oid of the builtin types,see src/include/catalog/pg_type.dat of postgresql
+		enum
+		{
+			BOOLOID        = 16,
+			BYTEAOID       = 17,
+			CHAROID        = 18,
+			NAMEOID        = 19,
+			INT8OID        = 20,
+			INT2OID        = 21,
+			INT4OID        = 23,
+			TEXTOID        = 25,
+			OIDOID         = 26,
+			JSONOID        = 114,
+			XMLOID         = 142,
+			CIDROID        = 650,
+			FLOAT4OID      = 700,
+			FLOAT8OID      = 701,
+			MONEYOID       = 790,
+			INETOID        = 869,
+			BPCHAROID      = 1042,
+			VARCHAROID     = 1043,
+			DATEOID        = 1082,
+			TIMEOID        = 1083,
+			TIMESTAMPOID   = 1114,
+			TIMESTAMPTZOID = 1184,
+			INTERVALOID    = 1186,
+			TIMETZOID      = 1266,
+			NUMERICOID     = 1700,
+			UUIDOID        = 2950,
+			JSONBOID       = 3802,
+		};
+
+		/// the oid of the array types of the builtin types above
+		enum
+		{
+			XMLARRAYOID         = 143,
+			JSONARRAYOID        = 199,
+			CIDRARRAYOID        = 651,
+			MONEYARRAYOID       = 791,
+			BOOLARRAYOID        = 1000,
+			BYTEAARRAYOID       = 1001,
+			CHARARRAYOID        = 1002,
+			NAMEARRAYOID        = 1003,
+			INT2ARRAYOID        = 1005,
+			INT4ARRAYOID        = 1007,
+			TEXTARRAYOID        = 1009,
+			BPCHARARRAYOID      = 1014,
+			VARCHARARRAYOID     = 1015,
+			INT8ARRAYOID        = 1016,
+			FLOAT4ARRAYOID      = 1021,
+			FLOAT8ARRAYOID      = 1022,
+			OIDARRAYOID         = 1028,
+			INETARRAYOID        = 1041,
+			TIMESTAMPARRAYOID   = 1115,
+			DATEARRAYOID        = 1182,
+			TIMEARRAYOID        = 1183,
+			TIMESTAMPTZARRAYOID = 1185,
+			INTERVALARRAYOID    = 1187,
+			NUMERICARRAYOID     = 1231,
+			TIMETZARRAYOID      = 1270,
+			UUIDARRAYOID        = 2951,
+			JSONBARRAYOID       = 3807,
+		};
+
+		/// the format code of the params and the results
+		enum
+		{
+			TEXT_FORMAT   = 0,
+			BINARY_FORMAT = 1,
+		};
+
+		/// seconds from 1970-01-01 to 2000-01-01,the epoch of the postgresql date and time types
+		const static int64_t POSTGRES_EPOCH = 946684800;
+
+		const static int64_t USECS_PER_SEC = 1000000;
+		const static int64_t SECS_PER_DAY = 86400;
+
+		/**
+		 * the state shared by the connection and the statements created by it,the statements
+		 * may be alive after the connection is closed,so they can't use the connection directly.
+		 */
+		struct session
+		{
+			PGconn * conn = nullptr;
+
+			/// the streaming ResultSet returned by the last query,it must be read out before
+			/// the next command can be sent
+			std::weak_ptr<resultset> active_rs;
+
+			/// used to generate the name of the prepared statements
+			uint64_t stmt_seq = 0;
+
+			/// increased when the results of the last command are discarded,the COPY writer and
+			/// reader use it to know whether the COPY is interrupted by another command
+			uint64_t command_seq = 0;
+
+			void discard_results()
+			{
+				std::shared_ptr<resultset> rs = active_rs.lock();
+				if (rs)
+					rs->close();
+				active_rs.reset();
+
+				command_seq++;
+
+				if (!conn)
+					return;
+
+				// end the COPY which is still in progress
+				PGresult * res;
+				while ((res = PQgetResult(conn)) != nullptr)
+				{
+					ExecStatusType status = PQresultStatus(res);
+					PQclear(res);
+					if (status == PGRES_COPY_IN)
+					{
+						PQputCopyEnd(conn, "the copy is interrupted by another command.");
+					}
+					else if (status == PGRES_COPY_OUT)
+					{
+						char * buf = nullptr;
+						while (PQgetCopyData(conn, &buf, 0) > 0)
+							PQfreemem(buf);
+					}
+					else if (status == PGRES_COPY_BOTH)
+					{
+						break;
+					}
+				}
+			}
+		};
+
+		/** @name Network byte order */
+		//@{
+
+		static inline uint16_t get_uint16(const char * p)
+		{
+			const unsigned char * b = (const unsigned char *)p;
+			return (uint16_t)((b[0] << 8) | b[1]);
+		}
+
+		static inline uint32_t get_uint32(const char * p)
+		{
+			const unsigned char * b = (const unsigned char *)p;
+			return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | (uint32_t)b[3];
+		}
+
+		static inline uint64_t get_uint64(const char * p)
+		{
+			return ((uint64_t)get_uint32(p) << 32) | (uint64_t)get_uint32(p + 4);
+		}
+
+		static inline void put_uint16(char * p, uint16_t v)
+		{
+			p[0] = (char)(v >> 8);
+			p[1] = (char)(v);
+		}
+
+		static inline void put_uint32(char * p, uint32_t v)
+		{
+			p[0] = (char)(v >> 24);
+			p[1] = (char)(v >> 16);
+			p[2] = (char)(v >> 8);
+			p[3] = (char)(v);
+		}
+
+		static inline void put_uint64(char * p, uint64_t v)
+		{
+			put_uint32(p, (uint32_t)(v >> 32));
+			put_uint32(p + 4, (uint32_t)(v));
+		}
+
+		static inline float get_float4(const char * p)
+		{
+			uint32_t i = get_uint32(p);
+			float f;
+			std::memcpy(&f, &i, sizeof(f));
+			return f;
+		}
+
+		static inline double get_float8(const char * p)
+		{
+			uint64_t i = get_uint64(p);
+			double d;
+			std::memcpy(&d, &i, sizeof(d));
+			return d;
+		}
+
+		static inline void put_float8(char * p, double d)
+		{
+			uint64_t i;
+			std::memcpy(&i, &d, sizeof(i));
+			put_uint64(p, i);
+		}
+
+		static inline void put_float4(char * p, float f)
+		{
+			uint32_t i;
+			std::memcpy(&i, &f, sizeof(i));
+			put_uint32(p, i);
+		}
+
+		//@}
+
+		/** @name Binary decoders */
+		//@{
+
+		/**
+		 * decode the integer types,returns false if the type is not a integer type.
+		 */
+		static bool decode_integer(unsigned int type, const char * value, int length, int64_t & result)
+		{
+			switch (type)
+			{
+			case BOOLOID: if (length != 1) return false; result = (value[0] ? 1 : 0); return true;
+			case INT2OID: if (length != 2) return false; result = (int64_t)(int16_t)get_uint16(value); return true;
+			case INT4OID: if (length != 4) return false; result = (int64_t)(int32_t)get_uint32(value); return true;
+			case OIDOID:  if (length != 4) return false; result = (int64_t)get_uint32(value); return true;
+			case INT8OID: if (length != 8) return false; result = (int64_t)get_uint64(value); return true;
+			}
+			return false;
+		}
+
+		/**
+		 * decode the floating point types,returns false if the type is not a floating point type.
+		 */
+		static bool decode_float(unsigned int type, const char * value, int length, double & result)
+		{
+			switch (type)
+			{
+			case FLOAT4OID: if (length != 4) return false; result = (double)get_float4(value); return true;
+			case FLOAT8OID: if (length != 8) return false; result = get_float8(value); return true;
+			}
+			return false;
+		}
+
+		/**
+		 * decode the binary numeric to the text representation,the numeric is sent as base 10000
+		 * digits : int16 ndigits,int16 weight,uint16 sign,int16 dscale,int16 digits[ndigits]
+		 */
+		static std::string decode_numeric(const char * value, int length)
+		{
+			if (length < 8)
+				return "";
+
+			int ndigits = (int16_t)get_uint16(value);
+			int weight  = (int16_t)get_uint16(value + 2);
+			int sign    = get_uint16(value + 4);
+			int dscale  = (int16_t)get_uint16(value + 6);
+
+			if (sign == 0xC000) return "NaN";
+			if (sign == 0xD000) return "Infinity";
+			if (sign == 0xF000) return "-Infinity";
+
+			if (ndigits < 0 || length < 8 + ndigits * 2)
+				return "";
+
+			auto digit = [value, ndigits](int i) -> int
+			{
+				return ((i >= 0 && i < ndigits) ? (int16_t)get_uint16(value + 8 + i * 2) : 0);
+			};
+
+			std::string s;
+			if (sign == 0x4000)
+				s += '-';
+
+			char buf[8];
+			if (weight < 0)
+			{
+				s += '0';
+			}
+			else
+			{
+				for (int i = 0; i <= weight; i++)
+				{
+					std::snprintf(buf, sizeof(buf), (i == 0 ? "%d" : "%04d"), digit(i));
+					s += buf;
+				}
+			}
+
+			if (dscale > 0)
+			{
+				std::string frac;
+				for (int i = weight + 1; (int)frac.length() < dscale; i++)
+				{
+					std::snprintf(buf, sizeof(buf), "%04d", digit(i));
+					frac += buf;
+				}
+				frac.resize(dscale);
+				s += '.';
+				s += frac;
+			}
+
+			return s;
+		}
+
+		/**
+		 * convert the microseconds since 2000-01-01 to the unix time and the fraction.
+		 */
+		static time_t to_unix_time(int64_t usecs, int64_t * fraction = nullptr)
+		{
+			int64_t secs = usecs / USECS_PER_SEC;
+			int64_t frac = usecs % USECS_PER_SEC;
+			if (frac < 0)
+			{
+				secs--;
+				frac += USECS_PER_SEC;
+			}
+			if (fraction)
+				*fraction = frac;
+			return (time_t)(secs + POSTGRES_EPOCH);
+		}
+
+		/**
+		 * decode the date and time types to the text representation like the text protocol,
+		 * eg : "2017-01-02 03:04:05.123456","2017-01-02","03:04:05"
+		 */
+		static std::string decode_datetime(unsigned int type, const char * value, int length)
+		{
+			char buf[64] = { 0 };
+			struct tm tm = { 0 };
+
+			if ((type == TIMESTAMPOID || type == TIMESTAMPTZOID) && length == 8)
+			{
+				int64_t usecs = (int64_t)get_uint64(value);
+				if (usecs == (std::numeric_limits<int64_t>::max)()) return "infinity";
+				if (usecs == (std::numeric_limits<int64_t>::min)()) return "-infinity";
+
+				int64_t frac = 0;
+				time_t t = to_unix_time(usecs, &frac);
+				if (!gmtime(&t, &tm))
+					return "";
+
+				std::size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+				if (frac > 0)
+					std::snprintf(buf + n, sizeof(buf) - n, ".%06d", (int)frac);
+				if (type == TIMESTAMPTZOID)
+					std::strncat(buf, "+00", sizeof(buf) - std::strlen(buf) - 1);
+				return buf;
+			}
+			else if (type == DATEOID && length == 4)
+			{
+				int32_t days = (int32_t)get_uint32(value);
+				if (days == (std::numeric_limits<int32_t>::max)()) return "infinity";
+				if (days == (std::numeric_limits<int32_t>::min)()) return "-infinity";
+
+				time_t t = (time_t)((int64_t)days * SECS_PER_DAY + POSTGRES_EPOCH);
+				if (!gmtime(&t, &tm))
+					return "";
+
+				std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+				return buf;
+			}
+			else if (type == TIMEOID && length == 8)
+			{
+				int64_t usecs = (int64_t)get_uint64(value);
+				int64_t secs = usecs / USECS_PER_SEC;
+				int n = std::snprintf(buf, sizeof(buf), "%02d:%02d:%02d",
+					(int)(secs / 3600), (int)(secs / 60 % 60), (int)(secs % 60));
+				if (usecs % USECS_PER_SEC > 0)
+					std::snprintf(buf + n, sizeof(buf) - n, ".%06d", (int)(usecs % USECS_PER_SEC));
+				return buf;
+			}
+
+			return "";
+		}
+
+		/**
+		 * whether the binary value of the type is converted to the text representation by
+		 * decode_text,the other types (text,varchar,json,xml,bytea...) are sent as they are.
+		 */
+		static bool is_decoded_type(unsigned int type)
+		{
+			switch (type)
+			{
+			case BOOLOID:
+			case INT2OID:
+			case INT4OID:
+			case INT8OID:
+			case OIDOID:
+			case FLOAT4OID:
+			case FLOAT8OID:
+			case NUMERICOID:
+			case MONEYOID:
+			case DATEOID:
+			case TIMEOID:
+			case TIMETZOID:
+			case TIMESTAMPOID:
+			case TIMESTAMPTZOID:
+			case INTERVALOID:
+			case UUIDOID:
+			case JSONBOID:
+			case INETOID:
+			case CIDROID:
+				return true;
+			}
+			return is_array_type(type);
+		}
+
+		static bool is_array_type(unsigned int type)
+		{
+			switch (type)
+			{
+			case XMLARRAYOID:
+			case JSONARRAYOID:
+			case CIDRARRAYOID:
+			case MONEYARRAYOID:
+			case BOOLARRAYOID:
+			case BYTEAARRAYOID:
+			case CHARARRAYOID:
+			case NAMEARRAYOID:
+			case INT2ARRAYOID:
+			case INT4ARRAYOID:
+			case TEXTARRAYOID:
+			case BPCHARARRAYOID:
+			case VARCHARARRAYOID:
+			case INT8ARRAYOID:
+			case FLOAT4ARRAYOID:
+			case FLOAT8ARRAYOID:
+			case OIDARRAYOID:
+			case INETARRAYOID:
+			case TIMESTAMPARRAYOID:
+			case DATEARRAYOID:
+			case TIMEARRAYOID:
+			case TIMESTAMPTZARRAYOID:
+			case INTERVALARRAYOID:
+			case NUMERICARRAYOID:
+			case TIMETZARRAYOID:
+			case UUIDARRAYOID:
+			case JSONBARRAYOID:
+				return true;
+			}
+			return false;
+		}
+
+		/**
+		 * convert the binary value to the same text representation as the text protocol,the
+		 * money is formatted like the "C" lc_monetary,eg : "-$1,234.56"
+		 * @return false if the type is not one of is_decoded_type() or the value is invalid
+		 */
+		static bool decode_text(unsigned int type, const char * value, int length, std::string & result)
+		{
+			int64_t i = 0;
+			double d = 0;
+			char buf[64];
+
+			if (type == BOOLOID && length == 1)
+			{
+				result = (value[0] ? "t" : "f");
+				return true;
+			}
+			if (decode_integer(type, value, length, i))
+			{
+				result = std::to_string(i);
+				return true;
+			}
+			if (decode_float(type, value, length, d))
+			{
+				// use the shortest representation which can be converted back to the same value
+				std::snprintf(buf, sizeof(buf), "%.15g", d);
+				if (std::strtod(buf, nullptr) != d)
+					std::snprintf(buf, sizeof(buf), "%.17g", d);
+				result = buf;
+				return true;
+			}
+
+			switch (type)
+			{
+			case NUMERICOID:
+				result = decode_numeric(value, length);
+				return !result.empty();
+			case MONEYOID:
+				if (length != 8)
+					return false;
+				result = decode_money((int64_t)get_uint64(value));
+				return true;
+			case DATEOID:
+			case TIMEOID:
+			case TIMESTAMPOID:
+			case TIMESTAMPTZOID:
+				result = decode_datetime(type, value, length);
+				return !result.empty();
+			case TIMETZOID:
+				if (length != 12)
+					return false;
+				result = decode_datetime(TIMEOID, value, 8);
+				result += decode_zone(-(int32_t)get_uint32(value + 8));
+				return true;
+			case INTERVALOID:
+				if (length != 16)
+					return false;
+				result = decode_interval((int64_t)get_uint64(value), (int32_t)get_uint32(value + 8),
+					(int32_t)get_uint32(value + 12));
+				return true;
+			case UUIDOID:
+				if (length != 16)
+					return false;
+				result.clear();
+				for (int n = 0; n < 16; n++)
+				{
+					if (n == 4 || n == 6 || n == 8 || n == 10)
+						result += '-';
+					std::snprintf(buf, sizeof(buf), "%02x", (unsigned char)value[n]);
+					result += buf;
+				}
+				return true;
+			case JSONBOID:
+				// the version byte and the json text
+				if (length < 1 || value[0] != 1)
+					return false;
+				result.assign(value + 1, length - 1);
+				return true;
+			case INETOID:
+			case CIDROID:
+				return decode_inet(type, value, length, result);
+			}
+
+			if (is_array_type(type))
+				return decode_array(value, length, result);
+
+			return false;
+		}
+
+		/**
+		 * the money is int64 in the smallest unit of the currency,the fraction digits of the
+		 * "C" lc_monetary is 2.
+		 */
+		static std::string decode_money(int64_t cents)
+		{
+			uint64_t v = (cents < 0 ? (uint64_t)0 - (uint64_t)cents : (uint64_t)cents);
+			std::string units = std::to_string(v / 100);
+			for (int n = (int)units.length() - 3; n > 0; n -= 3)
+				units.insert(n, 1, ',');
+
+			char frac[8];
+			std::snprintf(frac, sizeof(frac), ".%02d", (int)(v % 100));
+			return (cents < 0 ? "-$" : "$") + units + frac;
+		}
+
+		/**
+		 * the time zone offset of timetz,eg : "+08","-03:30"
+		 * @param offset Seconds east of UTC
+		 */
+		static std::string decode_zone(int32_t offset)
+		{
+			int32_t v = (offset < 0 ? -offset : offset);
+			char buf[16];
+			int n = std::snprintf(buf, sizeof(buf), "%c%02d", (offset < 0 ? '-' : '+'), (int)(v / 3600));
+			if (v % 3600 != 0)
+				n += std::snprintf(buf + n, sizeof(buf) - n, ":%02d", (int)(v / 60 % 60));
+			if (v % 60 != 0)
+				std::snprintf(buf + n, sizeof(buf) - n, ":%02d", (int)(v % 60));
+			return buf;
+		}
+
+		/**
+		 * the interval in the default "postgres" IntervalStyle,eg : "1 year 2 mons -3 days +04:05:06.5"
+		 */
+		static std::string decode_interval(int64_t usecs, int32_t days, int32_t months)
+		{
+			std::string s;
+			bool is_before = false;
+			char buf[64];
+
+			auto add_part = [&s, &is_before, &buf](int32_t v, const char * unit)
+			{
+				if (v == 0)
+					return;
+				std::snprintf(buf, sizeof(buf), "%s%s%d %s%s", (s.empty() ? "" : " "),
+					((is_before && v > 0) ? "+" : ""), (int)v, unit, (v != 1 ? "s" : ""));
+				s += buf;
+				is_before = (v < 0);
+			};
+			add_part(months / 12, "year");
+			add_part(months % 12, "mon");
+			add_part(days, "day");
+
+			if (s.empty() || usecs != 0)
+			{
+				uint64_t v = (usecs < 0 ? (uint64_t)0 - (uint64_t)usecs : (uint64_t)usecs);
+				uint64_t secs = v / USECS_PER_SEC;
+				int n = std::snprintf(buf, sizeof(buf), "%s%s%02llu:%02d:%02d", (s.empty() ? "" : " "),
+					(usecs < 0 ? "-" : (is_before ? "+" : "")), (unsigned long long)(secs / 3600),
+					(int)(secs / 60 % 60), (int)(secs % 60));
+				if (v % USECS_PER_SEC != 0)
+				{
+					n += std::snprintf(buf + n, sizeof(buf) - n, ".%06d", (int)(v % USECS_PER_SEC));
+					while (buf[n - 1] == '0')
+						buf[--n] = '\0';
+				}
+				s += buf;
+			}
+			return s;
+		}
+
+		/**
+		 * inet and cidr : uint8 family (2 ipv4,3 ipv6),uint8 bits,uint8 is_cidr,uint8 size,address
+		 */
+		static bool decode_inet(unsigned int type, const char * value, int length, std::string & result)
+		{
+			if (length < 4)
+				return false;
+
+			const unsigned char * b = (const unsigned char *)value;
+			int family = b[0], bits = b[1], size = b[3];
+			if (length != 4 + size || !((family == 2 && size == 4) || (family == 3 && size == 16)))
+				return false;
+
+			char buf[64];
+			const unsigned char * addr = b + 4;
+			if (family == 2)
+			{
+				std::snprintf(buf, sizeof(buf), "%d.%d.%d.%d", addr[0], addr[1], addr[2], addr[3]);
+				result = buf;
+			}
+			else
+			{
+				int words[8];
+				for (int n = 0; n < 8; n++)
+					words[n] = (addr[n * 2] << 8) | addr[n * 2 + 1];
+
+				// the longest run of the zero words is replaced by "::"
+				int best = -1, best_len = 0;
+				for (int n = 0; n < 8;)
+				{
+					int len = 0;
+					while (n + len < 8 && words[n + len] == 0)
+						len++;
+					if (len > best_len)
+					{
+						best = n;
+						best_len = len;
+					}
+					n += (len > 0 ? len : 1);
+				}
+				if (best_len < 2)
+					best = -1;
+
+				result.clear();
+				for (int n = 0; n < 8; n++)
+				{
+					if (best >= 0 && n >= best && n < best + best_len)
+					{
+						if (n == best)
+							result += ':';
+						continue;
+					}
+					if (n > 0)
+						result += ':';
+					// the ipv4 mapped or compatible address
+					if (n == 6 && best == 0 && (best_len == 6 || (best_len == 5 && words[5] == 0xffff)))
+					{
+						std::snprintf(buf, sizeof(buf), "%d.%d.%d.%d", addr[12], addr[13], addr[14], addr[15]);
+						result += buf;
+						break;
+					}
+					std::snprintf(buf, sizeof(buf), "%x", words[n]);
+					result += buf;
+				}
+				if (best >= 0 && best + best_len == 8)
+					result += ':';
+			}
+
+			if (type == CIDROID || bits != (family == 2 ? 32 : 128))
+				result += "/" + std::to_string(bits);
+			return true;
+		}
+
+		/**
+		 * the array : int32 ndim,int32 has_null,uint32 element type,int32 size and int32 lower
+		 * bound of every dimension,then every element is int32 length (-1 is NULL) and the value.
+		 * It's converted to the text representation,eg : {1,2,NULL} {{"a b",c},{d,e}}
+		 */
+		static bool decode_array(const char * value, int length, std::string & result)
+		{
+			if (length < 12)
+				return false;
+
+			int ndim = (int32_t)get_uint32(value);
+			unsigned int elem_type = get_uint32(value + 8);
+			if (ndim < 0 || ndim > 6 || length < 12 + ndim * 8)
+				return false;
+
+			result.clear();
+			if (ndim == 0)
+			{
+				result = "{}";
+				return true;
+			}
+
+			int dims[6];
+			int64_t count = 1;
+			bool lower_bounds = false;
+			std::string decoration;
+			for (int n = 0; n < ndim; n++)
+			{
+				dims[n] = (int32_t)get_uint32(value + 12 + n * 8);
+				int lower = (int32_t)get_uint32(value + 16 + n * 8);
+				if (dims[n] < 0)
+					return false;
+				count *= dims[n];
+				lower_bounds = (lower_bounds || lower != 1);
+				decoration += "[" + std::to_string(lower) + ":" + std::to_string(lower + dims[n] - 1) + "]";
+			}
+			if (lower_bounds)
+				result = decoration + "=";
+
+			const char * p = value + 12 + ndim * 8;
+			const char * end = value + length;
+			int index[6] = { 0 };
+			std::string elem;
+
+			for (int64_t k = 0; k < count; k++)
+			{
+				// open the dimensions which start at this element
+				int opened = ndim;
+				while (opened > 0 && index[opened - 1] == 0)
+					opened--;
+				if (k > 0)
+					result += ',';
+				for (int n = opened; n < ndim; n++)
+					result += '{';
+
+				if (end - p < 4)
+					return false;
+				int elem_len = (int32_t)get_uint32(p);
+				p += 4;
+				if (elem_len < 0)
+				{
+					result += "NULL";
+				}
+				else
+				{
+					if (end - p < elem_len)
+						return false;
+					if (elem_type == BYTEAOID)
+					{
+						char buf[4];
+						elem = "\\x";
+						for (int n = 0; n < elem_len; n++)
+						{
+							std::snprintf(buf, sizeof(buf), "%02x", (unsigned char)p[n]);
+							elem += buf;
+						}
+					}
+					else if (!decode_text(elem_type, p, elem_len, elem))
+					{
+						elem.assign(p, elem_len);
+					}
+					p += elem_len;
+					_append_array_element(result, elem);
+				}
+
+				// close the dimensions which end at this element
+				int n = ndim - 1;
+				for (; n >= 0; n--)
+				{
+					if (++index[n] < dims[n])
+						break;
+					index[n] = 0;
+					result += '}';
+				}
+			}
+
+			if (count == 0)
+			{
+				// some dimension is empty
+				result = "{}";
+			}
+			return true;
+		}
+
+		static void _append_array_element(std::string & result, const std::string & elem)
+		{
+			bool quote = elem.empty() || (elem.length() == 4 &&
+				std::toupper((unsigned char)elem[0]) == 'N' && std::toupper((unsigned char)elem[1]) == 'U' &&
+				std::toupper((unsigned char)elem[2]) == 'L' && std::toupper((unsigned char)elem[3]) == 'L');
+			for (std::size_t n = 0; n < elem.length() && !quote; n++)
+			{
+				char c = elem[n];
+				quote = (c == '{' || c == '}' || c == ',' || c == '"' || c == '\\' || std::isspace((unsigned char)c));
+			}
+			if (!quote)
+			{
+				result += elem;
+				return;
+			}
+
+			result += '"';
+			for (char c : elem)
+			{
+				if (c == '"' || c == '\\')
+					result += '\\';
+				result += c;
+			}
+			result += '"';
+		}
+
+		//@}
+
+		static struct tm * gmtime(const time_t * t, struct tm * result)
+		{
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_)
+			return (gmtime_s(result, t) == 0 ? result : nullptr);
+#else
+			return gmtime_r(t, result);
+#endif
+		}
 
-		const static my_bool no = false;
+		static time_t timegm(struct tm * tm)
+		{
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_)
+			return _mkgmtime(tm);
+#else
+			return ::timegm(tm);
+#endif
+		}
 
-		const static int MYSQL_OK = 0;
+		/**
+		 * returns true if the result status means the command is completed successfully.
+		 */
+		static bool is_ok(PGresult * res)
+		{
+			if (!res)
+				return false;
+			ExecStatusType status = PQresultStatus(res);
+			return (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK || status == PGRES_EMPTY_QUERY ||
+				status == PGRES_SINGLE_TUPLE
+#if defined(LIBPQ_HAS_CHUNK_MODE)
+				|| status == PGRES_TUPLES_CHUNK
+#endif
+				);
+		}
 
-		const static int STRLEN = 256;
+		/**
+		 * convert the '?' placeholders to the postgresql style $1,$2... the '?' in the quoted
+		 * strings,the quoted identifiers and the comments are not converted.
+		 * @return the number of the placeholders
+		 */
+		static int convert_placeholders(const std::string & sql, std::string & result)
+		{
+			int count = 0;
+			result.clear();
+			result.reserve(sql.length() + 16);
 
-		typedef struct param_t {
-			union {
-				int integer;
-				long long llong;
-				double real;
-				MYSQL_TIME timestamp;
-			} type;
-			unsigned long length;
-		} param_t;
+			for (std::size_t i = 0; i < sql.length(); i++)
+			{
+				char c = sql[i];
+				if (c == '\'' || c == '"')
+				{
+					// copy the quoted string,the quote is escaped by doubling it
+					std::size_t end = sql.find(c, i + 1);
+					end = (end == std::string::npos ? sql.length() : end + 1);
+					result.append(sql, i, end - i);
+					i = end - 1;
+				}
+				else if (c == '-' && i + 1 < sql.length() && sql[i + 1] == '-')
+				{
+					std::size_t end = sql.find('\n', i);
+					end = (end == std::string::npos ? sql.length() : end + 1);
+					result.append(sql, i, end - i);
+					i = end - 1;
+				}
+				else if (c == '/' && i + 1 < sql.length() && sql[i + 1] == '*')
+				{
+					std::size_t end = sql.find("*/", i + 2);
+					end = (end == std::string::npos ? sql.length() : end + 2);
+					result.append(sql, i, end - i);
+					i = end - 1;
+				}
+				else if (c == '?')
+				{
+					result += '$';
+					result += std::to_string(++count);
+				}
+				else
+				{
+					result += c;
+				}
+			}
 
-		typedef struct column_t {
-			my_bool is_null;
-			MYSQL_FIELD * field;
-			unsigned long length;
-			char * buffer;
-		} column_t;
+			return count;
+		}
 
 	};
 
@@ -0,0 +1,213 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <zdb2/util/histogram.hpp>
+#include <zdb2/db/pool_metrics.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * Render the metrics in the Prometheus text exposition format,eg :
+	 *
+	 * zdb2::prometheus prom;
+	 * prom.add(primary_ptr->get_metrics(), { { "pool", "primary" } });
+	 * prom.add(replica_ptr->get_metrics(), { { "pool", "replica" } });
+	 * std::string text = prom.str(); // the body of the HTTP response of "/metrics"
+	 *
+	 * The samples of the same metric name are grouped together with one HELP and TYPE line,so
+	 * several pools can be added.The histograms of microseconds are exposed in seconds.
+	 */
+	class prometheus
+	{
+	public:
+
+		typedef std::vector<std::pair<std::string, std::string>> labels;
+
+		prometheus(const std::string & prefix = "zdb2_") : m_prefix(prefix)
+		{
+		}
+
+		/**
+		 * Add the metrics of a pool.
+		 */
+		prometheus & add(const pool_metrics & m, const labels & l = labels())
+		{
+			add_gauge("pool_connections_idle", "The idle connections of the pool.", (double)m.idle_count, l);
+			add_gauge("pool_connections_using", "The connections checked out of the pool.", (double)m.using_count, l);
+			add_gauge("pool_connections_max", "The max connections of the pool.", (double)m.max_count, l);
+
+			add_counter("pool_checkouts_total", "The successful checkouts of the pool.", m.checkouts, l);
+			add_counter("pool_exhausted_total", "The checkouts which got no connection because the pool is full.", m.exhausted, l);
+			add_counter("pool_checkout_errors_total", "The checkouts which failed to open a new connection.", m.checkout_errors, l);
+			add_counter("pool_connects_total", "The connections opened by the pool.", m.connects, l);
+			add_counter("pool_connect_failures_total", "The failed attempts to open a connection.", m.connect_failures, l);
+			add_counter("pool_reaped_total", "The idle connections closed by the sweep thread.", m.reaped, l);
+			add_counter("pool_ping_failures_total", "The idle connections which failed to ping.", m.ping_failures, l);
+
+			if (m.wait_us)
+				add_histogram("pool_checkout_wait_seconds", "The time spent in getting a connection.", *m.wait_us, l);
+			if (m.hold_us)
+				add_histogram("pool_checkout_hold_seconds", "The time a connection is checked out.", *m.hold_us, l);
+			if (m.connect_us)
+				add_histogram("pool_connect_seconds", "The time of opening a connection.", *m.connect_us, l);
+			return (*this);
+		}
+
+		prometheus & add_gauge(const std::string & name, const std::string & help, double value, const labels & l = labels())
+		{
+			_family(name, help, "gauge").lines += m_prefix + name + _labels(l) + " " + _number(value) + "\n";
+			return (*this);
+		}
+
+		prometheus & add_counter(const std::string & name, const std::string & help, uint64_t value, const labels & l = labels())
+		{
+			_family(name, help, "counter").lines += m_prefix + name + _labels(l) + " " + std::to_string(value) + "\n";
+			return (*this);
+		}
+
+		/**
+		 * Add a histogram of microseconds,the le bounds are from 100us to 10s.
+		 */
+		prometheus & add_histogram(const std::string & name, const std::string & help, const histogram & h, const labels & l = labels())
+		{
+			static const uint64_t bounds[] = {
+				100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+				100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000,
+			};
+
+			family & f = _family(name, help, "histogram");
+
+			// the buckets of the histogram are finer than the le bounds,a bucket is counted by
+			// the first bound which is not less than the highest value of the bucket
+			uint64_t seen = 0;
+			int index = 0;
+			for (uint64_t bound : bounds)
+			{
+				for (; index < histogram::BUCKETS && histogram::highest_of(index) <= bound; index++)
+					seen += h.get_bucket_count(index);
+
+				labels bl = l;
+				bl.emplace_back("le", _number((double)bound / 1000000.0));
+				f.lines += m_prefix + name + "_bucket" + _labels(bl) + " " + std::to_string(seen) + "\n";
+			}
+
+			// the count is read after the buckets,so the +Inf bucket is not less than the others
+			uint64_t count = h.get_count();
+			if (count < seen)
+				count = seen;
+
+			labels bl = l;
+			bl.emplace_back("le", "+Inf");
+			f.lines += m_prefix + name + "_bucket" + _labels(bl) + " " + std::to_string(count) + "\n";
+			f.lines += m_prefix + name + "_sum" + _labels(l) + " " + _number((double)h.get_sum() / 1000000.0) + "\n";
+			f.lines += m_prefix + name + "_count" + _labels(l) + " " + std::to_string(count) + "\n";
+			return (*this);
+		}
+
+		/**
+		 * Get the text of all the metrics added.
+		 */
+		std::string str() const
+		{
+			std::string text;
+			for (auto & f : m_families)
+			{
+				text += "# HELP " + m_prefix + f.name + " " + f.help + "\n";
+				text += "# TYPE " + m_prefix + f.name + " " + f.type + "\n";
+				text += f.lines;
+			}
+			return text;
+		}
+
+		void clear()
+		{
+			m_families.clear();
+		}
+
+	protected:
+
+		struct family
+		{
+			std::string name;
+			std::string help;
+			std::string type;
+			std::string lines;
+		};
+
+		family & _family(const std::string & name, const std::string & help, const char * type)
+		{
+			for (auto & f : m_families)
+			{
+				if (f.name == name)
+					return f;
+			}
+
+			m_families.emplace_back();
+			family & f = m_families.back();
+			f.name = name;
+			f.help = help;
+			f.type = type;
+			return f;
+		}
+
+		static std::string _labels(const labels & l)
+		{
+			if (l.empty())
+				return std::string();
+
+			std::string s = "{";
+			for (std::size_t i = 0; i < l.size(); i++)
+			{
+				if (i > 0)
+					s += ",";
+				s += l[i].first + "=\"";
+				for (char c : l[i].second)
+				{
+					if (c == '\\')
+						s += "\\\\";
+					else if (c == '"')
+						s += "\\\"";
+					else if (c == '\n')
+						s += "\\n";
+					else
+						s += c;
+				}
+				s += "\"";
+			}
+			s += "}";
+			return s;
+		}
+
+		static std::string _number(double value)
+		{
+			char buf[32];
+			std::snprintf(buf, sizeof(buf), "%.9g", value);
+			return buf;
+		}
+
+	protected:
+
+		std::string m_prefix;
+
+		/// the metric families in the order they are added
+		std::vector<family> m_families;
+
+	};
+
+}
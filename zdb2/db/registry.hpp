@@ -0,0 +1,362 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+#if !defined(ZDB2_DISABLE_PLUGINS)
+#	if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_)
+#		ifndef WIN32_LEAN_AND_MEAN
+#			define WIN32_LEAN_AND_MEAN
+#		endif
+#		include <windows.h>
+#	else
+#		include <dlfcn.h>
+#	endif
+#endif
+
+#include <zdb2/net/url.hpp>
+#include <zdb2/db/hooks.hpp>
+#include <zdb2/db/stats.hpp>
+#include <zdb2/db/connection.hpp>
+
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_)
+#	define ZDB2_PLUGIN_EXPORT extern "C" __declspec(dllexport)
+#else
+#	define ZDB2_PLUGIN_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+/**
+ * Define the entry function of a backend plugin,the backends which are included by the plugin
+ * source file are exported to the application,eg :
+ *
+ * // zdb2_mysql.cpp
+ * // g++ -std=c++11 -shared -fPIC zdb2_mysql.cpp -o libzdb2_mysql.so -lmysqlclient
+ * #include <zdb2/db/mysql/mysql_async_connection.hpp>
+ * ZDB2_DECLARE_PLUGIN()
+ */
+#define ZDB2_DECLARE_PLUGIN()                                                     \
+	ZDB2_PLUGIN_EXPORT int zdb2_plugin_init(const zdb2::registry::host * h, int abi) \
+	{                                                                             \
+		if (!h || abi != zdb2::registry::ABI_VERSION || !h->reg)                  \
+			return -1;                                                            \
+		zdb2::hooks::attach(h->hooks_state);                                      \
+		zdb2::statement_stats::attach(h->stats_state);                            \
+		h->reg->merge(zdb2::registry::instance());                                \
+		return 0;                                                                 \
+	}
+
+namespace zdb2
+{
+
+	/**
+	 * The registry of the database backends,the pool finds the connection factory by the protocol
+	 * of the url (eg : "mysql" "sqlite") once when it is created,and creates all the connections
+	 * by the factory.
+	 *
+	 * A backend registers itself when it's connection header is included,so the application only
+	 * links the client libraries of the backends it includes,see zdb2/db/backends.hpp.
+	 *
+	 * A backend can also be built into a plugin,see ZDB2_DECLARE_PLUGIN.When a protocol is not
+	 * registered,the plugin file "libzdb2_<protocol>.so" ("zdb2_<protocol>.dll" on windows) is
+	 * searched in the directories of the ZDB2_PLUGIN_PATH environment variable (separated by ':'
+	 * or ';' on windows),the directories added by add_plugin_path(),and then the default search
+	 * path of the system.The plugins are never unloaded,because the connections created by them
+	 * may live until the application exits.Define ZDB2_DISABLE_PLUGINS to remove the plugin
+	 * support (and the dependency on libdl).
+	 */
+	class registry
+	{
+	public:
+
+		enum
+		{
+			/// increase it when the connection interface is changed,the plugin which is built with
+			/// a different version is refused.
+			ABI_VERSION = 4,
+		};
+
+		/**
+		 * the objects of the application passed to zdb2_plugin_init,the plugin uses the hooks and
+		 * the statistics buffers of the application instead of it's own static objects.
+		 */
+		struct host
+		{
+			registry * reg = nullptr;
+
+			hooks::shared_state * hooks_state = nullptr;
+
+			statement_stats::shared_state * stats_state = nullptr;
+		};
+
+		typedef connection * (*factory)(std::shared_ptr<url> url_ptr, std::size_t timeout);
+
+		/**
+		 * register a backend in the constructor,used by the backend headers.
+		 */
+		struct registrar
+		{
+			registrar(const char * db_type, factory f, bool replace = false)
+			{
+				registry::instance().add(db_type, f, replace);
+			}
+		};
+
+		static registry & instance()
+		{
+			static registry r;
+			return r;
+		}
+
+		template<class T>
+		static connection * create(std::shared_ptr<url> url_ptr, std::size_t timeout)
+		{
+			return static_cast<connection *>(new T(url_ptr, timeout));
+		}
+
+		/**
+		 * Register the factory of a protocol.
+		 * @param replace If true the factory registered before is replaced,otherwise the factory
+		 * registered first is kept
+		 * @return true if the factory is registered
+		 */
+		bool add(const std::string & db_type, factory f, bool replace = false)
+		{
+			if (db_type.empty() || !f)
+				return false;
+
+			std::lock_guard<std::mutex> g(m_mtx);
+			auto it = m_factories.find(db_type);
+			if (it != m_factories.end() && !replace)
+				return false;
+			m_factories[db_type] = f;
+			return true;
+		}
+
+		/**
+		 * Register the factories of the other registry which are not registered in this registry.
+		 */
+		void merge(registry & other)
+		{
+			if (&other == this)
+				return;
+
+			std::unordered_map<std::string, factory> factories;
+			{
+				std::lock_guard<std::mutex> g(other.m_mtx);
+				factories = other.m_factories;
+			}
+
+			std::lock_guard<std::mutex> g(m_mtx);
+			for (auto & pair : factories)
+				m_factories.insert(pair);
+		}
+
+		/**
+		 * Get the factory of a protocol,and load the plugin of the protocol if it is not registered.
+		 * @param err The reason if the factory is not found
+		 * @return The factory or nullptr
+		 */
+		factory find(const std::string & db_type, std::string * err = nullptr)
+		{
+			factory f = get(db_type);
+			if (f)
+				return f;
+
+#if !defined(ZDB2_DISABLE_PLUGINS)
+			std::string e;
+			if (_load_plugin(db_type, e))
+				f = get(db_type);
+			if (!f && e.empty())
+				e = "the plugin doesn't provide the database type.";
+			if (!f && err)
+				*err = e;
+#else
+			if (err)
+				*err = "the database type is not registered.";
+#endif
+			return f;
+		}
+
+		/**
+		 * Get the factory of a protocol without loading any plugin.
+		 */
+		factory get(const std::string & db_type)
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			auto it = m_factories.find(db_type);
+			return (it != m_factories.end() ? it->second : nullptr);
+		}
+
+		std::vector<std::string> get_db_types()
+		{
+			std::vector<std::string> types;
+			std::lock_guard<std::mutex> g(m_mtx);
+			for (auto & pair : m_factories)
+				types.emplace_back(pair.first);
+			return types;
+		}
+
+#if !defined(ZDB2_DISABLE_PLUGINS)
+		/**
+		 * Add a directory which is searched for the plugins.
+		 */
+		void add_plugin_path(const std::string & dir)
+		{
+			std::lock_guard<std::mutex> g(m_load_mtx);
+			m_plugin_paths.emplace_back(dir);
+		}
+
+		/**
+		 * Load a plugin file explicitly,eg : "/opt/app/lib/libzdb2_mysql.so"
+		 * @param err The reason if the plugin can't be loaded
+		 * @return true if loaded
+		 */
+		bool load_plugin(const std::string & file, std::string * err = nullptr)
+		{
+			std::lock_guard<std::mutex> g(m_load_mtx);
+			std::string e;
+			bool ret = _open(file, e);
+			if (!ret && err)
+				*err = e;
+			return ret;
+		}
+#endif
+
+	protected:
+
+#if !defined(ZDB2_DISABLE_PLUGINS)
+		bool _load_plugin(const std::string & db_type, std::string & err)
+		{
+			// the loading is serialized,but the factories lock is not held,because the static
+			// registrars of the plugin may register into this registry while it is loaded
+			std::lock_guard<std::mutex> g(m_load_mtx);
+
+			if (get(db_type))
+				return true;
+
+			for (auto & c : db_type)
+			{
+				if (!std::isalnum((unsigned char)c) && c != '_')
+				{
+					err = "invalid database type.";
+					return false;
+				}
+			}
+
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_)
+			const char separator = ';';
+			std::string name = "zdb2_" + db_type + ".dll";
+#elif defined(__APPLE__)
+			const char separator = ':';
+			std::string name = "libzdb2_" + db_type + ".dylib";
+#else
+			const char separator = ':';
+			std::string name = "libzdb2_" + db_type + ".so";
+#endif
+
+			std::vector<std::string> dirs;
+			const char * env = std::getenv("ZDB2_PLUGIN_PATH");
+			if (env)
+			{
+				std::string paths(env);
+				std::size_t begin = 0;
+				while (begin <= paths.length())
+				{
+					std::size_t end = paths.find(separator, begin);
+					if (end == std::string::npos)
+						end = paths.length();
+					if (end > begin)
+						dirs.emplace_back(paths.substr(begin, end - begin));
+					begin = end + 1;
+				}
+			}
+			dirs.insert(dirs.end(), m_plugin_paths.begin(), m_plugin_paths.end());
+
+			for (auto & dir : dirs)
+			{
+				std::string file = dir;
+				if (file.back() != '/' && file.back() != '\\')
+					file += '/';
+				file += name;
+				if (_open(file, err))
+					return true;
+			}
+
+			// the default search path of the system
+			return _open(name, err);
+		}
+
+		bool _open(const std::string & file, std::string & err)
+		{
+			typedef int(*init_func)(const host *, int);
+
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_)
+			HMODULE handle = ::LoadLibraryA(file.c_str());
+			if (!handle)
+			{
+				err = "can't load the plugin " + file + " : error " + std::to_string(::GetLastError());
+				return false;
+			}
+			init_func init = (init_func)::GetProcAddress(handle, "zdb2_plugin_init");
+#else
+			void * handle = ::dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+			if (!handle)
+			{
+				const char * e = ::dlerror();
+				err = (e ? e : ("can't load the plugin " + file));
+				return false;
+			}
+			init_func init = (init_func)::dlsym(handle, "zdb2_plugin_init");
+#endif
+
+			// the plugin is never unloaded,even it's invalid,the static objects of it may have
+			// registered into this registry already
+			if (!init)
+			{
+				err = file + " is not a zdb2 plugin.";
+				return false;
+			}
+			host h;
+			h.reg = this;
+			h.hooks_state = hooks::get_shared_state();
+			h.stats_state = statement_stats::get_shared_state();
+			if (init(&h, ABI_VERSION) != 0)
+			{
+				err = file + " is built with a different version of zdb2.";
+				return false;
+			}
+			return true;
+		}
+#endif
+
+	protected:
+
+		std::mutex m_mtx;
+
+		std::unordered_map<std::string, factory> m_factories;
+
+#if !defined(ZDB2_DISABLE_PLUGINS)
+		/// serialize the loading of the plugins
+		std::mutex m_load_mtx;
+
+		std::vector<std::string> m_plugin_paths;
+#endif
+
+	};
+
+}
@@ -0,0 +1,853 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <stdexcept>
+
+#include <zdb2/db/connection.hpp>
+#include <zdb2/db/materialized_result.hpp>
+#include <zdb2/db/pool.hpp>
+#include <zdb2/db/sql_util.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * Route the statements to a primary pool and several replica pools,eg :
+	 *
+	 * auto r = std::make_shared<zdb2::router>(primary_pool, std::chrono::milliseconds(2000));
+	 * r->add_replica(replica1_pool, 2);
+	 * r->add_replica(replica2_pool, 1);
+	 * r->start_lag_monitor();                    // optional
+	 *
+	 * auto s = r->new_session();                 // one session per request or per user
+	 * s->execute("UPDATE user SET name='%s' WHERE id=%d", name, id);  // primary
+	 * auto rs = s->query("SELECT * FROM user WHERE id=%d", id);         // primary,pinned by the write
+	 *
+	 * The reads (see sql_util::is_read_only) go to the replicas by the weights,the writes go to
+	 * the primary.After a write,the reads of the same session go to the primary until the pin
+	 * time is elapsed,so the session always reads it's own writes.The transactions must be done
+	 * on the connection returned by session::get_write().If no replica is available the reads go
+	 * to the primary.
+	 *
+	 * When the lag monitor is started,the reads with a max lag (see set_max_lag) are not sent to
+	 * the replicas which are lagging more than it,or which lag is unknown.
+	 *
+	 * session::query_hedged() sends the query to a second replica when the first one doesn't
+	 * answer within it's p95 latency,the first result is used and the other query is canceled.
+	 */
+	class router : public std::enable_shared_from_this<router>
+	{
+	public:
+
+		class session
+		{
+		public:
+			session(std::shared_ptr<router> router_ptr) : m_router_ptr(router_ptr)
+			{
+				m_max_lag = m_router_ptr->get_max_lag();
+			}
+
+			/**
+			 * Get a connection for the statement,the statement is classified by it's text.
+			 */
+			std::shared_ptr<connection> get(const char * sql)
+			{
+				return (sql_util::is_read_only(sql) ? get_read() : get_write());
+			}
+
+			/**
+			 * Get a connection of a replica,or of the primary if the session is pinned,use it for
+			 * the reads which can't be classified by the text,eg : a stored procedure call.
+			 */
+			std::shared_ptr<connection> get_read()
+			{
+				if (is_pinned())
+					return m_router_ptr->get_primary();
+				return m_router_ptr->get_replica(m_max_lag);
+			}
+
+			/**
+			 * Get a connection of the primary for the writes and the transactions,the session is
+			 * pinned to the primary.
+			 */
+			std::shared_ptr<connection> get_write()
+			{
+				pin();
+				return m_router_ptr->get_primary();
+			}
+
+			/**
+			 * Pin the session to the primary from now on for the pin time of the router.
+			 */
+			void pin()
+			{
+				m_pinned_until = std::chrono::steady_clock::now() + m_router_ptr->get_pin_time();
+			}
+
+			bool is_pinned()
+			{
+				return (std::chrono::steady_clock::now() < m_pinned_until);
+			}
+
+			/**
+			 * Set the max replication lag of the replicas used by the reads of this session,0 means
+			 * no limit.The default value is router::get_max_lag().
+			 */
+			void set_max_lag(std::chrono::milliseconds max_lag)
+			{
+				m_max_lag = max_lag;
+			}
+
+			std::chrono::milliseconds get_max_lag()
+			{
+				return m_max_lag;
+			}
+
+			/**
+			 * Executes the query on the connection selected by the sql text,the rows are copied
+			 * into a materialized_result,so the connection is returned to it's pool at once.
+			 * @return The result,or nullptr if the query is failed or no connection is available,
+			 * the error can be got by get_last_error()
+			 */
+			template<typename... Args>
+			std::shared_ptr<materialized_result> query(const char * sql, Args... args)
+			{
+				std::shared_ptr<connection> conn = get(sql);
+				return _query(conn, sql, args...);
+			}
+
+			/**
+			 * Same as query(),but the query is executed on a replica even if it can't be
+			 * classified as read only.
+			 */
+			template<typename... Args>
+			std::shared_ptr<materialized_result> query_read(const char * sql, Args... args)
+			{
+				std::shared_ptr<connection> conn = get_read();
+				return _query(conn, sql, args...);
+			}
+
+			/**
+			 * Same as query_read(),but if the replica doesn't answer within it's p95 latency the
+			 * query is sent to another replica too,the first result is returned and the other
+			 * query is canceled by connection::cancel().
+			 */
+			template<typename... Args>
+			std::shared_ptr<materialized_result> query_hedged(const char * sql, Args... args)
+			{
+				if (is_pinned())
+				{
+					std::shared_ptr<connection> conn = m_router_ptr->get_primary();
+					return _query(conn, sql, args...);
+				}
+
+				// the sql is formatted here,because the losing query may be executed after this
+				// function is returned
+				return m_router_ptr->hedged_query(sql_util::format(sql, args...), m_max_lag, m_error);
+			}
+
+			/**
+			 * Executes the statement on the connection selected by the sql text.
+			 * @return true if succeeded,the rows changed can be got by rows_changed()
+			 */
+			template<typename... Args>
+			bool execute(const char * sql, Args... args)
+			{
+				std::shared_ptr<connection> conn = get(sql);
+				if (!conn)
+				{
+					m_error = "no available connection in the pool.";
+					return false;
+				}
+
+				if (!conn->execute(sql, args...))
+				{
+					const char * err = conn->get_last_error();
+					m_error = ((err && err[0] != '\0') ? err : "unknown database error.");
+					return false;
+				}
+
+				m_rows_changed = conn->rows_changed();
+				return true;
+			}
+
+			int64_t rows_changed()
+			{
+				return m_rows_changed;
+			}
+
+			const char * get_last_error()
+			{
+				return m_error.c_str();
+			}
+
+		protected:
+			template<typename... Args>
+			std::shared_ptr<materialized_result> _query(std::shared_ptr<connection> & conn, const char * sql, Args... args)
+			{
+				if (!conn)
+				{
+					m_error = "no available connection in the pool.";
+					return nullptr;
+				}
+
+				std::shared_ptr<resultset> rs = conn->query(sql, args...);
+				if (!rs)
+				{
+					const char * err = conn->get_last_error();
+					m_error = ((err && err[0] != '\0') ? err : "unknown database error.");
+					return nullptr;
+				}
+				return materialized_result::materialize(rs);
+			}
+
+		protected:
+			std::shared_ptr<router> m_router_ptr;
+
+			std::chrono::steady_clock::time_point m_pinned_until;
+
+			std::chrono::milliseconds m_max_lag{ 0 };
+
+			int64_t m_rows_changed = 0;
+
+			std::string m_error;
+		};
+
+	public:
+		/**
+		 * @param primary_ptr The pool of the primary
+		 * @param pin_time How long the reads of a session go to the primary after a write,it
+		 * should be longer than the usual replication delay
+		 */
+		router(
+			std::shared_ptr<pool> primary_ptr,
+			std::chrono::milliseconds pin_time = std::chrono::milliseconds(1000)
+		)
+			: m_primary_ptr(primary_ptr)
+			, m_pin_time(pin_time)
+		{
+			if (!m_primary_ptr)
+				throw std::runtime_error("invalid parameters.");
+		}
+
+		virtual ~router()
+		{
+			stop_lag_monitor();
+		}
+
+		/**
+		 * Add a replica pool,the reads are distributed to the replicas by the weights.
+		 */
+		void add_replica(std::shared_ptr<pool> pool_ptr, std::size_t weight = 1)
+		{
+			if (!pool_ptr || weight == 0)
+				throw std::runtime_error("invalid parameters.");
+
+			std::shared_ptr<replica> r = std::make_shared<replica>();
+			r->pool_ptr = pool_ptr;
+			r->weight = (int64_t)weight;
+
+			std::lock_guard<std::mutex> g(m_mtx);
+			m_replicas.emplace_back(r);
+		}
+
+		std::size_t get_replica_count()
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			return m_replicas.size();
+		}
+
+		/**
+		 * Get the replication lag of a replica in milliseconds which is checked by the lag
+		 * monitor,-1 means unknown or the replication is stopped.
+		 */
+		int64_t get_replica_lag(std::size_t index)
+		{
+			std::lock_guard<std::mutex> g(m_mtx);
+			if (index >= m_replicas.size())
+				throw std::runtime_error("the replica index is out of range.");
+			return m_replicas[index]->lag_ms;
+		}
+
+		/**
+		 * Get the p95 latency of the reads of a replica in microseconds,0 means no enough samples.
+		 */
+		int64_t get_replica_p95(std::size_t index)
+		{
+			std::shared_ptr<replica> r;
+			{
+				std::lock_guard<std::mutex> g(m_mtx);
+				if (index >= m_replicas.size())
+					throw std::runtime_error("the replica index is out of range.");
+				r = m_replicas[index];
+			}
+			return r->get_p95();
+		}
+
+		std::shared_ptr<pool> get_primary_pool()
+		{
+			return m_primary_ptr;
+		}
+
+		std::chrono::milliseconds get_pin_time()
+		{
+			return m_pin_time;
+		}
+
+		/**
+		 * Set the default max replication lag of the new sessions,0 means no limit.
+		 */
+		void set_max_lag(std::chrono::milliseconds max_lag)
+		{
+			m_max_lag_ms = (int64_t)max_lag.count();
+		}
+
+		std::chrono::milliseconds get_max_lag()
+		{
+			return std::chrono::milliseconds(m_max_lag_ms.load());
+		}
+
+		/**
+		 * Set the hedge delay used before a replica has enough latency samples,and the lower
+		 * limit of the hedge delay.
+		 */
+		void set_hedge_delay(std::chrono::microseconds default_delay, std::chrono::microseconds min_delay)
+		{
+			m_hedge_delay_us = (int64_t)default_delay.count();
+			m_min_hedge_delay_us = (int64_t)min_delay.count();
+		}
+
+		/**
+		 * Get the count of the hedged queries which are sent,and which second query won.
+		 */
+		uint64_t get_hedge_count()     { return m_hedge_count;     }
+		uint64_t get_hedge_win_count() { return m_hedge_win_count; }
+
+		std::shared_ptr<session> new_session()
+		{
+			return std::make_shared<session>(this->shared_from_this());
+		}
+
+		std::shared_ptr<connection> get_primary()
+		{
+			return m_primary_ptr->get();
+		}
+
+		/**
+		 * Get a connection of a replica selected by the weights,when the pool of the selected
+		 * replica is exhausted or failed the other replicas are tried,and then the primary.
+		 * @param max_lag The replicas which lag is greater than it or unknown are skipped,0 means
+		 * no limit
+		 */
+		std::shared_ptr<connection> get_replica(std::chrono::milliseconds max_lag = std::chrono::milliseconds(0))
+		{
+			std::vector<std::shared_ptr<replica>> order = _replica_order(max_lag);
+			for (auto & r : order)
+			{
+				try
+				{
+					std::shared_ptr<connection> conn = r->pool_ptr->get();
+					if (conn)
+						return conn;
+				}
+				catch (std::exception &)
+				{
+				}
+			}
+			return m_primary_ptr->get();
+		}
+
+		/**
+		 * Start a thread which checks the replication lag of every replica periodically.
+		 * @param lag_sql The query which returns the lag in seconds in the first column,if it is
+		 * empty the query is selected by the database type :
+		 * mysql      - SHOW REPLICA STATUS (SHOW SLAVE STATUS for the old servers),Seconds_Behind_Source
+		 * postgresql - now() - pg_last_xact_replay_timestamp(),0 if all the received WAL is replayed
+		 * A NULL value or no row means the replication is stopped,the lag is set to -1.
+		 */
+		void start_lag_monitor(
+			std::chrono::milliseconds interval = std::chrono::milliseconds(1000),
+			const std::string & lag_sql = std::string())
+		{
+			std::lock_guard<std::mutex> g(m_monitor_mtx);
+			if (m_monitor_thread_ptr)
+				return;
+
+			m_monitor_stopped = false;
+			m_monitor_thread_ptr = std::make_shared<std::thread>([this, interval, lag_sql]()
+			{
+				while (true)
+				{
+					_check_lags(lag_sql);
+
+					std::unique_lock<std::mutex> lck(m_monitor_mtx);
+					if (m_monitor_cv.wait_for(lck, interval, [this]() { return m_monitor_stopped; }))
+						break;
+				}
+			});
+		}
+
+		void stop_lag_monitor()
+		{
+			std::shared_ptr<std::thread> thread_ptr;
+			{
+				std::lock_guard<std::mutex> g(m_monitor_mtx);
+				m_monitor_stopped = true;
+				m_monitor_cv.notify_all();
+				thread_ptr = m_monitor_thread_ptr;
+				m_monitor_thread_ptr.reset();
+			}
+			if (thread_ptr && thread_ptr->joinable())
+				thread_ptr->join();
+		}
+
+		/**
+		 * Executes the query on a replica,and on another replica too if the first one doesn't
+		 * answer within the hedge delay,see session::query_hedged().
+		 * @param sql The formatted SQL
+		 * @param err The error if the query is failed
+		 */
+		std::shared_ptr<materialized_result> hedged_query(const std::string & sql, std::chrono::milliseconds max_lag, std::string & err)
+		{
+			std::vector<std::shared_ptr<replica>> order = _replica_order(max_lag);
+			if (order.size() < 2)
+			{
+				// nothing to hedge
+				std::shared_ptr<replica> r = (order.empty() ? nullptr : order[0]);
+				std::shared_ptr<connection> conn = (r ? _get(r) : nullptr);
+				if (!conn)
+				{
+					r.reset();
+					conn = m_primary_ptr->get();
+				}
+				return _run(r, conn, sql, err);
+			}
+
+			std::shared_ptr<race> race_ptr = std::make_shared<race>();
+
+			_start(race_ptr, order[0], 0, sql);
+
+			int64_t delay_us = m_hedge_delay_us;
+			int64_t p95 = order[0]->get_p95();
+			if (p95 > 0)
+				delay_us = p95;
+			std::chrono::microseconds delay((std::max)(delay_us, m_min_hedge_delay_us.load()));
+
+			std::unique_lock<std::mutex> lck(race_ptr->mtx);
+
+			// send the second query when the first one is slow or failed
+			race_ptr->cv.wait_for(lck, delay, [&race_ptr]() { return race_ptr->finished > 0; });
+			if (!race_ptr->result)
+			{
+				lck.unlock();
+				m_hedge_count++;
+				_start(race_ptr, order[1], 1, sql);
+				lck.lock();
+			}
+
+			race_ptr->cv.wait(lck, [&race_ptr]() { return race_ptr->result || race_ptr->finished == race_ptr->started; });
+
+			std::shared_ptr<materialized_result> result = race_ptr->result;
+			if (result && race_ptr->winner == 1)
+				m_hedge_win_count++;
+			if (!result)
+				err = race_ptr->error;
+
+			std::vector<std::size_t> losers;
+			for (std::size_t i = 0; i < 2; i++)
+			{
+				if (race_ptr->conns[i])
+					losers.emplace_back(i);
+			}
+			lck.unlock();
+
+			// the cancel may need a new connection (eg : KILL QUERY of mysql),so it's done in the
+			// executor of the pool and the result is returned without waiting for it
+			for (std::size_t i : losers)
+				_cancel(race_ptr, i);
+
+			return result;
+		}
+
+	protected:
+
+		struct replica
+		{
+			std::shared_ptr<pool> pool_ptr;
+
+			/// the weights of the smooth weighted round robin,protected by the router mutex
+			int64_t weight = 1;
+			int64_t current_weight = 0;
+
+			/// the replication lag in milliseconds,-1 means unknown or the replication is stopped
+			std::atomic<int64_t> lag_ms{ -1 };
+
+			/// the latency samples of the reads in microseconds
+			std::mutex latency_mtx;
+			std::vector<uint32_t> samples;
+			std::size_t next_sample = 0;
+			std::size_t new_samples = 0;
+			int64_t p95 = 0;
+
+			enum { MAX_SAMPLES = 256, MIN_SAMPLES = 32 };
+
+			void add_sample(std::chrono::steady_clock::duration elapsed)
+			{
+				int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+				uint32_t v = (uint32_t)(std::min)(us, (int64_t)UINT32_MAX);
+
+				std::lock_guard<std::mutex> g(latency_mtx);
+				if (samples.size() < MAX_SAMPLES)
+					samples.emplace_back(v);
+				else
+					samples[next_sample] = v;
+				next_sample = (next_sample + 1) % MAX_SAMPLES;
+
+				// the percentile is recalculated every 16 samples
+				if (samples.size() >= MIN_SAMPLES && ++new_samples >= 16)
+				{
+					new_samples = 0;
+					std::vector<uint32_t> sorted(samples);
+					std::size_t n = sorted.size() * 95 / 100;
+					std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+					p95 = sorted[n];
+				}
+			}
+
+			int64_t get_p95()
+			{
+				std::lock_guard<std::mutex> g(latency_mtx);
+				return p95;
+			}
+		};
+
+		/**
+		 * the state of a hedged query.
+		 */
+		struct race
+		{
+			std::mutex mtx;
+			std::condition_variable cv;
+
+			/// the connections which are executing the query
+			std::shared_ptr<connection> conns[2];
+
+			/// the pools of the queries,the losers are canceled in their executors
+			std::shared_ptr<pool> pools[2];
+
+			std::size_t started = 0;
+			std::size_t finished = 0;
+			std::size_t winner = 0;
+
+			std::shared_ptr<materialized_result> result;
+			std::string error;
+		};
+
+		std::shared_ptr<connection> _get(std::shared_ptr<replica> & r)
+		{
+			try
+			{
+				return r->pool_ptr->get();
+			}
+			catch (std::exception &)
+			{
+			}
+			return nullptr;
+		}
+
+		std::shared_ptr<materialized_result> _run(std::shared_ptr<replica> r, std::shared_ptr<connection> & conn,
+			const std::string & sql, std::string & err)
+		{
+			if (!conn)
+			{
+				err = "no available connection in the pool.";
+				return nullptr;
+			}
+
+			auto begin = std::chrono::steady_clock::now();
+			std::shared_ptr<resultset> rs = conn->query("%s", sql.c_str());
+			if (!rs)
+			{
+				const char * e = conn->get_last_error();
+				err = ((e && e[0] != '\0') ? e : "unknown database error.");
+				return nullptr;
+			}
+
+			std::shared_ptr<materialized_result> result = materialized_result::materialize(rs);
+			if (r)
+				r->add_sample(std::chrono::steady_clock::now() - begin);
+			return result;
+		}
+
+		void _start(std::shared_ptr<race> race_ptr, std::shared_ptr<replica> r, std::size_t index, const std::string & sql)
+		{
+			{
+				std::lock_guard<std::mutex> g(race_ptr->mtx);
+				race_ptr->started++;
+				race_ptr->pools[index] = r->pool_ptr;
+			}
+
+			auto task = [race_ptr, r, index, sql]()
+			{
+				bool won = false;
+				{
+					std::lock_guard<std::mutex> g(race_ptr->mtx);
+					won = (race_ptr->result != nullptr);
+				}
+
+				// the get() may open a new connection,the race lock is not held,otherwise the other
+				// replica and the waiting caller are blocked by the slow connect
+				std::shared_ptr<connection> conn;
+				if (!won)
+				{
+					try
+					{
+						conn = r->pool_ptr->get();
+					}
+					catch (std::exception &)
+					{
+					}
+				}
+
+				{
+					std::lock_guard<std::mutex> g(race_ptr->mtx);
+					won = (race_ptr->result != nullptr);
+					if (won)
+					{
+						race_ptr->finished++;
+						race_ptr->cv.notify_all();
+					}
+					else
+					{
+						race_ptr->conns[index] = conn;
+					}
+				}
+
+				// the race is won by the other replica,the connection is returned to the pool
+				if (won)
+					return;
+
+				std::string err;
+				std::shared_ptr<materialized_result> result;
+				if (conn)
+				{
+					auto begin = std::chrono::steady_clock::now();
+					try
+					{
+						std::shared_ptr<resultset> rs = conn->query("%s", sql.c_str());
+						if (rs)
+							result = materialized_result::materialize(rs);
+						else
+							err = (conn->get_last_error() ? conn->get_last_error() : "");
+					}
+					catch (std::exception & e)
+					{
+						// eg : the loser is canceled,or the connection is lost while the rows are read
+						err = e.what();
+					}
+					if (result)
+						r->add_sample(std::chrono::steady_clock::now() - begin);
+				}
+				else
+				{
+					err = "no available connection in the pool.";
+				}
+
+				std::lock_guard<std::mutex> g(race_ptr->mtx);
+				race_ptr->conns[index].reset();
+				race_ptr->finished++;
+				if (result && !race_ptr->result)
+				{
+					race_ptr->result = result;
+					race_ptr->winner = index;
+				}
+				else if (!result && race_ptr->error.empty())
+				{
+					race_ptr->error = (err.empty() ? "unknown database error." : err);
+				}
+				race_ptr->cv.notify_all();
+			};
+
+			std::shared_ptr<executor> executor_ptr = r->pool_ptr->get_executor();
+			if (executor_ptr && executor_ptr->post(task))
+				return;
+
+			std::lock_guard<std::mutex> g(race_ptr->mtx);
+			race_ptr->finished++;
+			if (race_ptr->error.empty())
+				race_ptr->error = "the async task queue of the pool is full.";
+			race_ptr->cv.notify_all();
+		}
+
+		void _cancel(std::shared_ptr<race> race_ptr, std::size_t index)
+		{
+			std::shared_ptr<executor> executor_ptr = race_ptr->pools[index]->get_executor();
+			if (!executor_ptr)
+				return;
+
+			// if the task can't be posted,the loser is not canceled and runs to the end
+			executor_ptr->post([race_ptr, index]()
+			{
+				// the connection is returned to the pool after it is removed from the race,so the
+				// statement of another user can't be canceled here
+				std::lock_guard<std::mutex> g(race_ptr->mtx);
+				if (race_ptr->conns[index])
+					race_ptr->conns[index]->cancel();
+			});
+		}
+
+		/**
+		 * the replicas in the order of trying,the first one is selected by the smooth weighted
+		 * round robin,so the reads of a replica which weight is 2 are not sent in a burst.
+		 */
+		std::vector<std::shared_ptr<replica>> _replica_order(std::chrono::milliseconds max_lag)
+		{
+			std::vector<std::shared_ptr<replica>> order;
+
+			std::lock_guard<std::mutex> g(m_mtx);
+
+			std::vector<std::shared_ptr<replica>> candidates;
+			for (auto & r : m_replicas)
+			{
+				int64_t lag = r->lag_ms;
+				if (max_lag.count() > 0 && (lag < 0 || lag > max_lag.count()))
+					continue;
+				candidates.emplace_back(r);
+			}
+			if (candidates.empty())
+				return order;
+
+			int64_t total = 0;
+			std::size_t best = 0;
+			for (std::size_t i = 0; i < candidates.size(); i++)
+			{
+				replica & r = *candidates[i];
+				r.current_weight += r.weight;
+				total += r.weight;
+				if (r.current_weight > candidates[best]->current_weight)
+					best = i;
+			}
+			candidates[best]->current_weight -= total;
+
+			order.reserve(candidates.size());
+			for (std::size_t n = 0; n < candidates.size(); n++)
+				order.emplace_back(candidates[(best + n) % candidates.size()]);
+			return order;
+		}
+
+		void _check_lags(const std::string & lag_sql)
+		{
+			std::vector<std::shared_ptr<replica>> replicas;
+			{
+				std::lock_guard<std::mutex> g(m_mtx);
+				replicas = m_replicas;
+			}
+
+			for (auto & r : replicas)
+			{
+				int64_t lag = -1;
+				try
+				{
+					bool exhausted = false;
+					std::shared_ptr<connection> conn = r->pool_ptr->try_get(exhausted);
+
+					// all the connections are busy,no probe is made,keep the previous lag so a
+					// healthy replica isn't dropped from the lag bounded reads
+					if (!conn && exhausted)
+						continue;
+
+					if (conn)
+						lag = _query_lag(conn, r->pool_ptr->get_url()->get_dbtype(), lag_sql);
+				}
+				catch (std::exception &)
+				{
+				}
+				r->lag_ms = lag;
+			}
+		}
+
+		static int64_t _query_lag(std::shared_ptr<connection> & conn, const std::string & dbtype, const std::string & lag_sql)
+		{
+			std::shared_ptr<resultset> rs;
+			const char * column = nullptr;
+
+			if (!lag_sql.empty())
+			{
+				rs = conn->query("%s", lag_sql.c_str());
+			}
+			else if (dbtype == "mysql")
+			{
+				rs = conn->query("SHOW REPLICA STATUS");
+				column = "Seconds_Behind_Source";
+				if (!rs)
+				{
+					rs = conn->query("SHOW SLAVE STATUS");
+					column = "Seconds_Behind_Master";
+				}
+			}
+			else if (dbtype == "postgresql")
+			{
+				rs = conn->query(
+					"SELECT CASE WHEN pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() THEN 0 "
+					"ELSE EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()) END");
+			}
+
+			if (!rs || !rs->next_row())
+				return -1;
+
+			int index = (column ? rs->get_column_index(column) : 0);
+			if (index < 0 || rs->is_null(index))
+				return -1;
+
+			double seconds = rs->get_double(index);
+			return (seconds < 0 ? -1 : (int64_t)(seconds * 1000));
+		}
+
+	protected:
+
+		std::shared_ptr<pool> m_primary_ptr;
+
+		std::chrono::milliseconds m_pin_time;
+
+		/// the milliseconds,it may be set while the other threads are creating the sessions
+		std::atomic<int64_t> m_max_lag_ms{ 0 };
+
+		/// the microseconds,see set_hedge_delay()
+		std::atomic<int64_t> m_hedge_delay_us{ 50000 };
+		std::atomic<int64_t> m_min_hedge_delay_us{ 1000 };
+
+		std::atomic<uint64_t> m_hedge_count{ 0 };
+		std::atomic<uint64_t> m_hedge_win_count{ 0 };
+
+		std::mutex m_mtx;
+
+		std::vector<std::shared_ptr<replica>> m_replicas;
+
+		/// the lag monitor thread
+		std::shared_ptr<std::thread> m_monitor_thread_ptr;
+		std::mutex m_monitor_mtx;
+		std::condition_variable m_monitor_cv;
+		bool m_monitor_stopped = false;
+
+	};
+
+}
@@ -0,0 +1,206 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+
+#include <zdb2/db/connection.hpp>
+#include <zdb2/db/pool.hpp>
+#include <zdb2/db/sql_util.hpp>
+#include <zdb2/db/merged_resultset.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * Execute the same query on several pools or connections at the same time,and merge the
+	 * results into one ResultSet,eg :
+	 *
+	 * // the top 10 orders of all the shards
+	 * zdb2::scatter_gather sg;
+	 * for (auto & pool_ptr : shard_pools)
+	 *     sg.add_source(pool_ptr);
+	 * sg.order_by(2, zdb2::merged_resultset::as_double, true).limit(10);
+	 * auto rs = sg.query("SELECT id,user_id,amount FROM orders ORDER BY amount DESC LIMIT 10");
+	 *
+	 * // the order count and the total amount of every user of all the shards
+	 * zdb2::scatter_gather sg2;
+	 * ...
+	 * sg2.aggregate({ zdb2::merged_resultset::group_by, zdb2::merged_resultset::count, zdb2::merged_resultset::sum });
+	 * auto rs2 = sg2.query("SELECT user_id,COUNT(*),SUM(amount) FROM orders GROUP BY user_id");
+	 *
+	 * Every source is queried by a thread of the merged_resultset,a pool source checks out one
+	 * connection for the query,a connection source must not be used by others until the
+	 * merged_resultset is closed.The SQL should contain the ORDER BY and the LIMIT (offset + limit)
+	 * itself,so every database sorts and limits it's own rows.AVG can't be combined,query the SUM
+	 * and the COUNT instead.
+	 */
+	class scatter_gather
+	{
+	public:
+		scatter_gather()
+		{
+		}
+
+		scatter_gather & add_source(std::shared_ptr<pool> pool_ptr)
+		{
+			if (!pool_ptr)
+				throw std::runtime_error("invalid parameters.");
+			m_pools.emplace_back(pool_ptr);
+			m_conns.emplace_back(nullptr);
+			return (*this);
+		}
+
+		scatter_gather & add_source(std::shared_ptr<connection> conn_ptr)
+		{
+			if (!conn_ptr)
+				throw std::runtime_error("invalid parameters.");
+			m_pools.emplace_back(nullptr);
+			m_conns.emplace_back(conn_ptr);
+			return (*this);
+		}
+
+		/**
+		 * Merge the rows by the column,every source must return the rows sorted by the same order,
+		 * can be called several times for several columns.
+		 * @param type How the values are compared,it must be the same order as the ORDER BY of the
+		 * sources,eg : as_text for a TEXT column,as_int for an INTEGER column
+		 */
+		scatter_gather & order_by(int column, merged_resultset::value_type type, bool descending = false)
+		{
+			merged_resultset::order_key key;
+			key.column = column;
+			key.descending = descending;
+			key.type = type;
+			m_order_keys.emplace_back(key);
+			return (*this);
+		}
+
+		/**
+		 * The same as above,the values are compared by the collation function,eg : the collation
+		 * of the ORDER BY column is case insensitive.
+		 */
+		scatter_gather & order_by(int column, merged_resultset::collation_func collation, bool descending = false)
+		{
+			merged_resultset::order_key key;
+			key.column = column;
+			key.descending = descending;
+			key.type = merged_resultset::as_collation;
+			key.collation = collation;
+			m_order_keys.emplace_back(key);
+			return (*this);
+		}
+
+		/**
+		 * Return at most limit rows after skipping offset rows of the merged rows.
+		 */
+		scatter_gather & limit(std::size_t limit, std::size_t offset = 0)
+		{
+			m_limit = limit;
+			m_offset = offset;
+			return (*this);
+		}
+
+		/**
+		 * Combine the partial aggregates of the sources,there must be one function for every column.
+		 * @param types The value types of the columns,MIN and MAX compare the values by them,if it's
+		 * empty,the MIN and MAX columns must be order keys
+		 */
+		scatter_gather & aggregate(const std::vector<merged_resultset::aggregate_func> & funcs,
+			const std::vector<merged_resultset::value_type> & types = std::vector<merged_resultset::value_type>())
+		{
+			m_funcs = funcs;
+			m_types = types;
+			return (*this);
+		}
+
+		/**
+		 * Set the rows of every chunk fetched from a source,the fetching thread of a source stops
+		 * when 4 chunks are not read yet.
+		 */
+		scatter_gather & set_chunk_rows(std::size_t chunk_rows)
+		{
+			m_chunk_rows = (chunk_rows == 0 ? 1 : chunk_rows);
+			return (*this);
+		}
+
+		/**
+		 * Executes the query on all the sources,the sql and args are the same as connection::query().
+		 * @return The merged ResultSet,it's returned after every source has returned it's first
+		 * rows,or nullptr if any source is failed,the error can be got by get_last_error()
+		 */
+		template<typename... Args>
+		std::shared_ptr<merged_resultset> query(const char * sql, Args... args)
+		{
+			if (m_pools.empty())
+			{
+				m_error = "no source to query.";
+				return nullptr;
+			}
+
+			merged_resultset::mode mode = merged_resultset::concat;
+			if (!m_funcs.empty())
+				mode = merged_resultset::aggregate;
+			else if (!m_order_keys.empty())
+				mode = merged_resultset::merge;
+
+			std::shared_ptr<merged_resultset> rs = std::make_shared<merged_resultset>(
+				mode, m_order_keys, m_funcs, m_limit, m_offset, m_types);
+
+			std::string str = sql_util::format(sql, args...);
+			for (std::size_t i = 0; i < m_pools.size(); i++)
+			{
+				std::shared_ptr<pool> pool_ptr = m_pools[i];
+				std::shared_ptr<connection> conn_ptr = m_conns[i];
+				rs->add_stream([pool_ptr, conn_ptr]()
+				{
+					return (pool_ptr ? pool_ptr->get() : conn_ptr);
+				}, str, m_chunk_rows);
+			}
+
+			if (!rs->start())
+			{
+				m_error = rs->get_last_error();
+				return nullptr;
+			}
+			return rs;
+		}
+
+		const char * get_last_error()
+		{
+			return m_error.c_str();
+		}
+
+	protected:
+
+		std::vector<std::shared_ptr<pool>> m_pools;
+		std::vector<std::shared_ptr<connection>> m_conns;
+
+		std::vector<merged_resultset::order_key> m_order_keys;
+
+		std::vector<merged_resultset::aggregate_func> m_funcs;
+
+		std::vector<merged_resultset::value_type> m_types;
+
+		std::size_t m_limit = (std::numeric_limits<std::size_t>::max)();
+		std::size_t m_offset = 0;
+
+		std::size_t m_chunk_rows = 256;
+
+		std::string m_error;
+
+	};
+
+}
@@ -0,0 +1,275 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+#include <zdb2/db/pool.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * The counters of a shard,they are kept when the shard map is updated and the shard name is
+	 * not changed.
+	 */
+	struct shard_stats
+	{
+		/// the connections checked out of the shard
+		std::atomic<uint64_t> checkouts{ 0 };
+
+		/// the checkouts which got no connection,the pool is exhausted or the database is down
+		std::atomic<uint64_t> failures{ 0 };
+	};
+
+	/**
+	 * Map the shard keys to the pools,eg :
+	 *
+	 * auto map_ptr = std::make_shared<zdb2::shard_map>(zdb2::shard_map::consistent_hash);
+	 * map_ptr->add_shard("shard00", pool00);
+	 * map_ptr->add_shard("shard01", pool01);
+	 *
+	 * auto map_ptr = std::make_shared<zdb2::shard_map>(zdb2::shard_map::range);
+	 * map_ptr->add_shard("shard00", pool00);
+	 * map_ptr->add_shard("shard01", pool01);
+	 * map_ptr->add_range(0, "shard00");          // [0,1000000)
+	 * map_ptr->add_range(1000000, "shard01");    // [1000000,...)
+	 *
+	 * consistent_hash : every shard has (vnodes * weight) points on a hash ring,the key is hashed
+	 *                   onto the ring and belongs to the next point,so when a shard is added only
+	 *                   about 1/n of the keys are moved to it.The hash is FNV-1a with the murmur3
+	 *                   finalizer,it's the same on all the platforms,and an integer key is hashed
+	 *                   as it's decimal string.
+	 * range           : the key belongs to the range which lower bound is the greatest one not
+	 *                   greater than the key,only the integer keys are supported.
+	 *
+	 * The map is not changed after it's given to the shard_router,build a new map and call
+	 * shard_router::update() to change the shards.
+	 */
+	class shard_map
+	{
+	public:
+
+		enum strategy
+		{
+			consistent_hash,
+			range,
+		};
+
+		struct shard
+		{
+			std::string name;
+			std::shared_ptr<pool> pool_ptr;
+			std::size_t weight = 1;
+			std::shared_ptr<shard_stats> stats_ptr;
+		};
+
+		shard_map(strategy s = consistent_hash, std::size_t vnodes = 160)
+			: m_strategy(s)
+			, m_vnodes(vnodes)
+		{
+			if (m_vnodes == 0)
+				throw std::runtime_error("invalid parameters.");
+		}
+
+		strategy get_strategy() const
+		{
+			return m_strategy;
+		}
+
+		/**
+		 * Add a shard.
+		 * @param weight The count of the points on the hash ring is multiplied by it,it's not used
+		 * by the range strategy
+		 * @return The shard index
+		 */
+		std::size_t add_shard(const std::string & name, std::shared_ptr<pool> pool_ptr, std::size_t weight = 1)
+		{
+			if (name.empty() || !pool_ptr || weight == 0)
+				throw std::runtime_error("invalid parameters.");
+			if (find_shard(name) >= 0)
+				throw std::runtime_error("the shard " + name + " exists already.");
+
+			shard s;
+			s.name = name;
+			s.pool_ptr = pool_ptr;
+			s.weight = weight;
+			s.stats_ptr = std::make_shared<shard_stats>();
+			m_shards.emplace_back(s);
+
+			std::size_t index = m_shards.size() - 1;
+			if (m_strategy == consistent_hash)
+			{
+				for (std::size_t i = 0; i < m_vnodes * weight; i++)
+					m_ring.emplace_back(hash(name + "#" + std::to_string(i)), index);
+
+				// the points are sorted by the hash,and then by the name,so the ring is the same
+				// whatever the order of the shards is added
+				std::sort(m_ring.begin(), m_ring.end(), [this](const point & a, const point & b)
+				{
+					if (a.first != b.first)
+						return a.first < b.first;
+					return m_shards[a.second].name < m_shards[b.second].name;
+				});
+			}
+			return index;
+		}
+
+		/**
+		 * Add a range of the range strategy,the range ends at the lower bound of the next range.
+		 */
+		void add_range(int64_t lower, const std::string & name)
+		{
+			if (m_strategy != range)
+				throw std::runtime_error("the shard map is not a range map.");
+
+			int index = find_shard(name);
+			if (index < 0)
+				throw std::runtime_error("the shard " + name + " doesn't exist.");
+
+			auto it = std::lower_bound(m_ranges.begin(), m_ranges.end(), lower,
+				[](const std::pair<int64_t, std::size_t> & r, int64_t v) { return r.first < v; });
+			if (it != m_ranges.end() && it->first == lower)
+				throw std::runtime_error("the range exists already.");
+			m_ranges.emplace(it, lower, (std::size_t)index);
+		}
+
+		/**
+		 * Get the shard index of a key.
+		 * @return The shard index,or -1 if the key belongs to no shard
+		 */
+		int locate(const std::string & key) const
+		{
+			if (m_strategy == range)
+			{
+				char * end = nullptr;
+				long long v = std::strtoll(key.c_str(), &end, 10);
+				if (key.empty() || !end || *end != '\0')
+					throw std::runtime_error("the range shard map requires integer keys.");
+				return _locate_range((int64_t)v);
+			}
+			return _locate_hash(hash(key));
+		}
+
+		int locate(int64_t key) const
+		{
+			if (m_strategy == range)
+				return _locate_range(key);
+			return _locate_hash(hash(std::to_string(key)));
+		}
+
+		int find_shard(const std::string & name) const
+		{
+			for (std::size_t i = 0; i < m_shards.size(); i++)
+			{
+				if (m_shards[i].name == name)
+					return (int)i;
+			}
+			return -1;
+		}
+
+		std::size_t get_shard_count() const
+		{
+			return m_shards.size();
+		}
+
+		const shard & get_shard(std::size_t index) const
+		{
+			if (index >= m_shards.size())
+				throw std::runtime_error("the shard index is out of range.");
+			return m_shards[index];
+		}
+
+		/**
+		 * Use the stats of the shards which have the same name in the old map,so the counters are
+		 * not reset by the updating.
+		 */
+		void inherit_stats(const shard_map & old_map)
+		{
+			for (auto & s : m_shards)
+			{
+				int index = old_map.find_shard(s.name);
+				if (index >= 0)
+					s.stats_ptr = old_map.m_shards[index].stats_ptr;
+			}
+		}
+
+		/**
+		 * The 64 bits hash of the keys and the points on the ring.
+		 */
+		static uint64_t hash(const std::string & key)
+		{
+			uint64_t h = 14695981039346656037ULL;
+			for (unsigned char c : key)
+			{
+				h ^= c;
+				h *= 1099511628211ULL;
+			}
+
+			// the FNV-1a hash of the similar strings are close,mix the bits
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdULL;
+			h ^= h >> 33;
+			h *= 0xc4ceb9fe1a85ec53ULL;
+			h ^= h >> 33;
+			return h;
+		}
+
+	protected:
+
+		typedef std::pair<uint64_t, std::size_t> point;
+
+		int _locate_hash(uint64_t h) const
+		{
+			if (m_ring.empty())
+				return -1;
+
+			auto it = std::lower_bound(m_ring.begin(), m_ring.end(), h,
+				[](const point & p, uint64_t v) { return p.first < v; });
+			if (it == m_ring.end())
+				it = m_ring.begin();
+			return (int)it->second;
+		}
+
+		int _locate_range(int64_t key) const
+		{
+			auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), key,
+				[](int64_t v, const std::pair<int64_t, std::size_t> & r) { return v < r.first; });
+			if (it == m_ranges.begin())
+				return -1;
+			--it;
+			return (int)it->second;
+		}
+
+	protected:
+
+		strategy m_strategy = consistent_hash;
+
+		std::size_t m_vnodes = 160;
+
+		std::vector<shard> m_shards;
+
+		/// the points of the hash ring,sorted by the hash
+		std::vector<point> m_ring;
+
+		/// the lower bounds of the ranges,sorted
+		std::vector<std::pair<int64_t, std::size_t>> m_ranges;
+
+	};
+
+}
@@ -0,0 +1,229 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+
+#include <zdb2/db/connection.hpp>
+#include <zdb2/db/pool.hpp>
+#include <zdb2/db/shard_map.hpp>
+#include <zdb2/util/br_rwlock.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * Route the connections to the shards by the shard key,eg :
+	 *
+	 * auto map_ptr = std::make_shared<zdb2::shard_map>();
+	 * for (int i = 0; i < 16; i++)
+	 *     map_ptr->add_shard("shard" + std::to_string(i), pools[i]);
+	 *
+	 * zdb2::shard_router shards(map_ptr);
+	 * auto conn = shards.get(user_id);
+	 * auto rs = conn->query("SELECT * FROM user WHERE id=%lld", user_id);
+	 *
+	 * The map can be replaced by update() at any time,the get() calls don't wait for it,and the
+	 * connections which are checked out of the old shards are returned to their pools as usual.
+	 */
+	class shard_router
+	{
+	public:
+
+		/**
+		 * the metrics of a shard,see get_metrics().
+		 */
+		struct shard_metrics
+		{
+			std::string name;
+
+			uint64_t checkouts = 0;
+			uint64_t failures = 0;
+
+			/// the connections of the pool of the shard
+			std::size_t using_count = 0;
+			std::size_t idle_count = 0;
+			std::size_t max_count = 0;
+		};
+
+		shard_router(std::shared_ptr<shard_map> map_ptr)
+		{
+			if (!map_ptr || map_ptr->get_shard_count() == 0)
+				throw std::runtime_error("invalid parameters.");
+			m_map_ptr = map_ptr;
+			m_map_lock.set_name("shard_router.map");
+		}
+
+		/**
+		 * Replace the shard map,the shards which have the same name keep their counters.The map
+		 * must not be changed after it's given to this function.
+		 */
+		void update(std::shared_ptr<shard_map> map_ptr)
+		{
+			if (!map_ptr || map_ptr->get_shard_count() == 0)
+				throw std::runtime_error("invalid parameters.");
+
+			std::lock_guard<std::mutex> g(m_update_mtx);
+
+			std::shared_ptr<shard_map> old_ptr = get_map();
+			map_ptr->inherit_stats(*old_ptr);
+
+			br_wlock_guard g2(m_map_lock);
+			m_map_ptr.swap(map_ptr);
+		}
+
+		std::shared_ptr<shard_map> get_map()
+		{
+			br_rlock_guard g(m_map_lock);
+			return m_map_ptr;
+		}
+
+		/**
+		 * Get a connection of the shard of the key.
+		 * @return The connection,or nullptr if the pool of the shard is exhausted
+		 */
+		std::shared_ptr<connection> get(const std::string & key)
+		{
+			return _get(key);
+		}
+
+		std::shared_ptr<connection> get(int64_t key)
+		{
+			return _get(key);
+		}
+
+		/**
+		 * Get the pool of the shard of the key,eg : for pool::async_query().
+		 */
+		std::shared_ptr<pool> get_pool(const std::string & key)
+		{
+			br_rlock_guard g(m_map_lock);
+			return _shard(key).pool_ptr;
+		}
+
+		std::shared_ptr<pool> get_pool(int64_t key)
+		{
+			br_rlock_guard g(m_map_lock);
+			return _shard(key).pool_ptr;
+		}
+
+		/**
+		 * Get the name of the shard of the key.
+		 */
+		std::string shard_of(const std::string & key)
+		{
+			br_rlock_guard g(m_map_lock);
+			return _shard(key).name;
+		}
+
+		std::string shard_of(int64_t key)
+		{
+			br_rlock_guard g(m_map_lock);
+			return _shard(key).name;
+		}
+
+		/**
+		 * Get the metrics of every shard of the current map,the hot shard has more checkouts and
+		 * more using connections than the others.
+		 */
+		std::vector<shard_metrics> get_metrics()
+		{
+			std::vector<shard_metrics> metrics;
+
+			std::shared_ptr<shard_map> map_ptr = get_map();
+			for (std::size_t i = 0; i < map_ptr->get_shard_count(); i++)
+			{
+				const shard_map::shard & s = map_ptr->get_shard(i);
+
+				shard_metrics m;
+				m.name        = s.name;
+				m.checkouts   = s.stats_ptr->checkouts;
+				m.failures    = s.stats_ptr->failures;
+				m.using_count = s.pool_ptr->get_using_count();
+				m.idle_count  = s.pool_ptr->get_idle_count();
+				m.max_count   = s.pool_ptr->get_max_conn_count();
+				metrics.emplace_back(m);
+			}
+			return metrics;
+		}
+
+	protected:
+
+		static std::size_t _check(int index)
+		{
+			if (index < 0)
+				throw std::runtime_error("the key belongs to no shard.");
+			return (std::size_t)index;
+		}
+
+		/**
+		 * the shard of the key,the caller must hold the read lock of the map,so the map is used
+		 * by the raw pointer instead of a copy of the shared_ptr.
+		 */
+		template<typename Key>
+		const shard_map::shard & _shard(const Key & key)
+		{
+			shard_map * map = m_map_ptr.get();
+			return map->get_shard(_check(map->locate(key)));
+		}
+
+		template<typename Key>
+		std::shared_ptr<connection> _get(const Key & key)
+		{
+			// the pool may wait for a connection,so the read lock is not held by pool::get(),only
+			// the pool and the stats of the shard are kept alive for it
+			std::shared_ptr<pool> pool_ptr;
+			std::shared_ptr<shard_stats> stats_ptr;
+			{
+				br_rlock_guard g(m_map_lock);
+				const shard_map::shard & s = _shard(key);
+				pool_ptr = s.pool_ptr;
+				stats_ptr = s.stats_ptr;
+			}
+
+			std::shared_ptr<connection> conn;
+			try
+			{
+				conn = pool_ptr->get();
+			}
+			catch (std::exception &)
+			{
+				stats_ptr->failures++;
+				throw;
+			}
+
+			if (conn)
+				stats_ptr->checkouts++;
+			else
+				stats_ptr->failures++;
+			return conn;
+		}
+
+	protected:
+
+		/// guarded by m_map_lock,std::atomic_load of shared_ptr locks a global mutex of the library
+		std::shared_ptr<shard_map> m_map_ptr;
+
+		/// the map is read by every get() and replaced rarely
+		br_rwlock m_map_lock;
+
+		/// serialize the updating,the get() calls don't lock it
+		std::mutex m_update_mtx;
+
+	};
+
+}
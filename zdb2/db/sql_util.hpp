@@ -0,0 +1,330 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cctype>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace zdb2
+{
+
+	/**
+	 * Helper functions which look into the SQL text without a database.
+	 */
+	class sql_util
+	{
+	public:
+
+		/**
+		 * Format the SQL the same way as connection::execute() and connection::query() do,so the
+		 * SQL can be saved and executed later,eg : by another thread.
+		 */
+		static std::string format(const char * sql, ...)
+		{
+			if (!sql)
+				return std::string();
+
+			va_list ap, ap_copy;
+			va_start(ap, sql);
+
+			va_copy(ap_copy, ap);
+			int len = std::vsnprintf(nullptr, 0, sql, ap_copy);
+			va_end(ap_copy);
+
+			std::string str(len > 0 ? len : 0, '\0');
+			if (len > 0)
+			{
+				va_copy(ap_copy, ap);
+				std::vsnprintf((char*)str.data(), (std::size_t)len + 1, sql, ap_copy);
+				va_end(ap_copy);
+			}
+
+			va_end(ap);
+			return str;
+		}
+
+		/**
+		 * Split the SQL into upper case words,the string literals,the quoted identifiers and the
+		 * comments are skipped,the other characters are separators.
+		 * @param max_words Stop after this count of words,0 means no limit
+		 */
+		static std::vector<std::string> get_words(const char * sql, std::size_t max_words = 0)
+		{
+			std::vector<std::string> words;
+			if (!sql)
+				return words;
+
+			const char * p = sql;
+			while (*p)
+			{
+				char c = *p;
+				if (c == '\'' || c == '"' || c == '`')
+				{
+					// the quote is escaped by doubling it,or by a backslash in MySQL
+					p++;
+					while (*p)
+					{
+						if (*p == '\\' && c != '`' && p[1])
+							p += 2;
+						else if (*p == c && p[1] == c)
+							p += 2;
+						else if (*p == c)
+							break;
+						else
+							p++;
+					}
+					if (*p)
+						p++;
+				}
+				else if (c == '-' && p[1] == '-')
+				{
+					while (*p && *p != '\n')
+						p++;
+				}
+				else if (c == '#')
+				{
+					while (*p && *p != '\n')
+						p++;
+				}
+				else if (c == '/' && p[1] == '*')
+				{
+					p += 2;
+					while (*p && !(*p == '*' && p[1] == '/'))
+						p++;
+					if (*p)
+						p += 2;
+				}
+				else if (std::isalpha((unsigned char)c) || c == '_')
+				{
+					std::string word;
+					while (*p && (std::isalnum((unsigned char)*p) || *p == '_' || *p == '$'))
+						word += (char)std::toupper((unsigned char)*p++);
+					words.emplace_back(std::move(word));
+					if (max_words > 0 && words.size() >= max_words)
+						break;
+				}
+				else
+				{
+					p++;
+				}
+			}
+			return words;
+		}
+
+		/**
+		 * Normalize the SQL into a fingerprint,so the statements which are different only by the
+		 * literals have the same fingerprint,eg :
+		 * "SELECT * FROM t WHERE id IN (1, 2, 3) AND name = 'x'" -> "select * from t where id in (?+) and name = ?"
+		 * The string and number literals are replaced by ?,the lists of ? are collapsed into ?+,
+		 * the comments are removed,the spaces are collapsed,and the words out of the quotes are
+		 * lower cased.
+		 * @param max_length The fingerprint is truncated to this length
+		 */
+		static std::string fingerprint(const char * sql, std::size_t max_length = 1024)
+		{
+			std::string fp;
+			if (!sql)
+				return fp;
+
+			const char * p = sql;
+			bool space = false;
+			while (*p && fp.length() < max_length)
+			{
+				char c = *p;
+				if (std::isspace((unsigned char)c))
+				{
+					space = true;
+					p++;
+					continue;
+				}
+
+				if ((c == '-' && p[1] == '-') || c == '#')
+				{
+					while (*p && *p != '\n')
+						p++;
+					space = true;
+					continue;
+				}
+
+				if (c == '/' && p[1] == '*')
+				{
+					p += 2;
+					while (*p && !(*p == '*' && p[1] == '/'))
+						p++;
+					if (*p)
+						p += 2;
+					space = true;
+					continue;
+				}
+
+				if (space && !fp.empty())
+					fp += ' ';
+				space = false;
+
+				if (c == '\'')
+				{
+					// the string literal,the quote is escaped by doubling it,or by a backslash in MySQL
+					p++;
+					while (*p)
+					{
+						if (*p == '\\' && p[1])
+							p += 2;
+						else if (*p == '\'' && p[1] == '\'')
+							p += 2;
+						else if (*p == '\'')
+							break;
+						else
+							p++;
+					}
+					if (*p)
+						p++;
+					_add_placeholder(fp);
+				}
+				else if (c == '"' || c == '`' || c == '[')
+				{
+					// the quoted identifier is kept as is
+					char end = (c == '[' ? ']' : c);
+					fp += *p++;
+					while (*p && *p != end)
+						fp += *p++;
+					if (*p)
+						fp += *p++;
+				}
+				else if (std::isdigit((unsigned char)c) ||
+					(c == '.' && std::isdigit((unsigned char)p[1])))
+				{
+					// the number literal,include the hex and the exponent
+					while (*p && (std::isalnum((unsigned char)*p) || *p == '.' ||
+						((*p == '+' || *p == '-') && (p[-1] == 'e' || p[-1] == 'E'))))
+						p++;
+					_add_placeholder(fp);
+				}
+				else if (c == '?' || (c == '$' && std::isdigit((unsigned char)p[1])))
+				{
+					// the placeholders of the prepared statements
+					p++;
+					while (std::isdigit((unsigned char)*p))
+						p++;
+					_add_placeholder(fp);
+				}
+				else if (std::isalpha((unsigned char)c) || c == '_' || c == '@' || c == ':')
+				{
+					while (*p && (std::isalnum((unsigned char)*p) || *p == '_' || *p == '$' || *p == '@' || *p == ':' || *p == '.'))
+						fp += (char)std::tolower((unsigned char)*p++);
+				}
+				else
+				{
+					fp += *p++;
+				}
+			}
+
+			// the rows of a multi rows insert : "(?+), (?+), (?+)" -> "(?+)"
+			std::size_t pos = 0;
+			while ((pos = fp.find("(?+), (?+)", pos)) != std::string::npos)
+				fp.erase(pos + 4, 6);
+			pos = 0;
+			while ((pos = fp.find("(?+),(?+)", pos)) != std::string::npos)
+				fp.erase(pos + 4, 5);
+
+			if (fp.length() > max_length)
+				fp.resize(max_length);
+			return fp;
+		}
+
+		/**
+		 * Returns true if the SQL only reads the data,so it can be executed on a replica.When not
+		 * sure,eg : "SELECT ... FOR UPDATE","SELECT GET_LOCK(...)","SELECT pg_try_advisory_lock(...)"
+		 * or a CTE with a DML statement,false is returned.
+		 */
+		static bool is_read_only(const char * sql)
+		{
+			std::vector<std::string> words = get_words(sql);
+			if (words.empty())
+				return false;
+
+			const std::string & first = words[0];
+			if (first == "SHOW" || first == "DESCRIBE" || first == "DESC")
+				return true;
+
+			if (first == "EXPLAIN")
+			{
+				// EXPLAIN ANALYZE executes the statement
+				for (auto & word : words)
+				{
+					if (word == "ANALYZE")
+						return false;
+				}
+				return true;
+			}
+
+			if (first != "SELECT" && first != "WITH" && first != "VALUES" && first != "TABLE")
+				return false;
+
+			for (std::size_t i = 1; i < words.size(); i++)
+			{
+				const std::string & word = words[i];
+				if (word == "INSERT" || word == "UPDATE" || word == "DELETE" || word == "REPLACE" || word == "MERGE" ||
+					word == "INTO" || word == "LOCK" || word == "SHARE" || word == "NOWAIT" ||
+					word == "GET_LOCK" || word == "RELEASE_LOCK" || word == "RELEASE_ALL_LOCKS" ||
+					word == "IS_FREE_LOCK" || word == "IS_USED_LOCK" ||
+					word == "LAST_INSERT_ID" || word == "FOUND_ROWS" || word == "ROW_COUNT" ||
+					word == "NEXTVAL" || word == "SETVAL" || word == "LASTVAL" || word == "CURRVAL" ||
+					word == "SLEEP")
+				{
+					// "FOR UPDATE" contains UPDATE,"FOR SHARE" and "LOCK IN SHARE MODE" contains SHARE
+					return false;
+				}
+
+				// the advisory locks of PostgreSQL,eg : pg_advisory_lock_shared,pg_try_advisory_xact_lock,
+				// pg_advisory_unlock_all
+				if (word.compare(0, 12, "PG_ADVISORY_") == 0 || word.compare(0, 16, "PG_TRY_ADVISORY_") == 0)
+					return false;
+			}
+			return true;
+		}
+
+	protected:
+
+		/**
+		 * append a ? to the fingerprint,"?, ?" is collapsed into "?+".
+		 */
+		static void _add_placeholder(std::string & fp)
+		{
+			std::size_t i = fp.length();
+			if (i > 0 && fp[i - 1] == ' ')
+				i--;
+			if (i > 0 && fp[i - 1] == ',')
+			{
+				i--;
+				if (i > 0 && fp[i - 1] == ' ')
+					i--;
+				if (i > 1 && fp[i - 1] == '+' && fp[i - 2] == '?')
+				{
+					fp.resize(i);
+					return;
+				}
+				if (i > 0 && fp[i - 1] == '?')
+				{
+					fp.resize(i);
+					fp += '+';
+					return;
+				}
+			}
+			fp += '?';
+		}
+
+	};
+
+}
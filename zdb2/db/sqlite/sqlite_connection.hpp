@@ -18,16 +18,19 @@
 #include <atomic>
 #include <chrono>
 #include <functional>
+#include <vector>
 
 #include <sqlite3.h>
 
 #include <zdb2/config.hpp>
 #include <zdb2/net/url.hpp>
 #include <zdb2/db/connection.hpp>
+#include <zdb2/db/registry.hpp>
 
 #include <zdb2/db/sqlite/sqlite_util.hpp>
 #include <zdb2/db/sqlite/sqlite_stmt.hpp>
 #include <zdb2/db/sqlite/sqlite_resultset.hpp>
+#include <zdb2/db/materialized_result.hpp>
 
 namespace zdb2
 {
@@ -119,9 +122,7 @@ namespace zdb2
 		 */
 		virtual bool begin_transaction() override
 		{
-			if (SQLITE_OK == _execute_sql("BEGIN TRANSACTION;"))
-				return connection::begin_transaction();
-			return false;
+			return _transaction_begin([this]() { return (SQLITE_OK == _execute_sql("BEGIN TRANSACTION;")); });
 		}
 
 
@@ -137,10 +138,8 @@ namespace zdb2
 		{
 			if (is_intransaction())
 			{
-				if (connection::commit())
-				{
-					return (SQLITE_OK == _execute_sql("COMMIT TRANSACTION;"));
-				}
+				return _transaction_end(&hooks::on_txn_commit,
+					[this]() { return (SQLITE_OK == _execute_sql("COMMIT TRANSACTION;")); });
 			}
 			return false;
 		}
@@ -159,10 +158,8 @@ namespace zdb2
 		{
 			if (is_intransaction())
 			{
-				if (connection::rollback())
-				{
-					return (SQLITE_OK == _execute_sql("ROLLBACK TRANSACTION;"));
-				}
+				return _transaction_end(&hooks::on_txn_rollback,
+					[this]() { return (SQLITE_OK == _execute_sql("ROLLBACK TRANSACTION;")); });
 			}
 			return false;
 		}
@@ -223,8 +220,10 @@ namespace zdb2
 			std::vsprintf((char*)str.data(), sql, ap_copy);
 
 			va_end(ap);
-			
-			return (_execute_sql(str.c_str()) == SQLITE_OK);
+
+			auto ctx = _statement_begin(str.c_str());
+
+			return _statement_execute(ctx, str.c_str(), (_execute_sql(str.c_str()) == SQLITE_OK));
 		}
 
 		/**
@@ -264,6 +263,8 @@ namespace zdb2
 
 			va_end(ap);
 
+			auto ctx = _statement_begin(str.c_str());
+
 			int status;
 			const char * tail;
 			sqlite3_stmt * stmt;
@@ -276,9 +277,74 @@ namespace zdb2
 			status = sqlite_util::execute(m_timeout, sqlite3_prepare, m_db, str.c_str(), (int)str.length(), &stmt, &tail);
 #endif
 			if (status == SQLITE_OK)
-				return std::dynamic_pointer_cast<resultset>(std::make_shared<sqlite_resultset>(stmt,m_timeout));
+				return _statement_query(ctx, str.c_str(), std::dynamic_pointer_cast<resultset>(std::make_shared<sqlite_resultset>(stmt,m_timeout)));
+
+			return _statement_query(ctx, str.c_str(), nullptr);
+		}
+
+		/**
+		 * Executes the statements one by one,SQLite is an embedded database,so
+		 * there is no round trip to save. The rows returned by a statement are
+		 * read into the batch_result.
+		 */
+		virtual std::vector<batch_result> execute_batch(const std::vector<std::string> & sqls) override
+		{
+			std::vector<batch_result> results(sqls.size());
+			for (std::size_t i = 0; i < sqls.size(); i++)
+			{
+				batch_result & result = results[i];
+
+				auto ctx = _statement_begin(sqls[i].c_str());
+
+				int status;
+				const char * tail;
+				sqlite3_stmt * stmt = nullptr;
+
+#if defined SQLITEUNLOCK && SQLITE_VERSION_NUMBER >= 3006012
+				status = sqlite_util::sqlite3_blocking_prepare_v2(m_db, sqls[i].c_str(), (int)sqls[i].length(), &stmt, &tail);
+#elif SQLITE_VERSION_NUMBER >= 3004000
+				status = sqlite_util::execute(m_timeout, sqlite3_prepare_v2, m_db, sqls[i].c_str(), (int)sqls[i].length(), &stmt, &tail);
+#else
+				status = sqlite_util::execute(m_timeout, sqlite3_prepare, m_db, sqls[i].c_str(), (int)sqls[i].length(), &stmt, &tail);
+#endif
+				if (status == SQLITE_OK && stmt)
+				{
+					// the resultset owns the stmt and finalize it when closed
+					std::shared_ptr<sqlite_resultset> rs = std::make_shared<sqlite_resultset>(stmt, m_timeout);
+					try
+					{
+						if (rs->get_column_count() > 0)
+							result.rows = materialized_result::materialize(rs);
+						else
+							rs->next_row();
+						result.ok = true;
+					}
+					catch (std::exception &)
+					{
+					}
+					rs->close();
+				}
+				else if (status == SQLITE_OK)
+				{
+					// the sql is empty or only a comment
+					result.ok = true;
+				}
 
-			return nullptr;
+				if (!result.ok)
+				{
+					result.error = sqlite3_errmsg(m_db);
+					_statement_end(ctx, sqls[i].c_str(), false, 0);
+					for (std::size_t j = i + 1; j < sqls.size(); j++)
+						results[j].error = "not executed because of the previous error.";
+					break;
+				}
+
+				result.rows_changed = rows_changed();
+				result.last_rowid = last_rowid();
+
+				_statement_end(ctx, sqls[i].c_str(), true, _batch_rows(result));
+			}
+			return results;
 		}
 
 		/**
@@ -318,7 +384,20 @@ namespace zdb2
 
 			va_end(ap);
 
-			return std::dynamic_pointer_cast<stmt>(std::make_shared<sqlite_stmt>(m_db,str.c_str(),m_timeout));
+			return _statement_stmt(str.c_str(), std::dynamic_pointer_cast<stmt>(std::make_shared<sqlite_stmt>(m_db,str.c_str(),m_timeout)));
+		}
+
+
+		/**
+		 * Cancel the statement which is executing on this connection,see connection::cancel().
+		 * The statement is failed with SQLITE_INTERRUPT.
+		 */
+		virtual bool cancel() override
+		{
+			if (!m_db)
+				return false;
+			sqlite3_interrupt(m_db);
+			return true;
 		}
 
 
@@ -377,7 +456,8 @@ namespace zdb2
 			std::string params;
 			m_url_ptr->for_each_param([&params](std::pair<std::string, std::string> pair)
 			{
-				if (!pair.first.empty() && !pair.second.empty() && pair.first != "heap_limit")
+				if (!pair.first.empty() && !pair.second.empty() && pair.first != "heap_limit" &&
+					pair.first != "open_mode" && pair.first != "shared_cache")
 				{
 					params += "PRAGMA ";
 					params += pair.first;
@@ -423,7 +503,18 @@ namespace zdb2
 			*/
 			sqlite3_enable_shared_cache(true);
 #endif
-			status = sqlite3_open_v2(path.c_str(), &m_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_SHAREDCACHE, NULL);
+			// "open_mode=ro" opens the database read only,"open_mode=rw" doesn't create it,the read
+			// only connections without the shared cache ("shared_cache=false") can read a WAL
+			// database at the same time,eg : by the parallel_scan
+			int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+			std::string open_mode = m_url_ptr->get_param_value("open_mode");
+			if (open_mode == "ro")
+				flags = SQLITE_OPEN_READONLY;
+			else if (open_mode == "rw")
+				flags = SQLITE_OPEN_READWRITE;
+			flags |= (m_url_ptr->get_param_value("shared_cache") == "false" ? SQLITE_OPEN_PRIVATECACHE : SQLITE_OPEN_SHAREDCACHE);
+
+			status = sqlite3_open_v2(path.c_str(), &m_db, flags, NULL);
 #else
 			status = sqlite3_open(path.c_str(), &m_db);
 #endif
@@ -449,4 +540,10 @@ namespace zdb2
 		sqlite3 * m_db = nullptr;
 	};
 
+	namespace
+	{
+		/// register the backend when this header is included
+		const registry::registrar _sqlite_registrar("sqlite", &registry::create<sqlite_connection>);
+	}
+
 }
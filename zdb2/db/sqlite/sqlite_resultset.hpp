@@ -128,7 +128,9 @@ namespace zdb2
 		 */
 		virtual bool next_row() override
 		{
-			if (!m_stmt)
+			// sqlite3_step will restart the statement automatically if it is called after SQLITE_DONE,
+			// so we must remember whether all the rows have been fetched.
+			if (!m_stmt || m_done)
 				return false;
 
 			int status;
@@ -141,6 +143,7 @@ namespace zdb2
 			{
 				throw std::runtime_error("not desired return value of sqlite3_step.");
 			}
+			m_done = (status == SQLITE_DONE);
 			return (status == SQLITE_ROW);
 		}
 
@@ -574,6 +577,9 @@ namespace zdb2
 
 		std::unordered_map<std::string, int> m_column_name_map;
 
+		/// whether sqlite3_step has returned SQLITE_DONE
+		bool m_done = false;
+
 	};
 
 }
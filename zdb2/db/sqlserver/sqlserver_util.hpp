@@ -1,37 +0,0 @@
-/*
- * COPYRIGHT (C) 2017, zhllxt
- *
- * Author   : zhllxt
- * QQ       : 37792738
- * Email    : 37792738@qq.com
- * 
- */
-
-
-#pragma once
-
-#include <cctype>
-#include <string>
-#include <memory>
-#include <algorithm>
-#include <mutex>
-#include <thread>
-#include <condition_variable>
-
-#include <sql.h>
-#include <sqlext.h>
-#include <sqltypes.h>
-#include <odbcss.h>
-
-namespace zdb2
-{
-
-	class sqlserver_util
-	{
-	public:
-
-
-
-	};
-
-}
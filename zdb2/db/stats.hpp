@@ -0,0 +1,368 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+
+#include <zdb2/util/spin_lock.hpp>
+#include <zdb2/util/histogram.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * The statistics of the statements which are executed by the connections of a pool,grouped
+	 * by the fingerprint of the SQL (see sql_util::fingerprint),eg :
+	 *
+	 * pool_ptr->enable_stats(true);
+	 * ...
+	 * for (auto & s : pool_ptr->get_stats()->snapshot())
+	 *     printf("%s count=%llu total=%lluus p99=%lluus\n", s.fingerprint.c_str(), s.count, s.total_us, s.execute_us->get_percentile(99));
+	 *
+	 * Every statement records one sample : the execute time,the fetch time (the time spent in
+	 * resultset::next_row),the rows fetched or changed,and the bytes fetched.The query sample is
+	 * recorded when it's ResultSet is destroyed.The samples are buffered by every thread and added
+	 * into the lock free histograms of the fingerprint every 64 samples,or when snapshot() is
+	 * called,so the executing threads don't contend with each other.
+	 */
+	class statement_stats
+	{
+	public:
+
+		/**
+		 * the statistics of a fingerprint.
+		 */
+		struct entry
+		{
+			std::string fingerprint;
+
+			histogram execute_us;
+			histogram fetch_us;
+			histogram rows;
+			histogram bytes;
+
+			std::atomic<uint64_t> errors{ 0 };
+		};
+
+		/**
+		 * a copy of the statistics of a fingerprint,see snapshot().
+		 */
+		struct entry_snapshot
+		{
+			std::string fingerprint;
+
+			uint64_t count = 0;
+			uint64_t errors = 0;
+
+			/// the execute time and the fetch time of all the statements
+			uint64_t total_us = 0;
+
+			std::shared_ptr<histogram> execute_us;
+			std::shared_ptr<histogram> fetch_us;
+			std::shared_ptr<histogram> rows;
+			std::shared_ptr<histogram> bytes;
+		};
+
+		enum
+		{
+			/// the samples of a thread are flushed when the buffer is full
+			BUFFER_SIZE = 64,
+		};
+
+	protected:
+
+		struct local_buffer;
+
+	public:
+
+		/**
+		 * the buffers of all the threads,it's shared by the application and the plugins,the samples
+		 * recorded by the connections of a plugin are flushed by the pool of the application.
+		 */
+		struct shared_state
+		{
+			std::mutex mtx;
+
+			std::vector<local_buffer *> buffers;
+		};
+
+		/**
+		 * @param max_fingerprints The statements of the new fingerprints are recorded into the
+		 * fingerprint "<other>" when there are too many fingerprints
+		 */
+		statement_stats(std::size_t max_fingerprints = 1000) : m_max_fingerprints(max_fingerprints)
+		{
+		}
+
+		virtual ~statement_stats()
+		{
+			// the samples of this object in the buffers of the threads are dropped
+			std::lock_guard<std::mutex> g(_buffers_mtx());
+			for (auto buffer : _buffers())
+			{
+				std::lock_guard<spin_lock> bg(buffer->lock);
+				if (buffer->owner == this)
+				{
+					buffer->owner = nullptr;
+					buffer->samples.clear();
+				}
+			}
+		}
+
+		/**
+		 * Record a statement.
+		 * @param fingerprint The fingerprint of the SQL
+		 * @param ok false if the statement is failed
+		 */
+		void record(std::string fingerprint, uint64_t execute_us, uint64_t fetch_us, uint64_t rows, uint64_t bytes, bool ok)
+		{
+			local_buffer & buffer = _local_buffer();
+
+			std::lock_guard<spin_lock> g(buffer.lock);
+
+			if (buffer.owner != this)
+			{
+				// the thread records for another pool now
+				_flush(buffer);
+				buffer.owner = this;
+			}
+
+			buffer.samples.emplace_back();
+			sample & s = buffer.samples.back();
+			s.fingerprint = std::move(fingerprint);
+			s.execute_us = execute_us;
+			s.fetch_us = fetch_us;
+			s.rows = rows;
+			s.bytes = bytes;
+			s.ok = ok;
+
+			if (buffer.samples.size() >= BUFFER_SIZE)
+				_flush(buffer);
+		}
+
+		/**
+		 * Add the buffered samples of all the threads into the histograms.
+		 */
+		void flush()
+		{
+			std::lock_guard<std::mutex> g(_buffers_mtx());
+			for (auto buffer : _buffers())
+			{
+				std::lock_guard<spin_lock> bg(buffer->lock);
+				if (buffer->owner == this)
+					_flush(*buffer);
+			}
+		}
+
+		/**
+		 * Get a copy of the statistics,sorted by the total time,the most expensive fingerprint
+		 * is the first.
+		 */
+		std::vector<entry_snapshot> snapshot()
+		{
+			flush();
+
+			std::vector<entry_snapshot> entries;
+			{
+				std::lock_guard<std::mutex> g(m_mtx);
+				for (auto & pair : m_entries)
+				{
+					entry & e = *pair.second;
+
+					entry_snapshot s;
+					s.fingerprint = e.fingerprint;
+					s.execute_us = std::make_shared<histogram>();
+					s.fetch_us   = std::make_shared<histogram>();
+					s.rows       = std::make_shared<histogram>();
+					s.bytes      = std::make_shared<histogram>();
+					s.execute_us->merge(e.execute_us);
+					s.fetch_us->merge(e.fetch_us);
+					s.rows->merge(e.rows);
+					s.bytes->merge(e.bytes);
+					s.count    = s.execute_us->get_count();
+					s.errors   = e.errors;
+					s.total_us = s.execute_us->get_sum() + s.fetch_us->get_sum();
+					entries.emplace_back(s);
+				}
+			}
+
+			std::sort(entries.begin(), entries.end(), [](const entry_snapshot & a, const entry_snapshot & b)
+			{
+				return a.total_us > b.total_us;
+			});
+			return entries;
+		}
+
+		/**
+		 * Clear all the statistics and the buffered samples.
+		 */
+		void reset()
+		{
+			{
+				std::lock_guard<std::mutex> g(_buffers_mtx());
+				for (auto buffer : _buffers())
+				{
+					std::lock_guard<spin_lock> bg(buffer->lock);
+					if (buffer->owner == this)
+						buffer->samples.clear();
+				}
+			}
+
+			std::lock_guard<std::mutex> g(m_mtx);
+			m_entries.clear();
+		}
+
+		/**
+		 * Get the state of this module,it's passed to the plugins by the registry.
+		 */
+		static shared_state * get_shared_state()
+		{
+			return _state();
+		}
+
+		/**
+		 * Use the state of the application instead of the state of this module,see hooks::attach.
+		 */
+		static void attach(shared_state * state)
+		{
+			if (state)
+				_state() = state;
+		}
+
+	protected:
+
+		struct sample
+		{
+			std::string fingerprint;
+			uint64_t execute_us = 0;
+			uint64_t fetch_us = 0;
+			uint64_t rows = 0;
+			uint64_t bytes = 0;
+			bool ok = true;
+		};
+
+		/**
+		 * the samples of a thread,all of them belong to the same statement_stats.
+		 */
+		struct local_buffer
+		{
+			spin_lock lock;
+			statement_stats * owner = nullptr;
+			std::vector<sample> samples;
+
+			local_buffer()
+			{
+				samples.reserve(BUFFER_SIZE);
+				lock.set_name("statement_stats.buffer");
+
+				std::lock_guard<std::mutex> g(_buffers_mtx());
+				_buffers().emplace_back(this);
+			}
+
+			~local_buffer()
+			{
+				// the owner can't be destroyed before it's removed from the buffer,the destructor of
+				// the owner takes the same locks
+				std::lock_guard<std::mutex> g(_buffers_mtx());
+				{
+					std::lock_guard<spin_lock> bg(lock);
+					if (owner)
+						owner->_flush(*this);
+				}
+				auto & buffers = _buffers();
+				buffers.erase(std::remove(buffers.begin(), buffers.end(), this), buffers.end());
+			}
+		};
+
+		static shared_state *& _state()
+		{
+			static shared_state local;
+			static shared_state * state = &local;
+			return state;
+		}
+
+		static std::mutex & _buffers_mtx()
+		{
+			return _state()->mtx;
+		}
+
+		static std::vector<local_buffer *> & _buffers()
+		{
+			return _state()->buffers;
+		}
+
+		static local_buffer & _local_buffer()
+		{
+			static thread_local local_buffer buffer;
+			return buffer;
+		}
+
+		/**
+		 * add the samples of the buffer into the histograms,the buffer lock is held by the caller.
+		 */
+		void _flush(local_buffer & buffer)
+		{
+			if (buffer.samples.empty())
+				return;
+
+			if (buffer.owner && buffer.owner != this)
+			{
+				buffer.owner->_flush(buffer);
+				return;
+			}
+
+			std::lock_guard<std::mutex> g(m_mtx);
+			for (auto & s : buffer.samples)
+			{
+				auto it = m_entries.find(s.fingerprint);
+				if (it == m_entries.end())
+				{
+					if (m_entries.size() >= m_max_fingerprints)
+						s.fingerprint = "<other>";
+					it = m_entries.find(s.fingerprint);
+					if (it == m_entries.end())
+					{
+						std::shared_ptr<entry> e = std::make_shared<entry>();
+						e->fingerprint = s.fingerprint;
+						it = m_entries.emplace(s.fingerprint, e).first;
+					}
+				}
+
+				entry & e = *it->second;
+				e.execute_us.record(s.execute_us);
+				e.fetch_us.record(s.fetch_us);
+				e.rows.record(s.rows);
+				e.bytes.record(s.bytes);
+				if (!s.ok)
+					e.errors++;
+			}
+			buffer.samples.clear();
+		}
+
+	protected:
+
+		std::size_t m_max_fingerprints = 1000;
+
+		std::mutex m_mtx;
+
+		std::unordered_map<std::string, std::shared_ptr<entry>> m_entries;
+
+	};
+
+}
@@ -0,0 +1,630 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+
+#include <zdb2/util/executor.hpp>
+#include <zdb2/db/connection.hpp>
+#include <zdb2/db/resultset.hpp>
+#include <zdb2/db/sql_util.hpp>
+#include <zdb2/db/hooks.hpp>
+#include <zdb2/db/pool.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * A fixed memory ring buffer of the recent statements,and the captured slow statements with
+	 * their query plans,eg :
+	 *
+	 * auto trace_ptr = std::make_shared<zdb2::trace>(4096);
+	 * trace_ptr->set_slow_query(200, pool_ptr); // EXPLAIN the statements slower than 200ms
+	 * zdb2::hooks::install(trace_ptr);
+	 * ...
+	 * trace_ptr->dump("/tmp/zdb2_trace.txt");  // eg : when a latency spike is detected
+	 *
+	 * The statements are recorded by the on_query_end hook,and the queries by the on_query_close
+	 * hook when their ResultSet is closed,so the time includes the fetching (sqlite executes the
+	 * query in next_row) and the rows are the rows fetched.The writers never wait : every record
+	 * takes the next slot by an atomic counter,and the slot is written under it's own sequence
+	 * number,so the readers can detect a slot which is being written.When the writer of the older
+	 * round is still writing the slot,the new record is dropped and counted.
+	 *
+	 * The slow statements are explained on a connection of the explain pool by a background thread,
+	 * sqlite uses "EXPLAIN QUERY PLAN",mysql and postgresql use "EXPLAIN",every fingerprint is
+	 * explained at most once a minute.
+	 *
+	 * By default the SQL text and the parameters of the prepared statements are not kept,only the
+	 * fingerprint,call set_redact(false) to keep them.
+	 */
+	class trace : public hooks
+	{
+	public:
+
+		enum
+		{
+			FINGERPRINT_SIZE = 160,
+			SQL_SIZE         = 240,
+			PARAMS_SIZE      = 160,
+		};
+
+		/**
+		 * a recorded statement.
+		 */
+		struct record
+		{
+			/// the sequence number of the record,increased by 1 for every record
+			uint64_t seq = 0;
+
+			std::chrono::system_clock::time_point time;
+
+			uint64_t duration_us = 0;
+			int64_t rows = 0;
+			bool ok = true;
+
+			/// the address of the connection,the records of the same connection have the same id
+			uint64_t conn_id = 0;
+
+			/// the hash of the thread id
+			uint64_t thread_id = 0;
+
+			std::string fingerprint;
+
+			/// the SQL text,empty if it's redacted
+			std::string sql;
+
+			/// the parameters of the prepared statement,eg : "1, 'abc', NULL",empty if it's redacted
+			std::string params;
+		};
+
+		/**
+		 * a slow statement and it's query plan.
+		 */
+		struct slow_query
+		{
+			record op;
+
+			/// the rows of the EXPLAIN,or the error if the EXPLAIN is failed
+			std::string plan;
+		};
+
+		/**
+		 * @param capacity The count of the recent statements kept in the buffer
+		 */
+		trace(std::size_t capacity = 4096)
+			: m_capacity(capacity == 0 ? 1 : capacity)
+			, m_slots(new slot[capacity == 0 ? 1 : capacity])
+		{
+		}
+
+		virtual ~trace()
+		{
+			std::shared_ptr<executor> executor_ptr;
+			{
+				std::lock_guard<std::mutex> g(m_slow_mtx);
+				executor_ptr = m_executor_ptr;
+			}
+			if (executor_ptr)
+				executor_ptr->stop();
+		}
+
+		/**
+		 * Keep the SQL text and the parameters in the records or not,default true (not kept).
+		 */
+		trace & set_redact(bool redact)
+		{
+			m_redact.store(redact, std::memory_order_relaxed);
+			return (*this);
+		}
+
+		/**
+		 * Capture the statements slower than the threshold,and explain them on a connection of
+		 * the pool.
+		 * @param threshold_ms 0 to stop capturing
+		 * @param explain_pool_ptr The pool to run the EXPLAIN,nullptr to capture without the plan
+		 * @param max_slow_queries The count of the slow statements kept,the older ones are dropped
+		 */
+		trace & set_slow_query(std::size_t threshold_ms, std::shared_ptr<pool> explain_pool_ptr, std::size_t max_slow_queries = 64)
+		{
+			std::lock_guard<std::mutex> g(m_slow_mtx);
+			m_explain_pool_ptr = explain_pool_ptr;
+			m_max_slow_queries = (max_slow_queries == 0 ? 1 : max_slow_queries);
+			if (m_explain_pool_ptr && !m_executor_ptr)
+				m_executor_ptr = std::make_shared<executor>(1, 16);
+			m_slow_us.store((uint64_t)threshold_ms * 1000, std::memory_order_relaxed);
+			return (*this);
+		}
+
+		virtual void on_query_end(hook_event & ev) override
+		{
+			// the EXPLAIN of the slow statements are not recorded,and the query is recorded when
+			// it's ResultSet is closed
+			if (_in_explain() || ev.has_resultset)
+				return;
+
+			add(ev);
+		}
+
+		virtual void on_query_close(hook_event & ev) override
+		{
+			if (_in_explain())
+				return;
+
+			add(ev);
+		}
+
+		/**
+		 * Add a statement into the buffer,it's called by on_query_end and on_query_close,and can be
+		 * called by the other hooks which forward the events to the trace.
+		 */
+		void add(const hook_event & ev)
+		{
+			uint64_t seq = m_next_seq.fetch_add(1, std::memory_order_relaxed);
+			slot & s = m_slots[seq % m_capacity];
+
+			uint64_t version = s.version.load(std::memory_order_relaxed);
+			if ((version & 1) || !s.version.compare_exchange_strong(version, version + 1, std::memory_order_acquire))
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				std::atomic_thread_fence(std::memory_order_release);
+
+				s.seq = seq;
+				s.time_us = (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::system_clock::now().time_since_epoch()).count();
+				s.duration_us = ev.duration_us;
+				s.rows = ev.rows;
+				s.ok = ev.ok;
+				s.conn_id = (uint64_t)(uintptr_t)ev.conn;
+				s.thread_id = (uint64_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+				s.fingerprint_len = _copy(s.fingerprint, FINGERPRINT_SIZE, ev.fingerprint);
+				if (m_redact.load(std::memory_order_relaxed))
+				{
+					s.sql_len = 0;
+					s.params_len = 0;
+				}
+				else
+				{
+					s.sql_len = _copy(s.sql, SQL_SIZE, ev.sql);
+					s.params_len = _format_params(s.params, PARAMS_SIZE, ev.params);
+				}
+
+				s.version.store(version + 2, std::memory_order_release);
+			}
+
+			uint64_t slow_us = m_slow_us.load(std::memory_order_relaxed);
+			if (slow_us > 0 && ev.duration_us >= slow_us)
+				_capture(ev, seq);
+		}
+
+		/**
+		 * Get a copy of the recent statements,the oldest is the first.The slots which are being
+		 * written are skipped.
+		 */
+		std::vector<record> get_records()
+		{
+			std::vector<record> records;
+			records.reserve(m_capacity);
+
+			for (std::size_t i = 0; i < m_capacity; i++)
+			{
+				slot & s = m_slots[i];
+
+				uint64_t version = s.version.load(std::memory_order_acquire);
+				if (version == 0 || (version & 1))
+					continue;
+
+				slot copy;
+				copy.seq             = s.seq;
+				copy.time_us         = s.time_us;
+				copy.duration_us     = s.duration_us;
+				copy.rows            = s.rows;
+				copy.ok              = s.ok;
+				copy.conn_id         = s.conn_id;
+				copy.thread_id       = s.thread_id;
+				copy.fingerprint_len = s.fingerprint_len;
+				copy.sql_len         = s.sql_len;
+				copy.params_len      = s.params_len;
+				std::memcpy(copy.fingerprint, s.fingerprint, sizeof(copy.fingerprint));
+				std::memcpy(copy.sql, s.sql, sizeof(copy.sql));
+				std::memcpy(copy.params, s.params, sizeof(copy.params));
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (s.version.load(std::memory_order_relaxed) != version)
+					continue;
+
+				record r;
+				r.seq         = copy.seq;
+				r.time        = std::chrono::system_clock::time_point(std::chrono::microseconds(copy.time_us));
+				r.duration_us = copy.duration_us;
+				r.rows        = copy.rows;
+				r.ok          = copy.ok;
+				r.conn_id     = copy.conn_id;
+				r.thread_id   = copy.thread_id;
+				r.fingerprint.assign(copy.fingerprint, (std::min)((std::size_t)copy.fingerprint_len, (std::size_t)FINGERPRINT_SIZE));
+				r.sql.assign(copy.sql, (std::min)((std::size_t)copy.sql_len, (std::size_t)SQL_SIZE));
+				r.params.assign(copy.params, (std::min)((std::size_t)copy.params_len, (std::size_t)PARAMS_SIZE));
+				records.emplace_back(std::move(r));
+			}
+
+			std::sort(records.begin(), records.end(), [](const record & a, const record & b)
+			{
+				return a.seq < b.seq;
+			});
+			return records;
+		}
+
+		/**
+		 * Get a copy of the captured slow statements,the oldest is the first.
+		 */
+		std::vector<slow_query> get_slow_queries()
+		{
+			std::lock_guard<std::mutex> g(m_slow_mtx);
+			return std::vector<slow_query>(m_slow_queries.begin(), m_slow_queries.end());
+		}
+
+		/**
+		 * Get the count of the records which are dropped because their slots are being written.
+		 */
+		uint64_t get_dropped_count()
+		{
+			return m_dropped.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * Write the recent statements and the slow statements into a text file.
+		 * @return false if the file can't be written
+		 */
+		bool dump(const std::string & path)
+		{
+			std::FILE * fp = std::fopen(path.c_str(), "w");
+			if (!fp)
+				return false;
+
+			std::vector<record> records = get_records();
+			std::vector<slow_query> slow_queries = get_slow_queries();
+
+			std::fprintf(fp, "# %zu recent statements,%llu dropped\n", records.size(), (unsigned long long)get_dropped_count());
+			for (auto & r : records)
+				_write(fp, r);
+
+			std::fprintf(fp, "\n# %zu slow statements\n", slow_queries.size());
+			for (auto & q : slow_queries)
+			{
+				_write(fp, q.op);
+				std::fprintf(fp, "%s\n", q.plan.c_str());
+			}
+
+			bool ok = (std::ferror(fp) == 0);
+			if (std::fclose(fp) != 0)
+				ok = false;
+			return ok;
+		}
+
+	protected:
+
+		struct slot
+		{
+			/// odd when the slot is being written,0 when it's never written
+			std::atomic<uint64_t> version{ 0 };
+
+			uint64_t seq = 0;
+			int64_t time_us = 0;
+			uint64_t duration_us = 0;
+			int64_t rows = 0;
+			uint64_t conn_id = 0;
+			uint64_t thread_id = 0;
+			bool ok = true;
+
+			uint16_t fingerprint_len = 0;
+			uint16_t sql_len = 0;
+			uint16_t params_len = 0;
+
+			char fingerprint[FINGERPRINT_SIZE];
+			char sql[SQL_SIZE];
+			char params[PARAMS_SIZE];
+		};
+
+		static uint16_t _copy(char * dst, std::size_t size, const char * src)
+		{
+			if (!src)
+				return 0;
+			std::size_t len = std::strlen(src);
+			if (len > size)
+				len = size;
+			std::memcpy(dst, src, len);
+			return (uint16_t)len;
+		}
+
+		/**
+		 * format the parameters like the SQL literals,eg : "1, 'abc', NULL",they are truncated to
+		 * the size.
+		 */
+		static uint16_t _format_params(char * dst, std::size_t size, const std::vector<hook_param> * params)
+		{
+			if (!params || params->empty())
+				return 0;
+
+			std::string s;
+			char buf[64];
+			for (std::size_t i = 0; i < params->size() && s.length() < size; i++)
+			{
+				const hook_param & p = (*params)[i];
+				if (i > 0)
+					s += ", ";
+				switch (p.type)
+				{
+				case hook_param::STRING:
+					s += '\'';
+					for (std::size_t n = 0; n < p.s.length() && s.length() < size; n++)
+					{
+						if (p.s[n] == '\'')
+							s += '\'';
+						s += p.s[n];
+					}
+					s += '\'';
+					break;
+				case hook_param::INT:
+				case hook_param::INT64:
+				case hook_param::TIMESTAMP:
+					s += std::to_string(p.i);
+					break;
+				case hook_param::DOUBLE:
+					std::snprintf(buf, sizeof(buf), "%.17g", p.d);
+					s += buf;
+					break;
+				case hook_param::BLOB:
+					std::snprintf(buf, sizeof(buf), "<blob %zu bytes>", p.s.length());
+					s += buf;
+					break;
+				default:
+					s += "NULL";
+					break;
+				}
+			}
+
+			std::size_t len = (std::min)(s.length(), size);
+			std::memcpy(dst, s.data(), len);
+			return (uint16_t)len;
+		}
+
+		static bool & _in_explain()
+		{
+			static thread_local bool in_explain = false;
+			return in_explain;
+		}
+
+		/**
+		 * keep the slow statement,and explain it by the background thread.
+		 */
+		void _capture(const hook_event & ev, uint64_t seq)
+		{
+			slow_query q;
+			q.op.seq         = seq;
+			q.op.time        = std::chrono::system_clock::now();
+			q.op.duration_us = ev.duration_us;
+			q.op.rows        = ev.rows;
+			q.op.ok          = ev.ok;
+			q.op.conn_id     = (uint64_t)(uintptr_t)ev.conn;
+			q.op.thread_id   = (uint64_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+			q.op.fingerprint = (ev.fingerprint ? ev.fingerprint : "");
+			if (!m_redact.load(std::memory_order_relaxed))
+			{
+				if (ev.sql)
+					q.op.sql = ev.sql;
+				char params[PARAMS_SIZE];
+				q.op.params.assign(params, _format_params(params, PARAMS_SIZE, ev.params));
+			}
+
+			std::string sql = (ev.sql ? ev.sql : "");
+			std::shared_ptr<pool> pool_ptr;
+			std::shared_ptr<executor> executor_ptr;
+			{
+				std::lock_guard<std::mutex> g(m_slow_mtx);
+
+				pool_ptr = m_explain_pool_ptr;
+				executor_ptr = m_executor_ptr;
+
+				// every fingerprint is explained at most once a minute
+				auto now = std::chrono::steady_clock::now();
+				auto it = m_explained.find(q.op.fingerprint);
+				if (it != m_explained.end() && now - it->second < std::chrono::minutes(1))
+				{
+					q.plan = "the fingerprint is explained in the last minute.";
+					pool_ptr.reset();
+				}
+				else if (pool_ptr && _explain_prefix(pool_ptr) && _is_explainable(sql.c_str()))
+					m_explained[q.op.fingerprint] = now;
+				else
+					pool_ptr.reset();
+
+				if (m_explained.size() > 1000)
+					m_explained.clear();
+
+				if (!pool_ptr)
+				{
+					_push(std::move(q));
+					return;
+				}
+			}
+
+			std::shared_ptr<slow_query> q_ptr = std::make_shared<slow_query>(std::move(q));
+			bool posted = executor_ptr->post([this, q_ptr, pool_ptr, sql]()
+			{
+				q_ptr->plan = _explain(pool_ptr, sql);
+
+				std::lock_guard<std::mutex> g(m_slow_mtx);
+				_push(std::move(*q_ptr));
+			});
+
+			if (!posted)
+			{
+				std::lock_guard<std::mutex> g(m_slow_mtx);
+				q_ptr->plan = "the explain queue is full.";
+				_push(std::move(*q_ptr));
+			}
+		}
+
+		/**
+		 * keep the slow statement,m_slow_mtx is held by the caller.
+		 */
+		void _push(slow_query && q)
+		{
+			m_slow_queries.emplace_back(std::move(q));
+			while (m_slow_queries.size() > m_max_slow_queries)
+				m_slow_queries.pop_front();
+		}
+
+		static const char * _explain_prefix(std::shared_ptr<pool> & pool_ptr)
+		{
+			const std::string & dbtype = pool_ptr->get_url()->get_dbtype();
+			if (dbtype == "sqlite")
+				return "EXPLAIN QUERY PLAN ";
+			if (dbtype == "mysql" || dbtype == "postgresql")
+				return "EXPLAIN ";
+			return nullptr;
+		}
+
+		/**
+		 * only the DML statements can be explained,and EXPLAIN doesn't execute them.
+		 */
+		static bool _is_explainable(const char * sql)
+		{
+			std::vector<std::string> words = sql_util::get_words(sql, 1);
+			if (words.empty())
+				return false;
+			const std::string & first = words[0];
+			return (first == "SELECT" || first == "WITH" || first == "INSERT" || first == "UPDATE" ||
+				first == "DELETE" || first == "REPLACE");
+		}
+
+		static std::string _explain(std::shared_ptr<pool> pool_ptr, const std::string & sql)
+		{
+			_in_explain() = true;
+
+			std::string plan;
+			try
+			{
+				std::shared_ptr<connection> conn = pool_ptr->get();
+				if (!conn)
+				{
+					plan = "no available connection in the explain pool.";
+				}
+				else
+				{
+					std::string explain = _explain_prefix(pool_ptr) + sql;
+					std::shared_ptr<resultset> rs = conn->query("%s", explain.c_str());
+					if (!rs)
+					{
+						const char * e = conn->get_last_error();
+						plan = std::string("explain failed : ") + ((e && e[0] != '\0') ? e : "unknown database error.");
+					}
+					else
+					{
+						int cols = rs->get_column_count();
+						while (rs->next_row())
+						{
+							plan += "  ";
+							for (int i = 0; i < cols; i++)
+							{
+								if (i > 0)
+									plan += " | ";
+								const char * v = rs->get_string(i);
+								plan += (v ? v : "NULL");
+							}
+							plan += "\n";
+						}
+						if (!plan.empty())
+							plan.pop_back();
+					}
+				}
+			}
+			catch (std::exception & e)
+			{
+				plan = std::string("explain failed : ") + e.what();
+			}
+
+			_in_explain() = false;
+			return plan;
+		}
+
+		static void _write(std::FILE * fp, const record & r)
+		{
+			time_t t = std::chrono::system_clock::to_time_t(r.time);
+			struct tm tm = {};
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_)
+			gmtime_s(&tm, &t);
+#else
+			gmtime_r(&t, &tm);
+#endif
+			long long us = (long long)(std::chrono::duration_cast<std::chrono::microseconds>(
+				r.time.time_since_epoch()).count() % 1000000);
+
+			std::fprintf(fp, "%04d-%02d-%02d %02d:%02d:%02d.%06lld seq=%llu conn=%llx thread=%llx %lluus rows=%lld %s %s\n",
+				tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, us,
+				(unsigned long long)r.seq, (unsigned long long)r.conn_id, (unsigned long long)r.thread_id,
+				(unsigned long long)r.duration_us, (long long)r.rows, (r.ok ? "ok" : "failed"), r.fingerprint.c_str());
+			if (!r.sql.empty())
+				std::fprintf(fp, "  sql : %s\n", r.sql.c_str());
+			if (!r.params.empty())
+				std::fprintf(fp, "  params : %s\n", r.params.c_str());
+		}
+
+	protected:
+
+		std::size_t m_capacity = 4096;
+
+		std::unique_ptr<slot[]> m_slots;
+
+		std::atomic<uint64_t> m_next_seq{ 0 };
+
+		std::atomic<uint64_t> m_dropped{ 0 };
+
+		std::atomic<bool> m_redact{ true };
+
+		/// the slow threshold in microseconds,0 means no capture
+		std::atomic<uint64_t> m_slow_us{ 0 };
+
+		std::mutex m_slow_mtx;
+
+		std::shared_ptr<pool> m_explain_pool_ptr;
+
+		/// the thread of the EXPLAIN
+		std::shared_ptr<executor> m_executor_ptr;
+
+		std::size_t m_max_slow_queries = 64;
+
+		std::deque<slow_query> m_slow_queries;
+
+		/// the last time every fingerprint is explained
+		std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_explained;
+
+	};
+
+}
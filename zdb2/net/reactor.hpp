@@ -0,0 +1,326 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#if defined(__linux__)
+
+#include <cstddef>
+#include <cerrno>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+namespace zdb2
+{
+
+	/**
+	 * epoll based event loop,used to drive the non-blocking api of the database client libraries.
+	 * every loop thread owns an epoll instance,a socket is always handled by the same loop thread.
+	 * the waits are one shot,a handler is called exactly once,when the socket is ready or when
+	 * the wait is timeout.
+	 */
+	class reactor
+	{
+	public:
+		enum
+		{
+			event_read    = 0x01,
+			event_write   = 0x02,
+			event_except  = 0x04,
+			event_timeout = 0x08,
+		};
+
+		explicit reactor(std::size_t thread_count = 1)
+		{
+			if (thread_count == 0)
+				thread_count = 1;
+
+			for (std::size_t i = 0; i < thread_count; i++)
+			{
+				std::shared_ptr<loop> loop_ptr = std::make_shared<loop>();
+
+				loop_ptr->epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+				loop_ptr->event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+				if (loop_ptr->epoll_fd < 0 || loop_ptr->event_fd < 0)
+					throw std::runtime_error("unable to create the epoll instance.");
+
+				struct epoll_event ev = { 0 };
+				ev.events = EPOLLIN;
+				ev.data.fd = loop_ptr->event_fd;
+				::epoll_ctl(loop_ptr->epoll_fd, EPOLL_CTL_ADD, loop_ptr->event_fd, &ev);
+
+				m_loops.emplace_back(loop_ptr);
+			}
+
+			for (auto & loop_ptr : m_loops)
+			{
+				std::shared_ptr<loop> p = loop_ptr;
+				m_threads.emplace_back(std::make_shared<std::thread>([p]()
+				{
+					reactor::_loop_func(p);
+				}));
+			}
+		}
+
+		virtual ~reactor()
+		{
+			stop();
+
+			for (auto & loop_ptr : m_loops)
+			{
+				::close(loop_ptr->event_fd);
+				::close(loop_ptr->epoll_fd);
+			}
+		}
+
+		/**
+		 * the process wide reactor,it is created at the first time used,and has 2 loop threads.
+		 */
+		static std::shared_ptr<reactor> get_default()
+		{
+			static std::shared_ptr<reactor> s_reactor_ptr = std::make_shared<reactor>(2);
+			return s_reactor_ptr;
+		}
+
+		/**
+		 * wait for the socket to be ready,the handler is called in the loop thread with the ready
+		 * events,or with event_timeout if the socket is not ready within timeout_ms milliseconds.
+		 * @param timeout_ms zero means no timeout
+		 */
+		void async_wait(int fd, int events, std::size_t timeout_ms, std::function<void(int)> handler)
+		{
+			loop & l = _get_loop(fd);
+
+			uint32_t epoll_events = EPOLLONESHOT;
+			if (events & event_read)   epoll_events |= EPOLLIN;
+			if (events & event_write)  epoll_events |= EPOLLOUT;
+			if (events & event_except) epoll_events |= EPOLLPRI;
+
+			bool added = false;
+			{
+				std::lock_guard<std::mutex> g(l.mtx);
+
+				wait_op & op = l.ops[fd];
+				added = op.added;
+				op.added = true;
+				op.handler = std::move(handler);
+				op.deadline = (timeout_ms > 0 ? std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms) :
+					std::chrono::steady_clock::time_point::max());
+			}
+
+			struct epoll_event ev = { 0 };
+			ev.events = epoll_events;
+			ev.data.fd = fd;
+			if (::epoll_ctl(l.epoll_fd, added ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev) != 0)
+			{
+				if (errno == ENOENT)
+					::epoll_ctl(l.epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+				else if (errno == EEXIST)
+					::epoll_ctl(l.epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+			}
+
+			// wake up the loop,so the new deadline is used
+			if (timeout_ms > 0)
+				_wakeup(l);
+		}
+
+		/**
+		 * remove the socket from the reactor,must be called before the socket is closed.the handler
+		 * of the pending wait is not called.
+		 */
+		void cancel(int fd)
+		{
+			loop & l = _get_loop(fd);
+			{
+				std::lock_guard<std::mutex> g(l.mtx);
+				l.ops.erase(fd);
+			}
+			::epoll_ctl(l.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+		}
+
+		/**
+		 * run the handler in a loop thread.
+		 */
+		void post(std::function<void()> handler)
+		{
+			loop & l = *m_loops[m_next++ % m_loops.size()];
+			{
+				std::lock_guard<std::mutex> g(l.mtx);
+				l.posted.emplace_back(std::move(handler));
+			}
+			_wakeup(l);
+		}
+
+		void stop()
+		{
+			for (auto & loop_ptr : m_loops)
+			{
+				loop_ptr->stopped = true;
+				_wakeup(*loop_ptr);
+			}
+			for (auto & thread_ptr : m_threads)
+			{
+				if (!thread_ptr->joinable())
+					continue;
+				if (thread_ptr->get_id() == std::this_thread::get_id())
+					thread_ptr->detach();
+				else
+					thread_ptr->join();
+			}
+		}
+
+	protected:
+		struct wait_op
+		{
+			bool added = false;
+			std::function<void(int)> handler;
+			std::chrono::steady_clock::time_point deadline;
+		};
+
+		struct loop
+		{
+			int epoll_fd = -1;
+			int event_fd = -1;
+			std::atomic<bool> stopped{ false };
+
+			std::mutex mtx;
+			std::unordered_map<int, wait_op> ops;
+			std::deque<std::function<void()>> posted;
+		};
+
+		loop & _get_loop(int fd)
+		{
+			return *m_loops[(std::size_t)fd % m_loops.size()];
+		}
+
+		static void _wakeup(loop & l)
+		{
+			uint64_t one = 1;
+			ssize_t ret = ::write(l.event_fd, &one, sizeof(one));
+			(void)ret;
+		}
+
+		static void _loop_func(std::shared_ptr<loop> loop_ptr)
+		{
+			loop & l = *loop_ptr;
+			const int max_events = 64;
+			struct epoll_event events[max_events];
+
+			std::vector<std::pair<std::function<void(int)>, int>> ready;
+			std::deque<std::function<void()>> posted;
+
+			while (!l.stopped)
+			{
+				// calc the nearest deadline of the waits
+				int timeout = -1;
+				{
+					std::lock_guard<std::mutex> g(l.mtx);
+					auto now = std::chrono::steady_clock::now();
+					for (auto & pair : l.ops)
+					{
+						if (!pair.second.handler || pair.second.deadline == std::chrono::steady_clock::time_point::max())
+							continue;
+						long long ms = (long long)std::chrono::duration_cast<std::chrono::milliseconds>(pair.second.deadline - now).count();
+						ms = (ms < 0 ? 0 : ms + 1);
+						if (timeout < 0 || ms < timeout)
+							timeout = (int)ms;
+					}
+				}
+
+				int n = ::epoll_wait(l.epoll_fd, events, max_events, timeout);
+				if (n < 0 && errno != EINTR)
+					break;
+
+				{
+					std::lock_guard<std::mutex> g(l.mtx);
+
+					for (int i = 0; i < n; i++)
+					{
+						int fd = events[i].data.fd;
+						if (fd == l.event_fd)
+						{
+							uint64_t value = 0;
+							ssize_t ret = ::read(l.event_fd, &value, sizeof(value));
+							(void)ret;
+							continue;
+						}
+
+						auto iterator = l.ops.find(fd);
+						if (iterator == l.ops.end() || !iterator->second.handler)
+							continue;
+
+						int revents = 0;
+						if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) revents |= event_read;
+						if (events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) revents |= event_write;
+						if (events[i].events & EPOLLPRI) revents |= event_except;
+
+						ready.emplace_back(std::move(iterator->second.handler), revents);
+						iterator->second.handler = nullptr;
+					}
+
+					auto now = std::chrono::steady_clock::now();
+					for (auto & pair : l.ops)
+					{
+						if (pair.second.handler && pair.second.deadline <= now)
+						{
+							ready.emplace_back(std::move(pair.second.handler), (int)event_timeout);
+							pair.second.handler = nullptr;
+						}
+					}
+
+					posted.swap(l.posted);
+				}
+
+				// call the handlers without the lock,because the handlers usually start a new wait
+				for (auto & pair : ready)
+				{
+					pair.first(pair.second);
+				}
+				ready.clear();
+
+				for (auto & handler : posted)
+				{
+					handler();
+				}
+				posted.clear();
+			}
+		}
+
+	protected:
+
+		std::vector<std::shared_ptr<loop>> m_loops;
+
+		std::vector<std::shared_ptr<std::thread>> m_threads;
+
+		std::atomic<std::size_t> m_next{ 0 };
+
+	private:
+		/// no copy construct function
+		reactor(const reactor&) = delete;
+
+		/// no operator equal function
+		reactor& operator=(const reactor&) = delete;
+	};
+
+}
+
+#endif // __linux__
@@ -17,6 +17,8 @@
 #include <algorithm>
 #include <stdexcept>
 #include <unordered_map>
+#include <vector>
+#include <utility>
 
 namespace zdb2 
 {
@@ -24,19 +26,32 @@ namespace zdb2
 	/**
 	 * mysql
 	 * mysql://localhost:3306/test?user=root&password=swordfish
+	 * mysql://db1:3306,db2:3306,db3:3306/test?user=root&password=swordfish&lb=least_conn
 	 * 
 	 * sqlite
 	 * sqlite:///var/sqlite/test.db?synchronous=normal&heap_limit=8000&foreign_keys=on
 	 * 
 	 * postgresql
-	 * postgresql://localhost:5432/test?user=root&password=swordfish
+	 * postgresql://localhost:5432/test?user=root&password=swordfish&fetch-size=1000
 	 * 
 	 * oracle
 	 * oracle://localhost:1521/test?user=scott&password=tiger
 	 * oracle:///servicename?user=scott&password=tiger
 	 *
 	 * sqlserver
-	 * sqlserver://localhost:3306/test?user=root&password=swordfish
+	 * sqlserver://localhost:1433/test?user=sa&password=swordfish
+	 *
+	 * odbc
+	 * odbc://localhost:1433/test?driver=FreeTDS&user=sa&password=swordfish
+	 * odbc:///dsn?user=root&password=swordfish
+	 * odbc:///?driver=SQLite3&database=/var/sqlite/test.db
+	 *
+	 * null (the backend for the benchmarks,see zdb2/db/null/null_util.hpp)
+	 * null:///bench?latency_us=100
+	 *
+	 * The url of the server databases can have a list of hosts separated by ',',the pool spreads
+	 * the connections across the hosts,see zdb2/db/balancer.hpp.get_host() and get_port()
+	 * return the first host.
 	 */
 	class url
 	{
@@ -57,6 +72,26 @@ namespace zdb2
 		std::string get_dbname() { return m_dbname; }
 		std::string get_port()   { return m_port; }
 
+		/**
+		 * Get all the hosts of the url,every element is a pair of host and port.
+		 */
+		std::vector<std::pair<std::string, std::string>> get_hosts() { return m_hosts; }
+
+		/**
+		 * Get a copy of the url which has only one host of the host list.
+		 */
+		std::shared_ptr<url> get_host_url(std::size_t index)
+		{
+			if (index >= m_hosts.size())
+				throw std::runtime_error("the host index is out of range.");
+
+			std::shared_ptr<url> url_ptr(new url(*this));
+			url_ptr->m_host = m_hosts[index].first;
+			url_ptr->m_port = m_hosts[index].second;
+			url_ptr->m_hosts.assign(1, m_hosts[index]);
+			return url_ptr;
+		}
+
 		std::string get_param_value(std::string name)
 		{
 			auto iterator = m_params.find(name);
@@ -67,6 +102,15 @@ namespace zdb2
 			return "";
 		}
 
+		/**
+		 * Set the value of a param,eg : change the params of a copy of the url before a pool is
+		 * created by it.
+		 */
+		void set_param_value(std::string name, std::string value)
+		{
+			m_params[name] = value;
+		}
+
 		template<typename _handler>
 		void for_each_param(_handler h)
 		{
@@ -112,12 +156,19 @@ namespace zdb2
 				return _parse_mysql(pos_host_begin);
 			else if (m_dbtype == "oracle")
 				return _parse_oracle(pos_host_begin);
-			else if (m_dbtype == "postgresql")
+			else if (m_dbtype == "postgresql" || m_dbtype == "postgres")
+			{
+				m_dbtype = "postgresql";
 				return _parse_postgresql(pos_host_begin);
+			}
 			else if (m_dbtype == "sqlite")
 				return _parse_sqlite(pos_host_begin);
 			else if (m_dbtype == "sqlserver")
 				return _parse_sqlserver(pos_host_begin);
+			else if (m_dbtype == "odbc")
+				return _parse_odbc(pos_host_begin);
+			else if (m_dbtype == "null")
+				return _parse_null(pos_host_begin);
 			else
 				throw std::runtime_error("unknown database type.");
 
@@ -143,9 +194,10 @@ namespace zdb2
 		}
 
 		// postgresql://localhost:5432/test?user=root&password=swordfish
+		// postgresql://localhost/test?user=root&password=swordfish (the default port 5432 is used)
 		bool _parse_postgresql(std::size_t pos_host_begin)
 		{
-			return _parse_standard(pos_host_begin);
+			return _parse_standard(pos_host_begin, "5432");
 		}
 
 		// sqlite:///var/sqlite/test.db?synchronous=normal&heap_limit=8000&foreign_keys=on
@@ -165,34 +217,94 @@ namespace zdb2
 			return _parse_params(pos_db_end);
 		}
 
-		// sqlserver://localhost:3306/test?user=root&password=swordfish
+		// sqlserver://localhost:1433/test?user=sa&password=swordfish
 		bool _parse_sqlserver(std::size_t pos_host_begin)
 		{
 			return _parse_standard(pos_host_begin);
 		}
 
-		bool _parse_standard(std::size_t pos_host_begin)
+		// odbc://localhost:1433/test?driver=FreeTDS&user=sa&password=swordfish
+		// odbc:///dsn?user=root&password=swordfish (the data source name,it may be empty)
+		bool _parse_odbc(std::size_t pos_host_begin)
 		{
-			// parse the host
-			std::size_t pos_host_end = m_url.find_first_of(':', pos_host_begin);
-			if (pos_host_end == pos_host_begin || pos_host_end == std::string::npos)
+			if (m_url[pos_host_begin] != '/')
+				return _parse_standard(pos_host_begin);
+
+			pos_host_begin++;
+
+			std::size_t pos_dsn_end = m_url.find_first_of('?', pos_host_begin);
+			if (pos_dsn_end == std::string::npos)
 			{
-				throw std::runtime_error("url string is invalid,no host specified in url.");
+				throw std::runtime_error("url string is invalid,no odbc params specified in url.");
 				return false;
 			}
+			m_dbname = m_url.substr(pos_host_begin, pos_dsn_end - pos_host_begin);
 
-			m_host = m_url.substr(pos_host_begin, pos_host_end - pos_host_begin);
+			pos_dsn_end++;
 
-			pos_host_end++;
+			return _parse_params(pos_dsn_end);
+		}
+
+		// null:///bench?latency_us=100 (the name and the params are optional)
+		bool _parse_null(std::size_t pos_host_begin)
+		{
+			if (m_url[pos_host_begin] == '/')
+				pos_host_begin++;
 
-			// parse the port
-			std::size_t pos_port_end = m_url.find_first_of('/', pos_host_end);
-			if (pos_port_end == pos_host_end || pos_port_end == std::string::npos)
+			std::size_t pos_name_end = m_url.find_first_of('?', pos_host_begin);
+			if (pos_name_end == std::string::npos)
 			{
-				throw std::runtime_error("url string is invalid,no port specified in url.");
+				m_dbname = m_url.substr(pos_host_begin);
+				return true;
+			}
+			m_dbname = m_url.substr(pos_host_begin, pos_name_end - pos_host_begin);
+
+			pos_name_end++;
+
+			return (m_url.length() <= pos_name_end ? true : _parse_params(pos_name_end));
+		}
+
+		bool _parse_standard(std::size_t pos_host_begin, const char * default_port = nullptr)
+		{
+			// parse the hosts,eg : "db1:3306,db2:3306"
+			std::size_t pos_port_end = m_url.find_first_of('/', pos_host_begin);
+			if (pos_port_end == pos_host_begin || pos_port_end == std::string::npos)
+			{
+				throw std::runtime_error("url string is invalid,no host specified in url.");
 				return false;
 			}
-			m_port = m_url.substr(pos_host_end, pos_port_end - pos_host_end);
+
+			std::string hosts = m_url.substr(pos_host_begin, pos_port_end - pos_host_begin);
+			std::size_t pos_head = 0;
+			while (pos_head <= hosts.length())
+			{
+				std::size_t pos_sep = hosts.find_first_of(',', pos_head);
+				if (pos_sep == std::string::npos)
+					pos_sep = hosts.length();
+
+				std::string host = hosts.substr(pos_head, pos_sep - pos_head);
+				std::size_t pos_colon = host.find_first_of(':');
+				if (host.empty() || pos_colon == 0)
+				{
+					throw std::runtime_error("url string is invalid,no host specified in url.");
+					return false;
+				}
+				if ((pos_colon == std::string::npos && !default_port) || pos_colon + 1 == host.length())
+				{
+					throw std::runtime_error("url string is invalid,no port specified in url.");
+					return false;
+				}
+
+				if (pos_colon == std::string::npos)
+					m_hosts.emplace_back(host, default_port);
+				else
+					m_hosts.emplace_back(host.substr(0, pos_colon), host.substr(pos_colon + 1));
+
+				pos_head = pos_sep + 1;
+			}
+
+			m_host = m_hosts.front().first;
+			m_port = m_hosts.front().second;
 
 			pos_port_end++;
 
@@ -272,6 +384,9 @@ namespace zdb2
 		std::string m_dbname;
 		std::string m_port;
 
+		/// the host list,the first one is same as m_host and m_port
+		std::vector<std::pair<std::string, std::string>> m_hosts;
+
 		std::unordered_map<std::string, std::string> m_params;
 
 		void _clear()
@@ -283,6 +398,7 @@ namespace zdb2
 			m_dbname.clear();
 			m_port.clear();
 
+			m_hosts.clear();
 			m_params.clear();
 		}
 
@@ -0,0 +1,212 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ * referenced from : Ulrich Drepper "Futexes Are Tricky"
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_)
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#	pragma comment(lib, "Synchronization.lib")
+#	define ZDB2_FUTEX_WINDOWS
+#elif defined(__linux__)
+#	include <unistd.h>
+#	include <climits>
+#	include <sys/syscall.h>
+#	include <linux/futex.h>
+#	define ZDB2_FUTEX_LINUX
+#else
+#	include <mutex>
+#	include <condition_variable>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#	include <intrin.h>
+#endif
+
+#if defined(ZDB2_LOCK_PROFILING)
+#include <zdb2/util/lock_profile.hpp>
+#endif
+
+namespace zdb2
+{
+
+	/**
+	 * mutex which spins a short time with the pause instruction,and then parks the thread on a
+	 * futex (WaitOnAddress on windows),the unlock wakes one parked thread directly,so a waiter
+	 * never sleeps after the lock is free like the 1ms sleep of spin_lock.
+	 * the state is 0 : unlocked,1 : locked,2 : locked and there may be parked threads,the unlock
+	 * makes a system call only when the state is 2.
+	 * it's a drop in replacement of spin_lock for std::lock_guard.
+	 */
+	class adaptive_mutex
+	{
+	public:
+
+		enum
+		{
+			/// the tries before the thread is parked,every try pauses the cpu a little
+			SPIN_TRIES = 100,
+		};
+
+		adaptive_mutex()
+		{
+		}
+
+		bool try_lock()
+		{
+			int c = 0;
+			return m_state.compare_exchange_strong(c, 1, std::memory_order_acquire, std::memory_order_relaxed);
+		}
+
+		void lock()
+		{
+			if (try_lock())
+			{
+#if defined(ZDB2_LOCK_PROFILING)
+				m_profile.on_acquire(lock_profile::now(), 0, 0, true);
+#endif
+				return;
+			}
+
+#if defined(ZDB2_LOCK_PROFILING)
+			lock_profile::waiter w(m_profile);
+			w.backoff(0);
+#endif
+
+			int c = 0;
+			for (unsigned int k = 0; k < SPIN_TRIES; ++k)
+			{
+				pause();
+				c = m_state.load(std::memory_order_relaxed);
+				if (c == 0 && m_state.compare_exchange_weak(c, 1, std::memory_order_acquire, std::memory_order_relaxed))
+				{
+#if defined(ZDB2_LOCK_PROFILING)
+					w.acquired(true);
+#endif
+					return;
+				}
+				// don't spin when the others are parked already,the lock is busy
+				if (c == 2)
+					break;
+			}
+
+#if defined(ZDB2_LOCK_PROFILING)
+			w.backoff(lock_profile::SPIN_TRIES);
+#endif
+
+			// the state is set to 2 before parking,so the unlock knows it must wake a thread,the
+			// thread which takes the lock here keeps the state 2,because the others may be parked
+			c = m_state.exchange(2, std::memory_order_acquire);
+			while (c != 0)
+			{
+				_wait(2);
+				c = m_state.exchange(2, std::memory_order_acquire);
+			}
+
+#if defined(ZDB2_LOCK_PROFILING)
+			w.acquired(true);
+#endif
+		}
+
+		void unlock()
+		{
+#if defined(ZDB2_LOCK_PROFILING)
+			m_profile.on_release();
+#endif
+			if (m_state.exchange(0, std::memory_order_release) == 2)
+				_wake_one();
+		}
+
+		/**
+		 * set the name of the lock in the report of lock_profile,it does nothing unless the macro
+		 * ZDB2_LOCK_PROFILING is defined.
+		 */
+		void set_name(const char * name)
+		{
+#if defined(ZDB2_LOCK_PROFILING)
+			m_profile.set_name(name);
+#else
+			(void)name;
+#endif
+		}
+
+		/**
+		 * pause the cpu a little in a spin loop,it's cheaper than yield.
+		 */
+		static inline void pause()
+		{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+			_mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+			__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+			__asm__ __volatile__("yield" ::: "memory");
+#else
+			std::this_thread::yield();
+#endif
+		}
+
+	protected:
+
+		/// park the thread while the state is equal to the value
+		void _wait(int value)
+		{
+#if defined(ZDB2_FUTEX_LINUX)
+			syscall(SYS_futex, (int *)&m_state, FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+#elif defined(ZDB2_FUTEX_WINDOWS)
+			WaitOnAddress((volatile VOID *)&m_state, (PVOID)&value, sizeof(int), INFINITE);
+#else
+			std::unique_lock<std::mutex> g(m_park_mtx);
+			while (m_state.load(std::memory_order_relaxed) == value)
+				m_park_cv.wait(g);
+#endif
+		}
+
+		void _wake_one()
+		{
+#if defined(ZDB2_FUTEX_LINUX)
+			syscall(SYS_futex, (int *)&m_state, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#elif defined(ZDB2_FUTEX_WINDOWS)
+			WakeByAddressSingle((PVOID)&m_state);
+#else
+			std::lock_guard<std::mutex> g(m_park_mtx);
+			m_park_cv.notify_one();
+#endif
+		}
+
+	private:
+		/// no copy construct function
+		adaptive_mutex(const adaptive_mutex&) = delete;
+
+		/// no operator equal function
+		adaptive_mutex& operator=(const adaptive_mutex&) = delete;
+
+	protected:
+
+		std::atomic<int> m_state{ 0 };
+
+#if !defined(ZDB2_FUTEX_LINUX) && !defined(ZDB2_FUTEX_WINDOWS)
+		std::mutex m_park_mtx;
+		std::condition_variable m_park_cv;
+#endif
+
+#if defined(ZDB2_LOCK_PROFILING)
+		lock_profile m_profile{ "adaptive_mutex" };
+#endif
+	};
+
+}
@@ -0,0 +1,361 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ * referenced from : the linux kernel "brlock" (big reader lock)
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+
+#include <zdb2/util/adaptive_mutex.hpp>
+
+#if defined(ZDB2_LOCK_PROFILING)
+#include <zdb2/util/lock_profile.hpp>
+#endif
+
+namespace zdb2
+{
+
+	/**
+	 * big reader lock,the read lock is much cheaper than the write lock.
+	 * every thread has it's own reader slot which is on a separate cache line,so the readers of
+	 * different threads don't touch the same cache line,and the writer must check all the slots.
+	 * it's for the read mostly data,eg : the shard map,the routing table,and the interface is the
+	 * same as rwlock,use br_rlock_guard and br_wlock_guard.
+	 * the threads waiting for a writer are parked on the writer mutex,nobody sleeps.
+	 */
+	class br_rwlock
+	{
+	public:
+
+		enum
+		{
+			CACHE_LINE_SIZE = 64,
+
+			/// the max slots,if there are more threads than slots,some threads share a slot
+			MAX_SLOTS = 256,
+
+			/// the tries before the writer yields when it waits for the readers
+			SPIN_TRIES = 100,
+		};
+
+		/**
+		 * @param is_write_first If true a waiting writer blocks the new readers,otherwise the
+		 * writer waits until there are no readers
+		 * @param slots The reader slots,0 means twice the cpu cores,it's rounded up to a power of 2
+		 */
+		br_rwlock(bool is_write_first = true, std::size_t slots = 0)
+			: m_is_write_first(is_write_first)
+		{
+			if (slots == 0)
+				slots = 2 * (std::max)(std::thread::hardware_concurrency(), 1u);
+			if (slots > MAX_SLOTS)
+				slots = MAX_SLOTS;
+
+			m_slot_count = 1;
+			while (m_slot_count < slots)
+				m_slot_count <<= 1;
+
+			// operator new doesn't support the over aligned type before c++17,so align the buffer
+			// by hand
+			m_buffer.reset(new char[m_slot_count * sizeof(slot) + CACHE_LINE_SIZE]);
+			std::uintptr_t p = reinterpret_cast<std::uintptr_t>(m_buffer.get());
+			p = (p + CACHE_LINE_SIZE - 1) & ~(std::uintptr_t)(CACHE_LINE_SIZE - 1);
+			m_slots = reinterpret_cast<slot *>(p);
+			for (std::size_t i = 0; i < m_slot_count; i++)
+				new (&m_slots[i]) slot();
+		}
+
+		~br_rwlock()
+		{
+			for (std::size_t i = 0; i < m_slot_count; i++)
+				m_slots[i].~slot();
+		}
+
+		bool try_lock_read()
+		{
+			std::atomic_int & readers = _slot().readers;
+
+			// the order of the increment and the check of the writer is the same as the writer's
+			// (set the state,then check the readers),so one of them always sees the other one
+			readers.fetch_add(1, std::memory_order_seq_cst);
+			int state = m_state.load(std::memory_order_seq_cst);
+			if (state == WRITE_LOCKED || (m_is_write_first && state == WRITE_WAITING))
+			{
+				readers.fetch_sub(1, std::memory_order_release);
+				return false;
+			}
+			return true;
+		}
+
+		void lock_read()
+		{
+			if (try_lock_read())
+			{
+#if defined(ZDB2_LOCK_PROFILING)
+				m_profile.on_acquire(lock_profile::now(), 0, 0, false);
+#endif
+				return;
+			}
+
+#if defined(ZDB2_LOCK_PROFILING)
+			lock_profile::waiter w(m_profile);
+			w.backoff(lock_profile::SPIN_TRIES);
+#endif
+			do
+			{
+				// the writer holds the writer mutex until it unlocks,so wait on it
+				m_write_mtx.lock();
+				m_write_mtx.unlock();
+			} while (!try_lock_read());
+
+#if defined(ZDB2_LOCK_PROFILING)
+			w.acquired(false);
+#endif
+		}
+
+		void unlock_read()
+		{
+			int count = _slot().readers.fetch_sub(1, std::memory_order_release);
+
+#if defined(_DEBUG) || defined(DEBUG)
+			if (count <= 0)
+				throw std::runtime_error("exception : read lock count is less than 0,check whether lock_read/unlock_read missing match.");
+#else
+			(void)count;
+#endif // _DEBUG DEBUG
+		}
+
+		bool try_lock_write()
+		{
+			if (!m_write_mtx.try_lock())
+				return false;
+
+			m_state.store(WRITE_LOCKED, std::memory_order_seq_cst);
+			if (_has_readers())
+			{
+				m_state.store(IDLE, std::memory_order_release);
+				m_write_mtx.unlock();
+				return false;
+			}
+			return true;
+		}
+
+		void lock_write()
+		{
+#if defined(ZDB2_LOCK_PROFILING)
+			lock_profile::waiter w(m_profile);
+#endif
+			// the writers are serialized by the writer mutex,and the readers which are blocked by
+			// the writer are parked on it too
+			m_write_mtx.lock();
+
+			if (m_is_write_first)
+			{
+				// block the new readers at once,then wait for the readers which are in already
+				m_state.store(WRITE_LOCKED, std::memory_order_seq_cst);
+				for (unsigned int k = 0; _has_readers(); ++k)
+				{
+#if defined(ZDB2_LOCK_PROFILING)
+					w.backoff(k);
+#endif
+					_backoff(k);
+				}
+			}
+			else
+			{
+				// the new readers can still enter while the writer is waiting,the writer gets the
+				// lock only when it sees no readers after it has blocked the readers
+				for (unsigned int k = 0; ; ++k)
+				{
+					m_state.store(WRITE_LOCKED, std::memory_order_seq_cst);
+					if (!_has_readers())
+						break;
+					m_state.store(WRITE_WAITING, std::memory_order_seq_cst);
+
+#if defined(ZDB2_LOCK_PROFILING)
+					w.backoff(k);
+#endif
+					while (_has_readers())
+						_backoff(k++);
+				}
+			}
+
+#if defined(ZDB2_LOCK_PROFILING)
+			w.acquired(true);
+#endif
+		}
+
+		void unlock_write()
+		{
+#if defined(ZDB2_LOCK_PROFILING)
+			m_profile.on_release();
+#endif
+			m_state.store(IDLE, std::memory_order_release);
+			m_write_mtx.unlock();
+		}
+
+		std::size_t get_slot_count() const
+		{
+			return m_slot_count;
+		}
+
+		/**
+		 * set the name of the lock in the report of lock_profile,it does nothing unless the macro
+		 * ZDB2_LOCK_PROFILING is defined.
+		 */
+		void set_name(const char * name)
+		{
+#if defined(ZDB2_LOCK_PROFILING)
+			m_profile.set_name(name);
+			m_write_mtx.set_name((std::string(name ? name : "") + ".writer").c_str());
+#else
+			(void)name;
+#endif
+		}
+
+	protected:
+
+		enum
+		{
+			IDLE = 0,
+
+			/// the writer is waiting for the readers,the new readers can enter if it's not write first
+			WRITE_WAITING = 1,
+
+			WRITE_LOCKED = 2,
+		};
+
+		struct slot
+		{
+			std::atomic_int readers{ 0 };
+
+			char padding[CACHE_LINE_SIZE - sizeof(std::atomic_int)];
+		};
+
+		/// the index of the thread,it's given in the order of the first lock of the threads
+		static std::size_t _thread_index()
+		{
+			static std::atomic<std::size_t> next{ 0 };
+			static thread_local std::size_t index = next++;
+			return index;
+		}
+
+		inline slot & _slot()
+		{
+			return m_slots[_thread_index() & (m_slot_count - 1)];
+		}
+
+		bool _has_readers()
+		{
+			for (std::size_t i = 0; i < m_slot_count; i++)
+			{
+				if (m_slots[i].readers.load(std::memory_order_seq_cst) != 0)
+					return true;
+			}
+			return false;
+		}
+
+		/// the readers don't notify the writer when they unlock,so the writer spins and yields
+		static void _backoff(unsigned int k)
+		{
+			if (k < SPIN_TRIES)
+			{
+				adaptive_mutex::pause();
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+
+	private:
+		/// no copy construct function
+		br_rwlock(const br_rwlock&) = delete;
+
+		/// no operator equal function
+		br_rwlock& operator=(const br_rwlock&) = delete;
+
+	private:
+
+		std::unique_ptr<char[]> m_buffer;
+
+		/// the reader slots,they are in m_buffer and aligned to the cache line
+		slot * m_slots = nullptr;
+
+		std::size_t m_slot_count = 0;
+
+		/// it's read by every reader and written only by the writers
+		std::atomic_int m_state{ IDLE };
+
+		/// keep the writer mutex which is written by the parked readers away from m_state
+		char m_padding[CACHE_LINE_SIZE];
+
+		/// serialize the writers,and park the readers which are blocked by a writer
+		adaptive_mutex m_write_mtx;
+
+		/// is write first or not
+		const bool m_is_write_first = true;
+
+#if defined(ZDB2_LOCK_PROFILING)
+		lock_profile m_profile{ "br_rwlock" };
+#endif
+	};
+
+	/**
+	 * auto call lock_read and unlock_read
+	 */
+	class br_rlock_guard
+	{
+	public:
+		explicit br_rlock_guard(br_rwlock & lock) : m_rwlock(lock)
+		{
+			m_rwlock.lock_read();
+		}
+		~br_rlock_guard()
+		{
+			m_rwlock.unlock_read();
+		}
+	private:
+		br_rwlock & m_rwlock;
+
+		br_rlock_guard(const br_rlock_guard&) = delete;
+		br_rlock_guard& operator=(const br_rlock_guard&) = delete;
+	};
+
+	/**
+	 * auto call lock_write and unlock_write
+	 */
+	class br_wlock_guard
+	{
+	public:
+		explicit br_wlock_guard(br_rwlock & lock) : m_rwlock(lock)
+		{
+			m_rwlock.lock_write();
+		}
+		~br_wlock_guard()
+		{
+			m_rwlock.unlock_write();
+		}
+	private:
+		br_rwlock & m_rwlock;
+
+		br_wlock_guard(const br_wlock_guard&) = delete;
+		br_wlock_guard& operator=(const br_wlock_guard&) = delete;
+	};
+
+}
@@ -0,0 +1,280 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+#include <zdb2/util/adaptive_mutex.hpp>
+
+namespace zdb2
+{
+
+	/**
+	 * bounded work stealing thread pool.
+	 * every worker owns a task queue,a worker pops tasks from the back of its own queue and
+	 * steals from the front of the other workers queues when it's own queue is empty.
+	 */
+	class executor
+	{
+	public:
+		executor(std::size_t thread_count, std::size_t max_pending)
+			: m_state_ptr(std::make_shared<state>())
+		{
+			if (thread_count == 0)
+				thread_count = 1;
+
+			m_state_ptr->max_pending = (max_pending == 0 ? 1 : max_pending);
+			m_state_ptr->queues.reserve(thread_count);
+
+			for (std::size_t i = 0; i < thread_count; i++)
+			{
+				m_state_ptr->queues.emplace_back(std::make_shared<task_queue>());
+				m_state_ptr->queues.back()->lock.set_name("executor.queue");
+			}
+
+			// [important] : the worker threads hold the state by shared_ptr,not "this" pointer,because the
+			// executor may be destroyed inside one of its own worker threads (eg : the last reference of
+			// the owner object is released by a task),at this time the worker thread is detached instead
+			// of joined,and it must can still access the state safely after the executor is destroyed.
+			for (std::size_t i = 0; i < thread_count; i++)
+			{
+				std::shared_ptr<state> state_ptr = m_state_ptr;
+				m_threads.emplace_back(std::make_shared<std::thread>([state_ptr, i]()
+				{
+					executor::_worker_func(state_ptr, i);
+				}));
+			}
+		}
+
+		virtual ~executor()
+		{
+			stop();
+		}
+
+		/**
+		 * post a task to the executor.
+		 * @return false if the executor is stopped or the pending task count has reached the
+		 * max pending limit,in this case the task is not queued.
+		 */
+		bool post(std::function<void()> task)
+		{
+			state & s = *m_state_ptr;
+
+			if (s.stopped)
+				return false;
+
+			// reserve a pending slot first,so the limit can't be exceeded by concurrent posters
+			std::size_t pending = s.pending.load();
+			do
+			{
+				if (pending >= s.max_pending)
+					return false;
+			} while (!s.pending.compare_exchange_weak(pending, pending + 1));
+
+			// if called from one of our own workers,push to the worker's own queue,otherwise
+			// distribute the tasks to the queues round robin.
+			std::size_t index = (_tls_state() == &s) ? _tls_index() : (s.next++ % s.queues.size());
+
+			{
+				std::lock_guard<adaptive_mutex> g(s.queues[index]->lock);
+				s.queues[index]->tasks.emplace_back(std::move(task));
+			}
+
+			{
+				std::lock_guard<std::mutex> g(s.mtx);
+				s.signal++;
+			}
+			s.cv.notify_one();
+
+			return true;
+		}
+
+		/**
+		 * stop all the worker threads,the tasks which are not started will be discarded,the
+		 * discarded tasks are destroyed without being called.
+		 */
+		void stop()
+		{
+			{
+				std::lock_guard<std::mutex> g(m_state_ptr->mtx);
+				if (m_state_ptr->stopped)
+					return;
+				m_state_ptr->stopped = true;
+			}
+			m_state_ptr->cv.notify_all();
+
+			for (auto & thread_ptr : m_threads)
+			{
+				if (!thread_ptr->joinable())
+					continue;
+				if (thread_ptr->get_id() == std::this_thread::get_id())
+					thread_ptr->detach();
+				else
+					thread_ptr->join();
+			}
+
+			std::deque<std::function<void()>> discarded;
+			for (auto & queue_ptr : m_state_ptr->queues)
+			{
+				std::lock_guard<adaptive_mutex> g(queue_ptr->lock);
+				for (auto & task : queue_ptr->tasks)
+					discarded.emplace_back(std::move(task));
+				queue_ptr->tasks.clear();
+			}
+			m_state_ptr->pending = 0;
+
+			// the tasks are destroyed without the lock,because the destructor of a task may do
+			// anything,eg : complete an async operation with an error,see awaitable.hpp
+			discarded.clear();
+		}
+
+		bool is_stopped()
+		{
+			return m_state_ptr->stopped.load();
+		}
+
+		std::size_t get_thread_count()
+		{
+			return m_threads.size();
+		}
+
+		std::size_t get_pending_count()
+		{
+			return m_state_ptr->pending.load();
+		}
+
+		std::size_t get_max_pending()
+		{
+			return m_state_ptr->max_pending;
+		}
+
+	protected:
+		struct task_queue
+		{
+			adaptive_mutex lock;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		struct state
+		{
+			std::vector<std::shared_ptr<task_queue>> queues;
+
+			std::atomic<std::size_t> pending{ 0 };
+			std::size_t max_pending = 0;
+			std::atomic<std::size_t> next{ 0 };
+
+			/// used to sleep the idle workers and wake them up when new task is posted
+			std::mutex mtx;
+			std::condition_variable cv;
+			std::size_t signal = 0;
+			std::atomic<bool> stopped{ false };
+		};
+
+		static state *& _tls_state()
+		{
+			static thread_local state * s = nullptr;
+			return s;
+		}
+
+		static std::size_t & _tls_index()
+		{
+			static thread_local std::size_t i = 0;
+			return i;
+		}
+
+		static bool _pop_task(state & s, std::size_t index, std::function<void()> & task)
+		{
+			// own queue first,lifo for cache locality
+			{
+				task_queue & q = *s.queues[index];
+				std::lock_guard<adaptive_mutex> g(q.lock);
+				if (!q.tasks.empty())
+				{
+					task = std::move(q.tasks.back());
+					q.tasks.pop_back();
+					return true;
+				}
+			}
+
+			// steal from the other workers,fifo
+			for (std::size_t n = 1; n < s.queues.size(); n++)
+			{
+				task_queue & q = *s.queues[(index + n) % s.queues.size()];
+				std::lock_guard<adaptive_mutex> g(q.lock);
+				if (!q.tasks.empty())
+				{
+					task = std::move(q.tasks.front());
+					q.tasks.pop_front();
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		static void _worker_func(std::shared_ptr<state> state_ptr, std::size_t index)
+		{
+			state & s = *state_ptr;
+
+			_tls_state() = &s;
+			_tls_index() = index;
+
+			std::size_t seen = 0;
+
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lck(s.mtx);
+					if (s.stopped)
+						break;
+					seen = s.signal;
+				}
+
+				std::function<void()> task;
+				while (!s.stopped && _pop_task(s, index, task))
+				{
+					s.pending--;
+					// the task should handle it's exceptions by itself (eg : std::packaged_task),
+					// here we just make sure the worker thread won't be terminated.
+					try { task(); } catch (...) {}
+					task = nullptr;
+				}
+
+				std::unique_lock<std::mutex> lck(s.mtx);
+				s.cv.wait(lck, [&s, seen]() { return s.stopped || s.signal != seen; });
+			}
+
+			_tls_state() = nullptr;
+		}
+
+	protected:
+
+		std::shared_ptr<state> m_state_ptr;
+
+		std::vector<std::shared_ptr<std::thread>> m_threads;
+
+	private:
+		/// no copy construct function
+		executor(const executor&) = delete;
+
+		/// no operator equal function
+		executor& operator=(const executor&) = delete;
+	};
+
+}
@@ -0,0 +1,202 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <limits>
+
+namespace zdb2
+{
+
+	/**
+	 * lock free histogram of the unsigned integer values,eg : latency in microseconds.
+	 * the buckets are log linear like the HdrHistogram,every power of 2 is split into 32 sub
+	 * buckets,so the relative error of the percentiles is less than 1/32 (about 3%).the values
+	 * greater than 2^41 are counted in the last bucket.
+	 */
+	class histogram
+	{
+	public:
+
+		enum
+		{
+			SUB_BUCKET_BITS = 5,
+			SUB_BUCKETS     = 1 << SUB_BUCKET_BITS,
+			MAX_BITS        = 41,
+			BUCKETS         = SUB_BUCKETS + (MAX_BITS - SUB_BUCKET_BITS) * SUB_BUCKETS,
+		};
+
+		histogram()
+		{
+			reset();
+		}
+
+		void record(uint64_t value)
+		{
+			m_counts[index_of(value)].fetch_add(1, std::memory_order_relaxed);
+			m_count.fetch_add(1, std::memory_order_relaxed);
+			m_sum.fetch_add(value, std::memory_order_relaxed);
+
+			uint64_t v = m_min.load(std::memory_order_relaxed);
+			while (value < v && !m_min.compare_exchange_weak(v, value, std::memory_order_relaxed));
+
+			v = m_max.load(std::memory_order_relaxed);
+			while (value > v && !m_max.compare_exchange_weak(v, value, std::memory_order_relaxed));
+		}
+
+		/**
+		 * add the values of the other histogram into this histogram.
+		 */
+		void merge(const histogram & other)
+		{
+			for (int i = 0; i < BUCKETS; i++)
+			{
+				uint64_t n = other.m_counts[i].load(std::memory_order_relaxed);
+				if (n > 0)
+					m_counts[i].fetch_add(n, std::memory_order_relaxed);
+			}
+			m_count.fetch_add(other.m_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			m_sum.fetch_add(other.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+			uint64_t value = other.m_min.load(std::memory_order_relaxed);
+			uint64_t v = m_min.load(std::memory_order_relaxed);
+			while (value < v && !m_min.compare_exchange_weak(v, value, std::memory_order_relaxed));
+
+			value = other.m_max.load(std::memory_order_relaxed);
+			v = m_max.load(std::memory_order_relaxed);
+			while (value > v && !m_max.compare_exchange_weak(v, value, std::memory_order_relaxed));
+		}
+
+		void reset()
+		{
+			for (int i = 0; i < BUCKETS; i++)
+				m_counts[i].store(0, std::memory_order_relaxed);
+			m_count.store(0, std::memory_order_relaxed);
+			m_sum.store(0, std::memory_order_relaxed);
+			m_min.store((std::numeric_limits<uint64_t>::max)(), std::memory_order_relaxed);
+			m_max.store(0, std::memory_order_relaxed);
+		}
+
+		uint64_t get_count() const { return m_count.load(std::memory_order_relaxed); }
+		uint64_t get_sum()   const { return m_sum.load(std::memory_order_relaxed);   }
+		uint64_t get_max()   const { return m_max.load(std::memory_order_relaxed);   }
+
+		uint64_t get_min() const
+		{
+			return (get_count() > 0 ? m_min.load(std::memory_order_relaxed) : 0);
+		}
+
+		double get_mean() const
+		{
+			uint64_t count = get_count();
+			return (count > 0 ? (double)get_sum() / (double)count : 0);
+		}
+
+		/**
+		 * get the value at the percentile,eg : 99.9,the highest value of the bucket is returned.
+		 */
+		uint64_t get_percentile(double percentile) const
+		{
+			uint64_t count = get_count();
+			if (count == 0)
+				return 0;
+
+			if (percentile < 0)
+				percentile = 0;
+			if (percentile > 100)
+				percentile = 100;
+
+			uint64_t rank = (uint64_t)(percentile / 100.0 * (double)count + 0.5);
+			if (rank == 0)
+				rank = 1;
+
+			uint64_t seen = 0;
+			for (int i = 0; i < BUCKETS; i++)
+			{
+				seen += m_counts[i].load(std::memory_order_relaxed);
+				if (seen >= rank)
+				{
+					uint64_t value = highest_of(i);
+					uint64_t max = get_max();
+					return (value < max ? value : max);
+				}
+			}
+			return get_max();
+		}
+
+		/**
+		 * get the count of the values in the bucket.
+		 */
+		uint64_t get_bucket_count(int index) const
+		{
+			return m_counts[index].load(std::memory_order_relaxed);
+		}
+
+		static int index_of(uint64_t value)
+		{
+			if (value < SUB_BUCKETS)
+				return (int)value;
+
+			int bits = _msb(value);
+			if (bits >= MAX_BITS)
+				return BUCKETS - 1;
+
+			int shift = bits - SUB_BUCKET_BITS;
+			return SUB_BUCKETS + shift * SUB_BUCKETS + (int)((value >> shift) - SUB_BUCKETS);
+		}
+
+		static uint64_t lowest_of(int index)
+		{
+			if (index < SUB_BUCKETS)
+				return (uint64_t)index;
+
+			int shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+			uint64_t sub = (uint64_t)((index - SUB_BUCKETS) % SUB_BUCKETS);
+			return (SUB_BUCKETS + sub) << shift;
+		}
+
+		static uint64_t highest_of(int index)
+		{
+			if (index < SUB_BUCKETS)
+				return (uint64_t)index;
+
+			int shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+			return lowest_of(index) + (((uint64_t)1 << shift) - 1);
+		}
+
+	protected:
+
+		/// the index of the highest bit which is 1,the value must not be 0
+		static int _msb(uint64_t value)
+		{
+			int n = 0;
+			if (value >> 32) { value >>= 32; n += 32; }
+			if (value >> 16) { value >>= 16; n += 16; }
+			if (value >>  8) { value >>=  8; n +=  8; }
+			if (value >>  4) { value >>=  4; n +=  4; }
+			if (value >>  2) { value >>=  2; n +=  2; }
+			if (value >>  1) { n += 1; }
+			return n;
+		}
+
+	protected:
+
+		std::atomic<uint64_t> m_counts[BUCKETS];
+
+		std::atomic<uint64_t> m_count;
+		std::atomic<uint64_t> m_sum;
+		std::atomic<uint64_t> m_min;
+		std::atomic<uint64_t> m_max;
+
+	};
+
+}
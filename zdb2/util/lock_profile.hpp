@@ -0,0 +1,312 @@
+/*
+ * COPYRIGHT (C) 2017, zhllxt
+ *
+ * Author   : zhllxt
+ * QQ       : 37792738
+ * Email    : 37792738@qq.com
+ *
+ */
+
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+
+namespace zdb2
+{
+
+	/**
+	 * The contention counters of a lock,they are used by spin_lock and rwlock when the macro
+	 * ZDB2_LOCK_PROFILING is defined,eg :
+	 *
+	 * // compile with -DZDB2_LOCK_PROFILING
+	 * m_lock.set_name("pool");
+	 * ...
+	 * printf("%s", zdb2::lock_profile::report_string().c_str());
+	 *
+	 * A contended acquire is an acquire which is not successful at the first try.The time a
+	 * contended acquire waits is split into the spin time (the first 16 tries,which yield) and
+	 * the sleep time (the later tries,which sleep 0 or 1 millisecond).The hold time is measured
+	 * for the exclusive locks only.When a lock is destroyed,it's counters are added into the
+	 * retired counters of it's name (or it's kind if it has no name),so the report contains the
+	 * destroyed locks too.
+	 */
+	class lock_profile
+	{
+	public:
+
+		/**
+		 * the counters of a lock,or of all the destroyed locks of a name.
+		 */
+		struct snapshot
+		{
+			std::string name;
+
+			/// the count of the locks,the destroyed locks of the same name are merged
+			uint64_t instances = 0;
+
+			uint64_t acquires = 0;
+			uint64_t contended = 0;
+
+			uint64_t spin_ns = 0;
+			uint64_t sleep_ns = 0;
+
+			uint64_t max_wait_ns = 0;
+			uint64_t max_hold_ns = 0;
+		};
+
+		/**
+		 * measure a contended acquire,it's created on the stack of lock().
+		 */
+		class waiter
+		{
+		public:
+			waiter(lock_profile & profile) : m_profile(profile)
+			{
+			}
+
+			/// called before every backoff of the lock loop
+			inline void backoff(unsigned int k)
+			{
+				if (k == 0)
+					m_begin = lock_profile::now();
+				else if (k == SPIN_TRIES)
+					m_sleep_begin = lock_profile::now();
+			}
+
+			/// called when the lock is acquired
+			inline void acquired(bool exclusive)
+			{
+				int64_t now = lock_profile::now();
+				if (m_begin == 0)
+				{
+					m_profile.on_acquire(now, 0, 0, exclusive);
+					return;
+				}
+
+				int64_t spin_end = (m_sleep_begin != 0 ? m_sleep_begin : now);
+				int64_t sleep_ns = (m_sleep_begin != 0 ? now - m_sleep_begin : 0);
+				m_profile.on_acquire(now, (uint64_t)(spin_end - m_begin), (uint64_t)sleep_ns, exclusive);
+			}
+
+		protected:
+			lock_profile & m_profile;
+
+			int64_t m_begin = 0;
+			int64_t m_sleep_begin = 0;
+		};
+
+		enum
+		{
+			/// the tries which yield before the lock sleeps,the same as spin_lock and rwlock
+			SPIN_TRIES = 16,
+		};
+
+		lock_profile(const char * kind) : m_kind(kind)
+		{
+			std::lock_guard<std::mutex> g(_mtx());
+			_profiles().emplace_back(this);
+		}
+
+		~lock_profile()
+		{
+			std::lock_guard<std::mutex> g(_mtx());
+
+			auto & profiles = _profiles();
+			profiles.erase(std::remove(profiles.begin(), profiles.end(), this), profiles.end());
+
+			// the unnamed locks are merged by the kind,their addresses are reused by the new locks,
+			// and the retired counters would grow with every one of them
+			snapshot s = _snapshot();
+			if (m_name.empty())
+				s.name = m_kind;
+
+			snapshot & retired = _retired()[s.name];
+			retired.name         = s.name;
+			retired.instances   += 1;
+			retired.acquires    += s.acquires;
+			retired.contended   += s.contended;
+			retired.spin_ns     += s.spin_ns;
+			retired.sleep_ns    += s.sleep_ns;
+			retired.max_wait_ns  = (std::max)(retired.max_wait_ns, s.max_wait_ns);
+			retired.max_hold_ns  = (std::max)(retired.max_hold_ns, s.max_hold_ns);
+		}
+
+		void set_name(const char * name)
+		{
+			std::lock_guard<std::mutex> g(_mtx());
+			m_name = (name ? name : "");
+		}
+
+		void on_acquire(int64_t now, uint64_t spin_ns, uint64_t sleep_ns, bool exclusive)
+		{
+			m_acquires.fetch_add(1, std::memory_order_relaxed);
+			if (spin_ns > 0 || sleep_ns > 0)
+			{
+				m_contended.fetch_add(1, std::memory_order_relaxed);
+				m_spin_ns.fetch_add(spin_ns, std::memory_order_relaxed);
+				m_sleep_ns.fetch_add(sleep_ns, std::memory_order_relaxed);
+				_update_max(m_max_wait_ns, spin_ns + sleep_ns);
+			}
+			if (exclusive)
+				m_hold_begin = now;
+		}
+
+		/// called by the exclusive owner before the lock is released
+		void on_release()
+		{
+			if (m_hold_begin != 0)
+			{
+				_update_max(m_max_hold_ns, (uint64_t)(now() - m_hold_begin));
+				m_hold_begin = 0;
+			}
+		}
+
+		static inline int64_t now()
+		{
+			return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		/**
+		 * Get the counters of all the living locks and the retired counters of the destroyed locks,
+		 * the locks which wait most are the first.
+		 */
+		static std::vector<snapshot> report()
+		{
+			std::vector<snapshot> snapshots;
+			{
+				std::lock_guard<std::mutex> g(_mtx());
+				for (auto profile : _profiles())
+					snapshots.emplace_back(profile->_snapshot());
+				for (auto & pair : _retired())
+				{
+					snapshots.emplace_back(pair.second);
+					snapshots.back().name += " (destroyed)";
+				}
+			}
+
+			std::sort(snapshots.begin(), snapshots.end(), [](const snapshot & a, const snapshot & b)
+			{
+				return (a.spin_ns + a.sleep_ns) > (b.spin_ns + b.sleep_ns);
+			});
+			return snapshots;
+		}
+
+		/**
+		 * Get the report as a text table.
+		 */
+		static std::string report_string()
+		{
+			std::string s;
+			char line[512];
+			std::snprintf(line, sizeof(line), "%-40s %9s %12s %10s %7s %12s %12s %12s %12s\n",
+				"lock", "instances", "acquires", "contended", "%", "spin_us", "sleep_us", "max_wait_us", "max_hold_us");
+			s += line;
+
+			for (auto & r : report())
+			{
+				std::snprintf(line, sizeof(line), "%-40s %9llu %12llu %10llu %6.2f%% %12llu %12llu %12llu %12llu\n",
+					r.name.c_str(), (unsigned long long)r.instances, (unsigned long long)r.acquires,
+					(unsigned long long)r.contended, (r.acquires > 0 ? 100.0 * (double)r.contended / (double)r.acquires : 0.0),
+					(unsigned long long)(r.spin_ns / 1000), (unsigned long long)(r.sleep_ns / 1000),
+					(unsigned long long)(r.max_wait_ns / 1000), (unsigned long long)(r.max_hold_ns / 1000));
+				s += line;
+			}
+			return s;
+		}
+
+		/**
+		 * Clear the counters of all the locks.
+		 */
+		static void reset()
+		{
+			std::lock_guard<std::mutex> g(_mtx());
+			for (auto profile : _profiles())
+			{
+				profile->m_acquires    = 0;
+				profile->m_contended   = 0;
+				profile->m_spin_ns     = 0;
+				profile->m_sleep_ns    = 0;
+				profile->m_max_wait_ns = 0;
+				profile->m_max_hold_ns = 0;
+			}
+			_retired().clear();
+		}
+
+	protected:
+
+		/// the registry mutex is held by the caller
+		snapshot _snapshot()
+		{
+			snapshot s;
+			if (m_name.empty())
+			{
+				char name[64];
+				std::snprintf(name, sizeof(name), "%s@%p", m_kind, (void *)this);
+				s.name = name;
+			}
+			else
+			{
+				s.name = m_name;
+			}
+			s.instances   = 1;
+			s.acquires    = m_acquires;
+			s.contended   = m_contended;
+			s.spin_ns     = m_spin_ns;
+			s.sleep_ns    = m_sleep_ns;
+			s.max_wait_ns = m_max_wait_ns;
+			s.max_hold_ns = m_max_hold_ns;
+			return s;
+		}
+
+		static void _update_max(std::atomic<uint64_t> & max, uint64_t value)
+		{
+			uint64_t v = max.load(std::memory_order_relaxed);
+			while (value > v && !max.compare_exchange_weak(v, value, std::memory_order_relaxed));
+		}
+
+		static std::mutex & _mtx()
+		{
+			static std::mutex mtx;
+			return mtx;
+		}
+
+		static std::vector<lock_profile *> & _profiles()
+		{
+			static std::vector<lock_profile *> profiles;
+			return profiles;
+		}
+
+		static std::map<std::string, snapshot> & _retired()
+		{
+			static std::map<std::string, snapshot> retired;
+			return retired;
+		}
+
+	protected:
+
+		const char * m_kind = "";
+
+		std::string m_name;
+
+		std::atomic<uint64_t> m_acquires{ 0 };
+		std::atomic<uint64_t> m_contended{ 0 };
+		std::atomic<uint64_t> m_spin_ns{ 0 };
+		std::atomic<uint64_t> m_sleep_ns{ 0 };
+		std::atomic<uint64_t> m_max_wait_ns{ 0 };
+		std::atomic<uint64_t> m_max_hold_ns{ 0 };
+
+		/// the time the exclusive owner acquired the lock,it's accessed by the owner only
+		int64_t m_hold_begin = 0;
+	};
+
+}
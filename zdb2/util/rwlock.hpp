@@ -12,8 +12,13 @@
 
 #include <atomic>
 #include <thread>
+#include <chrono>
 #include <stdexcept>
 
+#if defined(ZDB2_LOCK_PROFILING)
+#include <zdb2/util/lock_profile.hpp>
+#endif
+
 namespace zdb2
 {
 
@@ -45,8 +50,14 @@ namespace zdb2
 
 		void lock_read()
 		{
+#if defined(ZDB2_LOCK_PROFILING)
+			lock_profile::waiter w(m_profile);
+#endif
 			for (unsigned int k = 0; !try_lock_read(); ++k)
 			{
+#if defined(ZDB2_LOCK_PROFILING)
+				w.backoff(k);
+#endif
 				if (k < 16)
 				{
 					std::this_thread::yield();
@@ -60,6 +71,9 @@ namespace zdb2
 					std::this_thread::sleep_for(std::chrono::milliseconds(1));
 				}
 			}
+#if defined(ZDB2_LOCK_PROFILING)
+			w.acquired(false);
+#endif
 		}
 
 		void unlock_read()
@@ -81,9 +95,15 @@ namespace zdb2
 
 		void lock_write()
 		{
+#if defined(ZDB2_LOCK_PROFILING)
+			lock_profile::waiter w(m_profile);
+#endif
 			m_write_wait_count++;
 			for (unsigned int k = 0; !try_lock_write(); ++k)
 			{
+#if defined(ZDB2_LOCK_PROFILING)
+				w.backoff(k);
+#endif
 				if (k < 16)
 				{
 					std::this_thread::yield();
@@ -97,14 +117,33 @@ namespace zdb2
 					std::this_thread::sleep_for(std::chrono::milliseconds(1));
 				}
 			}
+#if defined(ZDB2_LOCK_PROFILING)
+			w.acquired(true);
+#endif
 			m_write_wait_count--;
 		}
 
 		void unlock_write()
 		{
+#if defined(ZDB2_LOCK_PROFILING)
+			m_profile.on_release();
+#endif
 			m_lock_count.store(0);
 		}
 
+		/**
+		 * set the name of the lock in the report of lock_profile,it does nothing unless the macro
+		 * ZDB2_LOCK_PROFILING is defined.
+		 */
+		void set_name(const char * name)
+		{
+#if defined(ZDB2_LOCK_PROFILING)
+			m_profile.set_name(name);
+#else
+			(void)name;
+#endif
+		}
+
 	private:
 		/// no copy construct function
 		rwlock(const rwlock&) = delete;
@@ -121,6 +160,10 @@ namespace zdb2
 
 		/// is write first or not
 		const bool m_is_write_first = true;
+
+#if defined(ZDB2_LOCK_PROFILING)
+		lock_profile m_profile{ "rwlock" };
+#endif
 	};
 
 	/**
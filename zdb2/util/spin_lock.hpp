@@ -13,6 +13,11 @@
 
 #include <atomic>
 #include <thread>
+#include <chrono>
+
+#if defined(ZDB2_LOCK_PROFILING)
+#include <zdb2/util/lock_profile.hpp>
+#endif
 
 namespace zdb2
 {
@@ -28,8 +33,14 @@ namespace zdb2
 
 		void lock()
 		{
+#if defined(ZDB2_LOCK_PROFILING)
+			lock_profile::waiter w(m_profile);
+#endif
 			for (unsigned k = 0; !try_lock(); ++k)
 			{
+#if defined(ZDB2_LOCK_PROFILING)
+				w.backoff(k);
+#endif
 				if (k < 16)
 				{
 					std::this_thread::yield();
@@ -43,16 +54,39 @@ namespace zdb2
 					std::this_thread::sleep_for(std::chrono::milliseconds(1));
 				}
 			}
+#if defined(ZDB2_LOCK_PROFILING)
+			w.acquired(true);
+#endif
 		}
 
 		void unlock()
 		{
+#if defined(ZDB2_LOCK_PROFILING)
+			m_profile.on_release();
+#endif
 			v_.clear(std::memory_order_release);
 		}
 
+		/**
+		 * set the name of the lock in the report of lock_profile,it does nothing unless the macro
+		 * ZDB2_LOCK_PROFILING is defined.
+		 */
+		void set_name(const char * name)
+		{
+#if defined(ZDB2_LOCK_PROFILING)
+			m_profile.set_name(name);
+#else
+			(void)name;
+#endif
+		}
+
 	public:
 		std::atomic_flag v_ = ATOMIC_FLAG_INIT;
 
+#if defined(ZDB2_LOCK_PROFILING)
+		lock_profile m_profile{ "spin_lock" };
+#endif
+
 	};
 
 }
@@ -13,9 +13,32 @@
 
 #include <zdb2/config.hpp>
 #include <zdb2/net/url.hpp>
+#include <zdb2/util/histogram.hpp>
+#include <zdb2/util/lock_profile.hpp>
+#include <zdb2/util/adaptive_mutex.hpp>
+#include <zdb2/util/br_rwlock.hpp>
 #include <zdb2/db/stmt.hpp>
 #include <zdb2/db/resultset.hpp>
 #include <zdb2/db/connection.hpp>
+#include <zdb2/db/materialized_result.hpp>
+#include <zdb2/db/batch_result.hpp>
+#include <zdb2/db/batch.hpp>
+#include <zdb2/db/column_batch.hpp>
+#include <zdb2/db/sql_util.hpp>
+#include <zdb2/db/stats.hpp>
+#include <zdb2/db/hooks.hpp>
+#include <zdb2/db/instrumented.hpp>
+#include <zdb2/db/pool_metrics.hpp>
 #include <zdb2/db/pool.hpp>
+#include <zdb2/db/router.hpp>
+#include <zdb2/db/shard_map.hpp>
+#include <zdb2/db/shard_router.hpp>
+#include <zdb2/db/merged_resultset.hpp>
+#include <zdb2/db/scatter_gather.hpp>
+#include <zdb2/db/parallel_scan.hpp>
+#include <zdb2/db/prometheus.hpp>
+#include <zdb2/db/trace.hpp>
+#include <zdb2/db/capture.hpp>
+#include <zdb2/db/awaitable.hpp>
 
 